@@ -38,7 +38,14 @@
 #include <stdint.h>
 #include "base64.h"
 #include "base64_luts.h"
+#include "indicpufeatures.h"
 #include <stdio.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_X86
+#include <immintrin.h>
+#endif
 
 /* convert inlen raw bytes at in to base64 string (NUL-terminated) at out. 
  * out size should be at least 4*inlen/3 + 4.
@@ -58,11 +65,235 @@ int to64frombits_s(unsigned char *out, const unsigned char *in, int inlen, size_
 #pragma GCC diagnostic pop
 }
 
+#ifdef BASE64_X86
+/* Vector kernels after W. Mula and D. Lemire, "Faster Base64 Encoding and Decoding
+ * using AVX2 Instructions". Each converts whole blocks only and returns how much
+ * of in it consumed, the scalar code below does the rest.
+ */
+
+/* 0 scalar, 1 SSSE3, 2 AVX2 */
+static int simd_level = -1;
+
+static int base64_simd_level()
+{
+    if (simd_level < 0)
+    {
+        if (indi_cpu_has_avx2())
+            simd_level = 2;
+        else if (indi_cpu_has_ssse3())
+            simd_level = 1;
+        else
+            simd_level = 0;
+    }
+    return simd_level;
+}
+
+/* spread 12 bytes over the 16 lanes as 6 bit values */
+__attribute__((target("ssse3"))) static inline __m128i enc_reshuffle_ssse3(__m128i in)
+{
+    __m128i t0, t1, t2, t3;
+
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+/* 6 bit values to base64 digits */
+__attribute__((target("ssse3"))) static inline __m128i enc_translate_ssse3(__m128i in)
+{
+    const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i idx       = _mm_subs_epu8(in, _mm_set1_epi8(51));
+
+    idx = _mm_sub_epi8(idx, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, idx));
+}
+
+__attribute__((target("ssse3"))) static int enc_ssse3(unsigned char *out, const unsigned char *in, int inlen)
+{
+    int n = 0;
+
+    /* each step reads 16 bytes but only uses 12 */
+    for (; inlen - n >= 16; n += 12, out += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + n));
+        _mm_storeu_si128((__m128i *)out, enc_translate_ssse3(enc_reshuffle_ssse3(v)));
+    }
+    return n;
+}
+
+__attribute__((target("avx2"))) static int enc_avx2(unsigned char *out, const unsigned char *in, int inlen)
+{
+    const __m256i shuf = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                         10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i lut  = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+                                          65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    int n = 0;
+
+    /* 24 bytes per step, 12 in each lane */
+    for (; inlen - n >= 28; n += 24, out += 32)
+    {
+        __m256i v, t0, t1, t2, t3, idx;
+
+        v  = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + n)));
+        v  = _mm256_inserti128_si256(v, _mm_loadu_si128((const __m128i *)(in + n + 12)), 1);
+        v  = _mm256_shuffle_epi8(v, shuf);
+        t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        v  = _mm256_or_si256(t1, t3);
+
+        idx = _mm256_subs_epu8(v, _mm256_set1_epi8(51));
+        idx = _mm256_sub_epi8(idx, _mm256_cmpgt_epi8(v, _mm256_set1_epi8(25)));
+        _mm256_storeu_si256((__m256i *)out, _mm256_add_epi8(v, _mm256_shuffle_epi8(lut, idx)));
+    }
+
+    return n + enc_ssse3(out, in + n, inlen - n);
+}
+
+/* base64 digits to 6 bit values. Returns the sextets in *v and non-zero if any
+ * lane was not a base64 digit ('=', whitespace, NUL...).
+ */
+__attribute__((target("ssse3"))) static inline int dec_translate_ssse3(__m128i *v)
+{
+    const __m128i lut_lo  = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi  = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_rol = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+    __m128i hi_nib, lo_nib, lo, hi, eq_2f;
+
+    hi_nib = _mm_and_si128(_mm_srli_epi32(*v, 4), mask_2f);
+    lo_nib = _mm_and_si128(*v, mask_2f);
+    lo     = _mm_shuffle_epi8(lut_lo, lo_nib);
+    hi     = _mm_shuffle_epi8(lut_hi, hi_nib);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())))
+        return 1;
+
+    eq_2f = _mm_cmpeq_epi8(*v, mask_2f);
+    *v    = _mm_add_epi8(*v, _mm_shuffle_epi8(lut_rol, _mm_add_epi8(eq_2f, hi_nib)));
+    return 0;
+}
+
+/* pack 16 sextets into 12 bytes at the bottom of the register */
+__attribute__((target("ssse3"))) static inline __m128i dec_reshuffle_ssse3(__m128i v)
+{
+    v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+__attribute__((target("ssse3"))) static int dec_ssse3(char *out, const char *in, int inlen)
+{
+    int n = 0;
+
+    for (; inlen - n >= 16; n += 16, out += 12)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + n));
+        uint32_t w;
+
+        if (dec_translate_ssse3(&v))
+            break;
+        v = dec_reshuffle_ssse3(v);
+        _mm_storel_epi64((__m128i *)out, v);
+        w = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+        memcpy(out + 8, &w, 4);
+    }
+    return n;
+}
+
+__attribute__((target("avx2"))) static int dec_avx2(char *out, const char *in, int inlen)
+{
+    const __m256i lut_lo  = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                             0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                             0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                             0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi  = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                             0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                             0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                             0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_rol = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i shuf    = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                             2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+    int n = 0;
+
+    for (; inlen - n >= 32; n += 32, out += 24)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + n));
+        __m256i hi_nib, lo_nib, lo, hi, eq_2f;
+
+        hi_nib = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask_2f);
+        lo_nib = _mm256_and_si256(v, mask_2f);
+        lo     = _mm256_shuffle_epi8(lut_lo, lo_nib);
+        hi     = _mm256_shuffle_epi8(lut_hi, hi_nib);
+        if (!_mm256_testz_si256(lo, hi))
+            break;
+
+        eq_2f = _mm256_cmpeq_epi8(v, mask_2f);
+        v     = _mm256_add_epi8(v, _mm256_shuffle_epi8(lut_rol, _mm256_add_epi8(eq_2f, hi_nib)));
+
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, shuf);
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(v));
+        _mm_storel_epi64((__m128i *)(out + 16), _mm256_extracti128_si256(v, 1));
+    }
+
+    return n + dec_ssse3(out, in + n, inlen - n);
+}
+
+/* encode what the vector unit can of inlen bytes at in, return bytes consumed */
+static int to64frombits_simd(unsigned char *out, const unsigned char *in, int inlen)
+{
+    switch (base64_simd_level())
+    {
+        case 2:
+            return enc_avx2(out, in, inlen);
+        case 1:
+            return enc_ssse3(out, in, inlen);
+        default:
+            return 0;
+    }
+}
+
+/* decode what the vector unit can of the inlen chars at in, stopping short of
+ * anything but base64 digits. Return chars consumed, always a multiple of 4.
+ */
+static int from64tobits_simd(char *out, const char *in, int inlen)
+{
+    switch (base64_simd_level())
+    {
+        case 2:
+            return dec_avx2(out, in, inlen);
+        case 1:
+            return dec_ssse3(out, in, inlen);
+        default:
+            return 0;
+    }
+}
+#else
+#define to64frombits_simd(out, in, inlen)   0
+#define from64tobits_simd(out, in, inlen)   0
+#endif
+
 int to64frombits(unsigned char *out, const unsigned char *in, int inlen)
 {
     uint16_t *b64lut = (uint16_t *)base64lut;
     int dlen         = ((inlen + 2) / 3) * 4; /* 4/3, rounded up */
-    uint16_t *wbuf   = (uint16_t *)out;
+    uint16_t *wbuf;
+    int done;
+
+    done = to64frombits_simd(out, in, inlen);
+    in += done;
+    inlen -= done;
+    wbuf = (uint16_t *)(out + done / 3 * 4);
 
     for (; inlen > 2; inlen -= 3)
     {
@@ -97,27 +328,43 @@ int to64frombits(unsigned char *out, const unsigned char *in, int inlen)
  */
 int from64tobits(char *out, const char *in)
 {
-    char *cp = (char *)in;
-    while (*cp != 0)
-        cp += 4;
-    return from64tobits_fast(out, in, cp - in);
+    return from64tobits_fast(out, in, strlen(in));
 }
 
+/* convert inlen base64 digits at in to raw bytes at out, return bytes written.
+ * Line breaks between 4 digit groups are skipped and not counted in inlen.
+ * Conversion also ends at a padded group or a NUL, so the length of a
+ * NUL-terminated string that includes its line breaks may be given as well.
+ * out should be at least 3/4 of inlen.
+ */
 int from64tobits_fast(char *out, const char *in, int inlen)
 {
-    int outlen = 0;
+    const char *end = in + inlen; /* in holds at least this much */
+    char *op        = out;
     uint8_t b1, b2, b3;
     uint16_t s1, s2;
     uint32_t n32;
-    int j;
-    int n         = (inlen / 4) - 1;
-    uint16_t *inp = (uint16_t *)in;
+    const uint16_t *inp;
+    int n;
 
-    for (j = 0; j < n; j++)
+    while (inlen >= 4)
     {
-        if (in[0] == '\n')
+        /* vector run up to the next line break */
+        if (end - in >= 16)
+        {
+            n = from64tobits_simd(op, in, end - in);
+            in += n;
+            inlen -= n;
+            op += n / 4 * 3;
+            if (inlen < 4)
+                break;
+        }
+
+        while (*in == '\n' || *in == '\r')
             in++;
-        inp = (uint16_t *)in;
+        if (!in[0] || !in[1] || !in[2] || !in[3])
+            break;
+        inp = (const uint16_t *)in;
 
         s1 = rbase64lut[inp[0]];
         s2 = rbase64lut[inp[1]];
@@ -132,44 +379,22 @@ int from64tobits_fast(char *out, const char *in, int inlen)
         n32 >>= 8;
         b1 = (n32 & 0x00ff);
 
-        out[0] = b1;
-        out[1] = b2;
-        out[2] = b3;
-
-        in += 4;
-        out += 3;
-    }
-    outlen = (inlen / 4 - 1) * 3;
-    if (in[0] == '\n')
-        in++;
-    inp = (uint16_t *)in;
-
-    s1 = rbase64lut[inp[0]];
-    s2 = rbase64lut[inp[1]];
-
-    n32 = s1;
-    n32 <<= 10;
-    n32 |= s2 >> 2;
-
-    b3 = (n32 & 0x00ff);
-    n32 >>= 8;
-    b2 = (n32 & 0x00ff);
-    n32 >>= 8;
-    b1 = (n32 & 0x00ff);
-
-    *out++ = b1;
-    outlen++;
-    if ((inp[1] & 0x00FF) != 0x003D)
-    {
-        *out++ = b2;
-        outlen++;
-        if ((inp[1] & 0xFF00) != 0x3D00)
+        op[0] = b1;
+        op[1] = b2;
+        op[2] = b3;
+        if (in[3] == '=')
         {
-            *out++ = b3;
-            outlen++;
+            /* padded, so this was the last group */
+            op += in[2] == '=' ? 1 : 2;
+            break;
         }
+
+        op += 3;
+        in += 4;
+        inlen -= 4;
     }
-    return outlen;
+
+    return op - out;
 }
 
 #ifdef BASE64_PROGRAM
@@ -49,10 +49,11 @@ __attribute__((deprecated("unsafe function, use to64frombits_s instead")))
 extern int to64frombits(unsigned char *out, const unsigned char *in, int inlen);
 
 /** \brief Convert base64 to bytes array.
-    \param out output buffer in bytes. The buffer size must be at least (3 * size_of_in_buffer / 4) bytes long.
+    \param out output buffer in bytes. The buffer size must be at least (3 * inlen / 4) bytes long.
     \param in input base64 buffer
-    \param inlen base64 buffer lenght
-    \return 0 on success, -1 on failure.
+    \param inlen number of base64 characters in buffer. Line breaks between groups of 4 are skipped and need
+    not be counted, conversion also stops at a padded group or at a NUL.
+    \return number of bytes written to out.
  */
 
 extern int from64tobits(char *out, const char *in);
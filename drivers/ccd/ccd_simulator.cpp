@@ -18,6 +18,7 @@
 
 #include "ccd_simulator.h"
 #include "indicom.h"
+#include "indiparallel.h"
 #include "stream/streammanager.h"
 
 #include "locale_compat.h"
@@ -31,10 +32,56 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <algorithm>
+#include <chrono>
 
 static pthread_cond_t cv         = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t condMutex = PTHREAD_MUTEX_INITIALIZER;
 
+//  Number of bands parallelRows() cuts rows into, one per core.
+//  Not worth a thread below a few hundred thousand pixels
+static int rowBands(int rows)
+{
+    return INDI::parallelParts(rows, 128);
+}
+
+//  Run job(band, first, last) on each of the rowBands(rows) bands of rows
+template <typename Job>
+static void parallelRows(int rows, Job job)
+{
+    int const bands = rowBands(rows);
+    INDI::parallelFor(bands, [&](size_t band)
+    {
+        job(band, rows * band / bands, rows * (band + 1) / bands);
+    });
+}
+
+//  xorshift64* for the read noise. Seeded per row, so the noise does not depend
+//  on how the rows are split between threads and no generator is shared.
+class NoiseGenerator
+{
+    public:
+        explicit NoiseGenerator(uint64_t seed)
+        {
+            //  splitmix64 spreads consecutive seeds apart, xorshift must not start at 0
+            seed += 0x9e3779b97f4a7c15ULL;
+            seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+            state = (seed ^ (seed >> 31)) | 1;
+        }
+
+        //  Uniform in [0, range)
+        uint32_t operator()(uint32_t range)
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return ((state * 0x2545f4914f6cdd1dULL) >> 32) * range >> 32;
+        }
+
+    private:
+        uint64_t state;
+};
+
 static std::unique_ptr<CCDSim> ccdsim(new CCDSim());
 
 CCDSim::CCDSim() : INDI::FilterInterface(this)
@@ -190,6 +237,16 @@ bool CCDSim::initProperties()
     IUFillSwitchVector(&DirectorySP, DirectoryS, 2, getDeviceName(), "CCD_DIRECTORY_TOGGLE", "Use Dir.", SIMULATOR_TAB, IP_RW,
                        ISR_1OFMANY, 60, IPS_IDLE);
 
+    // Time taken to synthesize the last frame
+    IUFillNumber(&RenderTimeN[0], "RENDER_TIME", "Time (ms)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&RenderTimeNP, RenderTimeN, 1, getDeviceName(), "CCD_RENDER_TIME", "Render", SIMULATOR_TAB, IP_RO,
+                       60, IPS_IDLE);
+
+    // Star catalog made by indi_star_catalog. Without one, stars are looked up by running gsc for every frame.
+    IUFillText(&CatalogT[0], "PATH", "Path", getenv("INDI_STAR_CATALOG") ? getenv("INDI_STAR_CATALOG") : "");
+    IUFillTextVector(&CatalogTP, CatalogT, 1, getDeviceName(), "CCD_STAR_CATALOG", "Star Catalog", SIMULATOR_TAB, IP_RW,
+                     60, IPS_IDLE);
+
 #ifdef USE_EQUATORIAL_PE
     IDSnoopDevice(ActiveDeviceT[0].text, "EQUATORIAL_PE");
 #else
@@ -277,6 +334,11 @@ bool CCDSim::updateProperties()
 
         defineProperty(&DirectoryTP);
         defineProperty(&DirectorySP);
+        defineProperty(&CatalogTP);
+        defineProperty(&RenderTimeNP);
+
+        if (!m_Catalog.isOpen() && CatalogT[0].text[0] != '\0')
+            openCatalog();
 
         setupParameters();
 
@@ -298,6 +360,8 @@ bool CCDSim::updateProperties()
         deleteProperty(OffsetNP.name);
         deleteProperty(DirectoryTP.name);
         deleteProperty(DirectorySP.name);
+        deleteProperty(CatalogTP.name);
+        deleteProperty(RenderTimeNP.name);
 
         INDI::FilterInterface::updateProperties();
     }
@@ -344,7 +408,11 @@ bool CCDSim::StartExposure(float duration)
             return false;
     }
     else
+    {
+        // Back to mono after a color frame of Bayer super-pixels
+        PrimaryCCD.setNAxis(2);
         DrawCcdFrame(&PrimaryCCD);
+    }
     //  Now compress the actual wait time
     ExposureRequest = duration * m_TimeFactor;
     InExposure      = true;
@@ -432,7 +500,12 @@ void CCDSim::TimerHit()
                     InExposure = false;
                     // We don't bin for raw images.
                     if (DirectoryS[INDI_DISABLED].s == ISS_ON)
-                        PrimaryCCD.binFrame();
+                    {
+                        if (m_SimulateBayer)
+                            PrimaryCCD.binBayerFrame(BayerT[2].text);
+                        else
+                            PrimaryCCD.binFrame();
+                    }
                     ExposureComplete(&PrimaryCCD);
                 }
                 else
@@ -521,6 +594,7 @@ int CCDSim::DrawCcdFrame(INDI::CCDChip * targetChip)
     //  CCD frame is 16 bit data
     float exposure_time;
     float targetFocalLength;
+    auto renderStart = std::chrono::steady_clock::now();
 
     uint16_t * ptr = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer());
 
@@ -709,103 +783,137 @@ int CCDSim::DrawCcdFrame(INDI::CCDChip * targetChip)
 
         if (ftype == INDI::CCDChip::LIGHT_FRAME)
         {
-            AutoCNumeric locale;
-            char gsccmd[250];
-            FILE * pp;
             int drawn = 0;
 
-            sprintf(gsccmd, "gsc -c %8.6f %+8.6f -r %4.1f -m 0 %4.2f -n 3000",
-                    range360(rad + PEOffset),
-                    rangeDec(cameradec),
-                    radius,
-                    lookuplimit);
+            //  Project standard co-ordinates on the ccd and draw the star
+            auto drawStar = [&](double sx, double sy, float mag)
+            {
+                //  now convert to pixels
+                double ccdx = pa * sx + pb * sy + pc;
+                double ccdy = pd * sx + pe * sy + pf;
+
+                // Invert horizontally
+                ccdx = ccdW - ccdx;
+
+                return DrawImageStar(targetChip, mag, ccdx, ccdy, exposure_time);
+            };
 
-            pp = popen(gsccmd, "r");
-            if (pp != nullptr)
+            if (m_Catalog.isOpen())
             {
-                char line[256];
-                int stars = 0;
-                int lines = 0;
+                std::vector<StarCatalog::Star> stars;
+                m_Catalog.query(range360(rad + PEOffset), rangeDec(cameradec), radius / 60, lookuplimit, 3000, stars);
+
+                //  Same standard co-ordinates as below, from the unit vectors the catalog
+                //  keeps for its stars: toward the field center, east and north
+                double cx = cos(decr) * cos(rar), cy = cos(decr) * sin(rar), cz = sin(decr);
+                double ex = -sin(rar), ey = cos(rar);
+                double nx = -sin(decr) * cos(rar), ny = -sin(decr) * sin(rar), nz = cos(decr);
 
-                while (fgets(line, 256, pp) != nullptr)
+                for (const StarCatalog::Star &star : stars)
                 {
-                    //  ok, lets parse this line for specifcs we want
-                    char id[20];
-                    char plate[6];
-                    char ob[6];
-                    float mag;
-                    float mage;
-                    float ra;
-                    float dec;
-                    float pose;
-                    int band;
-                    float dist;
-                    int dir;
-                    int c;
-
-                    int rc = sscanf(line, "%10s %f %f %f %f %f %d %d %4s %2s %f %d", id, &ra, &dec, &pose, &mag, &mage,
-                                    &band, &c, plate, ob, &dist, &dir);
-                    if (rc == 12)
+                    double den = star.x * cx + star.y * cy + star.z * cz;
+                    double sx  = (star.x * ex + star.y * ey) / den;
+                    double sy  = -(star.x * nx + star.y * ny + star.z * nz) / den;
+
+                    drawn += drawStar(sx, sy, star.mag);
+                }
+
+                if (drawn == 0)
+                    LOGF_DEBUG("No stars in the catalog around %.4f %+.4f", range360(rad + PEOffset), rangeDec(cameradec));
+            }
+            else
+            {
+                AutoCNumeric locale;
+                char gsccmd[250];
+                FILE * pp;
+
+                sprintf(gsccmd, "gsc -c %8.6f %+8.6f -r %4.1f -m 0 %4.2f -n 3000",
+                        range360(rad + PEOffset),
+                        rangeDec(cameradec),
+                        radius,
+                        lookuplimit);
+
+                pp = popen(gsccmd, "r");
+                if (pp != nullptr)
+                {
+                    char line[256];
+                    int stars = 0;
+                    int lines = 0;
+
+                    while (fgets(line, 256, pp) != nullptr)
                     {
-                        lines++;
-                        stars++;
-
-                        //  Convert the ra/dec to standard co-ordinates
-                        double sx;    //  standard co-ords
-                        double sy;    //
-                        double srar;  //  star ra in radians
-                        double sdecr; //  star dec in radians;
-                        double ccdx;
-                        double ccdy;
-
-                        srar  = ra * 0.0174532925;
-                        sdecr = dec * 0.0174532925;
-
-                        //  Handbook of astronomical image processing
-                        //  page 253
-                        //  equations 9.1 and 9.2
-                        //  convert ra/dec to standard co-ordinates
-
-                        sx = cos(sdecr) * sin(srar - rar) /
-                             (cos(decr) * cos(sdecr) * cos(srar - rar) + sin(decr) * sin(sdecr));
-                        sy = (sin(decr) * cos(sdecr) * cos(srar - rar) - cos(decr) * sin(sdecr)) /
-                             (cos(decr) * cos(sdecr) * cos(srar - rar) + sin(decr) * sin(sdecr));
-
-                        //  now convert to pixels
-                        ccdx = pa * sx + pb * sy + pc;
-                        ccdy = pd * sx + pe * sy + pf;
-
-                        // Invert horizontally
-                        ccdx = ccdW - ccdx;
-
-                        rc = DrawImageStar(targetChip, mag, ccdx, ccdy, exposure_time);
-                        drawn += rc;
-#ifdef __DEV__
-                        if (rc == 1)
+                        //  ok, lets parse this line for specifcs we want
+                        char id[20];
+                        char plate[6];
+                        char ob[6];
+                        float mag;
+                        float mage;
+                        float ra;
+                        float dec;
+                        float pose;
+                        int band;
+                        float dist;
+                        int dir;
+                        int c;
+
+                        int rc = sscanf(line, "%10s %f %f %f %f %f %d %d %4s %2s %f %d", id, &ra, &dec, &pose, &mag, &mage,
+                                        &band, &c, plate, ob, &dist, &dir);
+                        if (rc == 12)
                         {
-                            LOGF_DEBUG("star %s scope %6.4f %6.4f star %6.4f %6.4f ccd %6.2f %6.2f", id, rad, decPE, ra, dec, ccdx, ccdy);
-                            LOGF_DEBUG("star %s ccd %6.2f %6.2f", id, ccdx, ccdy);
-                        }
+                            lines++;
+                            stars++;
+
+                            //  Convert the ra/dec to standard co-ordinates
+                            double sx;    //  standard co-ords
+                            double sy;    //
+                            double srar;  //  star ra in radians
+                            double sdecr; //  star dec in radians;
+
+                            srar  = ra * 0.0174532925;
+                            sdecr = dec * 0.0174532925;
+
+                            //  Handbook of astronomical image processing
+                            //  page 253
+                            //  equations 9.1 and 9.2
+                            //  convert ra/dec to standard co-ordinates
+
+                            sx = cos(sdecr) * sin(srar - rar) /
+                                 (cos(decr) * cos(sdecr) * cos(srar - rar) + sin(decr) * sin(sdecr));
+                            sy = (sin(decr) * cos(sdecr) * cos(srar - rar) - cos(decr) * sin(sdecr)) /
+                                 (cos(decr) * cos(sdecr) * cos(srar - rar) + sin(decr) * sin(sdecr));
+
+                            rc = drawStar(sx, sy, mag);
+                            drawn += rc;
+#ifdef __DEV__
+                            if (rc == 1)
+                            {
+                                LOGF_DEBUG("star %s scope %6.4f %6.4f star %6.4f %6.4f", id, rad, decPE, ra, dec);
+                            }
 #endif
+                        }
                     }
+                    pclose(pp);
+                }
+                else
+                {
+                    LOG_ERROR("Error looking up stars, is gsc installed with appropriate environment variables set ??");
+                }
+                if (drawn == 0)
+                {
+                    LOG_ERROR("Got no stars, is gsc installed with appropriate environment variables set ??");
                 }
-                pclose(pp);
-            }
-            else
-            {
-                LOG_ERROR("Error looking up stars, is gsc installed with appropriate environment variables set ??");
-            }
-            if (drawn == 0)
-            {
-                LOG_ERROR("Got no stars, is gsc installed with appropriate environment variables set ??");
             }
         }
 
         //  now we need to add background sky glow, with vignetting
         //  this is essentially the same math as drawing a dim star with
-        //  fwhm equivalent to the full field of view
+        //  fwhm equivalent to the full field of view.
+        //  Then we add some bias and read noise, in the same pass over the frame.
+
+        bool const glowing = ftype == INDI::CCDChip::LIGHT_FRAME || ftype == INDI::CCDChip::FLAT_FRAME;
+        float skyflux = 0;
 
-        if (ftype == INDI::CCDChip::LIGHT_FRAME || ftype == INDI::CCDChip::FLAT_FRAME)
+        if (glowing)
         {
             //  calculate flux from our zero point and gain values
             float glow = m_SkyGlow;
@@ -818,70 +926,82 @@ int CCDSim::DrawCcdFrame(INDI::CCDChip * targetChip)
                 glow = m_SkyGlow / 10;
             }
 
-            //fprintf(stderr,"Using glow %4.2f\n",glow);
-
             // Flux represents one second, scale up linearly for exposure time
-            float const skyflux = flux(glow) * exposure_time;
-
-            uint16_t * pt = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer());
-
-            nheight = targetChip->getSubH();
-            nwidth  = targetChip->getSubW();
-
-            for (int y = 0; y < nheight; y++)
-            {
-                float const sy = nheight / 2 - y;
-
-                for (int x = 0; x < nwidth; x++)
-                {
-                    float const sx = nwidth / 2 - x;
-
-                    // Vignetting parameter in arcsec
-                    float const vig = std::min(nwidth, nheight) * ImageScalex;
-
-                    // Squared distance to center in arcsec (need to make this account for actual pixel size)
-                    float const dc2 = sx * sx * ImageScalex * ImageScalex + sy * sy * ImageScaley * ImageScaley;
-
-                    // Gaussian falloff to the edges of the frame
-                    float const fa = exp(-2.0 * 0.7 * dc2 / (vig * vig));
+            skyflux = flux(glow) * exposure_time;
+        }
 
-                    // Get the current value of the pixel, add the sky glow and scale for vignetting
-                    float fp = (pt[0] + skyflux) * fa;
+        nheight = targetChip->getSubH();
+        nwidth  = targetChip->getSubW();
 
-                    // Clamp to limits, store minmax
-                    if (fp > m_MaxVal) fp = m_MaxVal;
-                    if (fp < pt[0]) fp = pt[0];
-                    if (fp > maxpix) maxpix = fp;
-                    if (fp < minpix) minpix = fp;
+        // Vignetting parameter in arcsec
+        float const vig = std::min(nwidth, nheight) * ImageScalex;
 
-                    // And put it back
-                    pt[0] = fp;
-                    pt++;
-                }
-            }
+        // Gaussian falloff to the edges of the frame. It is separable,
+        // exp(-(dx² + dy²)) = exp(-dx²) * exp(-dy²), so tabulate it once per column and once per row
+        std::vector<float> vigx(glowing ? nwidth : 0), vigy(glowing ? nheight : 0);
+        for (size_t x = 0; x < vigx.size(); x++)
+        {
+            float const sx = nwidth / 2 - static_cast<int>(x);
+            vigx[x] = exp(-2.0 * 0.7 * sx * sx * ImageScalex * ImageScalex / (vig * vig));
+        }
+        for (size_t y = 0; y < vigy.size(); y++)
+        {
+            float const sy = nheight / 2 - static_cast<int>(y);
+            vigy[y] = exp(-2.0 * 0.7 * sy * sy * ImageScaley * ImageScaley / (vig * vig));
         }
 
-        //  Now we add some bias and read noise
-        int subX = targetChip->getSubX();
-        int subY = targetChip->getSubY();
-        int subW = targetChip->getSubW() + subX;
-        int subH = targetChip->getSubH() + subY;
+        uint64_t const noiseSeed = random();
+        int const maxVal = m_MaxVal, bias = m_Bias, maxNoise = m_MaxNoise;
+        //  Each band keeps its own extremes, the shared ones are only updated once all are done
+        std::vector<int> bandMaxima(rowBands(nheight), maxpix), bandMinima(bandMaxima.size(), minpix);
 
-        if (m_MaxNoise > 0)
+        parallelRows(nheight, [&](int band, int first, int last)
         {
-            for (int x = subX; x < subW; x++)
+            int bandMax = bandMaxima[band], bandMin = bandMinima[band];
+            std::vector<int> noise(maxNoise > 0 ? nwidth : 0);
+
+            for (int y = first; y < last; y++)
             {
-                for (int y = subY; y < subH; y++)
+                uint16_t * pt = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer()) + y * nwidth;
+
+                if (glowing)
                 {
-                    int noise;
+                    float const fy = vigy[y];
+                    for (int x = 0; x < nwidth; x++)
+                    {
+                        // Get the current value of the pixel, add the sky glow and scale for vignetting
+                        float const fp = std::max(std::min((pt[x] + skyflux) * vigx[x] * fy, static_cast<float>(maxVal)),
+                                                  static_cast<float>(pt[x]));
+                        // And put it back
+                        pt[x] = fp;
+                        bandMax = std::max<int>(bandMax, pt[x]);
+                        bandMin = std::min<int>(bandMin, pt[x]);
+                    }
+                }
 
-                    noise = random();
-                    noise = noise % m_MaxNoise; //
+                if (maxNoise > 0)
+                {
+                    //  Draw the row's noise first, so the loop adding it has no dependency between pixels
+                    NoiseGenerator generator(noiseSeed * nheight + y);
+                    for (int x = 0; x < nwidth; x++)
+                        noise[x] = bias + generator(maxNoise);
 
-                    AddToPixel(targetChip, x, y, m_Bias + noise);
+                    for (int x = 0; x < nwidth; x++)
+                    {
+                        int const newval = std::min(pt[x] + noise[x], maxVal);
+                        pt[x] = newval;
+                        bandMax = std::max(bandMax, newval);
+                        bandMin = std::min(bandMin, newval);
+                    }
                 }
             }
-        }
+
+            bandMaxima[band] = bandMax;
+            bandMinima[band] = bandMin;
+        });
+
+        maxpix = *std::max_element(bandMaxima.begin(), bandMaxima.end());
+        minpix = *std::min_element(bandMinima.begin(), bandMinima.end());
     }
     else
     {
@@ -898,6 +1018,17 @@ int CCDSim::DrawCcdFrame(INDI::CCDChip * targetChip)
             ptr++;
         }
     }
+
+    auto renderEnd = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> renderTime = renderEnd - renderStart;
+    RenderTimeN[0].value = renderTime.count();
+    RenderTimeNP.s = IPS_OK;
+    if (isConnected() && renderEnd - m_RenderTimeSent >= std::chrono::seconds(1))
+    {
+        m_RenderTimeSent = renderEnd;
+        IDSetNumber(&RenderTimeNP, nullptr);
+    }
+
     return 0;
 }
 
@@ -940,30 +1071,47 @@ int CCDSim::DrawImageStar(INDI::CCDChip * targetChip, float mag, float x, float
 
     //IDLog("BoxSize %d %d\n",boxsizex,boxsizey);
 
-    for (sy = -boxsizey; sy <= boxsizey; sy++)
+    // Use a gaussian of unitary integral, scale it with the source flux
+    // f(x) = 1/(sqrt(2*pi)*sigma) * exp( -x² / (2*sigma²) )
+    // FWHM = 2*sqrt(2*log(2))*sigma => sigma = seeing/(2*sqrt(2*log(2)))
+    float const sigma = seeing / ( 2 * sqrt(2 * log(2)));
+
+    // The source contribution is the gaussian value, stretched by seeing/FWHM.
+    // Separable in x and y (distances in arcsec), so only one exp() per row and per column of the box
+    int const boxsize = 2 * boxsizey + 1;
+    std::vector<float> profilex(boxsize), profiley(boxsize);
+    for (int i = 0; i < boxsize; i++)
     {
-        for (sx = -boxsizey; sx <= boxsizey; sx++)
-        {
-            int rc;
+        int const d = i - boxsizey;
+        profilex[i] = exp(-(d * d * ImageScalex * ImageScalex) / (2 * sigma * sigma));
+        profiley[i] = exp(-(d * d * ImageScaley * ImageScaley) / (2 * sigma * sigma)) * flux / (sigma * sqrt(2 * 3.1416));
+    }
 
-            // Squared distance to center in arcsec (need to make this account for actual pixel size)
-            float const dc2 = sx * sx * ImageScalex * ImageScalex + sy * sy * ImageScaley * ImageScaley;
+    uint16_t * buffer = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer());
+    int const nwidth  = targetChip->getSubW();
+    int const nheight = targetChip->getSubH();
 
-            // Use a gaussian of unitary integral, scale it with the source flux
-            // f(x) = 1/(sqrt(2*pi)*sigma) * exp( -x² / (2*sigma²) )
-            // FWHM = 2*sqrt(2*log(2))*sigma => sigma = seeing/(2*sqrt(2*log(2)))
-            float const sigma = seeing / ( 2 * sqrt(2 * log(2)));
-            float const fa = 1 / (sigma * sqrt(2 * 3.1416)) * exp( -dc2 / (2 * sigma * sigma));
+    for (sy = -boxsizey; sy <= boxsizey; sy++)
+    {
+        // Same pixel AddToPixel() would pick for x + sx, y + sy
+        int const py = static_cast<int>(y + sy) - subY;
+        if (py < 0 || py >= nheight)
+            continue;
 
-            // The source contribution is the gaussian value, stretched by seeing/FWHM
-            float fp = fa * flux;
+        uint16_t * pt = buffer + py * nwidth;
+        for (sx = -boxsizey; sx <= boxsizey; sx++)
+        {
+            int const px = static_cast<int>(x + sx) - subX;
+            if (px < 0 || px >= nwidth)
+                continue;
 
-            if (fp < 0)
-                fp = 0;
+            float const fp = std::max(profilex[sx + boxsizey] * profiley[sy + boxsizey], 0.0f);
+            int const newval = std::min(pt[px] + static_cast<int>(fp), m_MaxVal);
 
-            rc = AddToPixel(targetChip, x + sx, y + sy, fp);
-            if (rc != 0)
-                drew = 1;
+            maxpix = std::max(maxpix, newval);
+            minpix = std::min(minpix, newval);
+            pt[px] = newval;
+            drew = 1;
         }
     }
     return drew;
@@ -1062,6 +1210,12 @@ bool CCDSim::ISNewText(const char * dev, const char * name, char * texts[], char
             IDSetText(&DirectoryTP, nullptr);
             return true;
         }
+        else if (!strcmp(CatalogTP.name, name))
+        {
+            IUUpdateText(&CatalogTP, texts, names, n);
+            openCatalog();
+            return true;
+        }
 
     }
 
@@ -1347,6 +1501,7 @@ bool CCDSim::saveConfigItems(FILE * fp)
 
     // Directory
     IUSaveConfigText(fp, &DirectoryTP);
+    IUSaveConfigText(fp, &CatalogTP);
 
     // Bayer
     IUSaveConfigSwitch(fp, &SimulateBayerSP);
@@ -1557,3 +1712,29 @@ bool CCDSim::loadNextImage()
     fits_close_file(fptr, &status);
     return true;
 }
+
+bool CCDSim::openCatalog()
+{
+    if (CatalogT[0].text[0] == '\0')
+    {
+        m_Catalog.close();
+        CatalogTP.s = IPS_IDLE;
+        LOG_INFO("No star catalog, stars are looked up with gsc.");
+        IDSetText(&CatalogTP, nullptr);
+        return true;
+    }
+
+    std::string error;
+    if (!m_Catalog.open(CatalogT[0].text, error))
+    {
+        CatalogTP.s = IPS_ALERT;
+        LOGF_ERROR("Failed to open star catalog %s: %s. Stars are looked up with gsc.", CatalogT[0].text, error.c_str());
+        IDSetText(&CatalogTP, nullptr);
+        return false;
+    }
+
+    CatalogTP.s = IPS_OK;
+    LOGF_INFO("Stars are drawn from catalog %s.", CatalogT[0].text);
+    IDSetText(&CatalogTP, nullptr);
+    return true;
+}
@@ -18,15 +18,19 @@
 
 #pragma once
 
+#include <chrono>
 #include <deque>
 
 #include "indiccd.h"
 #include "indifilterinterface.h"
+#include "star_catalog.h"
 
 /**
  * @brief The CCDSim class provides an advanced simulator for a CCD that includes a dedicated on-board guide chip.
  *
  * The CCD driver can generate star fields given that General-Star-Catalog (gsc) tool is installed on the same machine the driver is running.
+ * For frame rates gsc cannot keep up with, a star catalog made once with indi_star_catalog can be set in the CCD_STAR_CATALOG property
+ * (or the INDI_STAR_CATALOG environment variable) and is then queried in-process instead.
  *
  * Many simulator parameters can be configured to generate the final star field image. In addition to support guider chip and guiding pulses (ST4),
  * a filter wheel support is provided for 8 filter wheels. Cooler and temperature control is also supported.
@@ -126,6 +130,7 @@ class CCDSim : public INDI::CCD, public INDI::FilterInterface
         float CalcTimeLeft(timeval, float);
         bool loadNextImage();
         bool setupParameters();
+        bool openCatalog();
 
         // Turns on/off Bayer RGB simulation.
         void setBayerEnabled(bool onOff);
@@ -236,6 +241,15 @@ class CCDSim : public INDI::CCD, public INDI::FilterInterface
         ISwitch DirectoryS[2];
         ISwitchVectorProperty DirectorySP;
 
+        INumber RenderTimeN[1];
+        INumberVectorProperty RenderTimeNP;
+        // Last time RenderTimeNP was sent, at most once a second at streaming frame rates
+        std::chrono::steady_clock::time_point m_RenderTimeSent;
+
+        IText CatalogT[1] {};
+        ITextVectorProperty CatalogTP;
+        StarCatalog m_Catalog;
+
         ISwitchVectorProperty CrashSP;
         ISwitch CrashS[1];
 
@@ -0,0 +1,282 @@
+/*******************************************************************************
+  Copyright(c) 2026 INDI Library Contributors. All rights reserved.
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "star_catalog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t CATALOG_MAGIC = 0x31435349; // "ISC1"
+static const uint32_t CATALOG_BANDS = 180;
+// Decoded tiles kept around, a few fields worth
+static const size_t CACHED_TILES = 256;
+
+static const double DEG_TO_RAD = M_PI / 180.0;
+
+static void unitVector(StarCatalog::Star &star)
+{
+    double cd = cos(star.dec * DEG_TO_RAD);
+    star.x    = cd * cos(star.ra * DEG_TO_RAD);
+    star.y    = cd * sin(star.ra * DEG_TO_RAD);
+    star.z    = sin(star.dec * DEG_TO_RAD);
+}
+
+static uint32_t bandOf(double dec, uint32_t bands)
+{
+    int band = static_cast<int>(floor((dec + 90.0) * bands / 180.0));
+    return std::min<int>(std::max(band, 0), bands - 1);
+}
+
+static uint32_t tileOf(double ra, uint32_t tiles)
+{
+    ra      = fmod(ra, 360.0);
+    if (ra < 0)
+        ra += 360.0;
+    return std::min<uint32_t>(static_cast<uint32_t>(ra * tiles / 360.0), tiles - 1);
+}
+
+StarCatalog::~StarCatalog()
+{
+    close();
+}
+
+bool StarCatalog::open(const std::string &path, std::string &error)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(4 * sizeof(uint32_t)))
+    {
+        error = "not a star catalog";
+        ::close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+        error = strerror(errno);
+        return false;
+    }
+
+    const uint32_t *header = static_cast<const uint32_t *>(map);
+    uint32_t bands = header[1], tiles = header[2], stars = header[3];
+    uint64_t size = 4 * sizeof(uint32_t) + (uint64_t(bands) + 1 + tiles + 1) * sizeof(uint32_t) +
+                    uint64_t(stars) * sizeof(Record);
+    const uint32_t *bandStart = header + 4;
+    const uint32_t *tileStart = bandStart + bands + 1;
+
+    bool valid = header[0] == CATALOG_MAGIC && bands > 0 && bands <= 1 << 16 && tiles <= 1 << 24 &&
+                 size == static_cast<uint64_t>(st.st_size) && bandStart[0] == 0 && bandStart[bands] == tiles &&
+                 tileStart[0] == 0 && tileStart[tiles] == stars;
+
+    // Queries index tiles and stars through these without further checks: every band needs a tile, and no
+    // tile may start before the previous one
+    for (uint32_t band = 0; valid && band < bands; band++)
+        valid = bandStart[band] < bandStart[band + 1];
+    for (uint32_t tile = 0; valid && tile < tiles; tile++)
+        valid = tileStart[tile] <= tileStart[tile + 1];
+
+    if (!valid)
+    {
+        error = "not a star catalog or corrupted";
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    m_Map       = map;
+    m_MapSize   = st.st_size;
+    m_Bands     = bands;
+    m_BandStart = bandStart;
+    m_TileStart = tileStart;
+    m_Records   = reinterpret_cast<const Record *>(tileStart + tiles + 1);
+    return true;
+}
+
+void StarCatalog::close()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+
+    if (m_Map != nullptr)
+        munmap(m_Map, m_MapSize);
+    m_Map = nullptr;
+    m_Tiles.clear();
+    m_TileIndex.clear();
+}
+
+const std::vector<StarCatalog::Star> &StarCatalog::tile(uint32_t index)
+{
+    auto it = m_TileIndex.find(index);
+    if (it != m_TileIndex.end())
+    {
+        m_Tiles.splice(m_Tiles.begin(), m_Tiles, it->second);
+        return it->second->second;
+    }
+
+    if (m_Tiles.size() >= CACHED_TILES)
+    {
+        m_TileIndex.erase(m_Tiles.back().first);
+        m_Tiles.pop_back();
+    }
+
+    m_Tiles.emplace_front(index, std::vector<Star>());
+    m_TileIndex[index] = m_Tiles.begin();
+
+    std::vector<Star> &stars = m_Tiles.front().second;
+    stars.resize(m_TileStart[index + 1] - m_TileStart[index]);
+    for (size_t i = 0; i < stars.size(); i++)
+    {
+        const Record &record = m_Records[m_TileStart[index] + i];
+        stars[i].ra          = record.ra;
+        stars[i].dec         = record.dec;
+        stars[i].mag         = record.mag;
+        unitVector(stars[i]);
+    }
+    return stars;
+}
+
+size_t StarCatalog::query(double ra, double dec, double radius, double magLimit, size_t maxStars,
+                          std::vector<Star> &stars)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+
+    stars.clear();
+    if (m_Map == nullptr)
+        return 0;
+
+    Star center;
+    center.ra  = ra;
+    center.dec = dec;
+    unitVector(center);
+    double minDot = cos(std::min(radius, 180.0) * DEG_TO_RAD);
+
+    uint32_t firstBand = bandOf(dec - radius, m_Bands);
+    uint32_t lastBand  = bandOf(dec + radius, m_Bands);
+
+    // Half width of the cone in right ascension, all of it once the cone reaches a pole
+    double halfWidth = 180.0;
+    if (fabs(dec) + radius < 90.0)
+        halfWidth = asin(sin(radius * DEG_TO_RAD) / cos(dec * DEG_TO_RAD)) / DEG_TO_RAD;
+
+    for (uint32_t band = firstBand; band <= lastBand; band++)
+    {
+        uint32_t tiles = m_BandStart[band + 1] - m_BandStart[band];
+        uint32_t first = 0, count = tiles;
+
+        if (2 * halfWidth + 360.0 / tiles < 360.0)
+        {
+            first = tileOf(ra - halfWidth, tiles);
+            count = (tileOf(ra + halfWidth, tiles) + tiles - first) % tiles + 1;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (const Star &star : tile(m_BandStart[band] + (first + i) % tiles))
+            {
+                // Brightest first, the rest of the tile is too faint
+                if (star.mag > magLimit)
+                    break;
+                if (star.x * center.x + star.y * center.y + star.z * center.z >= minDot)
+                    stars.push_back(star);
+            }
+        }
+    }
+
+    std::sort(stars.begin(), stars.end(), [](const Star & a, const Star & b)
+    {
+        return a.mag < b.mag;
+    });
+    if (stars.size() > maxStars)
+        stars.resize(maxStars);
+
+    return stars.size();
+}
+
+bool StarCatalog::write(const std::string &path, std::vector<Star> &stars, std::string &error)
+{
+    // Tiles about a degree wide, narrower bands near the poles have fewer
+    std::vector<uint32_t> bandStart(CATALOG_BANDS + 1, 0);
+    for (uint32_t band = 0; band < CATALOG_BANDS; band++)
+    {
+        double center = (band + 0.5) * 180.0 / CATALOG_BANDS - 90.0;
+        uint32_t tiles = std::max(1.0, ceil(360.0 * cos(center * DEG_TO_RAD) * CATALOG_BANDS / 180.0));
+        bandStart[band + 1] = bandStart[band] + tiles;
+    }
+    uint32_t tiles = bandStart[CATALOG_BANDS];
+
+    auto tileOfStar = [&](const Star & star)
+    {
+        uint32_t band = bandOf(star.dec, CATALOG_BANDS);
+        return bandStart[band] + tileOf(star.ra, bandStart[band + 1] - bandStart[band]);
+    };
+
+    std::sort(stars.begin(), stars.end(), [&](const Star & a, const Star & b)
+    {
+        uint32_t ta = tileOfStar(a), tb = tileOfStar(b);
+        return ta != tb ? ta < tb : a.mag < b.mag;
+    });
+
+    std::vector<uint32_t> tileStart(tiles + 1, 0);
+    for (const Star &star : stars)
+        tileStart[tileOfStar(star) + 1]++;
+    for (uint32_t i = 0; i < tiles; i++)
+        tileStart[i + 1] += tileStart[i];
+
+    std::vector<Record> records(stars.size());
+    for (size_t i = 0; i < stars.size(); i++)
+        records[i] = { static_cast<float>(stars[i].ra), static_cast<float>(stars[i].dec), static_cast<float>(stars[i].mag) };
+
+    std::string tmp = path + ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "w");
+    if (fp == nullptr)
+    {
+        error = strerror(errno);
+        return false;
+    }
+
+    uint32_t header[4] = { CATALOG_MAGIC, CATALOG_BANDS, tiles, static_cast<uint32_t>(stars.size()) };
+    bool ok = fwrite(header, sizeof(header), 1, fp) == 1 &&
+              fwrite(bandStart.data(), sizeof(uint32_t), bandStart.size(), fp) == bandStart.size() &&
+              fwrite(tileStart.data(), sizeof(uint32_t), tileStart.size(), fp) == tileStart.size() &&
+              fwrite(records.data(), sizeof(Record), records.size(), fp) == records.size();
+    if (fclose(fp) != 0)
+        ok = false;
+
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        error = strerror(errno);
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    return true;
+}
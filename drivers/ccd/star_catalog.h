@@ -0,0 +1,120 @@
+/*******************************************************************************
+  Copyright(c) 2026 INDI Library Contributors. All rights reserved.
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The StarCatalog class reads stars from a memory mapped binary catalog.
+ *
+ * The catalog is made once, from the output of the gsc tool or any list of positions and magnitudes, by
+ * indi_star_catalog. The sky is cut in declination bands one degree high, each band in tiles about one
+ * degree wide, and the stars of every tile are stored brightest first. A cone query only looks at the tiles
+ * the cone touches and stops reading a tile at the magnitude limit. Tiles recently queried are kept
+ * decoded, with their unit vectors, so drawing successive frames of the same field costs no trigonometry.
+ *
+ * File layout, all in host byte order:
+ *
+ *     header           magic "ISC1", number of bands, number of tiles, number of stars (4 x 32 bit)
+ *     band index       bands + 1 entries, first tile of each band (32 bit)
+ *     tile index       tiles + 1 entries, first star of each tile (32 bit)
+ *     stars            RA (degrees), declination (degrees), magnitude (3 x float)
+ */
+class StarCatalog
+{
+    public:
+        struct Star
+        {
+            /// J2000 right ascension in degrees
+            double ra;
+            /// J2000 declination in degrees
+            double dec;
+            double mag;
+            /// Unit vector towards the star, x towards RA 0h, z towards the north pole
+            double x, y, z;
+        };
+
+        StarCatalog() = default;
+        ~StarCatalog();
+
+        StarCatalog(const StarCatalog &) = delete;
+        StarCatalog &operator=(const StarCatalog &) = delete;
+
+        /**
+         * @brief Map a catalog file, closing any catalog already open.
+         * @param path catalog made by write().
+         * @param error set to the reason on failure.
+         * @return True if the catalog is ready to query.
+         */
+        bool open(const std::string &path, std::string &error);
+        void close();
+        bool isOpen() const
+        {
+            return m_Map != nullptr;
+        }
+
+        /**
+         * @brief Find the stars in a cone, brightest first.
+         * @param ra right ascension of the cone center in degrees.
+         * @param dec declination of the cone center in degrees.
+         * @param radius cone radius in degrees.
+         * @param magLimit faintest magnitude returned.
+         * @param maxStars at most this many stars are returned, the brightest ones.
+         * @param stars receives the stars found, replacing its content.
+         * @return Number of stars found.
+         */
+        size_t query(double ra, double dec, double radius, double magLimit, size_t maxStars, std::vector<Star> &stars);
+
+        /**
+         * @brief Write a catalog file.
+         * @param path file to write, replaced only once it is complete.
+         * @param stars stars to write, only ra, dec and mag are used. Reordered on return.
+         * @param error set to the reason on failure.
+         * @return True on success.
+         */
+        static bool write(const std::string &path, std::vector<Star> &stars, std::string &error);
+
+    private:
+        struct Record
+        {
+            float ra;
+            float dec;
+            float mag;
+        };
+
+        const std::vector<Star> &tile(uint32_t index);
+
+        void *m_Map { nullptr };
+        size_t m_MapSize { 0 };
+        uint32_t m_Bands { 0 };
+        const uint32_t *m_BandStart { nullptr };
+        const uint32_t *m_TileStart { nullptr };
+        const Record *m_Records { nullptr };
+
+        // Most recently used tiles first
+        typedef std::list<std::pair<uint32_t, std::vector<Star>>> TileList;
+        TileList m_Tiles;
+        std::unordered_map<uint32_t, TileList::iterator> m_TileIndex;
+        std::mutex m_Lock;
+};
@@ -0,0 +1,138 @@
+/*******************************************************************************
+  Copyright(c) 2026 INDI Library Contributors. All rights reserved.
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+// Make the star catalog the CCD simulator reads, see star_catalog.h
+
+#include "star_catalog.h"
+
+#include "locale_compat.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage: indi_star_catalog [-g magnitude] catalog\n"
+            "Writes a star catalog for the CCD simulator.\n"
+            "Stars are read from stdin, one per line, either as printed by gsc or as \"ra dec magnitude\"\n"
+            "in degrees.\n"
+            "  -g magnitude  query gsc for the whole sky down to this magnitude instead\n");
+    exit(1);
+}
+
+// Parse a line of gsc output or a plain position, skip anything else
+static bool parseStar(const char *line, std::unordered_set<std::string> &ids, StarCatalog::Star &star)
+{
+    char id[20], plate[6], ob[6];
+    float ra, dec, pose, mag, mage, dist;
+    int band, c, dir;
+
+    if (sscanf(line, "%19s %f %f %f %f %f %d %d %5s %5s %f %d", id, &ra, &dec, &pose, &mag, &mage, &band, &c, plate, ob,
+               &dist, &dir) == 12)
+    {
+        // gsc cones overlap, and a star has one entry per plate it was measured on
+        if (!ids.insert(id).second)
+            return false;
+    }
+    else if (sscanf(line, "%f %f %f", &ra, &dec, &mag) != 3)
+        return false;
+
+    star.ra  = ra;
+    star.dec = dec;
+    star.mag = mag;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    double gscLimit = NAN;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'g':
+                gscLimit = atof(optarg);
+                break;
+            default:
+                usage();
+        }
+    }
+    if (optind != argc - 1)
+        usage();
+
+    AutoCNumeric locale;
+    std::vector<StarCatalog::Star> stars;
+    std::unordered_set<std::string> ids;
+    StarCatalog::Star star;
+    char line[256];
+
+    if (std::isnan(gscLimit))
+    {
+        while (fgets(line, sizeof(line), stdin) != nullptr)
+            if (parseStar(line, ids, star))
+                stars.push_back(star);
+    }
+    else
+    {
+        // 10 degree cones, overlapping enough to cover the sky
+        for (double dec = -90; dec <= 90; dec += 10)
+        {
+            double step = std::min(360.0, 10.0 / std::max(cos(dec * M_PI / 180.0), 0.01));
+            for (double ra = 0; ra < 360; ra += step)
+            {
+                char gsccmd[250];
+                snprintf(gsccmd, sizeof(gsccmd), "gsc -c %8.6f %+8.6f -r %4.1f -m 0 %4.2f -n 1000000", ra, dec, 8.0 * 60,
+                         gscLimit);
+
+                FILE *pp = popen(gsccmd, "r");
+                if (pp == nullptr)
+                {
+                    fprintf(stderr, "Failed to run gsc, is it installed with appropriate environment variables set?\n");
+                    return 1;
+                }
+                while (fgets(line, sizeof(line), pp) != nullptr)
+                    if (parseStar(line, ids, star))
+                        stars.push_back(star);
+                pclose(pp);
+            }
+            fprintf(stderr, "Declination %+3.0f, %zu stars\n", dec, stars.size());
+        }
+    }
+
+    if (stars.empty())
+    {
+        fprintf(stderr, "No stars read\n");
+        return 1;
+    }
+
+    std::string error;
+    if (!StarCatalog::write(argv[optind], stars, error))
+    {
+        fprintf(stderr, "Failed to write %s: %s\n", argv[optind], error.c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "Wrote %zu stars to %s\n", stars.size(), argv[optind]);
+    return 0;
+}
@@ -27,7 +27,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301  USA
 #include "indicom.h"
 #include "indilogger.h"
 
+#include <chrono>
 #include <cstring>
+#include <string>
 #include <unistd.h>
 
 #ifndef _WIN32
@@ -55,6 +57,9 @@ unsigned int DBG_SCOPE = 8;
 /* Add mutex to communications */
 std::mutex lx200CommsLock;
 
+/* Pipelined transactions, protected by lx200CommsLock */
+static LX200PipelineStats pipelineStats;
+
 void setLX200Debug(const char *deviceName, unsigned int debug_level)
 {
     strncpy(lx200Name, deviceName, MAXINDIDEVICE);
@@ -77,6 +82,10 @@ int getCommandSexa(int fd, double *value, const char *cmd);
 int getCommandString(int fd, char *data, const char *cmd);
 /* Get Int */
 int getCommandInt(int fd, int *value, const char *cmd);
+/* Send several queries in one write and read their replies in order */
+int getCommandPipeline(int fd, LX200Query *queries, int count);
+/* Get RA and DEC in one round trip */
+int getLX200RADEC(int fd, double *ra, double *dec);
 /* Get tracking frequency */
 int getTrackFreq(int fd, double *value);
 /* Get site Latitude */
@@ -318,6 +327,94 @@ int getCommandInt(int fd, int *value, const char *cmd)
     return 0;
 }
 
+int getCommandPipeline(int fd, LX200Query *queries, int count)
+{
+    std::string cmds;
+    int error_type = TTY_OK;
+    int nbytes_write = 0, nbytes_read = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        cmds += queries[i].cmd;
+        queries[i].reply[0] = '\0';
+        queries[i].error    = TTY_OK;
+    }
+
+    DEBUGFDEVICE(lx200Name, DBG_SCOPE, "CMD <%s>", cmds.c_str());
+
+/* Add mutex */
+    std::unique_lock<std::mutex> guard(lx200CommsLock);
+
+    auto start = std::chrono::steady_clock::now();
+
+    tcflush(fd, TCIFLUSH);
+
+    if ((error_type = tty_write_string(fd, cmds.c_str(), &nbytes_write)) != TTY_OK)
+        return error_type;
+
+    // The replies come back in order, once one is lost the rest cannot be matched
+    for (int i = 0; i < count; i++)
+    {
+        LX200Query &query = queries[i];
+        long timeout_ms   = query.timeout_ms > 0 ? query.timeout_ms : LX200_TIMEOUT * 1000;
+
+        if (error_type == TTY_OK)
+            error_type = tty_nread_section_expanded(fd, query.reply, LX200_REPLY_MAX_LEN, '#', timeout_ms / 1000,
+                                                    (timeout_ms % 1000) * 1000, &nbytes_read);
+        query.error = error_type;
+
+        if (error_type != TTY_OK)
+        {
+            query.reply[0] = '\0';
+            continue;
+        }
+
+        query.reply[nbytes_read - 1] = '\0';
+        DEBUGFDEVICE(lx200Name, DBG_SCOPE, "RES <%s> %s", query.reply, query.cmd);
+    }
+
+    tcflush(fd, TCIFLUSH);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    pipelineStats.transactions++;
+    pipelineStats.queries += count;
+    pipelineStats.errors += (error_type != TTY_OK);
+    pipelineStats.last_ms = ms;
+    pipelineStats.average_ms += (ms - pipelineStats.average_ms) / pipelineStats.transactions;
+
+    DEBUGFDEVICE(lx200Name, DBG_SCOPE, "%d queries in %.1f ms", count, ms);
+
+    return error_type;
+}
+
+void getLX200PipelineStats(LX200PipelineStats *stats)
+{
+    std::unique_lock<std::mutex> guard(lx200CommsLock);
+    *stats = pipelineStats;
+}
+
+int getLX200RADEC(int fd, double *ra, double *dec)
+{
+    LX200Query queries[2] = {};
+    int error_type;
+
+    queries[0].cmd = ":GR#";
+    queries[1].cmd = ":GD#";
+
+    if ((error_type = getCommandPipeline(fd, queries, 2)) != TTY_OK)
+        return error_type;
+
+    if (f_scansexa(queries[0].reply, ra) || f_scansexa(queries[1].reply, dec))
+    {
+        DEBUGDEVICE(lx200Name, DBG_SCOPE, "Unable to parse response");
+        return -1;
+    }
+
+    DEBUGFDEVICE(lx200Name, DBG_SCOPE, "VAL [%g] [%g]", *ra, *dec);
+
+    return 0;
+}
+
 int getCommandString(int fd, char *data, const char *cmd)
 {
     char *term;
@@ -205,6 +205,34 @@ int getCommandSexa(int fd, double *value, const char *cmd);
 int getCommandString(int fd, char *data, const char *cmd);
 /* Get Int */
 int getCommandInt(int fd, int *value, const char *cmd);
+
+#define LX200_REPLY_MAX_LEN 64
+
+/* One query of a pipelined transaction */
+typedef struct
+{
+    const char *cmd;                  /* Query to send, its reply must end with '#' */
+    int timeout_ms;                   /* Time to wait for the reply, 0 for the default */
+    char reply[LX200_REPLY_MAX_LEN];  /* Reply without the '#' */
+    int error;                        /* TTY_OK, or the error reading this reply */
+} LX200Query;
+
+/* Counters of pipelined transactions */
+typedef struct
+{
+    unsigned long transactions;
+    unsigned long queries;
+    unsigned long errors;
+    double last_ms;                   /* Round trip of the last transaction */
+    double average_ms;
+} LX200PipelineStats;
+
+/* Send several queries in one write and read their replies in order. Return 0 or the first error */
+int getCommandPipeline(int fd, LX200Query *queries, int count);
+/* Get pipelining counters since startup */
+void getLX200PipelineStats(LX200PipelineStats *stats);
+/* Get RA and DEC in one round trip */
+int getLX200RADEC(int fd, double *ra, double *dec);
 /* Get tracking frequency */
 int getTrackFreq(int fd, double *value);
 /* Get site Latitude */
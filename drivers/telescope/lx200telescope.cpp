@@ -29,6 +29,7 @@
 
 #include <libnova/sidereal_time.h>
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <cstring>
@@ -39,6 +40,11 @@
 #define LX200_GENERIC_SLEWRATE 5        /* slew rate, degrees/s */
 #define SIDRATE  0.004178 /* sidereal rate, degrees/s */
 
+/* Pipelined polling */
+#define PIPELINE_RETRY_POLLS     30   /* clean polls before trying pipelined queries again */
+#define PIPELINE_RETRY_MAX_POLLS 3600 /* the wait doubles each time the mount fails them again */
+#define PIPELINE_STATS_POLLS     10   /* polls between updates of the counters */
+
 LX200Telescope::LX200Telescope() : FI(this)
 {
 }
@@ -119,6 +125,14 @@ bool LX200Telescope::initProperties()
     IUFillText(&SiteNameT[0], "Name", "", "");
     IUFillTextVector(&SiteNameTP, SiteNameT, 1, getDeviceName(), "Site Name", "", SITE_TAB, IP_RW, 0, IPS_IDLE);
 
+    IUFillNumber(&PipelineStatsN[PIPELINE_TRANSACTIONS], "PIPELINE_TRANSACTIONS", "Transactions", "%.f", 0, 1e12, 0, 0);
+    IUFillNumber(&PipelineStatsN[PIPELINE_QUERIES], "PIPELINE_QUERIES", "Queries", "%.f", 0, 1e12, 0, 0);
+    IUFillNumber(&PipelineStatsN[PIPELINE_ERRORS], "PIPELINE_ERRORS", "Errors", "%.f", 0, 1e12, 0, 0);
+    IUFillNumber(&PipelineStatsN[PIPELINE_LAST_MS], "PIPELINE_LAST_MS", "Last (ms)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&PipelineStatsN[PIPELINE_AVERAGE_MS], "PIPELINE_AVERAGE_MS", "Average (ms)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&PipelineStatsNP, PipelineStatsN, 5, getDeviceName(), "PIPELINE_STATS", "Pipelined Polling",
+                       OPTIONS_TAB, IP_RO, 0, IPS_IDLE);
+
     if (genericCapability & LX200_HAS_FOCUS)
     {
         FI::SetCapability(FOCUSER_CAN_ABORT | FOCUSER_CAN_REVERSE | FOCUSER_HAS_VARIABLE_SPEED);
@@ -213,6 +227,7 @@ bool LX200Telescope::updateProperties()
 
         defineProperty(&GuideNSNP);
         defineProperty(&GuideWENP);
+        defineProperty(&PipelineStatsNP);
 
         if (genericCapability & LX200_HAS_FOCUS)
         {
@@ -220,6 +235,11 @@ bool LX200Telescope::updateProperties()
             //defineProperty(&FocusModeSP);
         }
 
+        // Give pipelined polling a fresh try on each connection
+        usePipelinedPolling = true;
+        pipelineCleanPolls  = 0;
+        pipelineRetryPolls  = PIPELINE_RETRY_POLLS;
+
         getBasicData();
     }
     else
@@ -241,6 +261,7 @@ bool LX200Telescope::updateProperties()
 
         deleteProperty(GuideNSNP.name);
         deleteProperty(GuideWENP.name);
+        deleteProperty(PipelineStatsNP.name);
 
         if (genericCapability & LX200_HAS_FOCUS)
         {
@@ -306,7 +327,7 @@ bool LX200Telescope::ReadScopeStatus()
         }
     }
 
-    if (getLX200RA(PortFD, &currentRA) < 0 || getLX200DEC(PortFD, &currentDEC) < 0)
+    if (!readRADEC())
     {
         EqNP.s = IPS_ALERT;
         IDSetNumber(&EqNP, "Error reading RA/DEC.");
@@ -1049,6 +1070,60 @@ void LX200Telescope::updateFocusTimer()
     IDSetNumber(&FocusTimerNP, nullptr);
 }
 
+bool LX200Telescope::readRADEC()
+{
+    // Ask for both coordinates at once, unless the mount cannot take queued queries
+    if (usePipelinedPolling)
+    {
+        bool ok = getLX200RADEC(PortFD, &currentRA, &currentDEC) == 0;
+        updatePipelineStats();
+        if (ok)
+        {
+            pipelineRetryPolls = PIPELINE_RETRY_POLLS;
+            return true;
+        }
+
+        LOGF_WARN("Mount did not answer pipelined queries, querying RA/DEC one at a time for %d polls.",
+                  pipelineRetryPolls);
+        usePipelinedPolling = false;
+        pipelineCleanPolls  = 0;
+    }
+
+    if (getLX200RA(PortFD, &currentRA) < 0 || getLX200DEC(PortFD, &currentDEC) < 0)
+    {
+        pipelineCleanPolls = 0;
+        return false;
+    }
+
+    // The failure may have been a glitch on the line, try again once the link has been clean for a while
+    if (++pipelineCleanPolls >= pipelineRetryPolls)
+    {
+        LOG_DEBUG("Trying pipelined RA/DEC queries again.");
+        usePipelinedPolling = true;
+        pipelineRetryPolls  = std::min(pipelineRetryPolls * 2, PIPELINE_RETRY_MAX_POLLS);
+    }
+
+    return true;
+}
+
+void LX200Telescope::updatePipelineStats()
+{
+    LX200PipelineStats stats;
+    getLX200PipelineStats(&stats);
+
+    // Every error right away, the rest every few polls
+    if (stats.errors == PipelineStatsN[PIPELINE_ERRORS].value && stats.transactions % PIPELINE_STATS_POLLS != 0)
+        return;
+
+    PipelineStatsN[PIPELINE_TRANSACTIONS].value = stats.transactions;
+    PipelineStatsN[PIPELINE_QUERIES].value      = stats.queries;
+    PipelineStatsN[PIPELINE_ERRORS].value       = stats.errors;
+    PipelineStatsN[PIPELINE_LAST_MS].value      = stats.last_ms;
+    PipelineStatsN[PIPELINE_AVERAGE_MS].value   = stats.average_ms;
+    PipelineStatsNP.s = IPS_OK;
+    IDSetNumber(&PipelineStatsNP, nullptr);
+}
+
 void LX200Telescope::mountSim()
 {
     static struct timeval ltv;
@@ -149,6 +149,11 @@ class LX200Telescope : public INDI::Telescope, public INDI::GuiderInterface, pub
         // Simulate Mount in simulation mode
         void mountSim();
 
+        // Poll RA and DEC, pipelined when the mount takes it
+        bool readRADEC();
+        // Send the pipelining counters to the client
+        void updatePipelineStats();
+
         // Focus functions
         static void updateFocusHelper(void *p);
         virtual bool AbortFocuser () override;
@@ -171,6 +176,11 @@ class LX200Telescope : public INDI::Telescope, public INDI::GuiderInterface, pub
         int trackingMode {0};
 
         bool sendTimeOnStartup = true, sendLocationOnStartup = true;
+        // Cleared when the mount does not answer several queries sent together, set again on connection
+        // and after pipelineRetryPolls clean polls one query at a time
+        bool usePipelinedPolling = true;
+        int pipelineCleanPolls {0};
+        int pipelineRetryPolls {0};
         uint8_t DBG_SCOPE {0};
 
         double JD {0};
@@ -203,6 +213,18 @@ class LX200Telescope : public INDI::Telescope, public INDI::GuiderInterface, pub
         ISwitchVectorProperty FocusModeSP;
         ISwitch FocusModeS[3];
 
+        /* Pipelined polling counters */
+        INumberVectorProperty PipelineStatsNP;
+        INumber PipelineStatsN[5];
+        enum
+        {
+            PIPELINE_TRANSACTIONS,
+            PIPELINE_QUERIES,
+            PIPELINE_ERRORS,
+            PIPELINE_LAST_MS,
+            PIPELINE_AVERAGE_MS,
+        };
+
         uint32_t genericCapability {0};
 };
 
@@ -29,6 +29,14 @@
  * work procedures may be registered that are called when there is nothing
  *   else to do;
  *
+ * timers are kept in a binary heap ordered by trigger time on the monotonic
+ *   clock, with a hash from timer id to node, so adding, removing and firing
+ *   a timer is O(log n) whatever the number of timers. nodes are recycled.
+ *
+ * on Linux, callback fds are watched with epoll so there is no set of fds to
+ *   rebuild on every loop, nor FD_SETSIZE limit. select() remains as the
+ *   fallback when epoll is not available.
+ *
  #define MAIN_TEST for a stand-alone test program.
  */
 
@@ -41,6 +49,12 @@
 #include <sys/types.h>
 #include <sys/time.h>
 
+#ifdef __linux__
+#define USE_EPOLL
+#include <errno.h>
+#include <sys/epoll.h>
+#endif
+
 #include "eventloop.h"
 #include "indidevapi.h"
 
@@ -60,23 +74,51 @@ static int ncback;   /* n entries in cback[] */
 static int ncbinuse; /* n entries in cback[] marked in_use */
 static int lastcb;   /* cback index of last cb called */
 
+/* info about one fd watched by callbacks, indexed by fd.
+ * the malloced array fdinfo is never shrunk.
+ */
+typedef struct
+{
+    int ncb;        /* n callbacks in use watching this fd */
+    int always;     /* epoll refused fd, a regular file, so it is always ready */
+    unsigned ready; /* == readystamp if fd was found ready in this loop */
+} FDI;
+static FDI *fdinfo;          /* malloced list of fd info */
+static int nfdinfo;          /* n entries in fdinfo[] */
+static unsigned readystamp;  /* bumped every time fds are checked */
+static fd_set rfdset;        /* ready fds when using select() */
+
+#ifdef USE_EPOLL
+#define MAXEVENTS 64 /* max epoll events handled per loop */
+static int epfd = -2; /* epoll instance, -1 to use select(), -2 until first needed */
+static int nalways;   /* n fds in fdinfo[] marked always */
+#endif
+
 /* info about one registered timer function.
- * the entries are kept sorted by increasing time from epoch, ie,
- *   the next entry to fire is at the begin of the list.
+ * active entries are kept in theap[], a binary min-heap ordered by trigger
+ *   time, ie, the next entry to fire is theap[0], and in tidhash[], an open
+ *   addressing hash of their ids. free entries are linked through next.
  */
 typedef struct TF
 {
-    double tgo;       /* trigger time, ms from epoch */
-    int interval;     /* repeat timer if interval > 0, ms */
-    void *ud;         /* user's data handle */
-    TCF *fp;          /* timer function */
-    int tid;          /* unique id for this timer */
-    struct TF *next;  /* pointer to next item */
+    double tgo;         /* trigger time, ms on the monotonic clock */
+    int interval;       /* repeat timer if interval > 0, ms */
+    void *ud;           /* user's data handle */
+    TCF *fp;            /* timer function */
+    int tid;            /* unique id for this timer */
+    int hidx;           /* index in theap[] */
+    unsigned long seq;  /* order of insertion, among timers of same tgo */
+    struct TF *next;    /* next free entry */
 } TF;
-static TF  timefunc_null = {0, 0, NULL, NULL, 0, NULL};
-static TF *timefunc = &timefunc_null;  /* list of timer functions */
-static int tid = 0;    /* source of unique timer ids */
-#define EPOCHDT(tp) /* ms from epoch to timeval *tp */ (((tp)->tv_usec) / 1000.0 + ((tp)->tv_sec) * 1000.0)
+#define TFCHUNK 64             /* entries malloced at once */
+static TF *tffree;             /* list of free entries */
+static TF **theap;             /* malloced heap of active entries */
+static int ntheap;             /* n entries in theap[] */
+static int maxtheap;           /* n entries malloced in theap[] */
+static TF **tidhash;           /* malloced hash of active entries by tid */
+static int ntidhash;           /* n slots in tidhash[], a power of 2 */
+static int tid = 0;            /* source of unique timer ids */
+static unsigned long tseq = 0; /* source of insertion order */
 
 /* info about one registered work procedure.
  * the malloced array wproc is never shrunk, entries are reused. new id's are
@@ -94,7 +136,7 @@ static int nwpinuse; /* n entries in wproc[] marked in-use */
 static int lastwp;   /* wproc index of last workproc called*/
 
 static void runWorkProc(void);
-static void callCallback(fd_set *rfdp);
+static void callCallback(void);
 static void checkTimer();
 static void oneLoop(void);
 static void deferTO(void *p);
@@ -155,6 +197,92 @@ int deferLoop0(int maxms, int *flagp)
     return (0);
 }
 
+#ifdef USE_EPOLL
+/* create the epoll instance used by oneLoop().
+ * leave epfd at -1, and so fall back to select(), if not supported.
+ */
+static void initEpoll(void)
+{
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+        perror("epoll_create1");
+}
+
+/* start watching fd with epoll. */
+static void epollAdd(int fd)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events  = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        if (errno == EPERM && !fdinfo[fd].always)
+        {
+            fdinfo[fd].always = 1;
+            nalways++;
+        }
+        else if (errno != EEXIST && errno != EPERM)
+            perror("epoll_ctl");
+    }
+}
+
+/* start over with a new epoll instance watching the fds that have callbacks.
+ * an fd closed before its callbacks were removed stays in epoll as long as a
+ *   dup or a child keeps its file open, and can no longer be removed by fd.
+ */
+static void rebuildEpoll(void)
+{
+    int fd;
+
+    close(epfd);
+    initEpoll();
+    for (fd = 0; epfd >= 0 && fd < nfdinfo; fd++)
+        if (fdinfo[fd].ncb > 0)
+            epollAdd(fd);
+}
+#endif
+
+/* count one more callback watching fd, and start watching it if it is the first. */
+static void watchFd(int fd)
+{
+    if (fd >= nfdinfo)
+    {
+        fdinfo = (FDI *)realloc(fdinfo, (fd + 1) * sizeof(FDI));
+        memset(&fdinfo[nfdinfo], 0, (fd + 1 - nfdinfo) * sizeof(FDI));
+        nfdinfo = fd + 1;
+    }
+    fdinfo[fd].ncb++;
+
+#ifdef USE_EPOLL
+    if (epfd == -2)
+        initEpoll();
+    /* add even if already counted: the fd may have been closed, and so
+     * dropped by epoll, then reused before its callbacks were removed.
+     */
+    if (epfd >= 0)
+        epollAdd(fd);
+#endif
+}
+
+/* count one less callback watching fd, and stop watching it if it was the last. */
+static void unwatchFd(int fd)
+{
+    if (--fdinfo[fd].ncb > 0)
+        return;
+
+#ifdef USE_EPOLL
+    if (fdinfo[fd].always)
+    {
+        fdinfo[fd].always = 0;
+        nalways--;
+    }
+    /* fails harmlessly if fd is already closed */
+    if (epfd >= 0)
+        (void)epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+}
+
 /* register a new callback, fp, to be called with ud as arg when fd is ready.
  * return a unique callback id for use with rmCallback().
  */
@@ -179,6 +307,8 @@ int addCallback(int fd, CBF *fp, void *ud)
     cp->fd     = fd;
     ncbinuse++;
 
+    watchFd(fd);
+
     /* id is index into array */
     return (cp - cback);
 }
@@ -200,47 +330,196 @@ void rmCallback(int cid)
     /* mark for reuse */
     cp->in_use = 0;
     ncbinuse--;
+
+    unwatchFd(cp->fd);
 }
 
-/* insert maintaining sort */
-static void insertTimer(TF *node)
+/* ms now on the monotonic clock */
+static double nowMs(void)
 {
-    TF *it = timefunc;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
 
-    for(; ; it = it->next)
+/* whether timer a fires before timer b */
+static int timerBefore(const TF *a, const TF *b)
+{
+    return a->tgo < b->tgo || (a->tgo == b->tgo && a->seq < b->seq);
+}
+
+/* put node at theap[i] */
+static void heapSet(int i, TF *node)
+{
+    theap[i]   = node;
+    node->hidx = i;
+}
+
+/* move node up the heap to its place */
+static void heapUp(TF *node)
+{
+    int i = node->hidx;
+    while (i > 0)
     {
-        if (it->next == NULL || node->tgo < it->next->tgo)
-        {
-            node->next = it->next;
-            it->next = node;
+        int parent = (i - 1) / 2;
+
+        if (!timerBefore(node, theap[parent]))
+            break;
+        heapSet(i, theap[parent]);
+        i = parent;
+    }
+    heapSet(i, node);
+}
+
+/* move node down the heap to its place */
+static void heapDown(TF *node)
+{
+    int i = node->hidx;
+    for (;;)
+    {
+        int child = 2 * i + 1;
+
+        if (child >= ntheap)
+            break;
+        if (child + 1 < ntheap && timerBefore(theap[child + 1], theap[child]))
+            child++;
+        if (!timerBefore(theap[child], node))
+            break;
+        heapSet(i, theap[child]);
+        i = child;
+    }
+    heapSet(i, node);
+}
+
+static void heapInsert(TF *node)
+{
+    if (ntheap == maxtheap)
+    {
+        maxtheap = maxtheap ? 2 * maxtheap : TFCHUNK;
+        theap    = (TF **)realloc(theap, maxtheap * sizeof(TF *));
+    }
+    node->hidx = ntheap++;
+    heapUp(node);
+}
+
+static void heapRemove(TF *node)
+{
+    TF *last = theap[--ntheap];
+    if (last == node)
+        return;
+    heapSet(node->hidx, last);
+    heapUp(last);
+    heapDown(last);
+}
+
+/* tidhash[] slot where timer_id is or would go */
+static int hashSlot(int timer_id)
+{
+    int i = timer_id & (ntidhash - 1);
+    while (tidhash[i] != NULL && tidhash[i]->tid != timer_id)
+        i = (i + 1) & (ntidhash - 1);
+    return i;
+}
+
+static void hashInsert(TF *node)
+{
+    /* keep the hash at most half full */
+    if (2 * (ntheap + 1) > ntidhash)
+    {
+        TF **old = tidhash;
+        int nold = ntidhash;
+        int i;
+
+        ntidhash = ntidhash ? 2 * ntidhash : 2 * TFCHUNK;
+        tidhash  = (TF **)calloc(ntidhash, sizeof(TF *));
+        for (i = 0; i < nold; i++)
+            if (old[i] != NULL)
+                tidhash[hashSlot(old[i]->tid)] = old[i];
+        free(old);
+    }
+    tidhash[hashSlot(node->tid)] = node;
+}
+
+static void hashRemove(TF *node)
+{
+    int mask = ntidhash - 1;
+    int i    = hashSlot(node->tid);
+    int j    = i;
+    int k;
+
+    /* close the gap, moving back entries that probed past it */
+    tidhash[i] = NULL;
+    for (;;)
+    {
+        j = (j + 1) & mask;
+        if (tidhash[j] == NULL)
             break;
+        k = tidhash[j]->tid & mask;
+        if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j))
+        {
+            tidhash[i] = tidhash[j];
+            tidhash[j] = NULL;
+            i          = j;
         }
     }
 }
 
-/* register a new timer function, fp, to be called with ud as arg after ms
- * milliseconds. add to list in order of increasing time from epoch, ie,
- * first entry runs soonest. return id for use with rmTimer().
- */
-static int addTimerImpl(int delay, int interval, TCF *fp, void *ud)
+/* find the timer by id */
+static TF *findTimer(int timer_id)
+{
+    if (ntidhash == 0)
+        return NULL;
+    return tidhash[hashSlot(timer_id)];
+}
+
+/* take a free entry, mallocing a chunk of them if none left */
+static TF *allocTimer(void)
 {
-    struct timeval t;
     TF *node;
 
-    /* get time now */
-    gettimeofday(&t, NULL);
+    if (tffree == NULL)
+    {
+        TF *chunk = (TF *)malloc(TFCHUNK * sizeof(TF));
+        int i;
+
+        for (i = 0; i < TFCHUNK; i++)
+        {
+            chunk[i].next = tffree;
+            tffree        = &chunk[i];
+        }
+    }
+
+    node   = tffree;
+    tffree = node->next;
+    return node;
+}
+
+/* remove the timer from the heap and hash, and recycle it */
+static void freeTimer(TF *node)
+{
+    hashRemove(node);
+    heapRemove(node);
+    node->next = tffree;
+    tffree     = node;
+}
 
-    /* create entry */
-    node = (TF*)malloc(sizeof(TF));
+/* register a new timer function, fp, to be called with ud as arg after ms
+ * milliseconds. return id for use with rmTimer().
+ */
+static int addTimerImpl(int delay, int interval, TCF *fp, void *ud)
+{
+    TF *node = allocTimer();
 
     /* init new entry */
     node->ud  = ud;
     node->fp  = fp;
     node->tid = ++tid; /* store new unique id */
-    node->tgo = EPOCHDT(&t) + delay;
+    node->tgo = nowMs() + delay;
+    node->seq = ++tseq;
     node->interval = interval;
 
-    insertTimer(node);
+    hashInsert(node);
+    heapInsert(node);
 
     return node->tid;
 }
@@ -255,54 +534,20 @@ int addPeriodicTimer(int ms, TCF *fp, void *ud)
     return addTimerImpl(ms, ms, fp, ud);
 }
 
-/* find the timer and remove from list */
-static TF *dettachTimer(TF *node)
-{
-    TF *it = timefunc;
-    for(; it->next != NULL; it = it->next)
-    {
-        if (it->next == node)
-        {
-            it->next = node->next;
-            return node;
-        }
-    }
-    return NULL;
-}
-
-/* find the timer by id */
-static TF *findTimer(int timer_id)
-{
-    TF *it = timefunc->next;
-    for(; it != NULL; it = it->next)
-        if (it->tid == timer_id)
-            return it;
-    return NULL;
-}
-
 /* remove the timer with the given id, as returned from addTimer().
  * silently ignore if id not found.
  */
 void rmTimer(int timer_id)
 {
-    TF *node, *it = timefunc;
-    for(; (node = it->next) != NULL; it = it->next)
-    {
-        if (node->tid == timer_id)
-        {
-            it->next = node->next;
-            free(node);
-            break;
-        }
-    }
+    TF *node = findTimer(timer_id);
+    if (node != NULL)
+        freeTimer(node);
 }
 
 /* Returns the timer's remaining value in milliseconds left until the timeout. */
 static double remainingTimerNode(TF *node)
 {
-    struct timeval now;
-    gettimeofday(&now, NULL);
-    return (node->tgo - EPOCHDT(&now));
+    return (node->tgo - nowMs());
 }
 
 /* Returns the timer's remaining value in milliseconds left until the timeout.
@@ -389,94 +634,166 @@ static void runWorkProc()
     (*wp->fp)(wp->ud);
 }
 
-/* run next callback whose fd is listed as ready to go in rfdp */
-static void callCallback(fd_set *rfdp)
+/* whether the fd of cp was found ready by oneLoop() */
+static int cbReady(CB *cp)
+{
+#ifdef USE_EPOLL
+    if (epfd >= 0)
+        return fdinfo[cp->fd].ready == readystamp;
+#endif
+    return FD_ISSET(cp->fd, &rfdset);
+}
+
+/* run next callback whose fd was found ready */
+static void callCallback()
 {
     CB *cp;
+    int n;
 
     /* skip if list is empty */
     if (!ncbinuse)
         return;
 
-    /* find next */
-    do
+    /* find next, a timer may have removed all those that were ready */
+    for (n = 0; n < ncback; n++)
     {
         lastcb = (lastcb + 1) % ncback;
         cp     = &cback[lastcb];
-    } while (!cp->in_use || !FD_ISSET(cp->fd, rfdp));
-
-    /* run */
-    (*cp->fp)(cp->fd, cp->ud);
+        if (cp->in_use && cbReady(cp))
+        {
+            /* run */
+            (*cp->fp)(cp->fd, cp->ud);
+            return;
+        }
+    }
 }
 
 /* run the next timer callback whose time has come, if any. all we have to do
- * is is check the first entry in timefunc because it is sorted in increasing
- * order of time from epoch to run, ie, first entry runs soonest.
+ * is is check theap[0] because it is the entry that runs soonest.
  */
 static void checkTimer()
 {
-    TF *node = timefunc->next;
+    TF *node;
+    int timer_id;
 
-    if (node == NULL || remainingTimerNode(node) > 0)
+    if (ntheap == 0 || remainingTimerNode(theap[0]) > 0)
         return;
 
+    node     = theap[0];
+    timer_id = node->tid;
     (*node->fp)(node->ud);
 
-    node = dettachTimer(node);
-
+    /* the callback may have removed it, and its entry be reused since */
+    node = findTimer(timer_id);
     if (node == NULL)
         return;
 
     if (node->interval > 0)
     {
         node->tgo += node->interval;
-        insertTimer(node);
+        node->seq = ++tseq;
+        heapDown(node);
     } else {
-        free(node);
+        freeTimer(node);
     }
 }
 
-/* check fd's from each active callback.
- * if any ready, call their callbacks else call each registered work procedure.
+/* ms until the soonest timer is due, 0 if it is late, -1 if there is none */
+static double timerDelay()
+{
+    double late;
+
+    if (ntheap == 0)
+        return -1;
+    late = remainingTimerNode(theap[0]);
+    return late < 0 ? 0 : late;
+}
+
+#ifdef USE_EPOLL
+/* wait with epoll for the ready fds, mark them in fdinfo[].
+ * return n fds ready, 0 if timed out, -1 on error.
  */
-static void oneLoop()
+static int waitEpoll()
+{
+    struct epoll_event evs[MAXEVENTS];
+    double delay;
+    int ns, nstale, i, timeout;
+
+    /* determine timeout, see oneLoop().
+     * rounded up, waking before the timer is due would only spin.
+     */
+    if (nwpinuse > 0 || nalways > 0)
+        timeout = 0;
+    else if ((delay = timerDelay()) >= 0)
+        timeout = (int)ceil(delay);
+    else
+        timeout = -1;
+
+    ns = epoll_wait(epfd, evs, MAXEVENTS, timeout);
+    if (ns < 0)
+    {
+        if (errno != EINTR)
+            perror("epoll_wait");
+        return -1;
+    }
+
+    readystamp++;
+    for (i = 0, nstale = 0; i < ns; i++)
+    {
+        if (fdinfo[evs[i].data.fd].ncb > 0)
+            fdinfo[evs[i].data.fd].ready = readystamp;
+        else
+            nstale++;
+    }
+    /* left over from a closed fd, it would be reported again and again */
+    if (nstale > 0)
+    {
+        rebuildEpoll();
+        ns -= nstale;
+    }
+    for (i = 0; nalways > 0 && i < nfdinfo; i++)
+    {
+        if (fdinfo[i].always)
+        {
+            fdinfo[i].ready = readystamp;
+            ns++;
+        }
+    }
+    return ns;
+}
+#endif
+
+/* wait with select for the ready fds, left in rfdset.
+ * return n fds ready, 0 if timed out, -1 on error.
+ */
+static int waitSelect()
 {
     struct timeval tv, *tvp;
-    fd_set rfd;
     CB *cp;
     int maxfd, ns;
+    double late;
 
     /* build list of callback file descriptors to check */
-    FD_ZERO(&rfd);
+    FD_ZERO(&rfdset);
     maxfd = -1;
     for (cp = cback; cp < &cback[ncback]; cp++)
     {
         if (cp->in_use)
         {
-            FD_SET(cp->fd, &rfd);
+            FD_SET(cp->fd, &rfdset);
             if (cp->fd > maxfd)
                 maxfd = cp->fd;
         }
     }
 
-    /* determine timeout:
-	 * if there are work procs
-	 *   set delay = 0
-	 * else if there is at least one timer func
-	 *   set delay = time until soonest timer func expires
-	 * else
-	 *   set delay = forever
-	 */
+    /* determine timeout, see oneLoop() */
     if (nwpinuse > 0)
     {
         tvp         = &tv;
         tvp->tv_sec = tvp->tv_usec = 0;
     }
-    else if (timefunc->next != NULL)
+    else if ((late = timerDelay()) >= 0)
     {
-        double late = remainingTimerNode(timefunc->next); /* ms late */
-        if (late < 0)
-            late = 0;
         late /= 1000.0; /* secs late */
         tvp          = &tv;
         tvp->tv_sec  = (long)floor(late);
@@ -486,19 +803,45 @@ static void oneLoop()
         tvp = NULL;
 
     /* check file descriptors, timeout depending on pending work */
-    ns = select(maxfd + 1, &rfd, NULL, NULL, tvp);
+    ns = select(maxfd + 1, &rfdset, NULL, NULL, tvp);
     if (ns < 0)
-    {
         perror("select");
+    return ns;
+}
+
+/* check fd's from each active callback.
+ * if any ready, call their callbacks else call each registered work procedure.
+ *
+ * the wait times out:
+ * if there are work procs
+ *   at once
+ * else if there is at least one timer func
+ *   when the soonest timer func expires
+ * else
+ *   never
+ */
+static void oneLoop()
+{
+    int ns;
+
+#ifdef USE_EPOLL
+    if (epfd == -2)
+        initEpoll();
+    if (epfd >= 0)
+        ns = waitEpoll();
+    else
+#endif
+        ns = waitSelect();
+
+    if (ns < 0)
         return;
-    }
 
     /* dispatch */
     checkTimer();
     if (ns == 0)
         runWorkProc();
     else
-        callCallback(&rfd);
+        callCallback();
 }
 
 /* timer callback used to implement deferLoop().
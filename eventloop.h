@@ -67,6 +67,8 @@ extern int addCallback(int fd, CBF *fp, void *ud);
 /** Remove a callback function.
 *
 * \param cid the callback ID returned from addCallback().
+* \note Remove it before closing its fd. Otherwise, if the fd was shared with a child or dup()ed, the loop
+* starts over with a new epoll set to stop hearing about it.
 */
 extern void rmCallback(int cid);
 
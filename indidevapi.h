@@ -322,6 +322,7 @@ extern int IEAddCallback(int readfiledes, IE_CBF *fp, void *userpointer);
 /** \brief Remove a callback function.
 *
 * \param callbackid the callback ID returned from IEAddCallback()
+* \note Remove it before closing its file descriptor, see rmCallback().
 */
 extern void IERmCallback(int callbackid);
 
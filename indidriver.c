@@ -32,6 +32,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301  USA
 #include "locale_compat.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -44,8 +46,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301  USA
 
 #include "userio.h"
 #include "indiuserio.h"
+#include "sharedblob.h"
 
 static pthread_mutex_t stdout_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t blob_mutex   = PTHREAD_MUTEX_INITIALIZER; /* one BLOB upload at a time */
+static pthread_cond_t held_cond    = PTHREAD_COND_INITIALIZER;  /* held_fp closed or emptied */
+static FILE *held_fp;       /* other messages while a BLOB upload has stdout */
+static char *held_buf;      /* their text */
+static size_t held_len;
+#define MAXHELD (1024 * 1024) /* max bytes held back, then writers wait for the upload */
 int verbose;      /* chatty */
 char *me = "";  /* a.out name */
 
@@ -107,6 +116,27 @@ static void rosc_add_unique(const char *propName, const char *devName, IPerm per
         rosc_add(propName, devName, perm, ptr, type);
 }
 
+/* lock stdout_mutex and return where to write a message to the client. this
+ * is stdout, unless a BLOB is being uploaded in which case the message is held
+ * back and sent right after it, so other threads do not wait for the upload.
+ * once MAXHELD bytes are held, as when a slow client makes the upload last,
+ * further writers wait for the upload to end like they would for stdout.
+ */
+static FILE *output_lock()
+{
+    pthread_mutex_lock(&stdout_mutex);
+    while (held_fp && held_len >= MAXHELD)
+        pthread_cond_wait(&held_cond, &stdout_mutex);
+    return held_fp ? held_fp : stdout;
+}
+
+/* finish a message started with output_lock() */
+static void output_unlock(FILE *out)
+{
+    fflush(out);
+    pthread_mutex_unlock(&stdout_mutex);
+}
+
 /* tell Client to delete the property with given name on given device, or
  * entire device if !name
  */
@@ -114,13 +144,12 @@ void IDDeleteVA(const char *dev, const char *name, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
 
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIODeleteVA(io, stdout, dev, name, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIODeleteVA(io, out, dev, name, fmt, ap);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDDelete(const char *dev, const char *name, const char *fmt, ...)
@@ -141,13 +170,12 @@ void IDSnoopDevice(const char *snooped_device, const char *snooped_property)
     {
         const userio *io = userio_file();
 
-        pthread_mutex_lock(&stdout_mutex);
+        FILE *out = output_lock();
 
-        userio_xmlv1(io, stdout);
-        IUUserIOGetProperties(io, stdout, snooped_device, snooped_property);
-        fflush(stdout);
+        userio_xmlv1(io, out);
+        IUUserIOGetProperties(io, out, snooped_device, snooped_property);
 
-        pthread_mutex_unlock(&stdout_mutex);
+        output_unlock(out);
     }
 }
 
@@ -158,16 +186,44 @@ void IDSnoopBLOBs(const char *snooped_device, const char *snooped_property, BLOB
 {
     const userio *io = userio_file();
 
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIOEnableBLOB(io, stdout, snooped_device, snooped_property, bh);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIOEnableBLOB(io, out, snooped_device, snooped_property, bh);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 /* Update property switches in accord with states and names. */
+/* Clients send the members in the order they were defined, so member i is checked before searching */
+static ISwitch *IUFindSwitchAt(const ISwitchVectorProperty *svp, char *names[], int i)
+{
+    if (i < svp->nsp && !strcmp(svp->sp[i].name, names[i]))
+        return &svp->sp[i];
+    return IUFindSwitch(svp, names[i]);
+}
+
+static INumber *IUFindNumberAt(const INumberVectorProperty *nvp, char *names[], int i)
+{
+    if (i < nvp->nnp && !strcmp(nvp->np[i].name, names[i]))
+        return &nvp->np[i];
+    return IUFindNumber(nvp, names[i]);
+}
+
+static IText *IUFindTextAt(const ITextVectorProperty *tvp, char *names[], int i)
+{
+    if (i < tvp->ntp && !strcmp(tvp->tp[i].name, names[i]))
+        return &tvp->tp[i];
+    return IUFindText(tvp, names[i]);
+}
+
+static IBLOB *IUFindBLOBAt(const IBLOBVectorProperty *bvp, char *names[], int i)
+{
+    if (i < bvp->nbp && !strcmp(bvp->bp[i].name, names[i]))
+        return &bvp->bp[i];
+    return IUFindBLOB(bvp, names[i]);
+}
+
 int IUUpdateSwitch(ISwitchVectorProperty *svp, ISState *states, char *names[], int n)
 {
     ISwitch *so = NULL; // On switch pointer
@@ -183,7 +239,7 @@ int IUUpdateSwitch(ISwitchVectorProperty *svp, ISState *states, char *names[], i
 
     for (int i = 0; i < n; i++)
     {
-        ISwitch *sp = IUFindSwitch(svp, names[i]);
+        ISwitch *sp = IUFindSwitchAt(svp, names, i);
 
         if (!sp)
         {
@@ -228,7 +284,7 @@ int IUUpdateNumber(INumberVectorProperty *nvp, double values[], char *names[], i
 
     for (int i = 0; i < n; i++)
     {
-        INumber *np = IUFindNumber(nvp, names[i]);
+        INumber *np = IUFindNumberAt(nvp, names, i);
         if (!np)
         {
             nvp->s = IPS_IDLE;
@@ -248,7 +304,7 @@ int IUUpdateNumber(INumberVectorProperty *nvp, double values[], char *names[], i
     /* First loop checks for error, second loop set all values atomically*/
     for (int i = 0; i < n; i++)
     {
-        INumber *np = IUFindNumber(nvp, names[i]);
+        INumber *np = IUFindNumberAt(nvp, names, i);
         np->value = values[i];
     }
 
@@ -262,7 +318,7 @@ int IUUpdateText(ITextVectorProperty *tvp, char *texts[], char *names[], int n)
 
     for (int i = 0; i < n; i++)
     {
-        IText *tp = IUFindText(tvp, names[i]);
+        IText *tp = IUFindTextAt(tvp, names, i);
         if (!tp)
         {
             tvp->s = IPS_IDLE;
@@ -274,7 +330,7 @@ int IUUpdateText(ITextVectorProperty *tvp, char *texts[], char *names[], int n)
     /* First loop checks for error, second loop set all values atomically*/
     for (int i = 0; i < n; i++)
     {
-        IText *tp = IUFindText(tvp, names[i]);
+        IText *tp = IUFindTextAt(tvp, names, i);
         IUSaveText(tp, texts[i]);
     }
 
@@ -289,7 +345,7 @@ int IUUpdateBLOB(IBLOBVectorProperty *bvp, int sizes[], int blobsizes[], char *b
 
     for (int i = 0; i < n; i++)
     {
-        IBLOB *bp = IUFindBLOB(bvp, names[i]);
+        IBLOB *bp = IUFindBLOBAt(bvp, names, i);
         if (!bp)
         {
             bvp->s = IPS_IDLE;
@@ -301,7 +357,7 @@ int IUUpdateBLOB(IBLOBVectorProperty *bvp, int sizes[], int blobsizes[], char *b
     /* First loop checks for error, second loop set all values atomically*/
     for (int i = 0; i < n; i++)
     {
-        IBLOB *bp = IUFindBLOB(bvp, names[i]);
+        IBLOB *bp = IUFindBLOBAt(bvp, names, i);
         IUSaveBLOB(bp, sizes[i], blobsizes[i], blobs[i], formats[i]);
     }
 
@@ -1041,17 +1097,283 @@ int dispatch(XMLEle *root, char msg[])
     return (1);
 }
 
+/* Parsed configuration files, so looking up a property does not read and parse the whole file again.
+ * A tree is reparsed when the file changes on disk, and dropped when it is written through this API.
+ * Trees are only used with config_mutex held, and never handed out.
+ */
+typedef struct ConfigCache
+{
+    char path[MAXRBUF];
+    dev_t device;    /* stamp of the parsed file */
+    ino_t inode;
+    off_t size;
+    struct timespec mtime;
+    XMLEle *root;
+    XMLEle **index;  /* open addressing on device and name, first of each */
+    unsigned mask;
+    struct ConfigCache *next;
+} ConfigCache;
+
+static ConfigCache *configCaches = NULL;
+static pthread_mutex_t config_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void configPath(char configFileName[MAXRBUF], const char *filename, const char *dev)
+{
+    if (filename)
+        strncpy(configFileName, filename, MAXRBUF - 1);
+    else if (getenv("INDICONFIG"))
+        strncpy(configFileName, getenv("INDICONFIG"), MAXRBUF - 1);
+    else
+        snprintf(configFileName, MAXRBUF, "%s/.indi/%s_config.xml", getenv("HOME"), dev);
+    configFileName[MAXRBUF - 1] = '\0';
+}
+
+/* The file a save replaces: what a symlinked configuration points to, so the link survives */
+static void configTarget(char target[MAXRBUF], const char *filename, const char *dev)
+{
+    char resolved[PATH_MAX];
+
+    configPath(target, filename, dev);
+    if (realpath(target, resolved) != NULL && strlen(resolved) < MAXRBUF)
+        strcpy(target, resolved);
+}
+
+/* Make a rename in the directory of path durable, best effort */
+static void configSyncDir(const char *path)
+{
+    char dir[MAXRBUF];
+    const char *slash = strrchr(path, '/');
+
+    if (slash == NULL)
+        strcpy(dir, ".");
+    else if (slash == path)
+        strcpy(dir, "/");
+    else
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+/* Nanoseconds, a file rewritten to the same size within a second must still be reparsed */
+#ifdef __APPLE__
+#define CONFIG_MTIME(st) ((st).st_mtimespec)
+#else
+#define CONFIG_MTIME(st) ((st).st_mtim)
+#endif
+
+static int configSameTime(const struct timespec *a, const struct timespec *b)
+{
+    return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+static unsigned configHash(const char *dev, const char *name)
+{
+    unsigned h = 2166136261u;
+    for (; *dev; dev++)
+        h = (h ^ (unsigned char)*dev) * 16777619u;
+    h = (h ^ 0xff) * 16777619u;
+    for (; *name; name++)
+        h = (h ^ (unsigned char)*name) * 16777619u;
+    return h;
+}
+
+static void configDrop(ConfigCache *cc)
+{
+    delXMLEle(cc->root);
+    free(cc->index);
+    cc->root  = NULL;
+    cc->index = NULL;
+    cc->mask  = 0;
+}
+
+/* Forget the parsed file, it is being written */
+static void configInvalidate(const char *path)
+{
+    pthread_mutex_lock(&config_mutex);
+    for (ConfigCache *cc = configCaches; cc != NULL; cc = cc->next)
+        if (!strcmp(cc->path, path))
+            configDrop(cc);
+    pthread_mutex_unlock(&config_mutex);
+}
+
+/* Parsed configuration file, reparsed if it changed. Call with config_mutex held */
+static ConfigCache *configLoad(const char *filename, const char *dev, char errmsg[])
+{
+    char path[MAXRBUF];
+    struct stat st;
+    ConfigCache *cc;
+
+    configPath(path, filename, dev);
+
+    for (cc = configCaches; cc != NULL; cc = cc->next)
+        if (!strcmp(cc->path, path))
+            break;
+
+    if (cc != NULL && cc->root != NULL && stat(path, &st) == 0 && st.st_dev == cc->device &&
+            st.st_ino == cc->inode && st.st_size == cc->size && configSameTime(&CONFIG_MTIME(st), &cc->mtime))
+        return cc;
+
+    if (cc == NULL)
+    {
+        assert_mem(cc = (ConfigCache *)calloc(1, sizeof(*cc)));
+        strcpy(cc->path, path);
+        cc->next     = configCaches;
+        configCaches = cc;
+    }
+    configDrop(cc);
+
+    FILE *fp = IUGetConfigFP(path, dev, "r", errmsg);
+    if (fp == NULL)
+        return NULL;
+
+    LilXML *lp = newLilXML();
+    char whynot[MAXRBUF];
+    fstat(fileno(fp), &st);
+    cc->root = readXMLFile(fp, lp, whynot);
+    delLilXML(lp);
+    fclose(fp);
+
+    if (cc->root == NULL)
+    {
+        snprintf(errmsg, MAXRBUF, "Unable to parse config XML: %s", whynot);
+        return NULL;
+    }
+
+    cc->device = st.st_dev;
+    cc->inode  = st.st_ino;
+    cc->size   = st.st_size;
+    cc->mtime  = CONFIG_MTIME(st);
+
+    cc->mask = 15;
+    while (cc->mask < 2u * nXMLEle(cc->root))
+        cc->mask = cc->mask * 2 + 1;
+    assert_mem(cc->index = (XMLEle **)calloc(cc->mask + 1, sizeof(XMLEle *)));
+
+    for (XMLEle *ep = nextXMLEle(cc->root, 1); ep != NULL; ep = nextXMLEle(cc->root, 0))
+    {
+        char *rdev, *rname;
+        if (crackDN(ep, &rdev, &rname, NULL) < 0)
+            continue;
+
+        unsigned i = configHash(rdev, rname) & cc->mask;
+        while (cc->index[i] != NULL && (strcmp(findXMLAttValu(cc->index[i], "device"), rdev) ||
+                                        strcmp(findXMLAttValu(cc->index[i], "name"), rname)))
+            i = (i + 1) & cc->mask;
+        if (cc->index[i] == NULL)
+            cc->index[i] = ep;
+    }
+
+    return cc;
+}
+
+/* Saved property of dev, the first one if property is NULL. Call with config_mutex held */
+static XMLEle *configFind(ConfigCache *cc, const char *dev, const char *property)
+{
+    if (property == NULL)
+    {
+        for (XMLEle *ep = nextXMLEle(cc->root, 1); ep != NULL; ep = nextXMLEle(cc->root, 0))
+            if (!strcmp(findXMLAttValu(ep, "device"), dev))
+                return ep;
+        return NULL;
+    }
+
+    for (unsigned i = configHash(dev, property) & cc->mask; cc->index[i] != NULL; i = (i + 1) & cc->mask)
+    {
+        if (!strcmp(findXMLAttValu(cc->index[i], "device"), dev) &&
+                !strcmp(findXMLAttValu(cc->index[i], "name"), property))
+            return cc->index[i];
+    }
+
+    return NULL;
+}
+
+/* Stand alone copy of a cached element, for use outside config_mutex */
+static XMLEle *configCopy(XMLEle *ep)
+{
+    int len   = sprlXMLEle(ep, 0);
+    char *buf = (char *)malloc(len + 1);
+    char errmsg[MAXRBUF];
+    XMLEle *copy = NULL;
+
+    assert_mem(buf);
+    sprXMLEle(buf, ep, 0);
+
+    LilXML *lp     = newLilXML();
+    XMLEle **nodes = parseXMLChunk(lp, buf, len, errmsg);
+    if (nodes != NULL)
+    {
+        copy = nodes[0];
+        for (int i = 1; copy != NULL && nodes[i] != NULL; i++)
+            delXMLEle(nodes[i]);
+        free(nodes);
+    }
+    delLilXML(lp);
+    free(buf);
+
+    return copy;
+}
+
+/* Member of a saved property, NULL if either is missing. Call with config_mutex held */
+static XMLEle *configFindMember(const char *dev, const char *property, const char *member)
+{
+    char errmsg[MAXRBUF];
+    ConfigCache *cc = configLoad(NULL, dev, errmsg);
+    XMLEle *root    = cc ? configFind(cc, dev, property) : NULL;
+
+    if (root == NULL)
+        return NULL;
+
+    for (XMLEle *ep = nextXMLEle(root, 1); ep != NULL; ep = nextXMLEle(root, 0))
+        if (!strcmp(member, findXMLAttValu(ep, "name")))
+            return ep;
+
+    return NULL;
+}
+
 int IUReadConfig(const char *filename, const char *dev, const char *property, int silent, char errmsg[])
 {
     char *rname, *rdev;
     XMLEle *root = NULL, *fproot = NULL;
-    LilXML *lp = newLilXML();
+
+    if (property != NULL)
+    {
+        /* dispatch a copy, the driver may read or save its config while handling it */
+        pthread_mutex_lock(&config_mutex);
+        ConfigCache *cc = configLoad(filename, dev, errmsg);
+        int loading     = cc != NULL && nXMLEle(cc->root) > 0 && silent != 1;
+        root = cc ? configFind(cc, dev, property) : NULL;
+        root = root ? configCopy(root) : NULL;
+        pthread_mutex_unlock(&config_mutex);
+
+        if (cc == NULL)
+            return -1;
+
+        if (loading)
+            IDMessage(dev, "[INFO] Loading device configuration...");
+
+        if (root != NULL)
+        {
+            dispatch(root, errmsg);
+            delXMLEle(root);
+        }
+
+        if (loading)
+            IDMessage(dev, "[INFO] Device configuration applied.");
+
+        return (0);
+    }
 
     FILE *fp = IUGetConfigFP(filename, dev, "r", errmsg);
 
     if (fp == NULL)
         return -1;
 
+    LilXML *lp = newLilXML();
     char whynot[MAXRBUF];
     fproot = readXMLFile(fp, lp, whynot);
 
@@ -1081,12 +1403,7 @@ int IUReadConfig(const char *filename, const char *dev, const char *property, in
         if (strcmp(dev, rdev))
             continue;
 
-        if ((property && !strcmp(property, rname)) || property == NULL)
-        {
-            dispatch(root, errmsg);
-            if (property)
-                break;
-        }
+        dispatch(root, errmsg);
     }
 
     if (nXMLEle(fproot) > 0 && silent != 1)
@@ -1150,294 +1467,103 @@ int IUSaveDefaultConfig(const char *source_config, const char *dest_config, cons
 
 int IUGetConfigOnSwitch(const ISwitchVectorProperty *property, int *index)
 {
-    char *rname, *rdev;
-    XMLEle *root = NULL, *fproot = NULL;
     char errmsg[MAXRBUF];
-    LilXML *lp = newLilXML();
     int propertyFound = 0;
     *index = -1;
 
-    FILE *fp = IUGetConfigFP(NULL, property->device, "r", errmsg);
+    pthread_mutex_lock(&config_mutex);
+    ConfigCache *cc = configLoad(NULL, property->device, errmsg);
+    XMLEle *root    = cc ? configFind(cc, property->device, property->name) : NULL;
 
-    if (fp == NULL)
-        return -1;
-
-    fproot = readXMLFile(fp, lp, errmsg);
-
-    if (fproot == NULL)
+    if (root != NULL)
     {
-        fclose(fp);
-        return -1;
-    }
-
-    for (root = nextXMLEle(fproot, 1); root != NULL; root = nextXMLEle(fproot, 0))
-    {
-        /* pull out device and name */
-        if (crackDN(root, &rdev, &rname, errmsg) < 0)
-        {
-            fclose(fp);
-            delXMLEle(fproot);
-            return -1;
-        }
-
-        // It doesn't belong to our device??
-        if (strcmp(property->device, rdev))
-            continue;
-
-        if (!strcmp(property->name, rname))
+        propertyFound = 1;
+        XMLEle *oneSwitch = NULL;
+        int oneSwitchIndex = 0;
+        ISState oneSwitchState;
+        for (oneSwitch = nextXMLEle(root, 1); oneSwitch != NULL; oneSwitch = nextXMLEle(root, 0), oneSwitchIndex++)
         {
-            propertyFound = 1;
-            XMLEle *oneSwitch = NULL;
-            int oneSwitchIndex = 0;
-            ISState oneSwitchState;
-            for (oneSwitch = nextXMLEle(root, 1); oneSwitch != NULL; oneSwitch = nextXMLEle(root, 0), oneSwitchIndex++)
+            if (crackISState(pcdataXMLEle(oneSwitch), &oneSwitchState) == 0 && oneSwitchState == ISS_ON)
             {
-                if (crackISState(pcdataXMLEle(oneSwitch), &oneSwitchState) == 0 && oneSwitchState == ISS_ON)
-                {
-                    *index = oneSwitchIndex;
-                    break;
-                }
+                *index = oneSwitchIndex;
+                break;
             }
-            break;
         }
     }
-
-    fclose(fp);
-    delXMLEle(fproot);
-    delLilXML(lp);
+    pthread_mutex_unlock(&config_mutex);
 
     return (propertyFound ? 0 : -1);
 }
 
 int IUGetConfigSwitch(const char *dev, const char *property, const char *member, ISState *value)
 {
-    char *rname, *rdev;
-    XMLEle *root = NULL, *fproot = NULL;
-    char errmsg[MAXRBUF];
-    LilXML *lp = newLilXML();
     int valueFound = 0;
 
-    FILE *fp = IUGetConfigFP(NULL, dev, "r", errmsg);
-
-    if (fp == NULL)
-        return -1;
-
-    fproot = readXMLFile(fp, lp, errmsg);
-
-    if (fproot == NULL)
-    {
-        fclose(fp);
-        return -1;
-    }
-
-    for (root = nextXMLEle(fproot, 1); root != NULL; root = nextXMLEle(fproot, 0))
-    {
-        /* pull out device and name */
-        if (crackDN(root, &rdev, &rname, errmsg) < 0)
-        {
-            fclose(fp);
-            delXMLEle(fproot);
-            return -1;
-        }
-
-        // It doesn't belong to our device??
-        if (strcmp(dev, rdev))
-            continue;
-
-        if ((property && !strcmp(property, rname)) || property == NULL)
-        {
-            XMLEle *oneSwitch = NULL;
-            for (oneSwitch = nextXMLEle(root, 1); oneSwitch != NULL; oneSwitch = nextXMLEle(root, 0))
-            {
-                if (!strcmp(member, findXMLAttValu(oneSwitch, "name")))
-                {
-                    if (crackISState(pcdataXMLEle(oneSwitch), value) == 0)
-                        valueFound = 1;
-                    break;
-                }
-            }
-            break;
-        }
-    }
-
-    fclose(fp);
-    delXMLEle(fproot);
-    delLilXML(lp);
+    pthread_mutex_lock(&config_mutex);
+    XMLEle *oneSwitch = configFindMember(dev, property, member);
+    if (oneSwitch != NULL && crackISState(pcdataXMLEle(oneSwitch), value) == 0)
+        valueFound = 1;
+    pthread_mutex_unlock(&config_mutex);
 
     return (valueFound == 1 ? 0 : -1);
 }
 
 int IUGetConfigOnSwitchIndex(const char *dev, const char *property, int *index)
 {
-    char *rname, *rdev;
-    XMLEle *root = NULL, *fproot = NULL;
     char errmsg[MAXRBUF];
-    LilXML *lp = newLilXML();
     *index = -1;
 
-    FILE *fp = IUGetConfigFP(NULL, dev, "r", errmsg);
-
-    if (fp == NULL)
-        return -1;
-
-    fproot = readXMLFile(fp, lp, errmsg);
-
-    if (fproot == NULL)
-    {
-        fclose(fp);
-        return -1;
-    }
+    pthread_mutex_lock(&config_mutex);
+    ConfigCache *cc = configLoad(NULL, dev, errmsg);
+    XMLEle *root    = cc ? configFind(cc, dev, property) : NULL;
 
-    for (root = nextXMLEle(fproot, 1); root != NULL; root = nextXMLEle(fproot, 0))
+    if (root != NULL)
     {
-        /* pull out device and name */
-        if (crackDN(root, &rdev, &rname, errmsg) < 0)
+        XMLEle *oneSwitch = NULL;
+        int currentIndex = 0;
+        for (oneSwitch = nextXMLEle(root, 1); oneSwitch != NULL; oneSwitch = nextXMLEle(root, 0), currentIndex++)
         {
-            fclose(fp);
-            delXMLEle(fproot);
-            return -1;
-        }
-
-        // It doesn't belong to our device??
-        if (strcmp(dev, rdev))
-            continue;
-
-        if ((property && !strcmp(property, rname)) || property == NULL)
-        {
-            XMLEle *oneSwitch = NULL;
-            int currentIndex = 0;
-            for (oneSwitch = nextXMLEle(root, 1); oneSwitch != NULL; oneSwitch = nextXMLEle(root, 0), currentIndex++)
+            ISState s = ISS_OFF;
+            if (crackISState(pcdataXMLEle(oneSwitch), &s) == 0 && s == ISS_ON)
             {
-                ISState s = ISS_OFF;
-                if (crackISState(pcdataXMLEle(oneSwitch), &s) == 0 && s == ISS_ON)
-                {
-                    *index = currentIndex;
-                    break;
-                }
+                *index = currentIndex;
+                break;
             }
-            break;
         }
     }
-
-    fclose(fp);
-    delXMLEle(fproot);
-    delLilXML(lp);
+    pthread_mutex_unlock(&config_mutex);
 
     return (*index >= 0 ? 0 : -1);
 }
 
 int IUGetConfigNumber(const char *dev, const char *property, const char *member, double *value)
 {
-    char *rname, *rdev;
-    XMLEle *root = NULL, *fproot = NULL;
-    char errmsg[MAXRBUF];
-    LilXML *lp = newLilXML();
     int valueFound = 0;
 
-    FILE *fp = IUGetConfigFP(NULL, dev, "r", errmsg);
-
-    if (fp == NULL)
-        return -1;
-
-    fproot = readXMLFile(fp, lp, errmsg);
-
-    if (fproot == NULL)
-    {
-        fclose(fp);
-        return -1;
-    }
-
-    for (root = nextXMLEle(fproot, 1); root != NULL; root = nextXMLEle(fproot, 0))
+    pthread_mutex_lock(&config_mutex);
+    XMLEle *oneNumber = configFindMember(dev, property, member);
+    if (oneNumber != NULL)
     {
-        /* pull out device and name */
-        if (crackDN(root, &rdev, &rname, errmsg) < 0)
-        {
-            fclose(fp);
-            delXMLEle(fproot);
-            return -1;
-        }
-
-        // It doesn't belong to our device??
-        if (strcmp(dev, rdev))
-            continue;
-
-        if ((property && !strcmp(property, rname)) || property == NULL)
-        {
-            XMLEle *oneNumber = NULL;
-            for (oneNumber = nextXMLEle(root, 1); oneNumber != NULL; oneNumber = nextXMLEle(root, 0))
-            {
-                if (!strcmp(member, findXMLAttValu(oneNumber, "name")))
-                {
-                    *value = atof(pcdataXMLEle(oneNumber));
-                    valueFound = 1;
-                    break;
-                }
-            }
-            break;
-        }
+        *value = atof(pcdataXMLEle(oneNumber));
+        valueFound = 1;
     }
-
-    fclose(fp);
-    delXMLEle(fproot);
-    delLilXML(lp);
+    pthread_mutex_unlock(&config_mutex);
 
     return (valueFound == 1 ? 0 : -1);
 }
 
 int IUGetConfigText(const char *dev, const char *property, const char *member, char *value, int len)
 {
-    char *rname, *rdev;
-    XMLEle *root = NULL, *fproot = NULL;
-    char errmsg[MAXRBUF];
-    LilXML *lp = newLilXML();
     int valueFound = 0;
 
-    FILE *fp = IUGetConfigFP(NULL, dev, "r", errmsg);
-
-    if (fp == NULL)
-        return -1;
-
-    fproot = readXMLFile(fp, lp, errmsg);
-
-    if (fproot == NULL)
-    {
-        fclose(fp);
-        return -1;
-    }
-
-    for (root = nextXMLEle(fproot, 1); root != NULL; root = nextXMLEle(fproot, 0))
+    pthread_mutex_lock(&config_mutex);
+    XMLEle *oneText = configFindMember(dev, property, member);
+    if (oneText != NULL)
     {
-        /* pull out device and name */
-        if (crackDN(root, &rdev, &rname, errmsg) < 0)
-        {
-            fclose(fp);
-            delXMLEle(fproot);
-            return -1;
-        }
-
-        // It doesn't belong to our device??
-        if (strcmp(dev, rdev))
-            continue;
-
-        if ((property && !strcmp(property, rname)) || property == NULL)
-        {
-            XMLEle *oneText = NULL;
-            for (oneText = nextXMLEle(root, 1); oneText != NULL; oneText = nextXMLEle(root, 0))
-            {
-                if (!strcmp(member, findXMLAttValu(oneText, "name")))
-                {
-                    strncpy(value, pcdataXMLEle(oneText), len);
-                    valueFound = 1;
-                    break;
-                }
-            }
-            break;
-        }
+        strncpy(value, pcdataXMLEle(oneText), len);
+        valueFound = 1;
     }
-
-    fclose(fp);
-    delXMLEle(fproot);
-    delLilXML(lp);
+    pthread_mutex_unlock(&config_mutex);
 
     return (valueFound == 1 ? 0 : -1);
 }
@@ -1447,15 +1573,13 @@ void IDMessageVA(const char *dev, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
 
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
+    userio_xmlv1(io, out);
 
-    IDUserIOMessageVA(io, stdout, dev, fmt, ap);
+    IDUserIOMessageVA(io, out, dev, fmt, ap);
 
-    fflush(stdout);
-
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDMessage(const char *dev, const char *fmt, ...)
@@ -1469,19 +1593,9 @@ void IDMessage(const char *dev, const char *fmt, ...)
 int IUPurgeConfig(const char *filename, const char *dev, char errmsg[])
 {
     char configFileName[MAXRBUF];
-    char configDir[MAXRBUF];
-
-    snprintf(configDir, MAXRBUF, "%s/.indi/", getenv("HOME"));
 
-    if (filename)
-        strncpy(configFileName, filename, MAXRBUF);
-    else
-    {
-        if (getenv("INDICONFIG"))
-            strncpy(configFileName, getenv("INDICONFIG"), MAXRBUF);
-        else
-            snprintf(configFileName, MAXRBUF, "%s%s_config.xml", configDir, dev);
-    }
+    configPath(configFileName, filename, dev);
+    configInvalidate(configFileName);
 
     if (remove(configFileName) != 0)
     {
@@ -1500,16 +1614,10 @@ FILE *IUGetConfigFP(const char *filename, const char *dev, const char *mode, cha
     FILE *fp = NULL;
 
     snprintf(configDir, MAXRBUF, "%s/.indi/", getenv("HOME"));
+    configPath(configFileName, filename, dev);
 
-    if (filename)
-        strncpy(configFileName, filename, MAXRBUF);
-    else
-    {
-        if (getenv("INDICONFIG"))
-            strncpy(configFileName, getenv("INDICONFIG"), MAXRBUF);
-        else
-            snprintf(configFileName, MAXRBUF, "%s%s_config.xml", configDir, dev);
-    }
+    if (strpbrk(mode, "wa+"))
+        configInvalidate(configFileName);
 
     if (stat(configDir, &st) != 0)
     {
@@ -1541,6 +1649,47 @@ FILE *IUGetConfigFP(const char *filename, const char *dev, const char *mode, cha
     return fp;
 }
 
+FILE *IUBeginConfigSave(const char *filename, const char *dev, char errmsg[])
+{
+    char tempFileName[MAXRBUF + 4];
+
+    configTarget(tempFileName, filename, dev);
+    strcat(tempFileName, ".tmp");
+
+    return IUGetConfigFP(tempFileName, dev, "w", errmsg);
+}
+
+int IUEndConfigSave(FILE *fp, const char *filename, const char *dev, char errmsg[])
+{
+    char configFileName[MAXRBUF], targetFileName[MAXRBUF], tempFileName[MAXRBUF + 4];
+    struct stat st;
+
+    configPath(configFileName, filename, dev);
+    configTarget(targetFileName, filename, dev);
+    snprintf(tempFileName, sizeof(tempFileName), "%s.tmp", targetFileName);
+    configInvalidate(configFileName);
+    configInvalidate(targetFileName);
+
+    /* keep the permissions of the file it replaces */
+    if (stat(targetFileName, &st) == 0)
+        fchmod(fileno(fp), st.st_mode & 07777);
+
+    /* the file only replaces the old one once all of it is on disk */
+    int failed = fflush(fp) != 0 || ferror(fp) || fsync(fileno(fp)) != 0;
+    failed = fclose(fp) != 0 || failed;
+
+    if (failed || rename(tempFileName, targetFileName) != 0)
+    {
+        snprintf(errmsg, MAXRBUF, "Unable to save config file %s: %s", configFileName, strerror(errno));
+        remove(tempFileName);
+        return -1;
+    }
+
+    configSyncDir(targetFileName);
+
+    return 0;
+}
+
 void IUSaveConfigTag(FILE *fp, int ctag, const char *dev, int silent)
 {
     if (!fp)
@@ -1567,16 +1716,15 @@ void IUSaveConfigTag(FILE *fp, int ctag, const char *dev, int silent)
 void IDDefTextVA(const ITextVectorProperty *tvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIODefTextVA(io, stdout, tvp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIODefTextVA(io, out, tvp, fmt, ap);
 
     /* Add this property to insure proper sanity check */
     rosc_add_unique(tvp->name, tvp->device, tvp->p, tvp, INDI_TEXT);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDDefText(const ITextVectorProperty *tvp, const char *fmt, ...)
@@ -1591,16 +1739,15 @@ void IDDefText(const ITextVectorProperty *tvp, const char *fmt, ...)
 void IDDefNumberVA(const INumberVectorProperty *nvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIODefNumberVA(io, stdout, nvp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIODefNumberVA(io, out, nvp, fmt, ap);
 
     /* Add this property to insure proper sanity check */
     rosc_add_unique(nvp->name, nvp->device, nvp->p, nvp, INDI_NUMBER);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDDefNumber(const INumberVectorProperty *nvp, const char *fmt, ...)
@@ -1615,16 +1762,15 @@ void IDDefNumber(const INumberVectorProperty *nvp, const char *fmt, ...)
 void IDDefSwitchVA(const ISwitchVectorProperty *svp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIODefSwitchVA(io, stdout, svp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIODefSwitchVA(io, out, svp, fmt, ap);
 
     /* Add this property to insure proper sanity check */
     rosc_add_unique(svp->name, svp->device, svp->p, svp, INDI_SWITCH);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDDefSwitch(const ISwitchVectorProperty *svp, const char *fmt, ...)
@@ -1639,13 +1785,12 @@ void IDDefSwitch(const ISwitchVectorProperty *svp, const char *fmt, ...)
 void IDDefLightVA(const ILightVectorProperty *lvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIODefLightVA(io, stdout, lvp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIODefLightVA(io, out, lvp, fmt, ap);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDDefLight(const ILightVectorProperty *lvp, const char *fmt, ...)
@@ -1660,16 +1805,15 @@ void IDDefLight(const ILightVectorProperty *lvp, const char *fmt, ...)
 void IDDefBLOBVA(const IBLOBVectorProperty *bvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIODefBLOBVA(io, stdout, bvp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIODefBLOBVA(io, out, bvp, fmt, ap);
 
     /* Add this property to insure proper sanity check */
     rosc_add_unique(bvp->name, bvp->device, bvp->p, bvp, INDI_BLOB);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDDefBLOB(const IBLOBVectorProperty *bvp, const char *fmt, ...)
@@ -1684,13 +1828,12 @@ void IDDefBLOB(const IBLOBVectorProperty *bvp, const char *fmt, ...)
 void IDSetTextVA(const ITextVectorProperty *tvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIOSetTextVA(io, stdout, tvp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIOSetTextVA(io, out, tvp, fmt, ap);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDSetText(const ITextVectorProperty *tvp, const char *fmt, ...)
@@ -1705,13 +1848,12 @@ void IDSetText(const ITextVectorProperty *tvp, const char *fmt, ...)
 void IDSetNumberVA(const INumberVectorProperty *nvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIOSetNumberVA(io, stdout, nvp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIOSetNumberVA(io, out, nvp, fmt, ap);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDSetNumber(const INumberVectorProperty *nvp, const char *fmt, ...)
@@ -1726,13 +1868,12 @@ void IDSetNumber(const INumberVectorProperty *nvp, const char *fmt, ...)
 void IDSetSwitchVA(const ISwitchVectorProperty *svp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIOSetSwitchVA(io, stdout, svp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIOSetSwitchVA(io, out, svp, fmt, ap);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDSetSwitch(const ISwitchVectorProperty *svp, const char *fmt, ...)
@@ -1747,13 +1888,12 @@ void IDSetSwitch(const ISwitchVectorProperty *svp, const char *fmt, ...)
 void IDSetLightVA(const ILightVectorProperty *lvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIOSetLightVA(io, stdout, lvp, fmt, ap);
-    fflush(stdout);
+    userio_xmlv1(io, out);
+    IUUserIOSetLightVA(io, out, lvp, fmt, ap);
 
-    pthread_mutex_unlock(&stdout_mutex);
+    output_unlock(out);
 }
 
 void IDSetLight(const ILightVectorProperty *lvp, const char *fmt, ...)
@@ -1764,17 +1904,72 @@ void IDSetLight(const ILightVectorProperty *lvp, const char *fmt, ...)
     va_end(ap);
 }
 
-/* tell client to update an existing BLOB vector property */
+/* tell client to update an existing BLOB vector property.
+ * BLOBs in buffers from IDSharedBlobAlloc() are handed to indiserver, if it
+ * takes them, instead of being encoded. blob_mutex keeps the segments in the
+ * same order as the messages claiming them.
+ * the message itself is written without stdout_mutex, while messages from
+ * other threads are held back until it is done.
+ */
 void IDSetBLOBVA(const IBLOBVectorProperty *bvp, const char *fmt, va_list ap)
 {
     const userio *io = userio_file();
+    int *attached    = NULL;
+    int encode       = 0;
+
+    pthread_mutex_lock(&blob_mutex);
+
+    for (int i = 0; i < bvp->nbp; i++)
+    {
+        IBLOB *bp = &bvp->bp[i];
+        if (bp->size == 0 || bp->bloblen == 0)
+            continue;
+        if (IDSharedBlobSend(bp->blob) < 0)
+        {
+            encode = 1;
+            continue;
+        }
+        if (attached == NULL)
+            attached = (int *)calloc(bvp->nbp, sizeof(int));
+        if (attached == NULL)
+        {
+            fprintf(stderr, "%s: Not enough memory.\n", __func__);
+            exit(1);
+        }
+        attached[i] = 1;
+    }
+
+    /* divert the others, unless this is only a small message anyway */
     pthread_mutex_lock(&stdout_mutex);
+    if (encode)
+        held_fp = open_memstream(&held_buf, &held_len);
+    if (held_fp)
+        pthread_mutex_unlock(&stdout_mutex);
 
     userio_xmlv1(io, stdout);
-    IUUserIOSetBLOBVA(io, stdout, bvp, fmt, ap);
+    if (attached)
+        IUUserIOSetBLOBAttachedVA(io, stdout, bvp, attached, fmt, ap);
+    else
+        IUUserIOSetBLOBVA(io, stdout, bvp, fmt, ap);
+
+    /* then send what they wrote meanwhile */
+    if (held_fp)
+    {
+        fflush(stdout);
+        pthread_mutex_lock(&stdout_mutex);
+        fclose(held_fp);
+        held_fp = NULL;
+        fwrite(held_buf, 1, held_len, stdout);
+        free(held_buf);
+        held_buf = NULL;
+        held_len = 0;
+        pthread_cond_broadcast(&held_cond);
+    }
     fflush(stdout);
 
     pthread_mutex_unlock(&stdout_mutex);
+    pthread_mutex_unlock(&blob_mutex);
+    free(attached);
 }
 
 void IDSetBLOB(const IBLOBVectorProperty *bvp, const char *fmt, ...)
@@ -1789,12 +1984,11 @@ void IDSetBLOB(const IBLOBVectorProperty *bvp, const char *fmt, ...)
 void IUUpdateMinMax(const INumberVectorProperty *nvp)
 {
     const userio *io = userio_file();
-    pthread_mutex_lock(&stdout_mutex);
+    FILE *out = output_lock();
 
-    userio_xmlv1(io, stdout);
-    IUUserIOUpdateMinMax(io, stdout, nvp);
-    fflush(stdout);
-    pthread_mutex_unlock(&stdout_mutex);
+    userio_xmlv1(io, out);
+    IUUserIOUpdateMinMax(io, out, nvp);
+    output_unlock(out);
 }
 
 int IUFindIndex(const char *needle, char **hay, unsigned int n)
@@ -80,6 +80,25 @@ be used as the configuration filename</li>
 */
 extern FILE *IUGetConfigFP(const char *filename, const char *dev, const char *mode, char errmsg[]);
 
+/** \brief Start writing a new configuration file, without touching the current one until IUEndConfigSave().
+    The contents go to a temporary file next to the configuration file, so an interrupted save cannot leave a truncated configuration behind.
+    \param filename full path of the configuration file, or NULL to generate it as described in the <b>Detailed Description</b> introduction.
+    \param dev device name. This is used if the filename parameter is NULL, and INDICONFIG environment variable is not set.
+    \param errmsg In case of errors, store the error message in this buffer. The size of the buffer must be at least MAXRBUF.
+    \return pointer to FILE to write the configuration to, otherwise NULL and errmsg is set.
+*/
+extern FILE *IUBeginConfigSave(const char *filename, const char *dev, char errmsg[]);
+
+/** \brief Finish a save started with IUBeginConfigSave(): close fp and replace the configuration file with it.
+    The new file keeps the permissions of the old one, and a symlinked configuration file stays a symlink to the replaced file.
+    \param fp file pointer returned by IUBeginConfigSave(). It is closed in all cases.
+    \param filename same as given to IUBeginConfigSave().
+    \param dev same as given to IUBeginConfigSave().
+    \param errmsg In case of errors, store the error message in this buffer. The size of the buffer must be at least MAXRBUF.
+    \return 0 on success, -1 on failure, in which case the previous configuration file is left as it was.
+*/
+extern int IUEndConfigSave(FILE *fp, const char *filename, const char *dev, char errmsg[]);
+
 /**
     \param filename full path of the configuration file. If set, it will be deleted from disk.
            If set to NULL, it will attempt to generate the filename as described in the <b>Detailed Description</b> introduction and then delete it.
@@ -32,6 +32,23 @@
  * 2017-01-29 JM: Added option to drop stream blobs if client blob queue is
  * higher than maxstreamsiz bytes
  *
+ * setBLOBVector messages from drivers are not parsed into XMLEle trees. Only
+ * their tags and attributes are looked at to route them, and the original
+ * bytes read from the driver are queued to clients as-is.
+ *
+ * Local drivers may hand over BLOBs as shared memory segments instead of
+ * base64 text, see libs/sharedblob.h. Such a oneBLOB is marked attached='true'
+ * and its segment arrives as a file descriptor on a datagram socket whose
+ * other end the driver finds in INDIBLOBFD. Clients on the local socket given
+ * with -u receive the segments the same way, along with the first byte of
+ * the message that refers to them. All others get the BLOBs base64 encoded
+ * from the segment, as if the driver had sent them so.
+ *
+ * On Linux, io readiness is gathered with epoll so each wakeup only touches
+ * the descriptors that are actually ready, and write interest is registered
+ * only while a Msg queue is non-empty. select() remains as the fallback when
+ * epoll is not available.
+ *
  * Implementation notes:
  *
  * We fork each driver and open a server socket listening for INDI clients.
@@ -41,13 +58,18 @@
  * one client or device, they are queued and only removed after the last
  * consumer is finished. XMLEle are converted to linear strings before being
  * sent to optimize write system calls and avoid blocking to slow clients.
- * Clients that get more than maxqsiz bytes behind are shut down.
+ * Several queued messages are sent with one writev, up to maxwsiz bytes, and
+ * writes never block so a slow client only takes what it can accept.
+ * Clients that get more than maxqsiz bytes behind are shut down. The bytes
+ * behind are kept up to date as messages are queued and sent, so message
+ * lengths are known before they are queued.
  */
 
 #define _GNU_SOURCE // needed for siginfo_t and sigaction
 
 #include "config.h"
 
+#include "base64.h"
 #include "fq.h"
 #include "indiapi.h"
 #include "indidevapi.h"
@@ -70,17 +92,34 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#ifdef __linux__
+#define USE_EPOLL
+#include <stdint.h>
+#include <sys/epoll.h>
+#endif
 
 #define INDIPORT      7624    /* default TCP/IP port to listen */
 #define REMOTEDVR     (-1234) /* invalid PID to flag remote drivers */
 #define MAXSBUF       512
 #define MAXRBUF       49152 /* max read buffering here */
-#define MAXWSIZ       49152 /* max bytes/write */
+#define MAXIOV        256   /* max Msgs sent per write */
 #define SHORTMSGSIZ   2048  /* buf size for most messages */
 #define DEFMAXQSIZ    128   /* default max q behind, MB */
 #define DEFMAXSSIZ    5     /* default max stream behind, MB */
 #define DEFMAXRESTART 10    /* default max restarts */
+#define DEFMAXWSIZ    1024  /* default max KB per write */
+#define MAXEVENTS     64    /* max epoll events handled per wakeup */
+#define BLOBTAG       "<setBLOBVector"  /* start of messages passed through raw */
+#define BLOBETAG      "</setBLOBVector" /* and their end */
+#define BLOBTAGLEN    (sizeof(BLOBTAG) - 1)
+#define BLOBETAGLEN   (sizeof(BLOBETAG) - 1)
+#define MAXBLOBFD     16    /* max attached BLOBs per message */
+#define BLOBFDNO      3     /* fd of the shared BLOB socket in local drivers */
 
 #ifdef OSX_EMBEDED_MODE
 #define LOGNAME  "/Users/%s/Library/Logs/indiserver.log"
@@ -88,11 +127,15 @@
 #endif
 
 /* associate a usage count with queuded client or device message */
-typedef struct
+typedef struct Msg
 {
     int count;         /* number of consumers left */
     unsigned long cl;  /* content length */
     char *cp;          /* content: buf or malloced */
+    int nfd;           /* n entries in fd[] */
+    int *fd;           /* malloced segments of attached BLOBs, in order */
+    size_t shmlen;     /* bytes used in all of fd[] */
+    struct Msg *inl;   /* copy with fd[] base64 encoded, while being routed */
     char buf[SHORTMSGSIZ];    /* local buf for most messages */
 } Msg;
 
@@ -127,9 +170,12 @@ typedef struct
     int allprops;       /* saw getProperties w/o device */
     BLOBHandling blob;  /* when to send setBLOBs */
     int s;              /* socket for this client */
+    int shm;            /* 1 if on usocket, then attached BLOBs are sent as fds */
     LilXML *lp;         /* XML parsing context */
     FQ *msgq;           /* Msg queue */
+    int qsize;          /* bytes behind in msgq, see msgQCharge() */
     unsigned int nsent; /* bytes of current Msg sent so far */
+    int wwatch;         /* 1 while write interest is registered */
 } ClInfo;
 static ClInfo *clinfo; /*  malloced pool of clients */
 static int nclinfo;    /* n total (not active) */
@@ -154,10 +200,19 @@ typedef struct
     int rfd;            /* read pipe fd */
     int wfd;            /* write pipe fd */
     int efd;            /* stderr from driver, if local */
+    int bfd;            /* shared BLOB segments from driver, if local */
     int restarts;       /* times process has been restarted */
     LilXML *lp;         /* XML parsing context */
     FQ *msgq;           /* Msg queue */
+    int qsize;          /* bytes behind in msgq, see msgQCharge() */
     unsigned int nsent; /* bytes of current Msg sent so far */
+    int wwatch;         /* 1 while write interest is registered */
+    char *bb;           /* raw setBLOBVector being collected, malloced */
+    size_t nbb;         /* bytes in bb */
+    size_t mbb;         /* bytes allocated for bb */
+    size_t sbb;         /* bytes of bb already scanned for the end */
+    char carry[BLOBTAGLEN]; /* possible start of BLOBTAG held for next read */
+    int ncarry;         /* bytes in carry[] */
 } DvrInfo;
 static DvrInfo *dvrinfo; /* malloced array of drivers */
 static int ndvrinfo;     /* n total */
@@ -166,12 +221,32 @@ static char *me;                                       /* our name */
 static int port = INDIPORT;                            /* public INDI port */
 static int verbose;                                    /* chattiness */
 static int lsocket;                                    /* listen socket */
+static int usocket = -1;                               /* local listen socket, if upath */
+static char *upath;                                    /* where to make usocket */
 static char *ldir;                                     /* where to log driver messages */
 static int maxqsiz       = (DEFMAXQSIZ * 1024 * 1024); /* kill if these bytes behind */
 static int maxstreamsiz  = (DEFMAXSSIZ * 1024 * 1024); /* drop blobs if these bytes behind while streaming*/
 static int maxrestarts   = DEFMAXRESTART;
+static int maxwsiz       = (DEFMAXWSIZ * 1024);         /* max bytes per write */
 static int terminateddrv = 0;
 
+#ifdef USE_EPOLL
+/* what an epoll event refers to, packed into epoll_data.u64 with the
+ * clinfo/dvrinfo index and the fd it was registered for.
+ */
+enum
+{
+    EV_LISTEN,   /* lsocket */
+    EV_ULISTEN,  /* usocket */
+    EV_FIFO,     /* fifo.fd */
+    EV_CLIENT,   /* ClInfo.s */
+    EV_DVR,      /* DvrInfo.rfd, also wfd for remote drivers */
+    EV_DVRWRITE, /* DvrInfo.wfd of local drivers */
+    EV_DVRERR    /* DvrInfo.efd */
+};
+static int epfd = -1; /* epoll instance, -1 to use select() */
+#endif
+
 static void logStartup(int ac, char *av[]);
 static void usage(void);
 //static void noZombies(void);
@@ -179,10 +254,20 @@ static void reapZombies(void);
 static void noSIGPIPE(void);
 static void indiFIFO(void);
 static void indiRun(void);
+#ifdef USE_EPOLL
+static void indiEpoll(void);
+static void indiRunEpoll(void);
+static void evAdd(int fd, uint32_t events, int kind, int idx);
+static void evMod(int fd, uint32_t events, int kind, int idx);
+static void evDel(int fd);
+#endif
+static void watchClient(ClInfo *cp);
+static void watchDvr(DvrInfo *dp);
 static void indiListen(void);
+static void indiUnixListen(void);
 static void newFIFO(void);
-static void newClient(void);
-static int newClSocket(void);
+static void newClient(int ls);
+static int newClSocket(int ls);
 static void shutdownClient(ClInfo *cp);
 static int readFromClient(ClInfo *cp);
 static void startDvr(DvrInfo *dp);
@@ -200,14 +285,33 @@ static Property *findSDevice(DvrInfo *dp, const char *dev, const char *name);
 static void addClDevice(ClInfo *cp, const char *dev, const char *name, int isblob);
 static int findClDevice(ClInfo *cp, const char *dev, const char *name);
 static int readFromDriver(DvrInfo *dp);
+static int parseFromDriver(DvrInfo *dp, char *buf, size_t n);
+static int xmlFromDriver(DvrInfo *dp, char *buf, size_t n, int *shutany);
+static int routeFromDriver(DvrInfo *dp, XMLEle *root, Msg *rmp);
+static int sendBLOBFromDriver(DvrInfo *dp, size_t len);
+static int attachBLOBs(DvrInfo *dp, XMLEle *root, Msg *mp);
+static int recvBLOBFd(int s);
+static void growBLOB(DvrInfo *dp, size_t more);
+static size_t findBLOBEnd(DvrInfo *dp);
+static void freeBLOB(DvrInfo *dp);
+static XMLEle *envelopeXMLEle(const char *raw, size_t len);
 static int stderrFromDriver(DvrInfo *dp);
-static int msgQSize(FQ *q);
+static void pushClientMsg(ClInfo *cp, Msg *mp);
+static void pushDriverMsg(DvrInfo *dp, Msg *mp);
+static int msgQCharge(Msg *mp);
+static void sizeMsgXMLEle(Msg *mp, XMLEle *root);
 static void setMsgXMLEle(Msg *mp, XMLEle *root);
 static void setMsgStr(Msg *mp, char *str);
 static void freeMsg(Msg *mp);
 static Msg *newMsg(void);
+static Msg *inlineMsg(Msg *mp);
+static size_t base64Lines(char *out, const unsigned char *in, size_t len);
 static int sendClientMsg(ClInfo *cp);
 static int sendDriverMsg(DvrInfo *cp);
+static int msgIOV(FQ *q, unsigned int nsent, struct iovec *iov);
+static ssize_t writeIOV(int fd, int issock, struct iovec *iov, int niov, Msg *fmp);
+static void traceIOV(const char *who, FQ *q, struct iovec *iov, int niov, ssize_t nw);
+static void msgSent(FQ *q, unsigned int *nsent, int *qsize, size_t nw);
 static void crackBLOB(const char *enableBLOB, BLOBHandling *bp);
 static void crackBLOBHandling(const char *dev, const char *name, const char *enableBLOB, ClInfo *cp);
 static void traceMsg(XMLEle *root);
@@ -288,6 +392,26 @@ int main(int ac, char *av[])
                     fifo.name = *++av;
                     ac--;
                     break;
+                case 'u':
+                    if (ac < 2)
+                    {
+                        fprintf(stderr, "-u requires local socket path\n");
+                        usage();
+                    }
+                    upath = *++av;
+                    ac--;
+                    break;
+                case 'w':
+                    if (ac < 2)
+                    {
+                        fprintf(stderr, "-w requires max KB per write\n");
+                        usage();
+                    }
+                    maxwsiz = 1024 * atoi(*++av);
+                    if (maxwsiz <= 0)
+                        maxwsiz = DEFMAXWSIZ * 1024;
+                    ac--;
+                    break;
                 case 'r':
                     if (ac < 2)
                     {
@@ -325,6 +449,11 @@ int main(int ac, char *av[])
     ndvrinfo = ac;
     dvrinfo  = (DvrInfo *)calloc(ndvrinfo, sizeof(DvrInfo));
 
+#ifdef USE_EPOLL
+    /* prepare the event engine before any fd is opened */
+    indiEpoll();
+#endif
+
     /* start each driver */
     while (ac-- > 0)
     {
@@ -372,6 +501,8 @@ static void usage(void)
             DEFMAXSSIZ);
     fprintf(stderr, " -p p     : alternate IP port, default %d\n", INDIPORT);
     fprintf(stderr, " -r r     : maximum driver restarts on error, default %d\n", DEFMAXRESTART);
+    fprintf(stderr, " -u path  : also listen on this local socket, clients there get shared BLOBs as fds\n");
+    fprintf(stderr, " -w k     : max KB sent to a client or driver per write, default %d\n", DEFMAXWSIZ);
     fprintf(stderr, " -f path  : Path to fifo for dynamic startup and shutdown of drivers.\n");
     fprintf(stderr, " -v       : show key events, no traffic\n");
     fprintf(stderr, " -vv      : -v + key message content\n");
@@ -480,7 +611,7 @@ static void startLocalDvr(DvrInfo *dp)
 {
     Msg *mp;
     char buf[32];
-    int rp[2], wp[2], ep[2];
+    int rp[2], wp[2], ep[2], bp[2];
     int pid;
 
 #ifdef OSX_EMBEDED_MODE
@@ -504,6 +635,11 @@ static void startLocalDvr(DvrInfo *dp)
         fprintf(stderr, "%s: stderr pipe: %s\n", indi_tstamp(NULL), strerror(errno));
         Bye();
     }
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, bp) < 0)
+    {
+        fprintf(stderr, "%s: BLOB socketpair: %s\n", indi_tstamp(NULL), strerror(errno));
+        Bye();
+    }
 
     /* fork&exec new process */
     pid = fork();
@@ -521,8 +657,11 @@ static void startLocalDvr(DvrInfo *dp)
         dup2(wp[0], 0); /* driver stdin reads from wp[0] */
         dup2(rp[1], 1); /* driver stdout writes to rp[1] */
         dup2(ep[1], 2); /* driver stderr writes to e[]1] */
-        for (fd = 3; fd < 100; fd++)
+        dup2(bp[1], BLOBFDNO); /* driver sends shared BLOBs to bp[1] */
+        for (fd = BLOBFDNO + 1; fd < 100; fd++)
             (void)close(fd);
+        snprintf(buf, sizeof(buf), "%d", BLOBFDNO);
+        setenv("INDIBLOBFD", buf, 1);
 
         if (*dp->envDev)
             setenv("INDIDEV", dp->envDev, 1);
@@ -580,6 +719,16 @@ static void startLocalDvr(DvrInfo *dp)
     close(wp[0]);
     close(rp[1]);
     close(ep[1]);
+    close(bp[1]);
+
+    /* our writes to the driver must never block, see writeIOV() */
+    fcntl(wp[1], F_SETFL, fcntl(wp[1], F_GETFL) | O_NONBLOCK);
+
+    /* segments are only looked for once their message is read, see
+     * attachBLOBs(), so they are always there already.
+     */
+    fcntl(bp[0], F_SETFL, fcntl(bp[0], F_GETFL) | O_NONBLOCK);
+    fcntl(bp[0], F_SETFD, FD_CLOEXEC);
 
     /* record pid, io channels, init lp and snoop list */
     dp->pid = pid;
@@ -588,6 +737,7 @@ static void startLocalDvr(DvrInfo *dp)
     dp->rfd     = rp[0];
     dp->wfd     = wp[1];
     dp->efd     = ep[0];
+    dp->bfd     = bp[0];
     dp->lp      = newLilXML();
     dp->msgq    = newFQ(1);
     dp->sprops  = (Property *)malloc(1); /* seed for realloc */
@@ -596,19 +746,26 @@ static void startLocalDvr(DvrInfo *dp)
     dp->active  = 1;
     dp->ndev    = 0;
     dp->dev     = (char **)malloc(sizeof(char *));
+    dp->wwatch  = 0;
+    dp->ncarry  = 0;
+    dp->qsize   = 0;
+
+#ifdef USE_EPOLL
+    evAdd(dp->rfd, EPOLLIN, EV_DVR, dp - dvrinfo);
+    evAdd(dp->efd, EPOLLIN, EV_DVRERR, dp - dvrinfo);
+#endif
 
     /* first message primes driver to report its properties -- dev known
      * if restarting
      */
     mp = newMsg();
-    pushFQ(dp->msgq, mp);
     snprintf(buf, sizeof(buf), "<getProperties version='%g'/>\n", INDIV);
     setMsgStr(mp, buf);
-    mp->count++;
+    pushDriverMsg(dp, mp);
 
     if (verbose > 0)
-        fprintf(stderr, "%s: Driver %s: pid=%d rfd=%d wfd=%d efd=%d\n", indi_tstamp(NULL), dp->name, dp->pid, dp->rfd,
-                dp->wfd, dp->efd);
+        fprintf(stderr, "%s: Driver %s: pid=%d rfd=%d wfd=%d efd=%d bfd=%d\n", indi_tstamp(NULL), dp->name, dp->pid,
+                dp->rfd, dp->wfd, dp->efd, dp->bfd);
 }
 
 /* start the given remote INDI driver connection.
@@ -643,6 +800,7 @@ static void startRemoteDvr(DvrInfo *dp)
     dp->port    = indi_port;
     dp->rfd     = sockfd;
     dp->wfd     = sockfd;
+    dp->bfd     = -1;
     dp->lp      = newLilXML();
     dp->msgq    = newFQ(1);
     dp->sprops  = (Property *)malloc(1); /* seed for realloc */
@@ -651,6 +809,13 @@ static void startRemoteDvr(DvrInfo *dp)
     dp->active  = 1;
     dp->ndev    = 1;
     dp->dev     = (char **)malloc(sizeof(char *));
+    dp->wwatch  = 0;
+    dp->ncarry  = 0;
+    dp->qsize   = 0;
+
+#ifdef USE_EPOLL
+    evAdd(dp->rfd, EPOLLIN, EV_DVR, dp - dvrinfo);
+#endif
 
     /* N.B. storing name now is key to limiting outbound traffic to this
      * dev.
@@ -663,7 +828,6 @@ static void startRemoteDvr(DvrInfo *dp)
      * outbound (and our inbound) traffic on this socket to this device.
      */
     mp = newMsg();
-    pushFQ(dp->msgq, mp);
     if (dev[0])
         sprintf(buf, "<getProperties device='%s' version='%g'/>\n", dp->dev[0], INDIV);
     else
@@ -672,7 +836,7 @@ static void startRemoteDvr(DvrInfo *dp)
         // among properties.
         sprintf(buf, "<getProperties device='*' version='%g'/>\n", INDIV);
     setMsgStr(mp, buf);
-    mp->count++;
+    pushDriverMsg(dp, mp);
 
     if (verbose > 0)
         fprintf(stderr, "%s: Driver %s: socket=%d\n", indi_tstamp(NULL), dp->name, sockfd);
@@ -769,13 +933,71 @@ static void indiListen()
 
     /* ok */
     lsocket = sfd;
+#ifdef USE_EPOLL
+    evAdd(lsocket, EPOLLIN, EV_LISTEN, 0);
+#endif
     if (verbose > 0)
         fprintf(stderr, "%s: listening to port %d on fd %d\n", indi_tstamp(NULL), port, sfd);
+
+    if (upath)
+        indiUnixListen();
+}
+
+/* create the local endpoint usocket at upath.
+ * exit if trouble.
+ */
+static void indiUnixListen()
+{
+    struct sockaddr_un serv_socket;
+    int sfd;
+
+    if (strlen(upath) >= sizeof(serv_socket.sun_path))
+    {
+        fprintf(stderr, "%s: %s: local socket path too long\n", indi_tstamp(NULL), upath);
+        Bye();
+    }
+
+    /* make socket endpoint */
+    if ((sfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    {
+        fprintf(stderr, "%s: socket: %s\n", indi_tstamp(NULL), strerror(errno));
+        Bye();
+    }
+
+    /* bind to path, replacing any left by an earlier run */
+    memset(&serv_socket, 0, sizeof(serv_socket));
+    serv_socket.sun_family = AF_UNIX;
+    strcpy(serv_socket.sun_path, upath);
+    (void)unlink(upath);
+    if (bind(sfd, (struct sockaddr *)&serv_socket, sizeof(serv_socket)) < 0)
+    {
+        fprintf(stderr, "%s: bind(%s): %s\n", indi_tstamp(NULL), upath, strerror(errno));
+        Bye();
+    }
+
+    /* willing to accept connections with a backlog of 5 pending */
+    if (listen(sfd, 5) < 0)
+    {
+        fprintf(stderr, "%s: listen: %s\n", indi_tstamp(NULL), strerror(errno));
+        Bye();
+    }
+
+    /* ok */
+    usocket = sfd;
+#ifdef USE_EPOLL
+    evAdd(usocket, EPOLLIN, EV_ULISTEN, 0);
+#endif
+    if (verbose > 0)
+        fprintf(stderr, "%s: listening to %s on fd %d\n", indi_tstamp(NULL), upath, sfd);
 }
 
 /* Attempt to open up FIFO */
 static void indiFIFO(void)
 {
+#ifdef USE_EPOLL
+    if (fifo.name && fifo.fd >= 0)
+        evDel(fifo.fd);
+#endif
     close(fifo.fd);
     fifo.fd = -1;
 
@@ -789,8 +1011,203 @@ static void indiFIFO(void)
             fprintf(stderr, "%s: open(%s): %s.\n", indi_tstamp(NULL), fifo.name, strerror(errno));
             Bye();
         }
+
+#ifdef USE_EPOLL
+        evAdd(fifo.fd, EPOLLIN, EV_FIFO, 0);
+#endif
+    }
+}
+
+#ifdef USE_EPOLL
+/* create the epoll instance used by indiRun().
+ * leave epfd at -1, and so fall back to select(), if not supported.
+ */
+static void indiEpoll(void)
+{
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+        fprintf(stderr, "%s: epoll_create1: %s, using select\n", indi_tstamp(NULL), strerror(errno));
+    else if (verbose > 0)
+        fprintf(stderr, "%s: using epoll on fd %d\n", indi_tstamp(NULL), epfd);
+}
+
+/* register fd with epfd for the given events.
+ * kind and idx tell indiRunEpoll() who owns fd.
+ */
+static void evAdd(int fd, uint32_t events, int kind, int idx)
+{
+    struct epoll_event ev;
+
+    if (epfd < 0)
+        return;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = events;
+    ev.data.u64 = ((uint64_t)kind << 56) | ((uint64_t)(idx & 0xffffff) << 32) | (uint32_t)fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        fprintf(stderr, "%s: epoll_ctl(ADD %d): %s\n", indi_tstamp(NULL), fd, strerror(errno));
+        Bye();
+    }
+}
+
+/* change the events of fd already registered with epfd */
+static void evMod(int fd, uint32_t events, int kind, int idx)
+{
+    struct epoll_event ev;
+
+    if (epfd < 0)
+        return;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events   = events;
+    ev.data.u64 = ((uint64_t)kind << 56) | ((uint64_t)(idx & 0xffffff) << 32) | (uint32_t)fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) < 0)
+    {
+        fprintf(stderr, "%s: epoll_ctl(MOD %d): %s\n", indi_tstamp(NULL), fd, strerror(errno));
+        Bye();
+    }
+}
+
+/* forget fd before it is closed.
+ * N.B. closing alone is not enough if a forked driver still holds a copy.
+ */
+static void evDel(int fd)
+{
+    if (epfd >= 0)
+        (void)epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+#endif
+
+/* make sure write interest for client cp is registered iff it has work to
+ * send. this is a no-op when using select() since indiRun() builds the write
+ * set from the queues each time.
+ */
+static void watchClient(ClInfo *cp)
+{
+#ifdef USE_EPOLL
+    int want = nFQ(cp->msgq) > 0;
+
+    if (epfd < 0 || !cp->active || want == cp->wwatch)
+        return;
+
+    evMod(cp->s, EPOLLIN | (want ? EPOLLOUT : 0), EV_CLIENT, cp - clinfo);
+    cp->wwatch = want;
+#else
+    INDI_UNUSED(cp);
+#endif
+}
+
+/* make sure write interest for driver dp is registered iff it has work to
+ * send. remote drivers share one socket for both directions so the read
+ * registration is modified, local drivers have wfd added and removed.
+ */
+static void watchDvr(DvrInfo *dp)
+{
+#ifdef USE_EPOLL
+    int want = nFQ(dp->msgq) > 0;
+
+    if (epfd < 0 || !dp->active || want == dp->wwatch)
+        return;
+
+    if (dp->wfd == dp->rfd)
+        evMod(dp->rfd, EPOLLIN | (want ? EPOLLOUT : 0), EV_DVR, dp - dvrinfo);
+    else if (want)
+        evAdd(dp->wfd, EPOLLOUT, EV_DVRWRITE, dp - dvrinfo);
+    else
+        evDel(dp->wfd);
+    dp->wwatch = want;
+#else
+    INDI_UNUSED(dp);
+#endif
+}
+
+#ifdef USE_EPOLL
+/* service traffic from clients and drivers using epoll.
+ * only the descriptors reported ready are visited. as with select, return
+ * as soon as anything was shut down so stale events are not acted upon; being
+ * level-triggered, whatever is left is reported again on the next call.
+ */
+static void indiRunEpoll(void)
+{
+    struct epoll_event evs[MAXEVENTS];
+    int i, n;
+
+    /* wait for action */
+    n = epoll_wait(epfd, evs, MAXEVENTS, -1);
+    if (n < 0)
+    {
+        if (errno == EINTR)
+            return;
+        fprintf(stderr, "%s: epoll_wait: %s\n", indi_tstamp(NULL), strerror(errno));
+        Bye();
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        uint32_t events = evs[i].events;
+        int kind        = (int)(evs[i].data.u64 >> 56);
+        int idx         = (int)((evs[i].data.u64 >> 32) & 0xffffff);
+        int fd          = (int)(evs[i].data.u64 & 0xffffffff);
+        int readable    = events & (EPOLLIN | EPOLLHUP | EPOLLERR);
+        ClInfo *cp;
+        DvrInfo *dp;
+
+        switch (kind)
+        {
+            /* new command from FIFO? */
+            case EV_FIFO:
+                if (fifo.fd != fd)
+                    break;
+                newFIFO();
+                return; /* drivers may have come and gone */
+
+            /* new client? */
+            case EV_LISTEN:
+                newClient(lsocket);
+                break;
+
+            case EV_ULISTEN:
+                newClient(usocket);
+                break;
+
+            /* message to/from client? */
+            case EV_CLIENT:
+                if (idx >= nclinfo || !(cp = &clinfo[idx])->active || cp->s != fd)
+                    break;
+                if (readable && readFromClient(cp) < 0)
+                    return; /* fds effected */
+                if ((events & EPOLLOUT) && nFQ(cp->msgq) > 0 && sendClientMsg(cp) < 0)
+                    return; /* fds effected */
+                break;
+
+            /* message to/from driver? */
+            case EV_DVR:
+                if (idx >= ndvrinfo || !(dp = &dvrinfo[idx])->active || dp->rfd != fd)
+                    break;
+                if (readable && readFromDriver(dp) < 0)
+                    return; /* fds effected */
+                if ((events & EPOLLOUT) && nFQ(dp->msgq) > 0 && sendDriverMsg(dp) < 0)
+                    return; /* fds effected */
+                break;
+
+            case EV_DVRWRITE:
+                if (idx >= ndvrinfo || !(dp = &dvrinfo[idx])->active || dp->wfd != fd)
+                    break;
+                if (nFQ(dp->msgq) > 0 && sendDriverMsg(dp) < 0)
+                    return; /* fds effected */
+                break;
+
+            case EV_DVRERR:
+                if (idx >= ndvrinfo || !(dp = &dvrinfo[idx])->active || dp->efd != fd)
+                    break;
+                if (stderrFromDriver(dp) < 0)
+                    return; /* fds effected */
+                break;
+        }
     }
 }
+#endif
 
 /* service traffic from clients and drivers */
 static void indiRun(void)
@@ -799,6 +1216,14 @@ static void indiRun(void)
     int maxfd = 0;
     int i, s;
 
+#ifdef USE_EPOLL
+    if (epfd >= 0)
+    {
+        indiRunEpoll();
+        return;
+    }
+#endif
+
     /* init with no writers or readers */
     FD_ZERO(&ws);
     FD_ZERO(&rs);
@@ -813,6 +1238,12 @@ static void indiRun(void)
     FD_SET(lsocket, &rs);
     if (lsocket > maxfd)
         maxfd = lsocket;
+    if (usocket >= 0)
+    {
+        FD_SET(usocket, &rs);
+        if (usocket > maxfd)
+            maxfd = usocket;
+    }
 
     /* add all client readers and client writers with work to send */
     for (i = 0; i < nclinfo; i++)
@@ -872,7 +1303,12 @@ static void indiRun(void)
     /* new client? */
     if (s > 0 && FD_ISSET(lsocket, &rs))
     {
-        newClient();
+        newClient(lsocket);
+        s--;
+    }
+    if (s > 0 && usocket >= 0 && FD_ISSET(usocket, &rs))
+    {
+        newClient(usocket);
         s--;
     }
 
@@ -1111,16 +1547,16 @@ static void newFIFO(void)
     }
 }
 
-/* prepare for new client arriving on lsocket.
+/* prepare for new client arriving on listen socket ls.
  * exit if trouble.
  */
-static void newClient()
+static void newClient(int ls)
 {
     ClInfo *cp = NULL;
     int s, cli;
 
     /* assign new socket */
-    s = newClSocket();
+    s = newClSocket(ls);
 
     /* try to reuse a clinfo slot, else add one */
     for (cli = 0; cli < nclinfo; cli++)
@@ -1145,12 +1581,23 @@ static void newClient()
     memset(cp, 0, sizeof(*cp));
     cp->active = 1;
     cp->s      = s;
+    cp->shm    = ls == usocket;
     cp->lp     = newLilXML();
     cp->msgq   = newFQ(1);
     cp->props  = malloc(1);
     cp->nsent  = 0;
+    cp->qsize  = 0;
+    cp->wwatch = 0;
 
-    if (verbose > 0)
+#ifdef USE_EPOLL
+    evAdd(cp->s, EPOLLIN, EV_CLIENT, cp - clinfo);
+#endif
+
+    if (verbose > 0 && cp->shm)
+    {
+        fprintf(stderr, "%s: Client %d: new arrival on %s - welcome!\n", indi_tstamp(NULL), cp->s, upath);
+    }
+    else if (verbose > 0)
     {
         struct sockaddr_in addr;
         socklen_t len = sizeof(addr);
@@ -1236,6 +1683,7 @@ static int readFromClient(ClInfo *cp)
 
             /* build a new message -- set content iff anyone cares */
             mp = newMsg();
+            sizeMsgXMLEle(mp, root);
 
             /* send message to driver(s) responsible for dev */
             q2RDrivers(dev, mp, root);
@@ -1280,16 +1728,22 @@ static int readFromClient(ClInfo *cp)
  */
 static int readFromDriver(DvrInfo *dp)
 {
-    char buf[MAXRBUF];
+    char buf[MAXRBUF + BLOBTAGLEN];
     int shutany = 0;
     ssize_t nr;
-    char err[1024];
-    XMLEle **nodes;
-    XMLEle *root;
-    int inode = 0;
+    size_t n, len;
 
-    /* read driver */
-    nr = read(dp->rfd, buf, sizeof(buf));
+    /* read driver, straight into the BLOB being collected if any */
+    if (dp->bb)
+    {
+        growBLOB(dp, MAXRBUF + 1);
+        nr = read(dp->rfd, dp->bb + dp->nbb, MAXRBUF);
+    }
+    else
+    {
+        memcpy(buf, dp->carry, dp->ncarry);
+        nr = read(dp->rfd, buf + dp->ncarry, MAXRBUF);
+    }
     if (nr <= 0)
     {
         if (nr < 0)
@@ -1301,127 +1755,495 @@ static int readFromDriver(DvrInfo *dp)
         return (-1);
     }
 
-    /* process XML chunk */
-    nodes = parseXMLChunk(dp->lp, buf, nr, err);
-
-    if (!nodes)
+    if (dp->bb)
     {
-        if (err[0])
-        {
-            char *ts = indi_tstamp(NULL);
-            fprintf(stderr, "%s: Driver %s: XML error: %s\n", ts, dp->name, err);
-            fprintf(stderr, "%s: Driver %s: XML read: %.*s\n", ts, dp->name, (int)nr, buf);
-            shutdownDvr(dp, 1);
-            return (-1);
-        }
-        return -1;
-    }
+        /* nothing more to do until the BLOB is complete */
+        dp->nbb += nr;
+        len = findBLOBEnd(dp);
+        if (len == 0)
+            return (0);
 
-    root = nodes[inode];
-    while (root)
+        /* whatever follows it is parsed as usual */
+        n = dp->nbb - len;
+        memcpy(buf, dp->bb + len, n);
+        if (sendBLOBFromDriver(dp, len) < 0)
+            shutany++;
+    }
+    else
     {
-        char *roottag    = tagXMLEle(root);
-        const char *dev  = findXMLAttValu(root, "device");
-        const char *name = findXMLAttValu(root, "name");
-        int isblob       = !strcmp(tagXMLEle(root), "setBLOBVector");
-        Msg *mp;
+        n          = dp->ncarry + nr;
+        dp->ncarry = 0;
+    }
 
-        if (verbose > 2)
-        {
-            fprintf(stderr, "%s: Driver %s: read ", indi_tstamp(0), dp->name);
-            traceMsg(root);
-        }
-        else if (verbose > 1)
-        {
-            fprintf(stderr, "%s: Driver %s: read <%s device='%s' name='%s'>\n", indi_tstamp(NULL), dp->name,
-                    tagXMLEle(root), findXMLAttValu(root, "device"), findXMLAttValu(root, "name"));
-        }
+    if (n > 0 && parseFromDriver(dp, buf, n) < 0)
+        shutany++;
 
-        /* that's all if driver is just registering a snoop */
-        /* JM 2016-05-18: Send getProperties to upstream chained servers as well.*/
-        if (!strcmp(roottag, "getProperties"))
-        {
-            addSDevice(dp, dev, name);
-            mp = newMsg();
-            /* send to interested chained servers upstream */
-            if (q2Servers(dp, mp, root) < 0)
-                shutany++;
-            /* Send to snooped drivers if they exist so that they can echo back the snooped propertly immediately */
-            q2RDrivers(dev, mp, root);
+    return (shutany ? -1 : 0);
+}
 
-            if (mp->count > 0)
-                setMsgXMLEle(mp, root);
-            else
-                freeMsg(mp);
-            delXMLEle(root);
-            inode++;
-            root = nodes[inode];
-            continue;
-        }
+/* process n bytes in buf read from driver dp.
+ * xml is parsed with dp->lp up to the start of any setBLOBVector, which is
+ * then collected raw in dp->bb until complete and routed without parsing.
+ * a trailing partial BLOBTAG is kept in dp->carry for the next read.
+ * return 0 if ok else -1 if had to shut down anything.
+ */
+static int parseFromDriver(DvrInfo *dp, char *buf, size_t n)
+{
+    int shutany = 0;
 
-        /* that's all if driver desires to snoop BLOBs from other drivers */
-        if (!strcmp(roottag, "enableBLOB"))
-        {
-            Property *sp = findSDevice(dp, dev, name);
-            if (sp)
-                crackBLOB(pcdataXMLEle(root), &sp->blob);
-            delXMLEle(root);
-            inode++;
-            root = nodes[inode];
-            continue;
-        }
+    while (n > 0)
+    {
+        char *bp    = memmem(buf, n, BLOBTAG, BLOBTAGLEN);
+        size_t nxml = bp ? (size_t)(bp - buf) : n;
+        size_t len;
 
-        /* Found a new device? Let's add it to driver info */
-        if (dev[0] && isDeviceInDriver(dev, dp) == 0)
+        /* hold back what might be the start of a BLOBTAG */
+        if (!bp)
         {
-            dp->dev           = (char **)realloc(dp->dev, (dp->ndev + 1) * sizeof(char *));
-            dp->dev[dp->ndev] = (char *)malloc(MAXINDIDEVICE * sizeof(char));
-
-            strncpy(dp->dev[dp->ndev], dev, MAXINDIDEVICE - 1);
-            dp->dev[dp->ndev][MAXINDIDEVICE - 1] = '\0';
-
-#ifdef OSX_EMBEDED_MODE
-            if (!dp->ndev)
-                fprintf(stderr, "STARTED \"%s\"\n", dp->name);
-            fflush(stderr);
-#endif
-
-            dp->ndev++;
+            size_t k = n < BLOBTAGLEN ? n : BLOBTAGLEN - 1;
+            for (; k > 0; k--)
+            {
+                if (!memcmp(buf + n - k, BLOBTAG, k))
+                    break;
+            }
+            nxml -= k;
+            memcpy(dp->carry, buf + nxml, k);
+            dp->ncarry = k;
         }
 
-        /* log messages if any and wanted */
-        if (ldir)
-            logDMsg(root, dev);
+        /* parse all up to BLOBTAG */
+        if (nxml > 0 && xmlFromDriver(dp, buf, nxml, &shutany) < 0)
+            return (-1);
+        if (!bp)
+            break;
 
-        /* build a new message -- set content iff anyone cares */
-        mp = newMsg();
+        /* collect the BLOB, done for now if it is not complete */
+        buf += nxml;
+        n -= nxml;
+        growBLOB(dp, n + MAXRBUF + 1);
+        memcpy(dp->bb, buf, n);
+        dp->nbb = n;
+        len     = findBLOBEnd(dp);
+        if (len == 0)
+            break;
 
-        /* send to interested clients */
-        if (q2Clients(NULL, isblob, dev, name, mp, root) < 0)
+        /* route it and carry on with whatever follows */
+        if (sendBLOBFromDriver(dp, len) < 0)
             shutany++;
-
-        /* send to snooping drivers */
-        q2SDrivers(dp, isblob, dev, name, mp, root);
-
-        /* set message content if anyone cares else forget it */
-        if (mp->count > 0)
-            setMsgXMLEle(mp, root);
-        else
-            freeMsg(mp);
-        delXMLEle(root);
-        inode++;
-        root = nodes[inode];
+        buf += len;
+        n -= len;
     }
 
-    free(nodes);
-
     return (shutany ? -1 : 0);
 }
 
-/* read more from the given driver stderr, add prefix and send to our stderr.
- * return 0 if ok else -1 if had to restart.
+/* parse n bytes of xml in buf from driver dp and route each complete
+ * message. count any shut down clients in *shutany.
+ * return 0 if ok else -1 if had to shut down dp.
  */
-static int stderrFromDriver(DvrInfo *dp)
+static int xmlFromDriver(DvrInfo *dp, char *buf, size_t n, int *shutany)
+{
+    char err[1024];
+    XMLEle **nodes;
+    XMLEle *root;
+    int inode;
+
+    /* process XML chunk */
+    nodes = parseXMLChunk(dp->lp, buf, n, err);
+
+    if (!nodes)
+    {
+        if (err[0])
+        {
+            char *ts = indi_tstamp(NULL);
+            fprintf(stderr, "%s: Driver %s: XML error: %s\n", ts, dp->name, err);
+            fprintf(stderr, "%s: Driver %s: XML read: %.*s\n", ts, dp->name, (int)n, buf);
+            shutdownDvr(dp, 1);
+        }
+        return -1;
+    }
+
+    for (inode = 0; (root = nodes[inode]) != NULL; inode++)
+    {
+        if (routeFromDriver(dp, root, NULL) < 0)
+            (*shutany)++;
+        delXMLEle(root);
+    }
+
+    free(nodes);
+
+    return (0);
+}
+
+/* send message root from driver dp to each interested client and driver.
+ * if rmp is not NULL it is a new Msg already holding the original text of
+ * root, which is queued instead of printing root. it is freed if nobody cares.
+ * return 0 if ok else -1 if had to shut down anything.
+ */
+static int routeFromDriver(DvrInfo *dp, XMLEle *root, Msg *rmp)
+{
+    int shutany      = 0;
+    char *roottag    = tagXMLEle(root);
+    const char *dev  = findXMLAttValu(root, "device");
+    const char *name = findXMLAttValu(root, "name");
+    int isblob       = !strcmp(tagXMLEle(root), "setBLOBVector");
+    Msg *mp;
+
+    if (verbose > 2)
+    {
+        fprintf(stderr, "%s: Driver %s: read ", indi_tstamp(0), dp->name);
+        traceMsg(root);
+    }
+    else if (verbose > 1)
+    {
+        fprintf(stderr, "%s: Driver %s: read <%s device='%s' name='%s'>\n", indi_tstamp(NULL), dp->name,
+                tagXMLEle(root), findXMLAttValu(root, "device"), findXMLAttValu(root, "name"));
+    }
+
+    /* that's all if driver is just registering a snoop */
+    /* JM 2016-05-18: Send getProperties to upstream chained servers as well.*/
+    if (!strcmp(roottag, "getProperties"))
+    {
+        addSDevice(dp, dev, name);
+        mp = newMsg();
+        sizeMsgXMLEle(mp, root);
+        /* send to interested chained servers upstream */
+        if (q2Servers(dp, mp, root) < 0)
+            shutany++;
+        /* Send to snooped drivers if they exist so that they can echo back the snooped propertly immediately */
+        q2RDrivers(dev, mp, root);
+
+        if (mp->count > 0)
+            setMsgXMLEle(mp, root);
+        else
+            freeMsg(mp);
+        if (rmp)
+            freeMsg(rmp);
+        return (shutany ? -1 : 0);
+    }
+
+    /* that's all if driver desires to snoop BLOBs from other drivers */
+    if (!strcmp(roottag, "enableBLOB"))
+    {
+        Property *sp = findSDevice(dp, dev, name);
+        if (sp)
+            crackBLOB(pcdataXMLEle(root), &sp->blob);
+        if (rmp)
+            freeMsg(rmp);
+        return (0);
+    }
+
+    /* Found a new device? Let's add it to driver info */
+    if (dev[0] && isDeviceInDriver(dev, dp) == 0)
+    {
+        dp->dev           = (char **)realloc(dp->dev, (dp->ndev + 1) * sizeof(char *));
+        dp->dev[dp->ndev] = (char *)malloc(MAXINDIDEVICE * sizeof(char));
+
+        strncpy(dp->dev[dp->ndev], dev, MAXINDIDEVICE - 1);
+        dp->dev[dp->ndev][MAXINDIDEVICE - 1] = '\0';
+
+#ifdef OSX_EMBEDED_MODE
+        if (!dp->ndev)
+            fprintf(stderr, "STARTED \"%s\"\n", dp->name);
+        fflush(stderr);
+#endif
+
+        dp->ndev++;
+    }
+
+    /* log messages if any and wanted */
+    if (ldir)
+        logDMsg(root, dev);
+
+    /* build a new message -- set content iff anyone cares */
+    mp = rmp;
+    if (!mp)
+    {
+        mp = newMsg();
+        sizeMsgXMLEle(mp, root);
+    }
+
+    /* send to interested clients */
+    if (q2Clients(NULL, isblob, dev, name, mp, root) < 0)
+        shutany++;
+
+    /* send to snooping drivers */
+    q2SDrivers(dp, isblob, dev, name, mp, root);
+
+    /* any base64 copy of attached BLOBs lives on in the queues it is on */
+    mp->inl = NULL;
+
+    /* set message content if anyone cares else forget it */
+    if (mp->count == 0)
+        freeMsg(mp);
+    else if (!rmp)
+        setMsgXMLEle(mp, root);
+
+    return (shutany ? -1 : 0);
+}
+
+/* route the complete setBLOBVector in the first len bytes of dp->bb.
+ * only its envelope is parsed, the bytes themselves become the message.
+ * return 0 if ok else -1 if had to shut down anything.
+ */
+static int sendBLOBFromDriver(DvrInfo *dp, size_t len)
+{
+    char *raw = dp->bb;
+    XMLEle *root;
+    Msg *mp;
+    int ret;
+
+    /* raw now belongs to the message */
+    raw[len] = '\0';
+    dp->bb   = NULL;
+    freeBLOB(dp);
+
+    root = envelopeXMLEle(raw, len);
+    if (!root)
+    {
+        fprintf(stderr, "%s: Driver %s: bad setBLOBVector: %.*s\n", indi_tstamp(NULL), dp->name,
+                (int)(len < 200 ? len : 200), raw);
+        free(raw);
+        return (0);
+    }
+
+    mp     = newMsg();
+    mp->cp = raw;
+    mp->cl = len;
+
+    /* collect the segments of any attached BLOBs */
+    if (attachBLOBs(dp, root, mp) < 0)
+    {
+        fprintf(stderr, "%s: Driver %s: missing shared BLOB for %s.%s\n", indi_tstamp(NULL), dp->name,
+                findXMLAttValu(root, "device"), findXMLAttValu(root, "name"));
+        freeMsg(mp);
+        delXMLEle(root);
+        return (0);
+    }
+
+    ret = routeFromDriver(dp, root, mp);
+    delXMLEle(root);
+
+    return (ret);
+}
+
+/* add to mp the segment of each oneBLOB of root marked attached, as they
+ * arrive from driver dp in the same order.
+ * return 0 if ok else -1 if any are missing or too small.
+ */
+static int attachBLOBs(DvrInfo *dp, XMLEle *root, Msg *mp)
+{
+    int bad = 0;
+    XMLEle *ep;
+
+    for (ep = nextXMLEle(root, 1); ep; ep = nextXMLEle(root, 0))
+    {
+        struct stat st;
+        size_t len;
+        int fd;
+
+        if (strcmp(tagXMLEle(ep), "oneBLOB") || strcmp(findXMLAttValu(ep, "attached"), "true"))
+            continue;
+
+        /* take each one regardless, to stay in step with the driver */
+        fd  = dp->bfd < 0 ? -1 : recvBLOBFd(dp->bfd);
+        len = strtoul(findXMLAttValu(ep, "len"), NULL, 10);
+        if (fd < 0 || mp->nfd == MAXBLOBFD || fstat(fd, &st) < 0 || (size_t)st.st_size < len)
+        {
+            if (fd >= 0)
+                close(fd);
+            bad++;
+            continue;
+        }
+
+        mp->fd = (int *)realloc(mp->fd, (mp->nfd + 1) * sizeof(int));
+        mp->fd[mp->nfd++] = fd;
+        mp->shmlen += len;
+    }
+
+    return (bad ? -1 : 0);
+}
+
+/* return the next fd passed on socket s, or -1 if none */
+static int recvBLOBFd(int s)
+{
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    struct iovec iov;
+    char tag;
+    int flags = MSG_DONTWAIT;
+    int fd    = -1;
+
+#ifdef MSG_CMSG_CLOEXEC
+    /* drivers we start later must not inherit them */
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base       = &tag;
+    iov.iov_len        = 1;
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    if (recvmsg(s, &msg, flags) <= 0)
+        return (-1);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+    return (fd);
+}
+
+/* insure dp->bb has room for more bytes.
+ * once the enclen of the first BLOB is known, room for all of it is made at
+ * once so large BLOBs are not repeatedly moved while they are collected.
+ */
+static void growBLOB(DvrInfo *dp, size_t more)
+{
+    size_t need = dp->nbb + more;
+    size_t size;
+    char *ep;
+
+    if (need <= dp->mbb)
+        return;
+
+    size = dp->mbb * 2;
+    if (size < need)
+        size = need;
+
+    ep = dp->bb ? memmem(dp->bb, dp->nbb < 4096 ? dp->nbb : 4096, "enclen=", 7) : NULL;
+    if (ep && ep + 8 < dp->bb + dp->nbb)
+    {
+        /* allow for a newline every 72 characters */
+        size_t enclen = strtoul(ep + 8, NULL, 10);
+        size_t hint   = enclen + enclen / 72 + MAXRBUF;
+        if (size < hint)
+            size = hint;
+    }
+
+    dp->bb = (char *)realloc(dp->bb, size);
+    if (!dp->bb)
+    {
+        fprintf(stderr, "%s: Driver %s: no memory for %zu byte BLOB\n", indi_tstamp(NULL), dp->name, size);
+        Bye();
+    }
+    dp->mbb = size;
+}
+
+/* return the length of the setBLOBVector in dp->bb including its closing tag,
+ * or 0 if not yet complete. dp->sbb remembers how far we have looked.
+ * N.B. '<' and '>' never appear unescaped in INDI attribute values or
+ *   BLOB data so searching for the raw tag text is unambiguous.
+ */
+static size_t findBLOBEnd(DvrInfo *dp)
+{
+    char *end = dp->bb + dp->nbb;
+    char *ep, *gt;
+
+    /* opening tag first, it may be all there is */
+    if (dp->sbb == 0)
+    {
+        gt = memchr(dp->bb, '>', dp->nbb);
+        if (!gt)
+            return (0);
+        if (gt[-1] == '/')
+            return (gt - dp->bb + 1);
+        dp->sbb = gt - dp->bb + 1;
+    }
+
+    ep = memmem(dp->bb + dp->sbb, dp->nbb - dp->sbb, BLOBETAG, BLOBETAGLEN);
+    if (!ep)
+    {
+        /* next time, look again where a partial closing tag might begin */
+        if (dp->nbb > dp->sbb + BLOBETAGLEN)
+            dp->sbb = dp->nbb - BLOBETAGLEN;
+        return (0);
+    }
+
+    gt = memchr(ep, '>', end - ep);
+    if (!gt)
+    {
+        dp->sbb = ep - dp->bb;
+        return (0);
+    }
+
+    return (gt - dp->bb + 1);
+}
+
+/* forget any BLOB being collected for dp */
+static void freeBLOB(DvrInfo *dp)
+{
+    free(dp->bb);
+    dp->bb  = NULL;
+    dp->nbb = 0;
+    dp->mbb = 0;
+    dp->sbb = 0;
+}
+
+/* return a new tree of the tags and attributes of the raw xml in raw,
+ * without any pcdata, or NULL if it can not be parsed. only the tags are
+ * copied and parsed so this costs little regardless of the BLOB size.
+ */
+static XMLEle *envelopeXMLEle(const char *raw, size_t len)
+{
+    static LilXML *elp;
+    const char *rp  = raw;
+    const char *end = raw + len;
+    char *tags      = NULL;
+    size_t ntags = 0, mtags = 0;
+    char err[1024];
+    XMLEle **nodes;
+    XMLEle *root;
+    int i;
+
+    /* collect each <...>, skipping whatever lies between */
+    while (rp < end && (rp = memchr(rp, '<', end - rp)) != NULL)
+    {
+        const char *gt = memchr(rp, '>', end - rp);
+        size_t l;
+
+        if (!gt)
+            break;
+        l = gt - rp + 1;
+        if (ntags + l > mtags)
+        {
+            mtags = 2 * (ntags + l);
+            tags  = (char *)realloc(tags, mtags);
+        }
+        memcpy(tags + ntags, rp, l);
+        ntags += l;
+        rp = gt + 1;
+    }
+
+    if (!elp)
+        elp = newLilXML();
+
+    nodes = parseXMLChunk(elp, tags, ntags, err);
+    free(tags);
+    root = nodes[0];
+    if (root)
+    {
+        for (i = 1; nodes[i]; i++)
+            delXMLEle(nodes[i]);
+    }
+    else
+    {
+        /* start clean next time */
+        delLilXML(elp);
+        elp = NULL;
+    }
+    free(nodes);
+
+    return (root);
+}
+
+/* read more from the given driver stderr, add prefix and send to our stderr.
+ * return 0 if ok else -1 if had to restart.
+ */
+static int stderrFromDriver(DvrInfo *dp)
 {
     static char exbuf[MAXRBUF];
     static int nexbuf;
@@ -1462,6 +2284,9 @@ static void shutdownClient(ClInfo *cp)
     Msg *mp;
 
     /* close connection */
+#ifdef USE_EPOLL
+    evDel(cp->s);
+#endif
     shutdown(cp->s, SHUT_RDWR);
     close(cp->s);
 
@@ -1474,6 +2299,7 @@ static void shutdownClient(ClInfo *cp)
         if (--mp->count == 0)
             freeMsg(mp);
     delFQ(cp->msgq);
+    cp->qsize = 0;
 
     /* ok now to recycle */
     cp->active = 0;
@@ -1505,6 +2331,7 @@ static void shutdownDvr(DvrInfo *dp, int restart)
 
         prXMLEle(stderr, root, 0);
         Msg *mp = newMsg();
+        sizeMsgXMLEle(mp, root);
 
         q2Clients(NULL, 0, dp->dev[i], NULL, mp, root);
         if (mp->count > 0)
@@ -1515,6 +2342,15 @@ static void shutdownDvr(DvrInfo *dp, int restart)
     }
 
     /* make sure it's dead, reclaim resources */
+#ifdef USE_EPOLL
+    evDel(dp->rfd);
+    if (dp->pid != REMOTEDVR)
+    {
+        if (dp->wwatch)
+            evDel(dp->wfd);
+        evDel(dp->efd);
+    }
+#endif
     if (dp->pid == REMOTEDVR)
     {
         /* socket connection */
@@ -1528,6 +2364,7 @@ static void shutdownDvr(DvrInfo *dp, int restart)
         close(dp->wfd);
         close(dp->rfd);
         close(dp->efd);
+        close(dp->bfd);
     }
 
 #ifdef OSX_EMBEDED_MODE
@@ -1539,6 +2376,8 @@ static void shutdownDvr(DvrInfo *dp, int restart)
     free(dp->sprops);
     free(dp->dev);
     delLilXML(dp->lp);
+    freeBLOB(dp);
+    dp->ncarry = 0;
 
     /* ok now to recycle */
     dp->active = 0;
@@ -1549,6 +2388,7 @@ static void shutdownDvr(DvrInfo *dp, int restart)
         if (--mp->count == 0)
             freeMsg(mp);
     delFQ(dp->msgq);
+    dp->qsize = 0;
 
     if (restart)
     {
@@ -1613,12 +2453,12 @@ static void q2RDrivers(const char *dev, Msg *mp, XMLEle *root)
         }
 
         /* ok: queue message to this driver */
-        mp->count++;
-        pushFQ(dp->msgq, mp);
+        pushDriverMsg(dp, mp);
         if (verbose > 1)
         {
-            fprintf(stderr, "%s: Driver %s: queuing responsible for <%s device='%s' name='%s'>\n", indi_tstamp(NULL),
-                    dp->name, tagXMLEle(root), findXMLAttValu(root, "device"), findXMLAttValu(root, "name"));
+            fprintf(stderr, "%s: Driver %s: queuing responsible for <%s device='%s' name='%s'>, %d bytes behind\n",
+                    indi_tstamp(NULL), dp->name, tagXMLEle(root), findXMLAttValu(root, "device"),
+                    findXMLAttValu(root, "name"), dp->qsize);
         }
     }
 }
@@ -1651,12 +2491,12 @@ static void q2SDrivers(DvrInfo *me, int isblob, const char *dev, const char *nam
         }
 
         /* ok: queue message to this device */
-        mp->count++;
-        pushFQ(dp->msgq, mp);
+        pushDriverMsg(dp, mp);
         if (verbose > 1)
         {
-            fprintf(stderr, "%s: Driver %s: queuing snooped <%s device='%s' name='%s'>\n", indi_tstamp(NULL), dp->name,
-                    tagXMLEle(root), findXMLAttValu(root, "device"), findXMLAttValu(root, "name"));
+            fprintf(stderr, "%s: Driver %s: queuing snooped <%s device='%s' name='%s'>, %d bytes behind\n",
+                    indi_tstamp(NULL), dp->name, tagXMLEle(root), findXMLAttValu(root, "device"),
+                    findXMLAttValu(root, "name"), dp->qsize);
         }
     }
 }
@@ -1755,7 +2595,7 @@ static int q2Clients(ClInfo *notme, int isblob, const char *dev, const char *nam
         }
 
         /* shut down this client if its q is already too large */
-        ql = msgQSize(cp->msgq);
+        ql = cp->qsize;
         if (isblob && maxstreamsiz > 0 && ql > maxstreamsiz)
         {
             // Drop frames for streaming blobs
@@ -1793,11 +2633,11 @@ static int q2Clients(ClInfo *notme, int isblob, const char *dev, const char *nam
         }
 
         /* ok: queue message to this client */
-        mp->count++;
-        pushFQ(cp->msgq, mp);
+        pushClientMsg(cp, mp);
         if (verbose > 1)
-            fprintf(stderr, "%s: Client %d: queuing <%s device='%s' name='%s'>\n", indi_tstamp(NULL), cp->s,
-                    tagXMLEle(root), findXMLAttValu(root, "device"), findXMLAttValu(root, "name"));
+            fprintf(stderr, "%s: Client %d: queuing <%s device='%s' name='%s'>, %d bytes behind\n",
+                    indi_tstamp(NULL), cp->s, tagXMLEle(root), findXMLAttValu(root, "device"),
+                    findXMLAttValu(root, "name"), cp->qsize);
     }
 
     return (shutany ? -1 : 0);
@@ -1856,7 +2696,7 @@ static int q2Servers(DvrInfo *me, Msg *mp, XMLEle *root)
             continue;
 
         /* shut down this client if its q is already too large */
-        ql = msgQSize(cp->msgq);
+        ql = cp->qsize;
         if (ql > maxqsiz)
         {
             if (verbose)
@@ -1867,38 +2707,68 @@ static int q2Servers(DvrInfo *me, Msg *mp, XMLEle *root)
         }
 
         /* ok: queue message to this client */
-        mp->count++;
-        pushFQ(cp->msgq, mp);
+        pushClientMsg(cp, mp);
         if (verbose > 1)
-            fprintf(stderr, "%s: Client %d: queuing <%s device='%s' name='%s'>\n", indi_tstamp(NULL), cp->s,
-                    tagXMLEle(root), findXMLAttValu(root, "device"), findXMLAttValu(root, "name"));
+            fprintf(stderr, "%s: Client %d: queuing <%s device='%s' name='%s'>, %d bytes behind\n",
+                    indi_tstamp(NULL), cp->s, tagXMLEle(root), findXMLAttValu(root, "device"),
+                    findXMLAttValu(root, "name"), cp->qsize);
     }
 
     return (shutany ? -1 : 0);
 }
 
-/* return size of all Msqs on the given q */
-static int msgQSize(FQ *q)
+/* put Msg mp on the queue of client cp and account for its size.
+ * clients not on usocket get any attached BLOBs base64 encoded instead.
+ */
+static void pushClientMsg(ClInfo *cp, Msg *mp)
 {
-    int i, l = 0;
+    if (mp->nfd > 0 && !cp->shm && (mp = inlineMsg(mp)) == NULL)
+        return;
+    mp->count++;
+    pushFQ(cp->msgq, mp);
+    cp->qsize += msgQCharge(mp);
+    watchClient(cp);
+}
 
-    for (i = 0; i < nFQ(q); i++)
-    {
-        Msg *mp = (Msg *)peekiFQ(q, i);
-        l += sizeof(Msg);
-        if (mp->cp != mp->buf)
-            l += mp->cl;
-    }
+/* put Msg mp on the queue of driver dp and account for its size.
+ * drivers always get any attached BLOBs base64 encoded.
+ */
+static void pushDriverMsg(DvrInfo *dp, Msg *mp)
+{
+    if (mp->nfd > 0 && (mp = inlineMsg(mp)) == NULL)
+        return;
+    mp->count++;
+    pushFQ(dp->msgq, mp);
+    dp->qsize += msgQCharge(mp);
+    watchDvr(dp);
+}
+
+/* return the bytes Msg mp adds to a queue: the Msg itself and its attached
+ * BLOBs plus its content if that does not fit in buf. the content part is
+ * paid back as it is sent, the rest when mp is popped. mp->cl must already
+ * be set.
+ */
+static int msgQCharge(Msg *mp)
+{
+    return (sizeof(Msg) + mp->shmlen + (mp->cl < sizeof(mp->buf) ? 0 : mp->cl));
+}
 
-    return (l);
+/* set the content length of Msg mp to that of root printed so mp can be
+ * queued before deciding whether to print it with setMsgXMLEle().
+ */
+static void sizeMsgXMLEle(Msg *mp, XMLEle *root)
+{
+    mp->cl = sprlXMLEle(root, 0);
 }
 
 /* print root as content in Msg mp.
+ * the length is reused if already set by sizeMsgXMLEle().
  */
 static void setMsgXMLEle(Msg *mp, XMLEle *root)
 {
     /* want cl to only count content, but need room for final \0 */
-    mp->cl = sprlXMLEle(root, 0);
+    if (mp->cl == 0)
+        mp->cl = sprlXMLEle(root, 0);
     if (mp->cl < sizeof(mp->buf))
         mp->cp = mp->buf;
     else
@@ -1929,30 +2799,174 @@ static Msg *newMsg(void)
 /* free Msg mp and everything it contains */
 static void freeMsg(Msg *mp)
 {
+    int i;
+
     if (mp->cp && mp->cp != mp->buf)
         free(mp->cp);
+    for (i = 0; i < mp->nfd; i++)
+        close(mp->fd[i]);
+    free(mp->fd);
     free(mp);
 }
 
-/* write the next chunk of the current message in the queue to the given
- * client. pop message from queue when complete and free the message if we are
- * the last one to use it. shut down this client if trouble.
+/* return a Msg like mp but with each attached oneBLOB replaced by the usual
+ * base64 encoded oneBLOB read from its segment. it is made at most once for
+ * each mp while mp is being routed, see mp->inl.
+ * return NULL if trouble.
+ */
+static Msg *inlineMsg(Msg *mp)
+{
+    const char *rp  = mp->cp;
+    const char *end = mp->cp + mp->cl;
+    const char *tp;
+    size_t mo;
+    char *op;
+    Msg *imp;
+    int i = 0;
+
+    if (mp->inl)
+        return (mp->inl);
+
+    /* room for all the text, all the BLOBs with a newline every 72 encoded
+     * characters and new enclen attributes and closing tags.
+     */
+    mo  = mp->cl + 4 * (mp->shmlen / 3) + mp->shmlen / 54 + mp->nfd * 128 + 1;
+    imp = newMsg();
+    imp->cp = op = (char *)malloc(mo);
+    if (!op)
+    {
+        fprintf(stderr, "%s: no memory for %zu byte BLOB\n", indi_tstamp(NULL), mo);
+        free(imp);
+        return (NULL);
+    }
+
+    while ((tp = memmem(rp, end - rp, "<oneBLOB", 8)) != NULL)
+    {
+        const char *gt = memchr(tp, '>', end - tp);
+        const char *ap = tp + 8;
+        const char *ae;
+        unsigned char *seg;
+        size_t len = 0;
+
+        if (!gt)
+            break;
+
+        /* pass along all that is not attached as is */
+        if (!memmem(tp, gt - tp, "attached=", 9))
+        {
+            memcpy(op, rp, gt + 1 - rp);
+            op += gt + 1 - rp;
+            rp = gt + 1;
+            continue;
+        }
+
+        memcpy(op, rp, ap - rp);
+        op += ap - rp;
+
+        /* copy each attribute except attached and len */
+        ae = gt[-1] == '/' ? gt - 1 : gt;
+        while (ap < ae)
+        {
+            const char *wp = ap;
+            const char *np, *eq, *vp, *ve;
+
+            while (ap < ae && (*ap == ' ' || *ap == '\t' || *ap == '\n' || *ap == '\r'))
+                ap++;
+            if (ap == ae)
+                break;
+            np = ap;
+            eq = memchr(np, '=', ae - np);
+            if (!eq || eq + 1 >= ae || (eq[1] != '\'' && eq[1] != '"'))
+                goto bad;
+            vp = eq + 2;
+            ve = memchr(vp, eq[1], ae - vp);
+            if (!ve)
+                goto bad;
+            ap = ve + 1;
+
+            if (eq - np == 3 && !memcmp(np, "len", 3))
+                len = strtoul(vp, NULL, 10);
+            else if (!(eq - np == 8 && !memcmp(np, "attached", 8)))
+            {
+                memcpy(op, wp, ap - wp);
+                op += ap - wp;
+            }
+        }
+
+        /* add the encoded segment */
+        if (i == mp->nfd)
+            goto bad;
+        op += sprintf(op, "\n    enclen='%zu'>\n", 4 * ((len + 2) / 3));
+        if (len > 0)
+        {
+            seg = (unsigned char *)mmap(NULL, len, PROT_READ, MAP_PRIVATE, mp->fd[i], 0);
+            if (seg == MAP_FAILED)
+            {
+                fprintf(stderr, "%s: mmap shared BLOB: %s\n", indi_tstamp(NULL), strerror(errno));
+                goto bad;
+            }
+            op += base64Lines(op, seg, len);
+            munmap(seg, len);
+        }
+        op += sprintf(op, "</oneBLOB>");
+        rp = gt + 1;
+        i++;
+    }
+
+    memcpy(op, rp, end - rp);
+    op += end - rp;
+    *op = '\0';
+    imp->cl = op - imp->cp;
+
+    mp->inl = imp;
+    return (imp);
+
+bad:
+    fprintf(stderr, "%s: bad attached BLOB: %.*s\n", indi_tstamp(NULL), (int)(mp->cl < 200 ? mp->cl : 200), mp->cp);
+    freeMsg(imp);
+    return (NULL);
+}
+
+/* encode len bytes at in to base64 at out, with a newline after each 72
+ * characters and at the end, as drivers do.
+ * return bytes written to out.
+ */
+static size_t base64Lines(char *out, const unsigned char *in, size_t len)
+{
+    char *op = out;
+
+    while (len > 0)
+    {
+        int n = len < 54 ? (int)len : 54;
+
+        op += to64frombits_s((unsigned char *)op, in, n, 73);
+        *op++ = '\n';
+        in += n;
+        len -= n;
+    }
+
+    return (op - out);
+}
+
+/* write as much as possible of the messages in the queue to the given
+ * client. pop each message from queue when complete and free the message if
+ * we are the last one to use it. shut down this client if trouble.
  * N.B. we assume we will never be called with cp->msgq empty.
  * return 0 if ok else -1 if had to shut down.
  */
 static int sendClientMsg(ClInfo *cp)
 {
-    ssize_t nsend, nw;
-    Msg *mp;
+    struct iovec iov[MAXIOV];
+    ssize_t nw;
+    int niov;
 
-    /* get current message */
-    mp = (Msg *)peekFQ(cp->msgq);
+    /* send the next messages, never more than maxwsiz */
+    niov = msgIOV(cp->msgq, cp->nsent, iov);
+    nw   = writeIOV(cp->s, 1, iov, niov, cp->nsent == 0 ? (Msg *)peekFQ(cp->msgq) : NULL);
 
-    /* send next chunk, never more than MAXWSIZ to reduce blocking */
-    nsend = mp->cl - cp->nsent;
-    if (nsend > MAXWSIZ)
-        nsend = MAXWSIZ;
-    nw = write(cp->s, &mp->cp[cp->nsent], nsend);
+    /* try again later if the client is not ready for more */
+    if (nw < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return (0);
 
     /* shut down if trouble */
     if (nw <= 0)
@@ -1966,50 +2980,39 @@ static int sendClientMsg(ClInfo *cp)
     }
 
     /* trace */
-    if (verbose > 2)
-    {
-        fprintf(stderr, "%s: Client %d: sending msg copy %d nq %d:\n%.*s\n", indi_tstamp(NULL), cp->s, mp->count,
-                nFQ(cp->msgq), (int)nw, &mp->cp[cp->nsent]);
-    }
-    else if (verbose > 1)
+    if (verbose > 1)
     {
-        fprintf(stderr, "%s: Client %d: sending %.50s\n", indi_tstamp(NULL), cp->s, &mp->cp[cp->nsent]);
+        char who[32];
+        snprintf(who, sizeof(who), "Client %d", cp->s);
+        traceIOV(who, cp->msgq, iov, niov, nw);
     }
 
-    /* update amount sent. when complete: free message if we are the last
-     * to use it and pop from our queue.
-     */
-    cp->nsent += nw;
-    if (cp->nsent == mp->cl)
-    {
-        if (--mp->count == 0)
-            freeMsg(mp);
-        popFQ(cp->msgq);
-        cp->nsent = 0;
-    }
+    /* update amount sent and behind, pop what is complete */
+    msgSent(cp->msgq, &cp->nsent, &cp->qsize, nw);
+    watchClient(cp);
 
     return (0);
 }
 
-/* write the next chunk of the current message in the queue to the given
- * driver. pop message from queue when complete and free the message if we are
- * the last one to use it. restart this driver if touble.
+/* write as much as possible of the messages in the queue to the given
+ * driver. pop each message from queue when complete and free the message if
+ * we are the last one to use it. restart this driver if touble.
  * N.B. we assume we will never be called with dp->msgq empty.
  * return 0 if ok else -1 if had to shut down.
  */
 static int sendDriverMsg(DvrInfo *dp)
 {
-    ssize_t nsend, nw;
-    Msg *mp;
+    struct iovec iov[MAXIOV];
+    ssize_t nw;
+    int niov;
 
-    /* get current message */
-    mp = (Msg *)peekFQ(dp->msgq);
+    /* send the next messages, never more than maxwsiz */
+    niov = msgIOV(dp->msgq, dp->nsent, iov);
+    nw   = writeIOV(dp->wfd, dp->pid == REMOTEDVR, iov, niov, NULL);
 
-    /* send next chunk, never more than MAXWSIZ to reduce blocking */
-    nsend = mp->cl - dp->nsent;
-    if (nsend > MAXWSIZ)
-        nsend = MAXWSIZ;
-    nw = write(dp->wfd, &mp->cp[dp->nsent], nsend);
+    /* try again later if the driver is not ready for more */
+    if (nw < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return (0);
 
     /* restart if trouble */
     if (nw <= 0)
@@ -2023,29 +3026,130 @@ static int sendDriverMsg(DvrInfo *dp)
     }
 
     /* trace */
-    if (verbose > 2)
+    if (verbose > 1)
     {
-        fprintf(stderr, "%s: Driver %s: sending msg copy %d nq %d:\n%.*s\n", indi_tstamp(NULL), dp->name, mp->count,
-                nFQ(dp->msgq), (int)nw, &mp->cp[dp->nsent]);
+        char who[MAXINDINAME + 8];
+        snprintf(who, sizeof(who), "Driver %s", dp->name);
+        traceIOV(who, dp->msgq, iov, niov, nw);
     }
-    else if (verbose > 1)
+
+    /* update amount sent and behind, pop what is complete */
+    msgSent(dp->msgq, &dp->nsent, &dp->qsize, nw);
+    watchDvr(dp);
+
+    return (0);
+}
+
+/* fill iov with the unsent content of the messages on q, starting nsent
+ * bytes into the first, up to maxwsiz bytes in all. a message with attached
+ * BLOBs is only ever first, so its fds go with its first byte.
+ * return number of iov[] used, at most MAXIOV.
+ */
+static int msgIOV(FQ *q, unsigned int nsent, struct iovec *iov)
+{
+    size_t budget = maxwsiz;
+    int niov      = 0;
+    int i;
+
+    for (i = 0; i < nFQ(q) && niov < MAXIOV && budget > 0; i++)
     {
-        fprintf(stderr, "%s: Driver %s: sending %.50s\n", indi_tstamp(NULL), dp->name, &mp->cp[dp->nsent]);
+        Msg *mp  = (Msg *)peekiFQ(q, i);
+        size_t n = mp->cl - nsent;
+
+        if (i > 0 && mp->nfd > 0)
+            break;
+        if (n > budget)
+            n = budget;
+        iov[niov].iov_base = &mp->cp[nsent];
+        iov[niov].iov_len  = n;
+        niov++;
+        budget -= n;
+        nsent = 0;
     }
 
-    /* update amount sent. when complete: free message if we are the last
-     * to use it and pop from our queue.
-     */
-    dp->nsent += nw;
-    if (dp->nsent == mp->cl)
+    return (niov);
+}
+
+/* write iov to fd without blocking.
+ * sockets are asked not to wait, driver pipes we write are O_NONBLOCK.
+ * if fmp is not NULL, iov starts with it and the fds of its attached BLOBs
+ * are passed along.
+ * return bytes written, else -1 with errno set.
+ */
+static ssize_t writeIOV(int fd, int issock, struct iovec *iov, int niov, Msg *fmp)
+{
+    if (issock)
     {
-        if (--mp->count == 0)
-            freeMsg(mp);
-        popFQ(dp->msgq);
-        dp->nsent = 0;
+        char cbuf[CMSG_SPACE(MAXBLOBFD * sizeof(int))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = niov;
+        if (fmp && fmp->nfd > 0)
+        {
+            struct cmsghdr *cmsg;
+            memset(cbuf, 0, sizeof(cbuf));
+            msg.msg_control    = cbuf;
+            msg.msg_controllen = CMSG_SPACE(fmp->nfd * sizeof(int));
+            cmsg               = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level   = SOL_SOCKET;
+            cmsg->cmsg_type    = SCM_RIGHTS;
+            cmsg->cmsg_len     = CMSG_LEN(fmp->nfd * sizeof(int));
+            memcpy(CMSG_DATA(cmsg), fmp->fd, fmp->nfd * sizeof(int));
+        }
+        return (sendmsg(fd, &msg, MSG_DONTWAIT));
     }
 
-    return (0);
+    return (writev(fd, iov, niov));
+}
+
+/* print the nw bytes just written from iov, messages taken from q */
+static void traceIOV(const char *who, FQ *q, struct iovec *iov, int niov, ssize_t nw)
+{
+    int i;
+
+    for (i = 0; i < niov && nw > 0; i++)
+    {
+        Msg *mp = (Msg *)peekiFQ(q, i);
+        int n   = nw < (ssize_t)iov[i].iov_len ? (int)nw : (int)iov[i].iov_len;
+
+        if (verbose > 2)
+            fprintf(stderr, "%s: %s: sending msg copy %d nq %d:\n%.*s\n", indi_tstamp(NULL), who, mp->count, nFQ(q),
+                    n, (char *)iov[i].iov_base);
+        else
+            fprintf(stderr, "%s: %s: sending %.*s\n", indi_tstamp(NULL), who, n < 50 ? n : 50,
+                    (char *)iov[i].iov_base);
+        nw -= n;
+    }
+}
+
+/* account for nw more bytes written from q, *nsent bytes into its first
+ * message. when a message is complete: free it if we are the last to use it
+ * and pop from q. *qsize is reduced as per msgQCharge().
+ */
+static void msgSent(FQ *q, unsigned int *nsent, int *qsize, size_t nw)
+{
+    while (nw > 0)
+    {
+        Msg *mp  = (Msg *)peekFQ(q);
+        size_t n = mp->cl - *nsent;
+
+        if (n > nw)
+            n = nw;
+        *nsent += n;
+        nw -= n;
+        if (mp->cl >= sizeof(mp->buf))
+            *qsize -= n;
+
+        if (*nsent == mp->cl)
+        {
+            *qsize -= sizeof(Msg) + mp->shmlen;
+            if (--mp->count == 0)
+                freeMsg(mp);
+            popFQ(q);
+            *nsent = 0;
+        }
+    }
 }
 
 /* return 0 if cp may be interested in dev/name else -1
@@ -2100,18 +3204,18 @@ static void addClDevice(ClInfo *cp, const char *dev, const char *name, int isblo
     pp->blob = B_NEVER;
 }
 
-/* block to accept a new client arriving on lsocket.
+/* block to accept a new client arriving on listen socket ls.
  * return private nonblocking socket or exit.
  */
-static int newClSocket()
+static int newClSocket(int ls)
 {
-    struct sockaddr_in cli_socket;
+    struct sockaddr_storage cli_socket;
     socklen_t cli_len;
     int cli_fd;
 
     /* get a private connection to new client */
     cli_len = sizeof(cli_socket);
-    cli_fd  = accept(lsocket, (struct sockaddr *)&cli_socket, &cli_len);
+    cli_fd  = accept(ls, (struct sockaddr *)&cli_socket, &cli_len);
     if (cli_fd < 0)
     {
         fprintf(stderr, "accept: %s\n", strerror(errno));
@@ -2249,6 +3353,8 @@ static void logDMsg(XMLEle *root, const char *dev)
 /* log when then exit */
 static void Bye()
 {
+    if (usocket >= 0)
+        (void)unlink(upath);
     fprintf(stderr, "%s: good bye\n", indi_tstamp(NULL));
     exit(1);
 }
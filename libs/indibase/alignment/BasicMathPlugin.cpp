@@ -14,6 +14,8 @@
 
 #include "indicom.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <iostream>
 #include <map>
@@ -26,6 +28,7 @@ BasicMathPlugin::BasicMathPlugin()
 {
     pActualToApparentTransform = gsl_matrix_alloc(3, 3);
     pApparentToActualTransform = gsl_matrix_alloc(3, 3);
+    pNearestTransform          = gsl_matrix_alloc(3, 3);
 }
 
 // Destructor
@@ -34,6 +37,7 @@ BasicMathPlugin::~BasicMathPlugin()
 {
     gsl_matrix_free(pActualToApparentTransform);
     gsl_matrix_free(pApparentToActualTransform);
+    gsl_matrix_free(pNearestTransform);
 }
 
 // Public methods
@@ -43,6 +47,10 @@ bool BasicMathPlugin::Initialise(InMemoryDatabase *pInMemoryDatabase)
     MathPlugin::Initialise(pInMemoryDatabase);
     InMemoryDatabase::AlignmentDatabaseType &SyncPoints = pInMemoryDatabase->GetAlignmentDatabase();
 
+    // Forget anything cached from the previous set of sync points
+    LastActualFace = nullptr;
+    std::fill_n(NearestSyncPoints, 3, SIZE_MAX);
+
     /// See how many entries there are in the in memory database.
     /// - If just one use a hint to mounts approximate alignment, this can either be ZENITH,
     /// NORTH_CELESTIAL_POLE or SOUTH_CELESTIAL_POLE. The hint is used to make a dummy second
@@ -382,25 +390,22 @@ bool BasicMathPlugin::TransformCelestialToTelescope(const double RightAscension,
         case 2:
         case 3:
         {
-            gsl_vector *pGSLActualVector = gsl_vector_alloc(3);
-            gsl_vector_set(pGSLActualVector, 0, ActualVector.x);
-            gsl_vector_set(pGSLActualVector, 1, ActualVector.y);
-            gsl_vector_set(pGSLActualVector, 2, ActualVector.z);
-            gsl_vector *pGSLApparentVector = gsl_vector_alloc(3);
-            MatrixVectorMultiply(pActualToApparentTransform, pGSLActualVector, pGSLApparentVector);
-            ApparentTelescopeDirectionVector.x = gsl_vector_get(pGSLApparentVector, 0);
-            ApparentTelescopeDirectionVector.y = gsl_vector_get(pGSLApparentVector, 1);
-            ApparentTelescopeDirectionVector.z = gsl_vector_get(pGSLApparentVector, 2);
+            // This runs on every telescope status update, so keep the vectors on the stack
+            double Actual[3] = { ActualVector.x, ActualVector.y, ActualVector.z };
+            double Apparent[3];
+            gsl_vector_view GSLActualVector   = gsl_vector_view_array(Actual, 3);
+            gsl_vector_view GSLApparentVector = gsl_vector_view_array(Apparent, 3);
+            MatrixVectorMultiply(pActualToApparentTransform, &GSLActualVector.vector, &GSLApparentVector.vector);
+            ApparentTelescopeDirectionVector.x = Apparent[0];
+            ApparentTelescopeDirectionVector.y = Apparent[1];
+            ApparentTelescopeDirectionVector.z = Apparent[2];
             ApparentTelescopeDirectionVector.Normalise();
-            gsl_vector_free(pGSLActualVector);
-            gsl_vector_free(pGSLApparentVector);
             break;
         }
 
         default:
         {
             gsl_matrix *pTransform;
-            gsl_matrix *pComputedTransform = nullptr;
             // Scale the actual telescope direction vector to make sure it traverses the unit sphere.
             TelescopeDirectionVector ScaledActualVector = ActualVector * 2.0;
             // Shoot the scaled vector in the into the list of actual facets
@@ -409,7 +414,14 @@ bool BasicMathPlugin::TransformCelestialToTelescope(const double RightAscension,
 #ifdef CONVEX_HULL_DEBUGGING
             int ActualFaces = 0;
 #endif
-            if (nullptr != CurrentFace)
+            // A tracking mount moves slowly across the sky, so try the face used last time first
+            if (nullptr != LastActualFace &&
+                    RayTriangleIntersection(ScaledActualVector,
+                                            ActualDirectionCosines[LastActualFace->vertex[0]->vnum - 1],
+                                            ActualDirectionCosines[LastActualFace->vertex[1]->vnum - 1],
+                                            ActualDirectionCosines[LastActualFace->vertex[2]->vnum - 1]))
+                pTransform = LastActualFace->pMatrix;
+            else if (nullptr != CurrentFace)
             {
                 do
                 {
@@ -442,77 +454,64 @@ bool BasicMathPlugin::TransformCelestialToTelescope(const double RightAscension,
                 while (CurrentFace != ActualConvexHull.faces);
                 if (CurrentFace == ActualConvexHull.faces)
                 {
-                    // Find the three nearest points and build a transform
-                    std::map<double, const AlignmentDatabaseEntry *> NearestMap;
-                    for (InMemoryDatabase::AlignmentDatabaseType::const_iterator Itr = SyncPoints.begin();
-                            Itr != SyncPoints.end(); Itr++)
+                    // Find the three nearest points and build a transform. The direction cosines
+                    // of the sync points were worked out by Initialise, compare squared distances.
+                    size_t Nearest[3] = { SIZE_MAX, SIZE_MAX, SIZE_MAX };
+                    double NearestDistance[3];
+                    std::fill_n(NearestDistance, 3, std::numeric_limits<double>::max());
+                    for (size_t Index = 0; Index < ActualDirectionCosines.size(); Index++)
                     {
-                        INDI::IEquatorialCoordinates RaDec;
-                        INDI::IHorizontalCoordinates ActualPoint;
-                        RaDec.rightascension  = (*Itr).RightAscension;
-                        RaDec.declination = (*Itr).Declination;
-                        EquatorialToHorizontal(&RaDec, &Position, (*Itr).ObservationJulianDate, &ActualPoint);
-                        TelescopeDirectionVector ActualDirectionCosine =
-                            TelescopeDirectionVectorFromAltitudeAzimuth(ActualPoint);
-                        NearestMap[(ActualDirectionCosine - ActualVector).Length()] = &(*Itr);
+                        TelescopeDirectionVector Difference = ActualDirectionCosines[Index] - ActualVector;
+                        double Distance                     = Difference ^ Difference;
+                        int Slot                            = 3;
+                        while (Slot > 0 && Distance < NearestDistance[Slot - 1])
+                        {
+                            if (Slot < 3)
+                            {
+                                NearestDistance[Slot] = NearestDistance[Slot - 1];
+                                Nearest[Slot]         = Nearest[Slot - 1];
+                            }
+                            Slot--;
+                        }
+                        if (Slot < 3)
+                        {
+                            NearestDistance[Slot] = Distance;
+                            Nearest[Slot]         = Index;
+                        }
                     }
-                    // First compute local horizontal coordinates for the three sync points
-                    std::map<double, const AlignmentDatabaseEntry *>::const_iterator Nearest = NearestMap.begin();
-                    const AlignmentDatabaseEntry *pEntry1                                    = (*Nearest).second;
-                    Nearest++;
-                    const AlignmentDatabaseEntry *pEntry2 = (*Nearest).second;
-                    Nearest++;
-                    const AlignmentDatabaseEntry *pEntry3 = (*Nearest).second;
-                    INDI::IHorizontalCoordinates ActualSyncPoint1;
-                    INDI::IHorizontalCoordinates ActualSyncPoint2;
-                    INDI::IHorizontalCoordinates ActualSyncPoint3;
-                    INDI::IEquatorialCoordinates RaDec1;
-                    INDI::IEquatorialCoordinates RaDec2;
-                    INDI::IEquatorialCoordinates RaDec3;
-                    RaDec1.declination = pEntry1->Declination;
-                    RaDec1.rightascension  = pEntry1->RightAscension;
-                    RaDec2.declination = pEntry2->Declination;
-                    RaDec2.rightascension  = pEntry2->RightAscension;
-                    RaDec3.declination = pEntry3->Declination;
-                    RaDec3.rightascension = pEntry3->RightAscension;
-                    EquatorialToHorizontal(&RaDec1, &Position, pEntry1->ObservationJulianDate, &ActualSyncPoint1);
-                    EquatorialToHorizontal(&RaDec2, &Position, pEntry2->ObservationJulianDate, &ActualSyncPoint2);
-                    EquatorialToHorizontal(&RaDec3, &Position, pEntry3->ObservationJulianDate, &ActualSyncPoint3);
-
-                    // Now express these coordinates as normalised direction vectors (a.k.a direction cosines)
-                    TelescopeDirectionVector ActualDirectionCosine1 =
-                        TelescopeDirectionVectorFromAltitudeAzimuth(ActualSyncPoint1);
-                    TelescopeDirectionVector ActualDirectionCosine2 =
-                        TelescopeDirectionVectorFromAltitudeAzimuth(ActualSyncPoint2);
-                    TelescopeDirectionVector ActualDirectionCosine3 =
-                        TelescopeDirectionVectorFromAltitudeAzimuth(ActualSyncPoint3);
-                    pComputedTransform = gsl_matrix_alloc(3, 3);
-                    CalculateTransformMatrices(ActualDirectionCosine1, ActualDirectionCosine2, ActualDirectionCosine3,
-                                               pEntry1->TelescopeDirection, pEntry2->TelescopeDirection,
-                                               pEntry3->TelescopeDirection, pComputedTransform, nullptr);
-                    pTransform = pComputedTransform;
+                    // Rebuild the transform only when the nearest points change
+                    if (!std::equal(Nearest, Nearest + 3, NearestSyncPoints))
+                    {
+                        CalculateTransformMatrices(ActualDirectionCosines[Nearest[0]],
+                                                   ActualDirectionCosines[Nearest[1]],
+                                                   ActualDirectionCosines[Nearest[2]],
+                                                   SyncPoints[Nearest[0]].TelescopeDirection,
+                                                   SyncPoints[Nearest[1]].TelescopeDirection,
+                                                   SyncPoints[Nearest[2]].TelescopeDirection, pNearestTransform,
+                                                   nullptr);
+                        std::copy(Nearest, Nearest + 3, NearestSyncPoints);
+                    }
+                    pTransform = pNearestTransform;
                 }
                 else
-                    pTransform = CurrentFace->pMatrix;
+                {
+                    LastActualFace = CurrentFace;
+                    pTransform     = CurrentFace->pMatrix;
+                }
             }
             else
                 return false;
 
             // OK - got an intersection - CurrentFace is pointing at the face
-            gsl_vector *pGSLActualVector = gsl_vector_alloc(3);
-            gsl_vector_set(pGSLActualVector, 0, ActualVector.x);
-            gsl_vector_set(pGSLActualVector, 1, ActualVector.y);
-            gsl_vector_set(pGSLActualVector, 2, ActualVector.z);
-            gsl_vector *pGSLApparentVector = gsl_vector_alloc(3);
-            MatrixVectorMultiply(pTransform, pGSLActualVector, pGSLApparentVector);
-            ApparentTelescopeDirectionVector.x = gsl_vector_get(pGSLApparentVector, 0);
-            ApparentTelescopeDirectionVector.y = gsl_vector_get(pGSLApparentVector, 1);
-            ApparentTelescopeDirectionVector.z = gsl_vector_get(pGSLApparentVector, 2);
+            double Actual[3] = { ActualVector.x, ActualVector.y, ActualVector.z };
+            double Apparent[3];
+            gsl_vector_view GSLActualVector   = gsl_vector_view_array(Actual, 3);
+            gsl_vector_view GSLApparentVector = gsl_vector_view_array(Apparent, 3);
+            MatrixVectorMultiply(pTransform, &GSLActualVector.vector, &GSLApparentVector.vector);
+            ApparentTelescopeDirectionVector.x = Apparent[0];
+            ApparentTelescopeDirectionVector.y = Apparent[1];
+            ApparentTelescopeDirectionVector.z = Apparent[2];
             ApparentTelescopeDirectionVector.Normalise();
-            gsl_vector_free(pGSLActualVector);
-            gsl_vector_free(pGSLApparentVector);
-            if (nullptr != pComputedTransform)
-                gsl_matrix_free(pComputedTransform);
             break;
         }
     }
@@ -103,6 +103,14 @@ class BasicMathPlugin : public AlignmentSubsystemForMathPlugins
     ConvexHull ApparentConvexHull;
     // Actual direction cosines for the 4+ case
     std::vector<TelescopeDirectionVector> ActualDirectionCosines;
+
+    // Actual face the last celestial to telescope transform went through, tried first next time
+    ConvexHull::tFace LastActualFace { nullptr };
+
+    // Transform built from the three sync points nearest to a direction outside the actual hull,
+    // kept for as long as the same three points stay the nearest
+    gsl_matrix *pNearestTransform;
+    size_t NearestSyncPoints[3];
 };
 
 } // namespace AlignmentSubsystem
@@ -117,6 +117,12 @@ BaseClientPrivate::~BaseClientPrivate()
          *
          */
     }
+    locker.unlock();
+
+    stopBLOBDecoders();
+
+    if (blobInflateReady)
+        inflateEnd(&blobInflate);
 }
 
 void BaseClientPrivate::clear()
@@ -376,6 +382,9 @@ void BaseClientPrivate::listenINDI()
 
     clear();
     LilXML *lillp = newLilXML();
+    setXMLContentHandler(lillp, &BaseClientPrivate::blobContent, this);
+    blobStreaming = false;
+    blobStreamsDone.clear();
 
     /* read from server, exit if find all requested properties */
     while (!sAboutToClose)
@@ -433,6 +442,7 @@ void BaseClientPrivate::listenINDI()
                 if (verbose)
                     prXMLEle(stderr, root, 0);
 
+                handOverBLOBStreams(root);
                 int err_code = dispatchCommand(root, msg);
 
                 if (err_code < 0)
@@ -445,7 +455,9 @@ void BaseClientPrivate::listenINDI()
                     }
                 }
 
-                delXMLEle(root); // not yet, delete and continue
+                if (root != blobQueuedRoot)
+                    delXMLEle(root); // not yet, delete and continue
+                blobQueuedRoot = nullptr;
                 inode++;
                 root = nodes[inode];
             }
@@ -456,7 +468,8 @@ void BaseClientPrivate::listenINDI()
 
     delLilXML(lillp);
 
-    int exit_code;
+    // Workers may still be in newBLOB() and send to the server, which needs sSocketBusy
+    waitBLOBDecoders();
 
     {
         std::lock_guard<std::mutex> locker(sSocketBusy);
@@ -474,13 +487,10 @@ void BaseClientPrivate::listenINDI()
 #endif
         clear();
         cDeviceNames.clear();
+        // The destructor may free the client as soon as it sees this, do not touch it afterwards
         sConnected = false;
         sSocketChanged.notify_all();
-
-        exit_code = sAboutToClose ? sExitCode : -1;
     }
-
-    disconnect(exit_code);
 }
 
 size_t BaseClientPrivate::sendData(const void *data, size_t size)
@@ -546,7 +556,7 @@ int BaseClientPrivate::dispatchCommand(XMLEle *root, char *errmsg)
         if (!strcmp(tag, "defBLOBVector"))
             return dp->buildProp(root, errmsg);
         else if (!strcmp(tag, "setBLOBVector"))
-            return dp->setValue(root, errmsg);
+            return setBLOB(dp, root, errmsg);
 
         // Ignore everything else
         return 0;
@@ -569,17 +579,297 @@ int BaseClientPrivate::dispatchCommand(XMLEle *root, char *errmsg)
             (!strcmp(tag, "defSwitchVector")) || (!strcmp(tag, "defLightVector")) ||
             (!strcmp(tag, "defBLOBVector")))
         return dp->buildProp(root, errmsg);
+    else if (!strcmp(tag, "setBLOBVector"))
+        return setBLOB(dp, root, errmsg);
     else if (!strcmp(tag, "setTextVector") || !strcmp(tag, "setNumberVector") ||
-             !strcmp(tag, "setSwitchVector") || !strcmp(tag, "setLightVector") ||
-             !strcmp(tag, "setBLOBVector"))
+             !strcmp(tag, "setSwitchVector") || !strcmp(tag, "setLightVector"))
         return dp->setValue(root, errmsg);
 
     return INDI_DISPATCH_ERROR;
 }
 
 
+int BaseClientPrivate::setBLOB(INDI::BaseDevice *dp, XMLEle *root, char *errmsg)
+{
+    std::unique_lock<std::mutex> lock(blobLock);
+
+    // Do not read further ahead than the workers keep up with
+    blobChanged.wait(lock, [this] { return blobJobs.size() < 2 * blobWorkers.size() || blobQuit; });
+
+    if (blobQuit)
+    {
+        lock.unlock();
+        return dp->setValue(root, errmsg);
+    }
+
+    blobJobs.push_back({dp, root, std::string(dp->getDeviceName()) + "." + findXMLAttValu(root, "name")});
+    blobQueuedRoot = root;
+    blobChanged.notify_all();
+
+    return 0;
+}
+
+void BaseClientPrivate::startBLOBDecoders(int count)
+{
+    stopBLOBDecoders();
+
+    std::lock_guard<std::mutex> lock(blobLock);
+    if (count <= 0)
+        return;
+
+    blobQuit = false;
+    for (int i = 0; i < count; i++)
+        blobWorkers.emplace_back(&BaseClientPrivate::decodeBLOBs, this);
+}
+
+void BaseClientPrivate::stopBLOBDecoders()
+{
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(blobLock);
+        blobQuit = true;
+        workers.swap(blobWorkers);
+    }
+    blobChanged.notify_all();
+
+    // Workers finish the queue before leaving
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void BaseClientPrivate::waitBLOBDecoders()
+{
+    std::unique_lock<std::mutex> lock(blobLock);
+    blobChanged.wait(lock, [this] { return blobJobs.empty() && blobBusy.empty(); });
+}
+
+void BaseClientPrivate::waitBLOBDecoders(const std::string &property)
+{
+    std::unique_lock<std::mutex> lock(blobLock);
+    blobChanged.wait(lock, [&]
+    {
+        return blobBusy.count(property) == 0 && std::none_of(blobJobs.begin(), blobJobs.end(),
+                [&](const BLOBJob & oneJob) { return oneJob.property == property; });
+    });
+}
+
+void BaseClientPrivate::decodeBLOBs()
+{
+    char errmsg[MAXRBUF];
+    std::unique_lock<std::mutex> lock(blobLock);
+
+    for (;;)
+    {
+        // The oldest BLOB whose property is not being decoded by another worker
+        auto job = blobJobs.end();
+        blobChanged.wait(lock, [&]
+        {
+            job = std::find_if(blobJobs.begin(), blobJobs.end(), [this](const BLOBJob & oneJob)
+            {
+                return blobBusy.count(oneJob.property) == 0;
+            });
+            return job != blobJobs.end() || (blobQuit && blobJobs.empty());
+        });
+
+        if (job == blobJobs.end())
+            return;
+
+        BLOBJob current = std::move(*job);
+        blobJobs.erase(job);
+        blobBusy.insert(current.property);
+        blobChanged.notify_all();
+        lock.unlock();
+
+        if (current.device->setValue(current.root, errmsg) < 0)
+            IDLog("Dispatch command error(%d): %s\n", -1, errmsg);
+        delXMLEle(current.root);
+
+        lock.lock();
+        blobBusy.erase(current.property);
+        blobChanged.notify_all();
+    }
+}
+
+int BaseClientPrivate::blobContent(void *ctx, XMLEle *ep, const char *data, int len)
+{
+    auto self = static_cast<BaseClientPrivate *>(ctx);
+
+    if (data == nullptr)
+        return self->beginBLOBStream(ep);
+
+    self->decodeBLOBStream(data, len);
+    return 0;
+}
+
+bool BaseClientPrivate::beginBLOBStream(XMLEle *ep)
+{
+    XMLEle *root = parentXMLEle(ep);
+    if (root == nullptr || strcmp(tagXMLEle(ep), "oneBLOB") || strcmp(tagXMLEle(root), "setBLOBVector"))
+        return false;
+
+    // The previous oneBLOB, of this vector or of one parsed from the same chunk
+    endBLOBStream();
+
+    const char *device = findXMLAttValu(root, "device");
+    const char *name   = findXMLAttValu(root, "name");
+    std::string property = std::string(device) + "." + name;
+    std::string blob     = property + "." + findXMLAttValu(ep, "name");
+
+    // Vectors are dispatched once the whole chunk is parsed. Until then an earlier BLOB of the element still
+    // needs its buffer, which the allocator may hand out again, so this one is decoded as usual
+    for (const auto &one : blobStreamsDone)
+    {
+        if (one.blob == blob)
+            return false;
+    }
+    BaseClient::BLOBAllocator allocator;
+    {
+        std::lock_guard<std::mutex> locker(blobAllocatorLock);
+        auto it = blobAllocators.find(property);
+        if (it == blobAllocators.end())
+            return false;
+        allocator = it->second;
+    }
+
+    size_t size = strtoul(findXMLAttValu(ep, "size"), nullptr, 10);
+    if (size == 0)
+        return false;
+
+    char errmsg[MAXRBUF];
+    INDI::BaseDevice *dp = findDev(device, errmsg);
+    if (dp == nullptr)
+        return false;
+
+    auto bvp = dp->getBLOB(name);
+    IBLOB *bp = bvp ? IUFindBLOB(bvp, findXMLAttValu(ep, "name")) : nullptr;
+    if (bp == nullptr)
+        return false;
+
+    // The allocator may hand out the buffer a worker is still delivering
+    waitBLOBDecoders(property);
+
+    void *data = allocator(bp, size);
+    if (data == nullptr)
+        return false;
+
+    blobStream.root       = root;
+    blobStream.element    = ep;
+    blobStream.blob       = blob;
+    blobStream.device     = dp;
+    blobStream.data       = static_cast<uint8_t *>(data);
+    blobStream.capacity   = size;
+    blobStream.size       = 0;
+    blobStream.compressed = strstr(findXMLAttValu(ep, "format"), ".z") != nullptr;
+    blobStream.ended      = false;
+    blobStream.error.clear();
+    blobTextSize = 0;
+
+    if (blobStream.compressed)
+    {
+        int r = blobInflateReady ? inflateReset(&blobInflate) : inflateInit(&blobInflate);
+        blobInflateReady = blobInflateReady || r == Z_OK;
+        if (r != Z_OK)
+            blobStream.error = "compression error: " + std::to_string(r);
+    }
+
+    blobStreaming = true;
+    return true;
+}
+
+void BaseClientPrivate::decodeBLOBStream(const char *data, int len)
+{
+    if (!blobStream.error.empty() || blobStream.ended)
+        return;
+
+    // Drop line breaks, after what is left of the last group
+    if (blobText.size() < blobTextSize + len)
+        blobText.resize(blobTextSize + len);
+    char *text = blobText.data() + blobTextSize;
+    for (const char *end = data + len; data < end; data++)
+    {
+        if (!isspace(static_cast<unsigned char>(*data)))
+            *text++ = *data;
+    }
+
+    size_t textSize = text - blobText.data();
+    size_t groups   = textSize / 4 * 4;
+    size_t room     = blobStream.capacity - blobStream.size;
+
+    // Whole groups are written out even when padded, so only decode in place when they fit
+    char *out = reinterpret_cast<char *>(blobStream.data + blobStream.size);
+    if (blobStream.compressed || groups / 4 * 3 > room)
+    {
+        if (blobBinary.size() < groups / 4 * 3)
+            blobBinary.resize(groups / 4 * 3);
+        out = reinterpret_cast<char *>(blobBinary.data());
+    }
+
+    size_t decoded = groups > 0 ? from64tobits_fast(out, blobText.data(), groups) : 0;
+
+    if (blobStream.compressed)
+    {
+        blobInflate.next_in   = reinterpret_cast<Bytef *>(out);
+        blobInflate.avail_in  = decoded;
+        blobInflate.next_out  = blobStream.data + blobStream.size;
+        blobInflate.avail_out = room;
+
+        int r = inflate(&blobInflate, Z_NO_FLUSH);
+        blobStream.size = blobStream.capacity - blobInflate.avail_out;
+        if (r == Z_STREAM_END)
+            blobStream.ended = true; // anything after the stream is the block index
+        else if (r != Z_OK && r != Z_BUF_ERROR)
+            blobStream.error = "compression error: " + std::to_string(r);
+        else if (blobInflate.avail_in > 0)
+            blobStream.error = "is larger than its announced size";
+    }
+    else if (out != reinterpret_cast<char *>(blobStream.data + blobStream.size))
+    {
+        if (decoded > room)
+            blobStream.error = "is larger than its announced size";
+        else
+            memcpy(blobStream.data + blobStream.size, out, decoded);
+    }
+
+    if (blobStream.error.empty() && !blobStream.compressed)
+        blobStream.size += decoded;
+
+    memmove(blobText.data(), blobText.data() + groups, textSize - groups);
+    blobTextSize = textSize - groups;
+}
+
+void BaseClientPrivate::endBLOBStream()
+{
+    if (!blobStreaming)
+        return;
+
+    if (blobStream.error.empty() && blobStream.compressed && !blobStream.ended)
+        blobStream.error = "compression error: " + std::to_string(Z_DATA_ERROR);
+    else if (blobStream.error.empty() &&
+             (blobStream.size != blobStream.capacity || (!blobStream.compressed && blobTextSize != 0)))
+        blobStream.error = "is smaller than its announced size";
+
+    blobStreamsDone.push_back(blobStream);
+    blobStreaming = false;
+}
+
+void BaseClientPrivate::handOverBLOBStreams(XMLEle *root)
+{
+    endBLOBStream();
+
+    // Streams of the vectors parsed after this one wait for their own turn
+    auto first = std::stable_partition(blobStreamsDone.begin(), blobStreamsDone.end(), [root](const BLOBStream & one)
+    {
+        return one.root != root;
+    });
+    for (auto one = first; one != blobStreamsDone.end(); ++one)
+        one->device->addStreamedBLOB(one->element, one->data, one->size, one->error);
+    blobStreamsDone.erase(first, blobStreamsDone.end());
+}
+
 int BaseClientPrivate::deleteDevice(const char *devName, char *errmsg)
 {
+    waitBLOBDecoders();
+
     for (auto devicei = cDevices.begin(); devicei != cDevices.end();)
     {
         if ((*devicei)->isDeviceNameMatch(devName))
@@ -608,6 +898,8 @@ int BaseClientPrivate::delPropertyCmd(XMLEle *root, char *errmsg)
     XMLAtt *ap;
     INDI::BaseDevice *dp;
 
+    waitBLOBDecoders();
+
     /* dig out device and optional property name */
     dp = findDev(root, 0, errmsg);
     if (!dp)
@@ -1102,6 +1394,23 @@ BLOBHandling INDI::BaseClient::getBLOBMode(const char *dev, const char *prop)
     return bHandle;
 }
 
+void INDI::BaseClient::setBLOBDecodeWorkers(int count)
+{
+    D_PTR(BaseClient);
+    d->startBLOBDecoders(count);
+}
+
+void INDI::BaseClient::setBLOBAllocator(const char *dev, const char *prop, BLOBAllocator allocator)
+{
+    D_PTR(BaseClient);
+    std::lock_guard<std::mutex> locker(d->blobAllocatorLock);
+
+    if (allocator)
+        d->blobAllocators[std::string(dev) + "." + prop] = allocator;
+    else
+        d->blobAllocators.erase(std::string(dev) + "." + prop);
+}
+
 bool INDI::BaseClient::getDevices(std::vector<INDI::BaseDevice *> &deviceList, uint16_t driverInterface )
 {
     D_PTR(BaseClient);
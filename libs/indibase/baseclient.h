@@ -21,6 +21,7 @@
 #include "indiapi.h"
 #include "indibase.h"
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -188,6 +189,40 @@ class INDI::BaseClient : public INDI::BaseMediator
          */
         BLOBHandling getBLOBMode(const char *dev, const char *prop = nullptr);
 
+        /** @brief setBLOBDecodeWorkers Decode incoming BLOBs on worker threads
+         *
+         *  By default BLOBs are decoded and uncompressed by the thread reading from the server, so no other
+         *  property is updated while a large BLOB is being decoded. With workers, the reading thread hands BLOBs
+         *  over and carries on, and BLOBs of different properties are decoded in parallel.
+         *
+         *  newBLOB() is then called from a worker thread. BLOBs of the same property are still decoded one at a
+         *  time and delivered in the order they were received.
+         *  @param count number of worker threads, 0 to decode BLOBs on the reading thread.
+         */
+        void setBLOBDecodeWorkers(int count);
+
+        /** @brief Returns the memory to decode a BLOB of @a size bytes into, or nullptr to decode it as usual */
+        typedef std::function<void *(IBLOB *bp, size_t size)> BLOBAllocator;
+
+        /** @brief setBLOBAllocator Decode the BLOBs of a property into client memory as they arrive
+         *
+         *  Usually a BLOB is collected in full, then decoded and uncompressed into new buffers. With an allocator,
+         *  the reading thread asks for a buffer as soon as a BLOB of the property starts arriving and decodes and
+         *  uncompresses the data straight into it while it is received. In newBLOB(), bp->blob then points to that
+         *  buffer. It stays owned by the client and must remain valid until the next BLOB of the element arrives;
+         *  the allocator may return the same buffer every time so frames are decoded without any allocation.
+         *  With decode workers, the allocator is only called once the previous BLOB of the property has been
+         *  delivered, so reusing the buffer is safe there too, at the cost of the reading thread waiting for
+         *  newBLOB() of that property.
+         *
+         *  The allocator is called on the reading thread. It should not block.
+         *  @param dev name of device.
+         *  @param prop name of BLOB property.
+         *  @param allocator returns at least @a size bytes, or nullptr to decode this BLOB as usual. Pass nullptr to
+         *  remove the allocator of the property.
+         */
+        void setBLOBAllocator(const char *dev, const char *prop, BLOBAllocator allocator);
+
         /** @brief Send new Text command to server */
         void sendNewText(ITextVectorProperty *pp);
         /** @brief Send new Text command to server */
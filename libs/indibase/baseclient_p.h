@@ -8,10 +8,14 @@
 #include <atomic>
 #include <string>
 #include <set>
+#include <deque>
 #include <thread>
 #include <cstdint>
 
 #include <lilxml.h>
+#include <zlib.h>
+
+#include "baseclient.h"
 
 #ifdef _WINDOWS
 #include <WinSock2.h>
@@ -33,6 +37,27 @@ struct BLOBMode
     BLOBHandling blobMode;
 };
 
+struct BLOBJob
+{
+    INDI::BaseDevice *device;
+    XMLEle *root;
+    std::string property; // device.name, decoded by one worker at a time
+};
+
+struct BLOBStream
+{
+    XMLEle *root;            // setBLOBVector, only compared against
+    XMLEle *element;         // oneBLOB being received
+    std::string blob;        // device.property.element
+    INDI::BaseDevice *device;
+    uint8_t *data;           // client memory
+    size_t capacity;
+    size_t size;
+    bool compressed;
+    bool ended;              // compressed stream complete
+    std::string error;
+};
+
 class BaseClientPrivate
 {
 public:
@@ -55,7 +80,7 @@ public:
     
 public:
     void listenINDI();
-    /** @brief clear Clear devices and blob modes */
+    /** @brief clear Clear devices and blob modes, once the BLOB decoders are idle */
     void clear();
 
 public:
@@ -81,6 +106,27 @@ public:
     /**  Process messages */
     int messageCmd(XMLEle *root, char *errmsg);
 
+public:
+    /** @brief Set BLOB values, on a decode worker if there are any. A queued root is owned by the worker */
+    int setBLOB(INDI::BaseDevice *dp, XMLEle *root, char *errmsg);
+
+    void startBLOBDecoders(int count);
+    void stopBLOBDecoders();
+    /** @brief Wait until queued BLOBs are delivered, before their device or property goes away */
+    void waitBLOBDecoders();
+    /** @brief Wait until the queued BLOBs of property (device.name) are delivered */
+    void waitBLOBDecoders(const std::string &property);
+    void decodeBLOBs();
+
+public:
+    /** @brief lilxml content handler, decodes oneBLOB content into client memory as it arrives */
+    static int blobContent(void *ctx, XMLEle *ep, const char *data, int len);
+    bool beginBLOBStream(XMLEle *ep);
+    void decodeBLOBStream(const char *data, int len);
+    void endBLOBStream();
+    /** @brief Give the devices the BLOBs streamed for root, before it is dispatched */
+    void handOverBLOBStreams(XMLEle *root);
+
 public:
     BaseClient *parent;
 
@@ -109,6 +155,27 @@ public:
     // Parse & FILE buffers for IO
 
     uint32_t timeout_sec, timeout_us;
+
+    // BLOB decode workers
+    std::vector<std::thread> blobWorkers;
+    std::deque<BLOBJob> blobJobs;
+    std::set<std::string> blobBusy;
+    std::mutex blobLock;
+    std::condition_variable blobChanged;
+    bool blobQuit {true};
+    XMLEle *blobQueuedRoot {nullptr};
+
+    // BLOBs decoded while received, only used by the reading thread except for blobAllocators
+    std::map<std::string, BaseClient::BLOBAllocator> blobAllocators; // by device.property
+    std::mutex blobAllocatorLock;
+    BLOBStream blobStream {};
+    bool blobStreaming {false};
+    std::vector<BLOBStream> blobStreamsDone;
+    std::vector<char> blobText;      // base64 without line breaks, partial group at the front
+    size_t blobTextSize {0};
+    std::vector<uint8_t> blobBinary; // decoded, when it cannot go to the client memory directly
+    z_stream blobInflate {};
+    bool blobInflateReady {false};
 };
 
 }
@@ -22,6 +22,7 @@
 #include "base64.h"
 #include "config.h"
 #include "indicom.h"
+#include "indiblockcompress.h"
 #include "indistandardproperty.h"
 #include "locale_compat.h"
 
@@ -66,9 +67,47 @@ BaseDevicePrivate::BaseDevicePrivate()
 BaseDevicePrivate::~BaseDevicePrivate()
 {
     delLilXML(lp);
+    pIndex.clear();
     pAll.clear();
 }
 
+void BaseDevicePrivate::addProperty(const INDI::Property &property)
+{
+    syncIndex();
+    pAll.push_back(property);
+    if (property.getName() != nullptr)
+        pIndex.emplace(property.getName(), property);
+    pIndexed = pAll.size();
+}
+
+void BaseDevicePrivate::syncIndex() const
+{
+    if (pIndexed == pAll.size())
+        return;
+
+    pIndex.clear();
+    for (const auto &oneProp : pAll)
+        if (oneProp.getName() != nullptr)
+            pIndex.emplace(oneProp.getName(), oneProp);
+    pIndexed = pAll.size();
+}
+
+bool BaseDevicePrivate::takeStreamedBLOB(const XMLEle *element, StreamedBLOB &streamed)
+{
+    std::lock_guard<std::mutex> lock(streamLock);
+    auto it = std::find_if(streamedBLOBs.begin(), streamedBLOBs.end(), [element](const StreamedBLOB & one)
+    {
+        return one.element == element;
+    });
+
+    if (it == streamedBLOBs.end())
+        return false;
+
+    streamed = *it;
+    streamedBLOBs.erase(it);
+    return true;
+}
+
 BaseDevice::BaseDevice()
     : d_ptr(new BaseDevicePrivate)
 { }
@@ -134,6 +173,17 @@ INDI::Property BaseDevice::getProperty(const char *name, INDI_PROPERTY_TYPE type
     D_PTR(const BaseDevice);
     std::lock_guard<std::mutex> lock(d->m_Lock);
 
+    d->syncIndex();
+
+    auto it = d->pIndex.find(name);
+    if (it == d->pIndex.end())
+        return INDI::Property();
+
+    const auto &indexed = it->second;
+    if ((type == indexed.getType() || type == INDI_UNKNOWN) && indexed.getRegistered() && indexed.isNameMatch(name))
+        return indexed;
+
+    // Another property of the same name further down, or the indexed one was renamed
     for (const auto &oneProp : getProperties())
     {
         if (type != oneProp.getType() && type != INDI_UNKNOWN)
@@ -168,6 +218,7 @@ int BaseDevice::removeProperty(const char *name, char *errmsg)
 
     std::lock_guard<std::mutex> lock(d->m_Lock);
 
+    d->syncIndex();
     d->pAll.erase_if([&name, &result](INDI::Property & prop) -> bool
     {
 #if 0
@@ -198,6 +249,12 @@ int BaseDevice::removeProperty(const char *name, char *errmsg)
             return false;
     });
 
+    if (result == 0)
+    {
+        d->pIndex.erase(name);
+        d->pIndexed = d->pAll.size();
+    }
+
     if (result != 0)
         snprintf(errmsg, MAXRBUF, "Error: Property %s not found in device %s.", name, getDeviceName());
 
@@ -479,7 +536,7 @@ int BaseDevice::buildProp(XMLEle *root, char *errmsg)
     indiProp.setTimeout(atoi(findXMLAttValu(root, "timeout")));
 
     std::unique_lock<std::mutex> lock(d->m_Lock);
-    d->pAll.push_back(indiProp);
+    d->addProperty(indiProp);
     lock.unlock();
 
     //IDLog("Adding number property %s to list.\n", indiProp->getName());
@@ -715,6 +772,40 @@ int BaseDevice::setBLOB(IBLOBVectorProperty *bvp, XMLEle *root, char *errmsg)
                     continue;
                 }
 
+                StreamedBLOB streamed;
+                if (d->takeStreamedBLOB(ep, streamed))
+                {
+                    if (!streamed.error.empty())
+                    {
+                        snprintf(errmsg, MAXRBUF, "INDI: %s.%s.%s %s", blobEL->bvp->device, blobEL->bvp->name,
+                                 blobEL->name, streamed.error.c_str());
+                        return -1;
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(d->streamLock);
+                        if (d->clientBLOBs.insert(blobEL).second)
+                            free(blobEL->blob);
+                    }
+                    blobEL->blob    = streamed.data;
+                    blobEL->bloblen = blobEL->size = streamed.size;
+
+                    strncpy(blobEL->format, valuXMLAtt(fa), MAXINDIFORMAT);
+                    if (strstr(blobEL->format, ".z"))
+                        blobEL->format[strlen(blobEL->format) - 2] = '\0';
+
+                    if (d->mediator)
+                        d->mediator->newBLOB(blobEL);
+                    continue;
+                }
+
+                {
+                    // Never resize memory the client handed over
+                    std::lock_guard<std::mutex> lock(d->streamLock);
+                    if (d->clientBLOBs.erase(blobEL))
+                        blobEL->blob = nullptr;
+                }
+
                 blobEL->size    = blobSize;
                 uint32_t base64_encoded_size = pcdatalenXMLEle(ep);
                 uint32_t base64_decoded_size = 3 * base64_encoded_size / 4;
@@ -726,7 +817,7 @@ int BaseDevice::setBLOB(IBLOBVectorProperty *bvp, XMLEle *root, char *errmsg)
                 if (strstr(blobEL->format, ".z"))
                 {
                     blobEL->format[strlen(blobEL->format) - 2] = '\0';
-                    uLongf dataSize = blobEL->size * sizeof(uint8_t);
+                    size_t dataSize = blobEL->size * sizeof(uint8_t);
                     uint8_t *dataBuffer = static_cast<uint8_t *>(malloc(dataSize));
 
                     if (dataBuffer == nullptr)
@@ -735,8 +826,7 @@ int BaseDevice::setBLOB(IBLOBVectorProperty *bvp, XMLEle *root, char *errmsg)
                         return (-1);
                     }
 
-                    int r = uncompress(dataBuffer, &dataSize, static_cast<unsigned char *>(blobEL->blob),
-                                       static_cast<uLong>(blobEL->bloblen));
+                    int r = blockUncompress(dataBuffer, &dataSize, static_cast<uint8_t *>(blobEL->blob), blobEL->bloblen);
                     if (r != Z_OK)
                     {
                         snprintf(errmsg, MAXRBUF, "INDI: %s.%s.%s compression error: %d", blobEL->bvp->device,
@@ -764,6 +854,19 @@ int BaseDevice::setBLOB(IBLOBVectorProperty *bvp, XMLEle *root, char *errmsg)
     return 0;
 }
 
+void BaseDevice::addStreamedBLOB(const XMLEle *element, void *data, size_t size, const std::string &error)
+{
+    D_PTR(BaseDevice);
+    std::lock_guard<std::mutex> lock(d->streamLock);
+
+    // An older entry for the same address is left over from an element that never reached setBLOB
+    d->streamedBLOBs.remove_if([element](const StreamedBLOB & one)
+    {
+        return one.element == element;
+    });
+    d->streamedBLOBs.push_back({element, data, size, error});
+}
+
 void BaseDevice::setDeviceName(const char *dev)
 {
     D_PTR(BaseDevice);
@@ -869,7 +972,7 @@ void BaseDevice::registerProperty(void *p, INDI_PROPERTY_TYPE type)
     else
     {
         std::lock_guard<std::mutex> lock(d->m_Lock);
-        d->pAll.push_back(INDI::Property(p, type));
+        d->addProperty(INDI::Property(p, type));
     }
 }
 
@@ -887,7 +990,7 @@ void BaseDevice::registerProperty(INDI::Property &property)
     else
     {
         std::lock_guard<std::mutex> lock(d->m_Lock);
-        d->pAll.push_back(property);
+        d->addProperty(property);
     }
 }
 
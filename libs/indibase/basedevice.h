@@ -246,6 +246,15 @@ public:
     /** @brief Parse and store BLOB in the respective vector */
     int setBLOB(IBLOBVectorProperty *pp, XMLEle *root, char *errmsg);
 
+    /** @brief Hand over the data of a oneBLOB element that was decoded while it was being received.
+     *  setBLOB() then takes the BLOB from @a data instead of the element content.
+     *  @param element the oneBLOB element, it is only compared against and never dereferenced.
+     *  @param data decoded and uncompressed BLOB, it remains owned by the caller.
+     *  @param size number of bytes in data.
+     *  @param error why decoding failed, empty if it did not.
+     */
+    void addStreamedBLOB(const XMLEle *element, void *data, size_t size, const std::string &error);
+
 protected:
     std::shared_ptr<BaseDevicePrivate> d_ptr;
     BaseDevice(BaseDevicePrivate &dd);
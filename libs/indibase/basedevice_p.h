@@ -23,25 +23,52 @@
 #include "indibase.h"
 
 #include <deque>
+#include <list>
+#include <set>
 #include <string>
 #include <mutex>
+#include <unordered_map>
 
 namespace INDI
 {
 
+struct StreamedBLOB
+{
+    const XMLEle *element; // oneBLOB this was decoded from
+    void *data;            // client memory, not owned
+    size_t size;
+    std::string error;
+};
+
 class BaseDevicePrivate
 {
 public:
     BaseDevicePrivate();
     virtual ~BaseDevicePrivate();
 
+public:
+    /** Add to pAll and the index, m_Lock must be held */
+    void addProperty(const INDI::Property &property);
+
+    /** Rebuild the index if pAll grew or shrank behind its back, m_Lock must be held */
+    void syncIndex() const;
+
+    /** Take the data the client decoded for element, if it did */
+    bool takeStreamedBLOB(const XMLEle *element, StreamedBLOB &streamed);
+
 public:
     std::string deviceName;
     BaseDevice::Properties pAll;
+    mutable std::unordered_map<std::string, INDI::Property> pIndex; // pAll by name, first of each name
+    mutable size_t pIndexed {0};                                    // pAll.size() the index was built for
     LilXML *lp {nullptr};
     INDI::BaseMediator *mediator {nullptr};
     std::deque<std::string> messageLog;
     mutable std::mutex m_Lock;
+
+    std::list<StreamedBLOB> streamedBLOBs; // handed over by the client, waiting for setBLOB
+    std::set<const IBLOB *> clientBLOBs;   // blob points to client memory
+    std::mutex streamLock;                 // for the two above
 };
 
 }
@@ -18,6 +18,7 @@
 
 #include "connectiontcp.h"
 
+#include "indicom.h"
 #include "indilogger.h"
 #include "indistandardproperty.h"
 
@@ -117,7 +118,10 @@ bool TCP::Connect()
         ts.tv_usec = 0;
 
         if (sockfd != -1)
+        {
+            tty_set_readahead(sockfd, 0);
             close(sockfd);
+        }
 
         // Lookup host name or IPv4 address
         hp = gethostbyname(hostname);
@@ -148,6 +152,9 @@ bool TCP::Connect()
             return false;
         }
 
+        // The fd number may have been read ahead on before, by whoever closed it without telling
+        tty_set_readahead(sockfd, 0);
+
         // Set the socket receiving and sending timeouts
         setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, (char *)&ts, sizeof(struct timeval));
         setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, (char *)&ts, sizeof(struct timeval));
@@ -183,6 +190,7 @@ bool TCP::Disconnect()
 {
     if (sockfd > 0)
     {
+        tty_set_readahead(sockfd, 0);
         close(sockfd);
         sockfd = PortFD = -1;
     }
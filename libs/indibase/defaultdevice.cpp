@@ -62,7 +62,16 @@ extern "C"
         const std::unique_lock<std::recursive_mutex> lock(INDI::DefaultDevicePrivate::devicesLock);
         for(auto &it : INDI::DefaultDevicePrivate::devices)
             if (dev == nullptr || strcmp(dev, it->defaultDevice->getDeviceName()) == 0)
+            {
+                auto property = it->defaultDevice->getProperty(name, INDI_SWITCH);
+                if (property.hasUpdateCallback())
+                {
+                    if (property.getSwitch()->update(states, names, n))
+                        property.emitUpdate();
+                    continue;
+                }
                 it->defaultDevice->ISNewSwitch(dev, name, states, names, n);
+            }
     }
 
     void ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n)
@@ -70,7 +79,16 @@ extern "C"
         const std::unique_lock<std::recursive_mutex> lock(INDI::DefaultDevicePrivate::devicesLock);
         for(auto &it : INDI::DefaultDevicePrivate::devices)
             if (dev == nullptr || strcmp(dev, it->defaultDevice->getDeviceName()) == 0)
+            {
+                auto property = it->defaultDevice->getProperty(name, INDI_NUMBER);
+                if (property.hasUpdateCallback())
+                {
+                    if (property.getNumber()->update(values, names, n))
+                        property.emitUpdate();
+                    continue;
+                }
                 it->defaultDevice->ISNewNumber(dev, name, values, names, n);
+            }
     }
 
     void ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n)
@@ -78,7 +96,16 @@ extern "C"
         const std::unique_lock<std::recursive_mutex> lock(INDI::DefaultDevicePrivate::devicesLock);
         for(auto &it : INDI::DefaultDevicePrivate::devices)
             if (dev == nullptr || strcmp(dev, it->defaultDevice->getDeviceName()) == 0)
+            {
+                auto property = it->defaultDevice->getProperty(name, INDI_TEXT);
+                if (property.hasUpdateCallback())
+                {
+                    if (property.getText()->update(texts, names, n))
+                        property.emitUpdate();
+                    continue;
+                }
                 it->defaultDevice->ISNewText(dev, name, texts, names, n);
+            }
     }
 
     void ISNewBLOB(const char *dev, const char *name,
@@ -88,7 +115,16 @@ extern "C"
         const std::unique_lock<std::recursive_mutex> lock(INDI::DefaultDevicePrivate::devicesLock);
         for(auto &it : INDI::DefaultDevicePrivate::devices)
             if (dev == nullptr || strcmp(dev, it->defaultDevice->getDeviceName()) == 0)
+            {
+                auto property = it->defaultDevice->getProperty(name, INDI_BLOB);
+                if (property.hasUpdateCallback())
+                {
+                    if (property.getBLOB()->update(sizes, blobsizes, blobs, formats, names, n))
+                        property.emitUpdate();
+                    continue;
+                }
                 it->defaultDevice->ISNewBLOB(dev, name, sizes, blobsizes, blobs, formats, names, n);
+            }
     }
 
     void ISSnoopDevice(XMLEle *root)
@@ -228,7 +264,7 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
 
     if (property == nullptr)
     {
-        fp = IUGetConfigFP(nullptr, getDeviceName(), "w", errmsg);
+        fp = IUBeginConfigSave(nullptr, getDeviceName(), errmsg);
 
         if (fp == nullptr)
         {
@@ -243,8 +279,12 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
 
         IUSaveConfigTag(fp, 1, getDeviceName(), silent ? 1 : 0);
 
-        fflush(fp);
-        fclose(fp);
+        if (IUEndConfigSave(fp, nullptr, getDeviceName(), errmsg) < 0)
+        {
+            if (!silent)
+                LOGF_WARN("Failed to save configuration. %s", errmsg);
+            return false;
+        }
 
         if (d->isDefaultConfigLoaded == false)
         {
@@ -364,11 +404,21 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
 
         if (propertySaved)
         {
-            fp = IUGetConfigFP(nullptr, getDeviceName(), "w", errmsg);
-            prXMLEle(fp, root, 0);
-            fflush(fp);
-            fclose(fp);
+            fp = IUBeginConfigSave(nullptr, getDeviceName(), errmsg);
+            if (fp != nullptr)
+            {
+                prXMLEle(fp, root, 0);
+                if (IUEndConfigSave(fp, nullptr, getDeviceName(), errmsg) < 0)
+                    fp = nullptr;
+            }
             delXMLEle(root);
+
+            if (fp == nullptr)
+            {
+                LOGF_WARN("Failed to save configuration. %s", errmsg);
+                return false;
+            }
+
             LOGF_DEBUG("Configuration successfully saved for %s.", property);
             return true;
         }
@@ -0,0 +1,351 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Software binning of camera frames
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Each output row is made in two steps: the input rows it covers are added
+    column by column into a row of accumulators (the vector kernels below),
+    then runs of binX accumulators are added and stored. In Bayer mode both
+    steps take every other row and column, starting on the pixel's color.
+*/
+
+#include "indibinning.h"
+#include "indicpufeatures.h"
+#include "indiparallel.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BINNING_X86
+#include <immintrin.h>
+#endif
+
+namespace INDI
+{
+
+// Below this many input pixels per part, handing it to another thread costs more than it saves
+static const size_t PIXELS_PER_PART = 1024 * 1024;
+
+namespace
+{
+
+// Accumulator wide enough for 255 x 255 binning of each pixel type
+template <typename Pixel> struct Accumulator
+{
+    typedef uint32_t type;
+};
+template <> struct Accumulator<uint32_t>
+{
+    typedef uint64_t type;
+};
+template <> struct Accumulator<float>
+{
+    typedef double type;
+};
+
+template <typename Pixel, typename Acc>
+void addRow(Acc *acc, const Pixel *row, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        acc[i] += row[i];
+}
+
+#ifdef BINNING_X86
+
+// The kernels add whole vectors only and return how many pixels they did, the scalar loop does the rest
+
+__attribute__((target("sse2"))) size_t addRow16SSE2(uint32_t *acc, const uint16_t *row, size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i *a = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(v, zero)));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(v, zero)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t addRow16AVX2(uint32_t *acc, const uint16_t *row, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i + 8));
+        __m256i *a = reinterpret_cast<__m256i *>(acc + i);
+        _mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), _mm256_cvtepu16_epi32(lo)));
+        _mm256_storeu_si256(a + 1, _mm256_add_epi32(_mm256_loadu_si256(a + 1), _mm256_cvtepu16_epi32(hi)));
+    }
+    return i;
+}
+
+__attribute__((target("sse2"))) size_t addRow8SSE2(uint32_t *acc, const uint8_t *row, size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i *a = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(a + 2, _mm_add_epi32(_mm_loadu_si128(a + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(a + 3, _mm_add_epi32(_mm_loadu_si128(a + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t addRow8AVX2(uint32_t *acc, const uint8_t *row, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i lo = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + i));
+        __m128i hi = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + i + 8));
+        __m256i *a = reinterpret_cast<__m256i *>(acc + i);
+        _mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), _mm256_cvtepu8_epi32(lo)));
+        _mm256_storeu_si256(a + 1, _mm256_add_epi32(_mm256_loadu_si256(a + 1), _mm256_cvtepu8_epi32(hi)));
+    }
+    return i;
+}
+
+#endif
+
+void addRow(uint32_t *acc, const uint16_t *row, size_t n)
+{
+    size_t i = 0;
+#ifdef BINNING_X86
+    i = cpuHasAVX2() ? addRow16AVX2(acc, row, n) : addRow16SSE2(acc, row, n);
+#endif
+    addRow<uint16_t, uint32_t>(acc + i, row + i, n - i);
+}
+
+void addRow(uint32_t *acc, const uint8_t *row, size_t n)
+{
+    size_t i = 0;
+#ifdef BINNING_X86
+    i = cpuHasAVX2() ? addRow8AVX2(acc, row, n) : addRow8SSE2(acc, row, n);
+#endif
+    addRow<uint8_t, uint32_t>(acc + i, row + i, n - i);
+}
+
+template <typename Pixel, typename Acc>
+inline Pixel finish(Acc sum, uint32_t n, BinningMode mode)
+{
+    if (mode == BINNING_MEAN)
+        return (sum + n / 2) / n;
+    return std::min<Acc>(sum, std::numeric_limits<Pixel>::max());
+}
+
+template <>
+inline float finish<float, double>(double sum, uint32_t n, BinningMode mode)
+{
+    return mode == BINNING_MEAN ? sum / n : sum;
+}
+
+template <typename Pixel>
+void binRows(const Pixel *src, Pixel *dst, uint32_t width, uint32_t height, uint32_t binX, uint32_t binY,
+             BinningMode mode, bool bayer, uint32_t firstRow, uint32_t lastRow)
+{
+    typedef typename Accumulator<Pixel>::type Acc;
+
+    const uint32_t outWidth = width / binX;
+    const uint32_t step     = bayer ? 2 : 1;
+    std::vector<Acc> acc(width);
+
+    for (uint32_t oy = firstRow; oy < lastRow; oy++)
+    {
+        // First input row, then every row (every other row in Bayer mode) of the same color
+        uint32_t y    = bayer ? (oy / 2) * 2 * binY + oy % 2 : oy * binY;
+        uint32_t rows = 0;
+
+        std::fill(acc.begin(), acc.end(), 0);
+        for (; rows < binY && y < height; rows++, y += step)
+            addRow(acc.data(), src + static_cast<size_t>(y) * width, width);
+
+        Pixel *out = dst + static_cast<size_t>(oy) * outWidth;
+        if (!bayer && binX == 2)
+        {
+            for (uint32_t ox = 0; ox < outWidth; ox++)
+                out[ox] = finish<Pixel, Acc>(acc[2 * ox] + acc[2 * ox + 1], rows * 2, mode);
+        }
+        else if (!bayer)
+        {
+            for (uint32_t ox = 0; ox < outWidth; ox++)
+            {
+                Acc sum = 0;
+                for (uint32_t l = 0; l < binX; l++)
+                    sum += acc[ox * binX + l];
+                out[ox] = finish<Pixel, Acc>(sum, rows * binX, mode);
+            }
+        }
+        else
+        {
+            for (uint32_t ox = 0; ox < outWidth; ox++)
+            {
+                // The last cell of an odd binned width has only part of its columns
+                Acc sum       = 0;
+                uint32_t cols = 0;
+                for (uint32_t x = (ox / 2) * 2 * binX + ox % 2; cols < binX && x < width; cols++, x += 2)
+                    sum += acc[x];
+                out[ox] = finish<Pixel, Acc>(sum, rows * cols, mode);
+            }
+        }
+    }
+}
+
+template <typename Pixel>
+void binPixels(const void *src, void *dst, uint32_t width, uint32_t height, uint32_t binX, uint32_t binY,
+               BinningMode mode, bool bayer)
+{
+    const uint32_t outHeight = height / binY;
+    const size_t bands = std::min<size_t>(parallelParts(static_cast<size_t>(width) * height, PIXELS_PER_PART),
+                                          outHeight);
+
+    parallelFor(bands, [&](size_t i)
+    {
+        binRows(static_cast<const Pixel *>(src), static_cast<Pixel *>(dst), width, height, binX, binY, mode, bayer,
+                outHeight * i / bands, outHeight * (i + 1) / bands);
+    });
+}
+
+template <typename Pixel>
+void superPixelRows(const Pixel *src, Pixel *dst, uint32_t width, uint32_t height, const uint32_t cell[4],
+                    uint32_t firstRow, uint32_t lastRow)
+{
+    typedef typename Accumulator<Pixel>::type Acc;
+
+    const uint32_t outWidth = width / 2;
+    const size_t plane      = static_cast<size_t>(outWidth) * (height / 2);
+
+    for (uint32_t oy = firstRow; oy < lastRow; oy++)
+    {
+        // The two rows of the cells, their pixels in the order of the pattern
+        const Pixel *rows[2] = { src + static_cast<size_t>(2 * oy) * width, src + static_cast<size_t>(2 * oy + 1) * width };
+        Pixel *red   = dst + static_cast<size_t>(oy) * outWidth;
+        Pixel *green = red + plane;
+        Pixel *blue  = green + plane;
+
+        for (uint32_t ox = 0; ox < outWidth; ox++)
+        {
+            const uint32_t x = 2 * ox;
+            red[ox]   = rows[cell[0] / 2][x + cell[0] % 2];
+            green[ox] = finish<Pixel, Acc>(Acc(rows[cell[1] / 2][x + cell[1] % 2]) + rows[cell[2] / 2][x + cell[2] % 2], 2,
+                                           BINNING_MEAN);
+            blue[ox]  = rows[cell[3] / 2][x + cell[3] % 2];
+        }
+    }
+}
+
+template <typename Pixel>
+void superPixels(const void *src, void *dst, uint32_t width, uint32_t height, const uint32_t cell[4])
+{
+    const uint32_t outHeight = height / 2;
+    const size_t bands = std::min<size_t>(parallelParts(static_cast<size_t>(width) * height, PIXELS_PER_PART),
+                                          outHeight);
+
+    parallelFor(bands, [&](size_t i)
+    {
+        superPixelRows(static_cast<const Pixel *>(src), static_cast<Pixel *>(dst), width, height, cell,
+                       outHeight * i / bands, outHeight * (i + 1) / bands);
+    });
+}
+
+}
+
+bool binFrame(const void *src, void *dst, uint32_t width, uint32_t height, int bitpix, uint32_t binX, uint32_t binY,
+              BinningMode mode, bool bayer)
+{
+    if (binX == 0 || binY == 0 || binX > 255 || binY > 255)
+        return false;
+
+    switch (bitpix)
+    {
+        case 8:
+            binPixels<uint8_t>(src, dst, width, height, binX, binY, mode, bayer);
+            return true;
+        case 16:
+            binPixels<uint16_t>(src, dst, width, height, binX, binY, mode, bayer);
+            return true;
+        case 32:
+            binPixels<uint32_t>(src, dst, width, height, binX, binY, mode, bayer);
+            return true;
+        case -32:
+            binPixels<float>(src, dst, width, height, binX, binY, mode, bayer);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool superPixelFrame(const void *src, void *dst, uint32_t width, uint32_t height, int bitpix, const char *pattern)
+{
+    // Where in the 2x2 cell, row by row, are red, the two greens and blue
+    uint32_t cell[4];
+    uint32_t greens = 0, found = 0;
+    for (uint32_t i = 0; pattern != nullptr && i < 4 && pattern[i] != '\0'; i++)
+    {
+        switch (pattern[i])
+        {
+            case 'R':
+                cell[0] = i;
+                found |= 1;
+                break;
+            case 'G':
+                if (greens < 2)
+                    cell[1 + greens] = i;
+                greens++;
+                found |= 2;
+                break;
+            case 'B':
+                cell[3] = i;
+                found |= 4;
+                break;
+            default:
+                return false;
+        }
+    }
+    if (found != 7 || greens != 2)
+        return false;
+
+    switch (bitpix)
+    {
+        case 8:
+            superPixels<uint8_t>(src, dst, width, height, cell);
+            return true;
+        case 16:
+            superPixels<uint16_t>(src, dst, width, height, cell);
+            return true;
+        case 32:
+            superPixels<uint32_t>(src, dst, width, height, cell);
+            return true;
+        case -32:
+            superPixels<float>(src, dst, width, height, cell);
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
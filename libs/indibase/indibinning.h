@@ -0,0 +1,74 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Software binning of camera frames
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstdint>
+
+namespace INDI
+{
+
+typedef enum
+{
+    /// Add the binned pixels, integer pixels saturate at their maximum value
+    BINNING_SUM,
+    /// Average the binned pixels, rounded to the nearest integer for integer pixels
+    BINNING_MEAN
+} BinningMode;
+
+/**
+ * @brief Bin a frame in software.
+ *
+ * The binned frame is width / binX by height / binY pixels, pixels left over at the right and bottom edges
+ * are dropped. Rows are binned on all CPU cores, with vector kernels where the CPU has them.
+ *
+ * In Bayer mode the color filter pattern is kept: each output pixel is made of binX by binY input pixels
+ * of its own color, so the binned frame is a mosaic of the same pattern at a lower resolution.
+ * @param src frame to bin.
+ * @param dst binned frame, must not overlap src.
+ * @param width width of src in pixels.
+ * @param height height of src in pixels.
+ * @param bitpix pixel type as FITS BITPIX: 8, 16 or 32 for unsigned integers, -32 for float.
+ * @param binX horizontal binning.
+ * @param binY vertical binning.
+ * @param mode sum or mean of the binned pixels.
+ * @param bayer keep the Bayer pattern of the frame.
+ * @return False if the pixel type is not supported or a binning is 0.
+ */
+bool binFrame(const void *src, void *dst, uint32_t width, uint32_t height, int bitpix, uint32_t binX, uint32_t binY,
+              BinningMode mode, bool bayer = false);
+
+/**
+ * @brief Bin a Bayer frame 2x2 into color super-pixels.
+ *
+ * Each 2x2 cell of the color filter pattern becomes one RGB pixel: the red pixel of the cell, the mean of its
+ * two green pixels and its blue pixel. The result is width / 2 by height / 2 pixels in three planes, red, green
+ * then blue, as FITS stores color images. Rows are made on all CPU cores.
+ * @param src Bayer frame.
+ * @param dst color frame, must not overlap src.
+ * @param width width of src in pixels.
+ * @param height height of src in pixels.
+ * @param bitpix pixel type as FITS BITPIX: 8, 16 or 32 for unsigned integers, -32 for float.
+ * @param pattern colors of the first 2x2 cell of src row by row, such as "RGGB".
+ * @return False if the pixel type or the pattern is not supported.
+ */
+bool superPixelFrame(const void *src, void *dst, uint32_t width, uint32_t height, int bitpix, const char *pattern);
+
+}
@@ -0,0 +1,257 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Block-parallel zlib compression
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Stream layout, all of it a valid zlib stream up to the adler32:
+
+        zlib header (2 bytes)
+        block 1 .. block n-1   raw deflate, each ending on a sync flush
+        block n                raw deflate, final
+        adler32 of all data    (4 bytes, big endian)
+        index                  n x { compressed size, uncompressed size }
+        n
+        magic "IZB1"
+
+    index entries, n and the magic are 32 bit little endian.
+*/
+
+#include "indiblockcompress.h"
+#include "indiparallel.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace INDI
+{
+
+// Uncompressed bytes per block, enough blocks to keep the cores busy on a typical frame
+static const size_t BLOCK_SIZE = 512 * 1024;
+static const uint32_t INDEX_MAGIC = 0x31425a49; // "IZB1"
+
+namespace
+{
+
+struct Block
+{
+    const uint8_t *src;
+    size_t srcLen;
+    std::vector<uint8_t> out;   // compressed, when compressing
+    uint8_t *dst;               // where it goes, when uncompressing
+    size_t dstLen;
+    uLong adler;                // of the uncompressed data
+    int status;
+};
+
+void put32le(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+uint32_t get32le(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+void deflateBlock(Block &b, int level, bool last)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    b.adler  = adler32(adler32(0, nullptr, 0), b.src, b.srcLen);
+    b.status = deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (b.status != Z_OK)
+        return;
+
+    // room for the sync flush marker too
+    b.out.resize(deflateBound(&zs, b.srcLen) + 16);
+    zs.next_in   = const_cast<Bytef *>(b.src);
+    zs.avail_in  = b.srcLen;
+    zs.next_out  = b.out.data();
+    zs.avail_out = b.out.size();
+
+    int r = deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if ((last && r != Z_STREAM_END) || (!last && (r != Z_OK || zs.avail_in != 0 || zs.avail_out == 0)))
+        b.status = r == Z_OK || r == Z_STREAM_END ? Z_BUF_ERROR : r;
+    b.out.resize(zs.total_out);
+    deflateEnd(&zs);
+}
+
+void inflateBlock(Block &b, bool last)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    b.status = inflateInit2(&zs, -MAX_WBITS);
+    if (b.status != Z_OK)
+        return;
+
+    zs.next_in   = const_cast<Bytef *>(b.src);
+    zs.avail_in  = b.srcLen;
+    zs.next_out  = b.dst;
+    zs.avail_out = b.dstLen;
+
+    int r = inflate(&zs, Z_SYNC_FLUSH);
+    if (last ? r != Z_STREAM_END : ((r != Z_OK && r != Z_BUF_ERROR) || zs.avail_in != 0))
+        b.status = r == Z_OK || r == Z_BUF_ERROR || r == Z_STREAM_END ? Z_DATA_ERROR : r;
+    else if (zs.avail_out != 0)
+        b.status = Z_DATA_ERROR;
+    else
+        b.adler = adler32(adler32(0, nullptr, 0), b.dst, b.dstLen);
+    inflateEnd(&zs);
+}
+
+}
+
+size_t blockCompressBound(size_t srcLen)
+{
+    size_t blocks = std::max<size_t>(1, (srcLen + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    return compressBound(srcLen) + blocks * (8 + 16 + 8) + 16;
+}
+
+int blockCompress(uint8_t *dst, size_t *dstLen, const uint8_t *src, size_t srcLen, int level)
+{
+    size_t n = std::max<size_t>(1, (srcLen + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    std::vector<Block> blocks(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        blocks[i].src    = src + i * BLOCK_SIZE;
+        blocks[i].srcLen = std::min(BLOCK_SIZE, srcLen - i * BLOCK_SIZE);
+    }
+
+    parallelFor(n, [&](size_t i)
+    {
+        deflateBlock(blocks[i], level, i == n - 1);
+    });
+
+    size_t total = 2 + 4 + n * 8 + 8;
+    for (auto &b : blocks)
+    {
+        if (b.status != Z_OK)
+            return b.status;
+        total += b.out.size();
+    }
+    if (total > *dstLen)
+        return Z_BUF_ERROR;
+
+    // zlib header, with the level hint zlib itself would give
+    int flevel = level == Z_DEFAULT_COMPRESSION ? 2 : level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    uint8_t *p = dst;
+    *p++ = 0x78;
+    *p = flevel << 6;
+    *p += 31 - ((0x78 << 8) + *p) % 31;
+    p++;
+
+    uLong adler = blocks[0].adler;
+    for (size_t i = 0; i < n; i++)
+    {
+        memcpy(p, blocks[i].out.data(), blocks[i].out.size());
+        p += blocks[i].out.size();
+        if (i > 0)
+            adler = adler32_combine(adler, blocks[i].adler, blocks[i].srcLen);
+    }
+    *p++ = adler >> 24;
+    *p++ = adler >> 16;
+    *p++ = adler >> 8;
+    *p++ = adler;
+
+    for (auto &b : blocks)
+    {
+        put32le(p, b.out.size());
+        put32le(p + 4, b.srcLen);
+        p += 8;
+    }
+    put32le(p, n);
+    put32le(p + 4, INDEX_MAGIC);
+    p += 8;
+
+    *dstLen = p - dst;
+    return Z_OK;
+}
+
+int blockUncompress(uint8_t *dst, size_t *dstLen, const uint8_t *src, size_t srcLen)
+{
+    size_t n = 0;
+
+    // look for a consistent index, anything else is left to zlib
+    if (srcLen >= 2 + 4 + 8 + 8 && get32le(src + srcLen - 4) == INDEX_MAGIC)
+    {
+        n = get32le(src + srcLen - 8);
+        if (n == 0 || n > (srcLen - 2 - 4 - 8) / 8)
+            n = 0;
+    }
+
+    std::vector<Block> blocks(n);
+    if (n > 0)
+    {
+        const uint8_t *index = src + srcLen - 8 - n * 8;
+        size_t in = 2, out = 0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            blocks[i].src    = src + in;
+            blocks[i].srcLen = get32le(index + i * 8);
+            blocks[i].dst    = dst + out;
+            blocks[i].dstLen = get32le(index + i * 8 + 4);
+            in  += blocks[i].srcLen;
+            out += blocks[i].dstLen;
+        }
+
+        if (in + 4 + n * 8 + 8 != srcLen || out > *dstLen)
+            n = 0;
+    }
+
+    if (n == 0)
+    {
+        uLongf len = *dstLen;
+        int r = uncompress(dst, &len, src, srcLen);
+        *dstLen = len;
+        return r;
+    }
+
+    parallelFor(n, [&](size_t i)
+    {
+        inflateBlock(blocks[i], i == n - 1);
+    });
+
+    uLong adler = blocks[0].adler;
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (blocks[i].status != Z_OK)
+            return blocks[i].status;
+        if (i > 0)
+            adler = adler32_combine(adler, blocks[i].adler, blocks[i].dstLen);
+        total += blocks[i].dstLen;
+    }
+
+    const uint8_t *a = src + srcLen - 8 - n * 8 - 4;
+    if (adler != (static_cast<uLong>(a[0]) << 24 | a[1] << 16 | a[2] << 8 | a[3]))
+        return Z_DATA_ERROR;
+
+    *dstLen = total;
+    return Z_OK;
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Block-parallel zlib compression
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace INDI
+{
+
+/**
+ * @brief Size of the buffer blockCompress() needs for srcLen bytes.
+ */
+size_t blockCompressBound(size_t srcLen);
+
+/**
+ * @brief Compress with zlib, splitting the data into blocks compressed on all CPU cores.
+ *
+ * The result is a single standard zlib stream, so any zlib uncompress() reads it (.z BLOBs stay
+ * compatible with existing clients). It is followed by an index of the blocks, which zlib ignores and
+ * which lets blockUncompress() inflate the blocks in parallel too.
+ * @param dst output buffer, at least blockCompressBound(srcLen) bytes.
+ * @param dstLen size of dst on input, compressed size on output.
+ * @param src data to compress.
+ * @param srcLen number of bytes to compress.
+ * @param level zlib compression level from 1 (fastest) to 9 (smallest).
+ * @return Z_OK on success or a zlib error code.
+ */
+int blockCompress(uint8_t *dst, size_t *dstLen, const uint8_t *src, size_t srcLen, int level);
+
+/**
+ * @brief Uncompress a zlib stream, in parallel if it was made by blockCompress().
+ * @param dst output buffer.
+ * @param dstLen size of dst on input, uncompressed size on output.
+ * @param src zlib stream.
+ * @param srcLen size of src.
+ * @return Z_OK on success or a zlib error code, as uncompress().
+ */
+int blockUncompress(uint8_t *dst, size_t *dstLen, const uint8_t *src, size_t srcLen);
+
+}
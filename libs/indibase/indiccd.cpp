@@ -29,10 +29,11 @@
 
 #include "indiccd.h"
 
-#include "fpack/fpack.h"
 #include "indicom.h"
 #include "locale_compat.h"
 #include "indiutility.h"
+#include "indiblockcompress.h"
+#include "sharedblob.h"
 
 #include <fitsio.h>
 
@@ -199,6 +200,24 @@ bool CCD::initProperties()
                        IMAGE_SETTINGS_TAB, IP_RW, ISR_1OFMANY, 60, IPS_IDLE);
     PrimaryCCD.SendCompressed = false;
 
+    // FITS tile compression used when compressing FITS images
+    FitsCompressionSP[FITS_COMPRESS_RICE].fill("FITS_COMPRESS_RICE", "Rice", ISS_ON);
+    FitsCompressionSP[FITS_COMPRESS_HCOMPRESS].fill("FITS_COMPRESS_HCOMPRESS", "HCompress", ISS_OFF);
+    FitsCompressionSP[FITS_COMPRESS_GZIP].fill("FITS_COMPRESS_GZIP", "GZIP", ISS_OFF);
+    FitsCompressionSP.fill(getDeviceName(), "CCD_FITS_COMPRESSION", "FITS Compression", IMAGE_SETTINGS_TAB, IP_RW,
+                           ISR_1OFMANY, 60, IPS_IDLE);
+
+    // Quantization of floating point images and HCompress scale, 0 for lossless HCompress
+    FitsCompressionNP[FITS_QUANTIZE_LEVEL].fill("FITS_QUANTIZE_LEVEL", "Quantize level", "%.f", 0, 64, 1, 4);
+    FitsCompressionNP[FITS_HCOMPRESS_SCALE].fill("FITS_HCOMPRESS_SCALE", "HCompress scale", "%.1f", 0, 64, 0.5, 0);
+    FitsCompressionNP.fill(getDeviceName(), "CCD_FITS_COMPRESSION_SETTINGS", "FITS Compression", IMAGE_SETTINGS_TAB,
+                           IP_RW, 60, IPS_IDLE);
+
+    // Lower levels keep up with fast cameras, higher levels make smaller frames
+    CompressionLevelNP[0].fill("CCD_COMPRESSION_LEVEL", "Level", "%.f", 1, 9, 1, 4);
+    CompressionLevelNP.fill(getDeviceName(), "CCD_COMPRESSION_LEVEL", "Compression", IMAGE_SETTINGS_TAB, IP_RW, 60,
+                            IPS_IDLE);
+
     // Primary CCD Chip Data Blob
     IUFillBLOB(&PrimaryCCD.FitsB, "CCD1", "Image", "");
     IUFillBLOBVector(&PrimaryCCD.FitsBP, &PrimaryCCD.FitsB, 1, getDeviceName(), "CCD1", "Image Data", IMAGE_INFO_TAB,
@@ -506,6 +525,9 @@ bool CCD::updateProperties()
                 defineProperty(&GuideCCD.ImageBinNP);
         }
         defineProperty(&PrimaryCCD.CompressSP);
+        defineProperty(&FitsCompressionSP);
+        defineProperty(&FitsCompressionNP);
+        defineProperty(&CompressionLevelNP);
         defineProperty(&PrimaryCCD.FitsBP);
         if (HasGuideHead())
         {
@@ -577,6 +599,9 @@ bool CCD::updateProperties()
             deleteProperty(PrimaryCCD.AbortExposureSP.name);
         deleteProperty(PrimaryCCD.FitsBP.name);
         deleteProperty(PrimaryCCD.CompressSP.name);
+        deleteProperty(FitsCompressionSP.getName());
+        deleteProperty(FitsCompressionNP.getName());
+        deleteProperty(CompressionLevelNP.getName());
 
 #if 0
         deleteProperty(PrimaryCCD.RapidGuideSP.name);
@@ -1218,6 +1243,26 @@ bool CCD::ISNewNumber(const char * dev, const char * name, double values[], char
             return true;
         }
 
+        // FITS Compression Settings
+        if (!strcmp(name, FitsCompressionNP.getName()))
+        {
+            FitsCompressionNP.update(values, names, n);
+            FitsCompressionNP.setState(IPS_OK);
+            FitsCompressionNP.apply();
+            saveConfig(true, FitsCompressionNP.getName());
+            return true;
+        }
+
+        // Compression Level
+        if (!strcmp(name, CompressionLevelNP.getName()))
+        {
+            CompressionLevelNP.update(values, names, n);
+            CompressionLevelNP.setState(IPS_OK);
+            CompressionLevelNP.apply();
+            saveConfig(true, CompressionLevelNP.getName());
+            return true;
+        }
+
         // Camera Temperature Ramp
         if (!strcmp(name, TemperatureRampNP.getName()))
         {
@@ -1496,6 +1541,16 @@ bool CCD::ISNewSwitch(const char * dev, const char * name, ISState * states, cha
             return true;
         }
 
+        // FITS Compression Algorithm
+        if (!strcmp(name, FitsCompressionSP.getName()))
+        {
+            FitsCompressionSP.update(states, names, n);
+            FitsCompressionSP.setState(IPS_OK);
+            FitsCompressionSP.apply();
+            saveConfig(true, FitsCompressionSP.getName());
+            return true;
+        }
+
         // Guide Chip Compression
         if (strcmp(name, GuideCCD.CompressSP.name) == 0)
         {
@@ -2600,22 +2655,25 @@ bool CCD::ExposureCompletePrivate(CCDChip * targetChip)
             std::unique_lock<std::mutex> guard(ccdBufferLock);
 
             //  Now we have to send fits format data to the client
-            memsize = 5760;
-            memptr  = malloc(memsize);
+            //  The file is made in a shared BLOB buffer, indiserver then takes it without a copy.
+            //  Sized for the data and a few header blocks so it seldom needs to grow.
+            size_t dataBytes = static_cast<size_t>(nelements) * (targetChip->getBPP() / 8);
+            memsize = 2880 * ((dataBytes + 2879) / 2880 + 4);
+            memptr  = IDSharedBlobAlloc(memsize);
             if (!memptr)
             {
                 LOGF_ERROR("Error: failed to allocate memory: %lu", memsize);
                 return false;
             }
 
-            fits_create_memfile(&fptr, &memptr, &memsize, 2880, realloc, &status);
+            fits_create_memfile(&fptr, &memptr, &memsize, 2880, IDSharedBlobRealloc, &status);
 
             if (status)
             {
                 fits_report_error(stderr, status); /* print out any error messages */
                 fits_get_errstatus(status, error_status);
                 fits_close_file(fptr, &status);
-                free(memptr);
+                IDSharedBlobFree(memptr);
                 LOGF_ERROR("FITS Error: %s", error_status);
                 return false;
             }
@@ -2627,7 +2685,7 @@ bool CCD::ExposureCompletePrivate(CCDChip * targetChip)
                 fits_report_error(stderr, status); /* print out any error messages */
                 fits_get_errstatus(status, error_status);
                 fits_close_file(fptr, &status);
-                free(memptr);
+                IDSharedBlobFree(memptr);
                 LOGF_ERROR("FITS Error: %s", error_status);
                 return false;
             }
@@ -2641,16 +2699,22 @@ bool CCD::ExposureCompletePrivate(CCDChip * targetChip)
                 fits_report_error(stderr, status); /* print out any error messages */
                 fits_get_errstatus(status, error_status);
                 fits_close_file(fptr, &status);
-                free(memptr);
+                IDSharedBlobFree(memptr);
                 LOGF_ERROR("FITS Error: %s", error_status);
                 return false;
             }
 
+            // The buffer may be larger than the file, which ends with the image HDU
+            LONGLONG headstart = 0, datastart = 0, dataend = 0;
+            fits_flush_file(fptr, &status);
+            fits_get_hduaddrll(fptr, &headstart, &datastart, &dataend, &status);
             fits_close_file(fptr, &status);
+            if (dataend > 0 && static_cast<size_t>(dataend) < memsize)
+                memsize = dataend;
 
             bool rc = uploadFile(targetChip, memptr, memsize, sendImage, saveImage /*, useSolver*/);
 
-            free(memptr);
+            IDSharedBlobFree(memptr);
 
             guard.unlock();
 
@@ -2814,96 +2878,45 @@ bool CCD::uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBy
     {
         if (!strcmp(targetChip->getImageExtension(), "fits"))
         {
-            int  compressedBytes = 0;
-            char filename[MAXRBUF] = {0};
-            strncpy(filename, "/tmp/compressedfits.fits", MAXRBUF);
+            void * fzData  = nullptr;
+            size_t fzBytes = 0;
 
-            FILE * fp = fopen(filename, "w");
-            if (fp == nullptr)
+            if (compressFITS(fitsData, totalBytes, &fzData, &fzBytes) == false)
             {
-                LOGF_ERROR("Unable to save temporary image file: %s", strerror(errno));
-                return false;
+                // The image is still good, send it as it is
+                LOG_WARN("FITS compression failed, sending the image uncompressed.");
+                targetChip->FitsB.blob    = const_cast<void *>(fitsData);
+                targetChip->FitsB.bloblen = totalBytes;
+                snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s", targetChip->getImageExtension());
             }
-
-            int n = 0;
-            for (int nr = 0; nr < static_cast<int>(totalBytes); nr += n)
-                n = fwrite(static_cast<const uint8_t *>(fitsData) + nr, 1, totalBytes - nr, fp);
-            fclose(fp);
-
-            fpstate	fpvar;
-            std::vector<std::string> arguments = {"fpack", filename};
-            std::vector<char *> arglist;
-            for (const auto &arg : arguments)
-                arglist.push_back(const_cast<char *>(arg.data()));
-            arglist.push_back(nullptr);
-
-            int argc = arglist.size() - 1;
-            char ** argv = arglist.data();
-
-            // TODO: Check for errors
-            fp_init (&fpvar);
-            fp_get_param (argc, argv, &fpvar);
-            fp_preflight (argc, argv, FPACK, &fpvar);
-            fp_loop (argc, argv, FPACK, filename, fpvar);
-
-            // Remove temporary file from disk
-            remove(filename);
-
-            // Add .fz
-            strncat(filename, ".fz", 4);
-
-            struct stat st;
-            stat(filename, &st);
-            compressedBytes = st.st_size;
-
-            compressedData = new uint8_t[compressedBytes];
-
-            if (compressedData == nullptr)
-            {
-                LOG_ERROR("Ran out of memory compressing image.");
-                return false;
-            }
-
-            fp = fopen(filename, "r");
-            if (fp == nullptr)
+            else
             {
-                LOGF_ERROR("Unable to open temporary image file: %s", strerror(errno));
-                delete [] compressedData;
-                return false;
+                compressedData            = static_cast<uint8_t *>(fzData);
+                targetChip->FitsB.blob    = compressedData;
+                targetChip->FitsB.bloblen = fzBytes;
+                totalBytes = fzBytes;
+                snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s.fz", targetChip->getImageExtension());
             }
-
-            n = 0;
-            for (int nr = 0; nr < compressedBytes; nr += n)
-                n = fread(compressedData + nr, 1, compressedBytes - nr, fp);
-            fclose(fp);
-
-            // Remove compressed temporary file from disk
-            remove(filename);
-
-            targetChip->FitsB.blob    = compressedData;
-            targetChip->FitsB.bloblen = compressedBytes;
-            totalBytes = compressedBytes;
-            snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s.fz", targetChip->getImageExtension());
         }
         else
         {
-            uLong compressedBytes = sizeof(char) * totalBytes + totalBytes / 64 + 16 + 3;
-            compressedData  = new uint8_t[compressedBytes];
+            size_t compressedBytes = blockCompressBound(totalBytes);
+            compressedData  = static_cast<uint8_t *>(IDSharedBlobAlloc(compressedBytes));
 
             if (fitsData == nullptr || compressedData == nullptr)
             {
-                if (compressedData)
-                    delete [] compressedData;
+                IDSharedBlobFree(compressedData);
                 LOG_ERROR("Error: Ran out of memory compressing image");
                 return false;
             }
 
-            int r = compress2(compressedData, &compressedBytes, (const Bytef *)fitsData, totalBytes, 9);
+            int r = blockCompress(compressedData, &compressedBytes, static_cast<const uint8_t *>(fitsData), totalBytes,
+                                  getCompressionLevel());
             if (r != Z_OK)
             {
                 /* this should NEVER happen */
                 LOG_ERROR("Error: Failed to compress image");
-                delete [] compressedData;
+                IDSharedBlobFree(compressedData);
                 return false;
             }
 
@@ -2948,14 +2961,88 @@ bool CCD::uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBy
         }
     }
 
-    if (compressedData)
-        delete [] compressedData;
+    IDSharedBlobFree(compressedData);
 
     DEBUG(Logger::DBG_DEBUG, "Upload complete");
 
     return true;
 }
 
+bool CCD::compressFITS(const void * fitsData, size_t totalBytes, void ** fzData, size_t * fzBytes)
+{
+    fitsfile * fptr = nullptr;
+    fitsfile * fzptr = nullptr;
+    void * memptr = const_cast<void *>(fitsData);
+    size_t memsize = totalBytes;
+    int status = 0;
+    char error_status[MAXRBUF];
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Tiled images usually shrink to about half, grow in steps of an eighth
+    *fzBytes = 2880 * (totalBytes / 2 / 2880 + 2);
+    *fzData  = IDSharedBlobAlloc(*fzBytes);
+    if (*fzData == nullptr)
+    {
+        LOG_ERROR("Error: Ran out of memory compressing image");
+        return false;
+    }
+
+    fits_open_memfile(&fptr, "", READONLY, &memptr, &memsize, 0, nullptr, &status);
+    fits_create_memfile(&fzptr, fzData, fzBytes, 2880 * (totalBytes / 8 / 2880 + 1), IDSharedBlobRealloc,
+                        &status);
+
+    switch (FitsCompressionSP.findOnSwitchIndex())
+    {
+        case FITS_COMPRESS_HCOMPRESS:
+            fits_set_compression_type(fzptr, HCOMPRESS_1, &status);
+            fits_set_hcomp_scale(fzptr, FitsCompressionNP[FITS_HCOMPRESS_SCALE].getValue(), &status);
+            break;
+
+        case FITS_COMPRESS_GZIP:
+            fits_set_compression_type(fzptr, GZIP_1, &status);
+            break;
+
+        default:
+            fits_set_compression_type(fzptr, RICE_1, &status);
+            break;
+    }
+    fits_set_quantize_level(fzptr, FitsCompressionNP[FITS_QUANTIZE_LEVEL].getValue(), &status);
+
+    fits_img_compress(fptr, fzptr, &status);
+
+    // The buffer may be larger than the file, which ends with the compressed HDU
+    LONGLONG headstart = 0, datastart = 0, dataend = 0;
+    fits_flush_file(fzptr, &status);
+    fits_get_hduaddrll(fzptr, &headstart, &datastart, &dataend, &status);
+
+    if (status)
+    {
+        fits_report_error(stderr, status); /* print out any error messages */
+        fits_get_errstatus(status, error_status);
+        status = 0;
+        fits_close_file(fzptr, &status);
+        status = 0;
+        fits_close_file(fptr, &status);
+        IDSharedBlobFree(*fzData);
+        *fzData = nullptr;
+        LOGF_WARN("FITS compression error: %s", error_status);
+        return false;
+    }
+
+    fits_close_file(fzptr, &status);
+    fits_close_file(fptr, &status);
+    if (dataend > 0 && static_cast<size_t>(dataend) < *fzBytes)
+        *fzBytes = dataend;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff = end - start;
+    LOGF_DEBUG("FITS compression took %g seconds, %zu to %zu bytes (ratio %.2f)", diff.count(), totalBytes, *fzBytes,
+               *fzBytes ? static_cast<double>(totalBytes) / *fzBytes : 0.0);
+
+    return true;
+}
+
 void CCD::SetCCDParams(int x, int y, int bpp, float xf, float yf)
 {
     PrimaryCCD.setResolution(x, y);
@@ -2989,6 +3076,9 @@ bool CCD::saveConfigItems(FILE * fp)
 #endif
 
     IUSaveConfigSwitch(fp, &PrimaryCCD.CompressSP);
+    FitsCompressionSP.save(fp);
+    FitsCompressionNP.save(fp);
+    CompressionLevelNP.save(fp);
 
     if (HasCooler())
         IUSaveConfigNumber(fp, &TemperatureRampNP);
@@ -30,6 +30,7 @@
 #include "defaultdevice.h"
 #include "indiguiderinterface.h"
 #include "indipropertynumber.h"
+#include "indipropertyswitch.h"
 #include "inditimer.h"
 #include "indielapsedtimer.h"
 #include "dsp/manager.h"
@@ -147,6 +148,14 @@ class CCD : public DefaultDevice, GuiderInterface
 
         static void wsThreadHelper(void * context);
 
+        /**
+         * @brief getCompressionLevel returns the zlib level used for compressed non-FITS images and streams.
+         */
+        int getCompressionLevel() const
+        {
+            return static_cast<int>(CompressionLevelNP[0].getValue());
+        }
+
         /////////////////////////////////////////////////////////////////////////////
         /// Group Names
         /////////////////////////////////////////////////////////////////////////////
@@ -707,6 +716,26 @@ class CCD : public DefaultDevice, GuiderInterface
         std::chrono::system_clock::time_point exposureLoopStartup;
 #endif
 
+        // FITS tile compression algorithm
+        INDI::PropertySwitch FitsCompressionSP {3};
+        enum
+        {
+            FITS_COMPRESS_RICE,
+            FITS_COMPRESS_HCOMPRESS,
+            FITS_COMPRESS_GZIP
+        };
+
+        // FITS tile compression settings
+        INDI::PropertyNumber FitsCompressionNP {2};
+        enum
+        {
+            FITS_QUANTIZE_LEVEL,
+            FITS_HCOMPRESS_SCALE
+        };
+
+        // zlib level of compressed non-FITS images and streams
+        INDI::PropertyNumber CompressionLevelNP {1};
+
         // FITS Header
         IText FITSHeaderT[2] {};
         ITextVectorProperty FITSHeaderTP;
@@ -725,6 +754,7 @@ class CCD : public DefaultDevice, GuiderInterface
         /// Utility Functions
         ///////////////////////////////////////////////////////////////////////////////
         bool uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBytes, bool sendImage, bool saveImage);
+        bool compressFITS(const void * fitsData, size_t totalBytes, void ** fzData, size_t * fzBytes);
         void getMinMax(double * min, double * max, CCDChip * targetChip);
         int getFileIndex(const char * dir, const char * prefix, const char * ext);
         bool ExposureCompletePrivate(CCDChip * targetChip);
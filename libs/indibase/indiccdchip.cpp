@@ -16,6 +16,7 @@
  Boston, MA 02110-1301, USA.
 *******************************************************************************/
 #include "indiccdchip.h"
+#include "indibinning.h"
 #include "indidevapi.h"
 #include "locale_compat.h"
 
@@ -229,79 +230,48 @@ void CCDChip::setImageExtension(const char *ext)
 
 void CCDChip::binFrame()
 {
-    if (BinX == 1)
+    binFrame(false);
+}
+
+void CCDChip::binBayerFrame(const char *pattern)
+{
+    if (BinX != 2 || BinY != 2)
+    {
+        binFrame(true);
         return;
+    }
 
-    // Jasem: Keep full frame shadow in memory to enhance performance and just swap frame pointers after operation is complete
     if (BinFrame == nullptr)
         BinFrame = new uint8_t[RawFrameSize];
 
-    memset(BinFrame, 0, RawFrameSize);
+    // Three planes of a quarter of the pixels each fit in the raw frame
+    if (!INDI::superPixelFrame(RawFrame, BinFrame, SubW, SubH, getBPP(), pattern))
+        return;
 
-    switch (getBPP())
-    {
-        case 8:
-        {
-            uint8_t *bin_buf = BinFrame;
-            // Try to average pixels since in 8bit they get saturated pretty quickly
-            double factor      = (BinX * BinX) / 2;
-            double accumulator = 0;
-
-            for (uint32_t i = 0; i < SubH; i += BinX)
-                for (uint32_t j = 0; j < SubW; j += BinX)
-                {
-                    accumulator = 0;
-                    for (int k = 0; k < BinX; k++)
-                    {
-                        for (int l = 0; l < BinX; l++)
-                        {
-                            accumulator += *(RawFrame + j + (i + k) * SubW + l);
-                        }
-                    }
-
-                    accumulator /= factor;
-                    if (accumulator > UINT8_MAX)
-                        *bin_buf = UINT8_MAX;
-                    else
-                        *bin_buf += static_cast<uint8_t>(accumulator);
-                    bin_buf++;
-                }
-        }
-        break;
-
-        case 16:
-        {
-            uint16_t *bin_buf    = reinterpret_cast<uint16_t *>(BinFrame);
-            uint16_t *RawFrame16 = reinterpret_cast<uint16_t *>(RawFrame);
-            uint16_t val;
-            for (uint32_t i = 0; i < SubH; i += BinX)
-                for (uint32_t j = 0; j < SubW; j += BinX)
-                {
-                    for (int k = 0; k < BinX; k++)
-                    {
-                        for (int l = 0; l < BinX; l++)
-                        {
-                            val = *(RawFrame16 + j + (i + k) * SubW + l);
-                            if (val + *bin_buf > UINT16_MAX)
-                                *bin_buf = UINT16_MAX;
-                            else
-                                *bin_buf += val;
-                        }
-                    }
-                    bin_buf++;
-                }
-        }
-        break;
-
-        default:
-            return;
-    }
+    uint8_t *rawFramePointer = RawFrame;
+    RawFrame                 = BinFrame;
+    BinFrame                 = rawFramePointer;
+    NAxis                    = 3;
+}
+
+void CCDChip::binFrame(bool bayer)
+{
+    if (BinX == 1 && BinY == 1)
+        return;
+
+    // Jasem: Keep full frame shadow in memory to enhance performance and just swap frame pointers after operation is complete
+    if (BinFrame == nullptr)
+        BinFrame = new uint8_t[RawFrameSize];
+
+    // Average pixels in 8bit since they get saturated pretty quickly
+    if (!INDI::binFrame(RawFrame, BinFrame, SubW, SubH, getBPP(), BinX, BinY,
+                        getBPP() == 8 ? BINNING_MEAN : BINNING_SUM, bayer))
+        return;
 
     // Swap frame pointers
     uint8_t *rawFramePointer = RawFrame;
     RawFrame                 = BinFrame;
-    // We just memset it next time we use it
-    BinFrame = rawFramePointer;
+    BinFrame                 = rawFramePointer;
 }
 
 }
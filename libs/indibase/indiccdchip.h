@@ -376,11 +376,23 @@ class CCDChip
 
         /**
          * @brief binFrame Perform softwre binning on the CCD frame. Only use this function if hardware
-         * binning is not supported.
+         * binning is not supported. 8 bit frames are averaged, deeper frames are summed and saturate at their
+         * maximum value. The binned frame is SubW / BinX by SubH / BinY pixels.
          */
         void binFrame();
 
+        /**
+         * @brief binBayerFrame Perform software binning on a Bayer CCD frame. Binned 2x2, each cell of the
+         * color filter pattern becomes one RGB super-pixel, and the frame a color one with NAxis 3 until the
+         * driver sets it back. Other binnings keep the pattern: each binned pixel is made of pixels of its own
+         * color only.
+         * @param pattern Bayer pattern of the frame, such as "RGGB".
+         */
+        void binBayerFrame(const char *pattern);
+
     private:
+        void binFrame(bool bayer);
+
         /////////////////////////////////////////////////////////////////////////////////////////
         /// Chip Variables
         /////////////////////////////////////////////////////////////////////////////////////////
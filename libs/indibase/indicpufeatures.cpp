@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Processor features the vector kernels are chosen by
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "indicpufeatures.h"
+
+namespace INDI
+{
+
+bool cpuHasAVX2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static const bool avx2 = []()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+bool cpuHasSSSE3()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static const bool ssse3 = []()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+    }();
+    return ssse3;
+#else
+    return false;
+#endif
+}
+
+}
+
+int indi_cpu_has_avx2(void)
+{
+    return INDI::cpuHasAVX2();
+}
+
+int indi_cpu_has_ssse3(void)
+{
+    return INDI::cpuHasSSSE3();
+}
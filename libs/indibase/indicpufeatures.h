@@ -0,0 +1,53 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Processor features the vector kernels are chosen by
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#ifdef __cplusplus
+namespace INDI
+{
+
+/**
+ * @brief Whether the processor runs AVX2 instructions.
+ *
+ * Probed on first use only, so kernels built for AVX2 with the target attribute can check it on each call.
+ * Always false on other than x86 processors.
+ */
+bool cpuHasAVX2();
+
+/**
+ * @brief Whether the processor runs SSSE3 instructions, probed like cpuHasAVX2().
+ */
+bool cpuHasSSSE3();
+
+}
+
+extern "C" {
+#endif
+
+/** @brief INDI::cpuHasAVX2() for C code, 1 or 0. */
+int indi_cpu_has_avx2(void);
+
+/** @brief INDI::cpuHasSSSE3() for C code, 1 or 0. */
+int indi_cpu_has_ssse3(void);
+
+#ifdef __cplusplus
+}
+#endif
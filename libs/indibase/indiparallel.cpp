@@ -0,0 +1,161 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Parallel loops on a shared pool of worker threads
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+    Each parallelFor() call queues one Loop. Whoever runs a loop, its caller or
+    a worker, takes the next index until there is none left; the last one to
+    finish a job wakes the caller up.
+*/
+
+#include "indiparallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace INDI
+{
+
+namespace
+{
+
+struct Loop
+{
+    Loop(size_t count, const std::function<void(size_t)> &job) : count(count), job(job) {}
+
+    void run()
+    {
+        size_t finished = 0;
+        for (size_t i; (i = next++) < count; finished++)
+            job(i);
+
+        if (finished > 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done += finished;
+            if (done == count)
+                allDone.notify_all();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        allDone.wait(lock, [this]() { return done == count; });
+    }
+
+    const size_t count;
+    const std::function<void(size_t)> &job;   // only called before done reaches count
+    std::atomic<size_t> next {0};
+    size_t done {0};
+    std::mutex mutex;
+    std::condition_variable allDone;
+};
+
+class Pool
+{
+public:
+    Pool()
+    {
+        size_t workers = parallelThreads() - 1;
+        for (size_t i = 0; i < workers; i++)
+            threads.emplace_back(&Pool::work, this);
+    }
+
+    ~Pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wakeUp.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    void run(size_t count, const std::function<void(size_t)> &job)
+    {
+        auto loop = std::make_shared<Loop>(count, job);
+        if (count > 1 && !threads.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                loops.push_back(loop);
+            }
+            if (count > 2)
+                wakeUp.notify_all();
+            else
+                wakeUp.notify_one();
+        }
+        loop->run();
+        loop->wait();
+    }
+
+private:
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            wakeUp.wait(lock, [this]() { return quit || !loops.empty(); });
+            if (quit)
+                return;
+
+            // Keep the loop queued while it runs, other workers may join in
+            std::shared_ptr<Loop> loop = loops.front();
+            lock.unlock();
+            loop->run();
+            lock.lock();
+
+            if (!loops.empty() && loops.front() == loop)
+                loops.pop_front();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::deque<std::shared_ptr<Loop>> loops;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool quit {false};
+};
+
+}
+
+size_t parallelThreads()
+{
+    static const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    return threads;
+}
+
+size_t parallelParts(size_t size, size_t minPartSize)
+{
+    return std::max<size_t>(1, std::min(parallelThreads(), size / std::max<size_t>(minPartSize, 1)));
+}
+
+void parallelFor(size_t count, const std::function<void(size_t index)> &job)
+{
+    static Pool pool;
+    pool.run(count, job);
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+
+    Parallel loops on a shared pool of worker threads
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace INDI
+{
+
+/**
+ * @brief Number of threads parallelFor() can run on, the calling thread included.
+ */
+size_t parallelThreads();
+
+/**
+ * @brief Number of parts to cut work of the given size into for parallelFor(), at most parallelThreads().
+ * @param size amount of work, in any unit.
+ * @param minPartSize less work than this in a part costs more to hand to another thread than it saves.
+ * @return at least one part.
+ */
+size_t parallelParts(size_t size, size_t minPartSize);
+
+/**
+ * @brief Run job(i) for every i in [0, count) and return when all of them are done.
+ *
+ * The jobs are spread over the calling thread and a pool of parallelThreads() - 1 worker threads, started on
+ * first use and kept for the life of the process, so the loop costs no thread creation. Jobs may run in any
+ * order and at the same time, each index runs once. Several threads may call parallelFor() at once, and a job
+ * may call it again: the caller always works on its own loop, so it never waits for a busy pool.
+ * @param count number of jobs.
+ * @param job function called with each index.
+ */
+void parallelFor(size_t count, const std::function<void(size_t index)> &job);
+
+}
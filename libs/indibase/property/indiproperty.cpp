@@ -416,6 +416,25 @@ void Property::save(FILE *fp) const
     PROPERTY_CASE( property->save(fp); )
 }
 
+void Property::onUpdate(const std::function<void()> &callback)
+{
+    D_PTR(Property);
+    d->onUpdateCallback = callback;
+}
+
+bool Property::hasUpdateCallback() const
+{
+    D_PTR(const Property);
+    return d->onUpdateCallback != nullptr;
+}
+
+void Property::emitUpdate()
+{
+    D_PTR(Property);
+    if (d->onUpdateCallback)
+        d->onUpdateCallback();
+}
+
 void Property::apply(const char *format, ...) const
 {
     D_PTR(const Property);
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <cstdarg>
+#include <functional>
 
 #define INDI_PROPERTY_BACKWARD_COMPATIBILE
 namespace INDI
@@ -102,6 +103,14 @@ public:
 public:
     void save(FILE *fp) const;
 
+public:
+    /** Handle new values from clients here instead of in ISNew*. The driver
+     *  updates the property with them and calls the callback, which then
+     *  sets the state and applies it. */
+    void onUpdate(const std::function<void()> &callback);
+    bool hasUpdateCallback() const;
+    void emitUpdate();
+
 public:
     void apply(const char *format, ...) const ATTRIBUTE_FORMAT_PRINTF(2, 3);
     void define(const char *format, ...) const ATTRIBUTE_FORMAT_PRINTF(2, 3);
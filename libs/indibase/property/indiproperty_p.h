@@ -41,6 +41,7 @@ public:
     INDI_PROPERTY_TYPE type = INDI_UNKNOWN;
     bool registered = false;
     bool dynamic = false;
+    std::function<void()> onUpdateCallback;
 
     PropertyPrivate(void *property, INDI_PROPERTY_TYPE type);
     PropertyPrivate(ITextVectorProperty *property);
@@ -71,9 +71,11 @@
 #endif
 
 #ifndef _WIN32
+#include <pthread.h>
 #include <unistd.h>
 #include <termios.h>
 #include <sys/param.h>
+#include <sys/socket.h>
 #define PARITY_NONE 0
 #define PARITY_EVEN 1
 #define PARITY_ODD  2
@@ -97,6 +99,22 @@ static int tty_generic_udp_format = 0;
 static int tty_sequence_number = 1;
 static int tty_clear_trailing_lf = 0;
 
+#ifndef _WIN32
+/* Bytes read past the stop character by a section read, kept for the next read on an fd that opted in */
+#define TTY_READAHEAD_SIZE 512
+typedef struct
+{
+    int enabled;
+    int start;
+    int end;
+    char data[TTY_READAHEAD_SIZE];
+} tty_readahead;
+
+static tty_readahead **tty_readaheads = NULL;
+static int tty_readaheads_count = 0;
+static pthread_mutex_t tty_readaheads_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 #if defined(HAVE_LIBNOVA)
 int extractISOTime(const char *timestr, struct ln_date *iso_date)
 {
@@ -363,11 +381,252 @@ void tty_clr_trailing_read_lf(int enabled)
     tty_clear_trailing_lf = enabled;
 }
 
+#ifndef _WIN32
+/* The read-ahead buffer of fd, NULL if out of memory */
+static tty_readahead *tty_get_readahead(int fd)
+{
+    tty_readahead *ra = NULL;
+
+    if (fd < 0)
+        return NULL;
+
+    pthread_mutex_lock(&tty_readaheads_mutex);
+
+    if (fd >= tty_readaheads_count)
+    {
+        int count = fd + 16;
+        tty_readahead **readaheads = realloc(tty_readaheads, count * sizeof(tty_readahead *));
+        if (readaheads != NULL)
+        {
+            memset(readaheads + tty_readaheads_count, 0, (count - tty_readaheads_count) * sizeof(tty_readahead *));
+            tty_readaheads       = readaheads;
+            tty_readaheads_count = count;
+        }
+    }
+
+    // Buffers are never freed so callers can use them unlocked, one reader per fd as before
+    if (fd < tty_readaheads_count)
+    {
+        if (tty_readaheads[fd] == NULL)
+            tty_readaheads[fd] = calloc(1, sizeof(tty_readahead));
+        ra = tty_readaheads[fd];
+    }
+
+    pthread_mutex_unlock(&tty_readaheads_mutex);
+
+    return ra;
+}
+
+/* The read-ahead buffer of fd if it opted in, NULL otherwise */
+static tty_readahead *tty_find_readahead(int fd)
+{
+    tty_readahead *ra = NULL;
+
+    pthread_mutex_lock(&tty_readaheads_mutex);
+    if (fd >= 0 && fd < tty_readaheads_count && tty_readaheads[fd] != NULL && tty_readaheads[fd]->enabled)
+        ra = tty_readaheads[fd];
+    pthread_mutex_unlock(&tty_readaheads_mutex);
+
+    return ra;
+}
+
+/* Forget bytes read ahead on fd, they are stale once the input is flushed or the port changes */
+static void tty_drop_readahead(int fd)
+{
+    pthread_mutex_lock(&tty_readaheads_mutex);
+    if (fd >= 0 && fd < tty_readaheads_count && tty_readaheads[fd] != NULL)
+        tty_readaheads[fd]->start = tty_readaheads[fd]->end = 0;
+    pthread_mutex_unlock(&tty_readaheads_mutex);
+}
+#endif
+
+void tty_set_readahead(int fd, int enabled)
+{
+#ifdef _WIN32
+    INDI_UNUSED(fd);
+    INDI_UNUSED(enabled);
+#else
+    // Nothing to allocate for an fd that never opted in
+    if (enabled)
+        tty_get_readahead(fd);
+
+    pthread_mutex_lock(&tty_readaheads_mutex);
+    if (fd >= 0 && fd < tty_readaheads_count && tty_readaheads[fd] != NULL)
+    {
+        tty_readaheads[fd]->enabled = enabled;
+        tty_readaheads[fd]->start = tty_readaheads[fd]->end = 0;
+    }
+    pthread_mutex_unlock(&tty_readaheads_mutex);
+#endif
+}
+
+#ifndef _WIN32
+/* Refill an empty read-ahead buffer with whatever fd has available */
+static int tty_fill_readahead(int fd, tty_readahead *ra, long timeout_seconds, long timeout_microseconds)
+{
+    int err, bytesRead;
+
+    if (ra->start < ra->end)
+        return TTY_OK;
+
+    if ((err = tty_timeout_microseconds(fd, timeout_seconds, timeout_microseconds)))
+        return err;
+
+    bytesRead = read(fd, ra->data, TTY_READAHEAD_SIZE);
+
+    // Readable with nothing to read is a hang up
+    if (bytesRead <= 0)
+        return TTY_READ_ERROR;
+
+    ra->start = 0;
+    ra->end   = bytesRead;
+
+    return TTY_OK;
+}
+
+/* Read until stop_char, or nsize bytes if nsize > 0, through the read-ahead buffer of fd */
+static int tty_read_section_buffered(int fd, tty_readahead *ra, char *buf, int nsize, char stop_char,
+                                     long timeout_seconds, long timeout_microseconds, int *nbytes_read)
+{
+    int err;
+
+    for (;;)
+    {
+        if ((err = tty_fill_readahead(fd, ra, timeout_seconds, timeout_microseconds)))
+            return err;
+
+        char *start = ra->data + ra->start;
+        int len     = ra->end - ra->start;
+
+        if (tty_clear_trailing_lf && *start == 0x0A && *nbytes_read == 0)
+        {
+            if (tty_debug)
+                IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
+
+            ra->start++;
+            if (stop_char == 0x0A)
+                return TTY_OK;
+            continue;
+        }
+
+        char *stop = memchr(start, stop_char, len);
+        if (stop != NULL)
+            len = stop - start + 1;
+        if (nsize > 0 && len > nsize - *nbytes_read)
+        {
+            len  = nsize - *nbytes_read;
+            stop = NULL;
+        }
+
+        memcpy(buf + *nbytes_read, start, len);
+        ra->start += len;
+
+        if (tty_debug)
+        {
+            int i = 0;
+            for (i = *nbytes_read; i < *nbytes_read + len; i++)
+                IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, i, (unsigned char)buf[i], buf[i]);
+        }
+
+        *nbytes_read += len;
+
+        if (stop != NULL)
+            return TTY_OK;
+        else if (nsize > 0 && *nbytes_read >= nsize)
+            return TTY_OVERFLOW;
+    }
+}
+
+/* Read until stop_char, or nsize bytes if nsize > 0, leaving whatever follows stop_char in fd */
+static int tty_read_section_exact(int fd, char *buf, int nsize, char stop_char, long timeout_seconds,
+                                  long timeout_microseconds, int *nbytes_read)
+{
+    char chunk[TTY_READAHEAD_SIZE];
+    int type         = 0;
+    socklen_t length = sizeof(type);
+    int stream       = getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &length) == 0 && type == SOCK_STREAM;
+    int available    = 0;
+    int err, len, bytesRead;
+
+    for (;;)
+    {
+        if (available <= 0)
+        {
+            if ((err = tty_timeout_microseconds(fd, timeout_seconds, timeout_microseconds)))
+                return err;
+
+            // Bytes known to be there are read without waiting for each of them
+            available = 1;
+#ifdef FIONREAD
+            if (!stream && (ioctl(fd, FIONREAD, &available) != 0 || available <= 0))
+                available = 1;
+#endif
+        }
+
+        len = 1;
+        if (stream)
+        {
+            // A socket can be looked at first, and read up to stop_char at once
+            bytesRead = recv(fd, chunk, sizeof(chunk), MSG_PEEK);
+            if (bytesRead <= 0)
+                return TTY_READ_ERROR;
+
+            char *stop = memchr(chunk, stop_char, bytesRead);
+            len        = stop != NULL ? stop - chunk + 1 : bytesRead;
+            available  = 0;
+        }
+        if (nsize > 0 && len > nsize - *nbytes_read)
+            len = nsize - *nbytes_read;
+
+        bytesRead = read(fd, buf + *nbytes_read, len);
+
+        // Readable with nothing to read is a hang up
+        if (bytesRead <= 0)
+            return TTY_READ_ERROR;
+
+        available -= bytesRead;
+
+        if (tty_debug)
+        {
+            int i = 0;
+            for (i = *nbytes_read; i < *nbytes_read + bytesRead; i++)
+                IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, i, (unsigned char)buf[i], buf[i]);
+        }
+
+        if (tty_clear_trailing_lf && *nbytes_read == 0 && buf[0] == 0x0A)
+        {
+            if (tty_debug)
+                IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
+
+            if (stop_char == 0x0A)
+                return TTY_OK;
+            memmove(buf, buf + 1, --bytesRead);
+            if (bytesRead == 0)
+                continue;
+        }
+
+        *nbytes_read += bytesRead;
+
+        // Nothing past the first stop_char was read, so it can only be last
+        if (buf[*nbytes_read - 1] == stop_char)
+            return TTY_OK;
+        else if (nsize > 0 && *nbytes_read >= nsize)
+            return TTY_OVERFLOW;
+    }
+}
+#endif
+
 int tty_timeout(int fd, int timeout)
+{
+    return tty_timeout_microseconds(fd, timeout, 0);
+}
+
+int tty_timeout_microseconds(int fd, long timeout_seconds, long timeout_microseconds)
 {
 #if defined(_WIN32) || defined(ANDROID)
     INDI_UNUSED(fd);
-    INDI_UNUSED(timeout);
+    INDI_UNUSED(timeout_seconds);
+    INDI_UNUSED(timeout_microseconds);
     return TTY_ERRNO;
 #else
 
@@ -381,9 +640,9 @@ int tty_timeout(int fd, int timeout)
     FD_ZERO(&readout);
     FD_SET(fd, &readout);
 
-    /* wait for 'timeout' seconds */
-    tv.tv_sec  = timeout;
-    tv.tv_usec = 0;
+    /* wait for the timeout */
+    tv.tv_sec  = timeout_seconds + timeout_microseconds / 1000000;
+    tv.tv_usec = timeout_microseconds % 1000000;
 
     /* Wait till we have a change in the fd status */
     retval = select(fd + 1, &readout, NULL, NULL, &tv);
@@ -460,6 +719,11 @@ int tty_write_string(int fd, const char *buf, int *nbytes_written)
 }
 
 int tty_read(int fd, char *buf, int nbytes, int timeout, int *nbytes_read)
+{
+    return tty_read_expanded(fd, buf, nbytes, timeout, 0, nbytes_read);
+}
+
+int tty_read_expanded(int fd, char *buf, int nbytes, long timeout_seconds, long timeout_microseconds, int *nbytes_read)
 {
 #ifdef _WIN32
     return TTY_ERRNO;
@@ -477,7 +741,8 @@ int tty_read(int fd, char *buf, int nbytes, int timeout, int *nbytes_read)
         return TTY_PARAM_ERROR;
 
     if (tty_debug)
-        IDLog("%s: Request to read %d bytes with %d timeout for fd %d\n", __FUNCTION__, nbytes, timeout, fd);
+        IDLog("%s: Request to read %d bytes with %ld s %ld us timeout for fd %d\n", __FUNCTION__, nbytes, timeout_seconds,
+              timeout_microseconds, fd);
 
     char geminiBuffer[257]={0};
     char* buffer = buf;
@@ -487,10 +752,30 @@ int tty_read(int fd, char *buf, int nbytes, int timeout, int *nbytes_read)
         numBytesToRead = nbytes + 8;
         buffer = geminiBuffer;
     }
+    else if (!tty_generic_udp_format)
+    {
+        // Start with what the last section read left over
+        tty_readahead *ra = tty_find_readahead(fd);
+        if (ra != NULL && ra->start < ra->end)
+        {
+            if (tty_clear_trailing_lf && ra->data[ra->start] == 0x0A)
+            {
+                if (tty_debug)
+                    IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
+                ra->start++;
+            }
+
+            bytesRead = ra->end - ra->start < numBytesToRead ? ra->end - ra->start : numBytesToRead;
+            memcpy(buffer, ra->data + ra->start, bytesRead);
+            ra->start += bytesRead;
+            *nbytes_read += bytesRead;
+            numBytesToRead -= bytesRead;
+        }
+    }
 
     while (numBytesToRead > 0)
     {
-        if ((err = tty_timeout(fd, timeout)))
+        if ((err = tty_timeout_microseconds(fd, timeout_seconds, timeout_microseconds)))
             return err;
 
         bytesRead = read(fd, buffer + (*nbytes_read), ((uint32_t)numBytesToRead));
@@ -526,7 +811,7 @@ int tty_read(int fd, char *buf, int nbytes, int timeout, int *nbytes_read)
         if (intSizedBuffer[0] != tty_sequence_number)
         {
             // Not the right reply just do the read again.
-            return tty_read(fd, buf, nbytes, timeout, nbytes_read);
+            return tty_read_expanded(fd, buf, nbytes, timeout_seconds, timeout_microseconds, nbytes_read);
         }
 
         *nbytes_read -= 8;
@@ -539,6 +824,12 @@ int tty_read(int fd, char *buf, int nbytes, int timeout, int *nbytes_read)
 }
 
 int tty_read_section(int fd, char *buf, char stop_char, int timeout, int *nbytes_read)
+{
+    return tty_read_section_expanded(fd, buf, stop_char, timeout, 0, nbytes_read);
+}
+
+int tty_read_section_expanded(int fd, char *buf, char stop_char, long timeout_seconds, long timeout_microseconds,
+                              int *nbytes_read)
 {
 #ifdef _WIN32
     return TTY_ERRNO;
@@ -550,13 +841,11 @@ int tty_read_section(int fd, char *buf, char stop_char, int timeout, int *nbytes
         return TTY_ERRNO;
 
     int bytesRead = 0;
-    int err       = TTY_OK;
     *nbytes_read  = 0;
 
-    uint8_t *read_char = 0;
-
     if (tty_debug)
-        IDLog("%s: Request to read until stop char '%#02X' with %d timeout for fd %d\n", __FUNCTION__, stop_char, timeout, fd);
+        IDLog("%s: Request to read until stop char '%#02X' with %ld s %ld us timeout for fd %d\n", __FUNCTION__, stop_char,
+              timeout_seconds, timeout_microseconds, fd);
 
     if (tty_gemini_udp_format)
     {
@@ -569,7 +858,7 @@ int tty_read_section(int fd, char *buf, char stop_char, int timeout, int *nbytes
         if (intSizedBuffer[0] != tty_sequence_number)
         {
             // Not the right reply just do the read again.
-            return tty_read_section(fd, buf, stop_char, timeout, nbytes_read);
+            return tty_read_section_expanded(fd, buf, stop_char, timeout_seconds, timeout_microseconds, nbytes_read);
         }
 
         for (int index = 8; index < bytesRead; index++)
@@ -601,31 +890,11 @@ int tty_read_section(int fd, char *buf, char stop_char, int timeout, int *nbytes
     }
     else
     {
-        for (;;)
-        {
-            if ((err = tty_timeout(fd, timeout)))
-                return err;
-
-            read_char = (uint8_t*)(buf + *nbytes_read);
-            bytesRead = read(fd, read_char, 1);
-
-            if (bytesRead < 0)
-                return TTY_READ_ERROR;
-
-            if (tty_debug)
-                IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, (*nbytes_read), *read_char, *read_char);
-
-            if (!(tty_clear_trailing_lf && *read_char == 0X0A && *nbytes_read == 0))
-                (*nbytes_read)++;
-            else {
-                if (tty_debug)
-                    IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
-            }
-
-            if (*read_char == stop_char) {
-                return TTY_OK;
-            }
-        }
+        tty_readahead *ra = tty_find_readahead(fd);
+        if (ra != NULL)
+            return tty_read_section_buffered(fd, ra, buf, 0, stop_char, timeout_seconds, timeout_microseconds,
+                                             nbytes_read);
+        return tty_read_section_exact(fd, buf, 0, stop_char, timeout_seconds, timeout_microseconds, nbytes_read);
     }
 
     return TTY_TIME_OUT;
@@ -634,6 +903,12 @@ int tty_read_section(int fd, char *buf, char stop_char, int timeout, int *nbytes
 }
 
 int tty_nread_section(int fd, char *buf, int nsize, char stop_char, int timeout, int *nbytes_read)
+{
+    return tty_nread_section_expanded(fd, buf, nsize, stop_char, timeout, 0, nbytes_read);
+}
+
+int tty_nread_section_expanded(int fd, char *buf, int nsize, char stop_char, long timeout_seconds,
+                               long timeout_microseconds, int *nbytes_read)
 {
 #ifdef _WIN32
     return TTY_ERRNO;
@@ -644,43 +919,24 @@ int tty_nread_section(int fd, char *buf, int nsize, char stop_char, int timeout,
 
     // For Gemini
     if (tty_gemini_udp_format || tty_generic_udp_format)
-        return tty_read_section(fd, buf, stop_char, timeout, nbytes_read);
+        return tty_read_section_expanded(fd, buf, stop_char, timeout_seconds, timeout_microseconds, nbytes_read);
 
-    int bytesRead = 0;
-    int err       = TTY_OK;
     *nbytes_read  = 0;
-    uint8_t *read_char = 0;
-    memset(buf, 0, nsize);
-
-    if (tty_debug)
-        IDLog("%s: Request to read until stop char '%#02X' with %d timeout for fd %d\n", __FUNCTION__, stop_char, timeout, fd);
 
-    for (;;)
-    {
-        if ((err = tty_timeout(fd, timeout)))
-            return err;
-
-        read_char = (uint8_t*)(buf + *nbytes_read);
-        bytesRead = read(fd, read_char, 1);
+    if (nsize <= 0)
+        return TTY_PARAM_ERROR;
 
-        if (bytesRead < 0)
-            return TTY_READ_ERROR;
+    memset(buf, 0, nsize);
 
-        if (tty_debug)
-            IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, (*nbytes_read), *read_char, *read_char);
+    if (tty_debug)
+        IDLog("%s: Request to read until stop char '%#02X' with %ld s %ld us timeout for fd %d\n", __FUNCTION__, stop_char,
+              timeout_seconds, timeout_microseconds, fd);
 
-        if (!(tty_clear_trailing_lf && *read_char == 0X0A && *nbytes_read == 0))
-            (*nbytes_read)++;
-        else {
-            if (tty_debug)
-                IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
-        }
-
-        if (*read_char == stop_char)
-            return TTY_OK;
-        else if (*nbytes_read >= nsize)
-            return TTY_OVERFLOW;
-    }
+    tty_readahead *ra = tty_find_readahead(fd);
+    if (ra != NULL)
+        return tty_read_section_buffered(fd, ra, buf, nsize, stop_char, timeout_seconds, timeout_microseconds,
+                                         nbytes_read);
+    return tty_read_section_exact(fd, buf, nsize, stop_char, timeout_seconds, timeout_microseconds, nbytes_read);
 
 #endif
 }
@@ -898,6 +1154,7 @@ int tty_connect(const char *device, int bit_rate, int word_size, int parity, int
     }
 #endif
 
+    tty_set_readahead(t_fd, 0);
     *fd = t_fd;
     /* return success */
     return TTY_OK;
@@ -1104,6 +1361,7 @@ int tty_connect(const char *device, int bit_rate, int word_size, int parity, int
         return TTY_PORT_FAILURE;
     }
 
+    tty_set_readahead(t_fd, 0);
     *fd = t_fd;
     /* return success */
     return TTY_OK;
@@ -1123,6 +1381,7 @@ int tty_disconnect(int fd)
 #else
     int err;
     tcflush(fd, TCIOFLUSH);
+    tty_set_readahead(fd, 0);
     err = close(fd);
 
     if (err != 0)
@@ -1132,6 +1391,19 @@ int tty_disconnect(int fd)
 #endif
 }
 
+int tty_tcflush(int fd, int queue_selector)
+{
+#ifdef _WIN32
+    INDI_UNUSED(fd);
+    INDI_UNUSED(queue_selector);
+    return -1;
+#else
+    if (queue_selector != TCOFLUSH)
+        tty_drop_readahead(fd);
+    return tcflush(fd, queue_selector);
+#endif
+}
+
 void tty_error_msg(int err_code, char *err_msg, int err_msg_len)
 {
     switch (err_code)
@@ -123,6 +123,17 @@ extern "C" {
 */
 int tty_read(int fd, char *buf, int nbytes, int timeout, int *nbytes_read);
 
+/** \brief read buffer from terminal with a timeout of seconds and microseconds
+    \param fd file descriptor
+    \param buf pointer to store data. Must be initilized and big enough to hold data.
+    \param nbytes number of bytes to read.
+    \param timeout_seconds number of seconds to wait for terminal before a timeout error is issued.
+    \param timeout_microseconds number of microseconds to wait in addition to \e timeout_seconds.
+    \param nbytes_read the number of bytes read.
+    \return On success, it returns TTY_OK, otherwise, a TTY_ERROR code.
+*/
+int tty_read_expanded(int fd, char *buf, int nbytes, long timeout_seconds, long timeout_microseconds, int *nbytes_read);
+
 /** \brief read buffer from terminal with a delimiter
     \param fd file descriptor
     \param buf pointer to store data. Must be initilized and big enough to hold data.
@@ -130,10 +141,24 @@ int tty_read(int fd, char *buf, int nbytes, int timeout, int *nbytes_read);
     \param timeout number of seconds to wait for terminal before a timeout error is issued.
     \param nbytes_read the number of bytes read.
     \return On success, it returns TTY_OK, otherwise, a TTY_ERROR code.
+    \note Nothing after \e stop_char is read, unless \e fd opted in with tty_set_readahead(). Sockets are read
+    in chunks up to \e stop_char.
 */
 
 int tty_read_section(int fd, char *buf, char stop_char, int timeout, int *nbytes_read);
 
+/** \brief read buffer from terminal with a delimiter and a timeout of seconds and microseconds
+    \param fd file descriptor
+    \param buf pointer to store data. Must be initilized and big enough to hold data.
+    \param stop_char if the function encounters \e stop_char then it stops reading and returns the buffer.
+    \param timeout_seconds number of seconds to wait for terminal before a timeout error is issued.
+    \param timeout_microseconds number of microseconds to wait in addition to \e timeout_seconds.
+    \param nbytes_read the number of bytes read.
+    \return On success, it returns TTY_OK, otherwise, a TTY_ERROR code.
+*/
+int tty_read_section_expanded(int fd, char *buf, char stop_char, long timeout_seconds, long timeout_microseconds,
+                              int *nbytes_read);
+
 /** \brief read buffer from terminal with a delimiter
     \param fd file descriptor
     \param buf pointer to store data. Must be initilized and big enough to hold data.
@@ -146,6 +171,19 @@ int tty_read_section(int fd, char *buf, char stop_char, int timeout, int *nbytes
 
 int tty_nread_section(int fd, char *buf, int nsize, char stop_char, int timeout, int *nbytes_read);
 
+/** \brief read buffer from terminal with a delimiter and a timeout of seconds and microseconds
+    \param fd file descriptor
+    \param buf pointer to store data. Must be initilized and big enough to hold data.
+    \param nsize size of buf. If stop character is not encountered before nsize, the function aborts.
+    \param stop_char if the function encounters \e stop_char then it stops reading and returns the buffer.
+    \param timeout_seconds number of seconds to wait for terminal before a timeout error is issued.
+    \param timeout_microseconds number of microseconds to wait in addition to \e timeout_seconds.
+    \param nbytes_read the number of bytes read.
+    \return On success, it returns TTY_OK, otherwise, a TTY_ERROR code.
+*/
+int tty_nread_section_expanded(int fd, char *buf, int nsize, char stop_char, long timeout_seconds,
+                               long timeout_microseconds, int *nbytes_read);
+
 /** \brief Writes a buffer to fd.
     \param fd file descriptor
     \param buffer a null-terminated buffer to write to fd.
@@ -182,6 +220,26 @@ int tty_connect(const char *device, int bit_rate, int word_size, int parity, int
 */
 int tty_disconnect(int fd);
 
+/** \brief Let the section reads on fd read past the stop character and keep the rest for the next tty_read*().
+
+    The port is then read in chunks instead of a byte at a time. Only opt in if all reads of \e fd go through
+    the tty_read*() functions and its input is flushed with tty_tcflush(). Raw read() and tcflush() calls miss
+    what was read ahead. tty_connect() and tty_disconnect() turn it off again.
+    \param fd file descriptor
+    \param enabled 1 to read ahead, 0 to read no more than each call returns. Either way, bytes read ahead so far
+    are dropped.
+*/
+void tty_set_readahead(int fd, int enabled);
+
+/** \brief Flush a tty like tcflush(), including any bytes read ahead on it.
+
+    Only needed on an fd that opted in with tty_set_readahead(); otherwise it is tcflush().
+    \param fd file descriptor
+    \param queue_selector TCIFLUSH, TCOFLUSH or TCIOFLUSH
+    \return 0 on success, -1 on error with errno set, as tcflush()
+*/
+int tty_tcflush(int fd, int queue_selector);
+
 /** \brief Retrieve the tty error message
     \param err_code the error code return by any TTY function.
     \param err_msg an initialized buffer to hold the error message.
@@ -199,6 +257,7 @@ void tty_set_generic_udp_format(int enabled);
 void tty_clr_trailing_read_lf(int enabled);
 
 int tty_timeout(int fd, int timeout);
+int tty_timeout_microseconds(int fd, long timeout_seconds, long timeout_microseconds);
 /*@}*/
 
 /**
@@ -24,6 +24,12 @@
 
 #include <stdlib.h>
 
+// BLOBs are sent as lines of 72 base64 characters, each from 54 bytes
+#define BLOB_LINE_BYTES     54
+#define BLOB_LINE_CHARS     72
+// lines encoded per write
+#define BLOB_CHUNK_LINES    1024
+
 static void s_userio_xml_message_vprintf(const userio *io, void *user, const char *fmt, va_list ap)
 {
     char message[MAXINDIMESSAGE];
@@ -102,9 +108,6 @@ void IUUserIOBLOBContextOne(
     const char *name, unsigned int size, unsigned int bloblen, const void *blob, const char *format
 )
 {
-    unsigned char *encblob;
-    int l;
-
     userio_prints    (io, user, "  <oneBLOB\n"
                                 "    name='");
     userio_xml_escape(io, user, name);
@@ -121,44 +124,69 @@ void IUUserIOBLOBContextOne(
     }
     else
     {
-        size_t sz = 4 * bloblen / 3 + 4;
-        assert_mem(encblob = (unsigned char *)malloc(sz)); // #PS: TODO
-        l = to64frombits_s(encblob, blob, bloblen, sz);
-        if (l == 0) {
-            fprintf(stderr, "%s: Not enough memory for decoding.\n", __func__);
-            exit(1);
-        }
-        userio_printf    (io, user, "    enclen='%d'\n", l); // safe
+        const unsigned char *in = (const unsigned char *)blob;
+        unsigned char *encblob, *op;
+        size_t done = 0;
+
+        // whole lines of base64 are encoded a chunk at a time, so memory use does not grow with the blob
+        assert_mem(encblob = (unsigned char *)malloc(BLOB_CHUNK_LINES * (BLOB_LINE_CHARS + 1)));
+
+        userio_printf    (io, user, "    enclen='%u'\n", 4 * ((bloblen + 2) / 3)); // safe
         userio_prints    (io, user, "    format='");
         userio_xml_escape(io, user, format);
         userio_prints    (io, user, "'>\n");
-        size_t written = 0;
 
-        while ((int)written < l)
+        while (done < bloblen)
         {
-            size_t towrite = ((l - written) > 72) ? 72 : l - written;
-            size_t wr      = userio_write(io, user, encblob + written, towrite);
+            size_t left = bloblen - done;
+            size_t wr;
+            int i;
 
-            if (wr == 0)
+            op = encblob;
+            for (i = 0; i < BLOB_CHUNK_LINES && left > 0; i++)
             {
-                free(encblob);
-                return;
+                int n = left < BLOB_LINE_BYTES ? left : BLOB_LINE_BYTES;
+
+                op += to64frombits_s(op, in + done, n, BLOB_LINE_CHARS);
+                *op++ = '\n';
+                done += n;
+                left -= n;
             }
 
-            written += wr;
-            if ((written % 72) == 0)
-                userio_putc(io, user, '\n');
+            for (size_t written = 0; written < (size_t)(op - encblob); written += wr)
+            {
+                wr = userio_write(io, user, encblob + written, (op - encblob) - written);
+                if (wr == 0)
+                {
+                    free(encblob);
+                    return;
+                }
+            }
         }
 
-        if ((written % 72) != 0)
-            userio_putc(io, user, '\n');
-
         free(encblob);
     }
 
     userio_prints    (io, user, "  </oneBLOB>\n");
 }
 
+void IUUserIOBLOBContextAttached(
+    const userio *io, void *user,
+    const char *name, unsigned int size, unsigned int bloblen, const char *format
+)
+{
+    userio_prints    (io, user, "  <oneBLOB\n"
+                                "    name='");
+    userio_xml_escape(io, user, name);
+    userio_prints    (io, user, "'\n");
+    userio_printf    (io, user, "    size='%d'\n", size); // safe
+    userio_printf    (io, user, "    len='%u'\n", bloblen); // safe
+    userio_prints    (io, user, "    format='");
+    userio_xml_escape(io, user, format);
+    userio_prints    (io, user, "'\n"
+                                "    attached='true'/>\n");
+}
+
 void IUUserIOBLOBContext(const userio *io, void *user, const IBLOBVectorProperty *bvp)
 {
     for (int i = 0; i < bvp->nbp; i++)
@@ -717,6 +745,14 @@ void IUUserIOSetBLOBVA(
     const userio *io, void *user,
     const IBLOBVectorProperty *bvp, const char *fmt, va_list ap
 )
+{
+    IUUserIOSetBLOBAttachedVA(io, user, bvp, NULL, fmt, ap);
+}
+
+void IUUserIOSetBLOBAttachedVA(
+    const userio *io, void *user,
+    const IBLOBVectorProperty *bvp, const int *attached, const char *fmt, va_list ap
+)
 {
     locale_char_t *orig = indi_locale_C_numeric_push();
     userio_prints    (io, user, "<setBLOBVector\n"
@@ -732,7 +768,20 @@ void IUUserIOSetBLOBVA(
     s_userio_xml_message_vprintf(io, user, fmt, ap);
     userio_prints    (io, user, ">\n");
 
-    IUUserIOBLOBContext(io, user, bvp);
+    for (int i = 0; i < bvp->nbp; i++)
+    {
+        IBLOB *bp = &bvp->bp[i];
+        if (attached && attached[i])
+            IUUserIOBLOBContextAttached(
+                io, user,
+                bp->name, bp->size, bp->bloblen, bp->format
+            );
+        else
+            IUUserIOBLOBContextOne(
+                io, user,
+                bp->name, bp->size, bp->bloblen, bp->blob, bp->format
+            );
+    }
 
     userio_prints    (io, user, "</setBLOBVector>\n");
     indi_locale_C_numeric_pop(orig);
@@ -54,6 +54,10 @@ void IUUserIOBLOBContextOne(
     const userio *io, void *user,
     const char *name, unsigned int size, unsigned int bloblen, const void *blob, const char *format
 );
+void IUUserIOBLOBContextAttached(
+    const userio *io, void *user,
+    const char *name, unsigned int size, unsigned int bloblen, const char *format
+);
 void IUUserIONewBLOBFinish(const userio *io, void *user);
 
 void IUUserIOEnableBLOB(
@@ -74,6 +78,7 @@ void IUUserIOSetNumberVA(const userio *io, void *user, const struct _INumberVect
 void IUUserIOSetSwitchVA(const userio *io, void *user, const struct _ISwitchVectorProperty *svp, const char *fmt, va_list ap);
 void IUUserIOSetLightVA(const userio *io, void *user, const struct _ILightVectorProperty *lvp, const char *fmt, va_list ap);
 void IUUserIOSetBLOBVA(const userio *io, void *user, const struct _IBLOBVectorProperty *bvp, const char *fmt, va_list ap);
+void IUUserIOSetBLOBAttachedVA(const userio *io, void *user, const struct _IBLOBVectorProperty *bvp, const int *attached, const char *fmt, va_list ap);
 
 void IUUserIOUpdateMinMax(const userio *io, void *user, const struct _INumberVectorProperty *nvp);
 
@@ -99,6 +99,9 @@ struct LilXML_
     int lastc;     /* last char (just used wiht skipping)*/
     int skipping;  /* in comment or declaration */
     int inblob;    /* in oneBLOB element */
+    XMLContentHandler content; /* takes the content of elements it chooses */
+    void *contentctx;
+    int incontent; /* content of ce goes to handler */
 };
 
 /* internal representation of a (possibly nested) XML element */
@@ -153,6 +156,12 @@ LilXML *newLilXML()
     return (lp);
 }
 
+void setXMLContentHandler(LilXML *lp, XMLContentHandler handler, void *ctx)
+{
+    lp->content    = handler;
+    lp->contentctx = ctx;
+}
+
 /* discard */
 void delLilXML(LilXML *lp)
 {
@@ -250,7 +259,8 @@ XMLEle **parseXMLChunk(LilXML *lp, char *buf, int size, char ynot[])
         if (lp->ce)
         {
             char *ctag = tagXMLEle(lp->ce);
-            if (ctag && !(strcmp(ctag, "oneBLOB")) && (lp->cs == INCON))
+            /* content going to the handler is never stored in pcdata */
+            if (ctag && !(strcmp(ctag, "oneBLOB")) && (lp->cs == INCON) && !lp->incontent)
             {
 #ifdef WITH_ENCLEN
                 XMLAtt *blenatt = findXMLAtt(lp->ce, "enclen");
@@ -303,6 +313,19 @@ XMLEle **parseXMLChunk(LilXML *lp, char *buf, int size, char ynot[])
             continue;
         }
 
+        /* content for the handler, hand over everything up to the next tag at once */
+        if (lp->incontent && lp->cs == INCON && !lp->skipping && lp->lastc != '<' && newc != '<')
+        {
+            char *ltpos = memchr(curr, '<', size - (curr - buf));
+            int len     = ltpos ? ltpos - curr : size - (curr - buf);
+            for (char *nl = curr; (nl = memchr(nl, '\n', len - (nl - curr))) != NULL; nl++)
+                lp->ln++;
+            (*lp->content)(lp->contentctx, lp->ce, curr, len);
+            lp->lastc = curr[len - 1];
+            curr += len;
+            continue;
+        }
+
         /* new line? */
         if (newc == '\n')
             lp->ln++;
@@ -1029,13 +1052,29 @@ static int oneXMLchar(LilXML *lp, int c, char ynot[])
                 lp->cs = SAWLTINCON;
             else if (!isspace(c))
             {
-                growString(&lp->ce->pcdata, c);
+                char ch = c;
+                lp->incontent = lp->content && (*lp->content)(lp->contentctx, lp->ce, NULL, 0);
+                if (lp->incontent)
+                    (*lp->content)(lp->contentctx, lp->ce, &ch, 1);
+                else
+                    growString(&lp->ce->pcdata, c);
                 lp->cs = INCON;
             }
             break;
 
         case INCON: /* reading content */
-            if (c == '&')
+            if (lp->incontent)
+            {
+                char ch = c;
+                if (c == '<')
+                {
+                    lp->incontent = 0;
+                    lp->cs        = SAWLTINCON;
+                }
+                else
+                    (*lp->content)(lp->contentctx, lp->ce, &ch, 1);
+            }
+            else if (c == '&')
             {
                 newString(&lp->entity);
                 growString(&lp->entity, c);
@@ -1141,10 +1180,15 @@ static int oneXMLchar(LilXML *lp, int c, char ynot[])
 /* set up for a fresh start again */
 static void initParser(LilXML *lp)
 {
+    XMLContentHandler content = lp->content;
+    void *contentctx          = lp->contentctx;
+
     delXMLEle(lp->ce);
     freeString(&lp->endtag);
     memset(lp, 0, sizeof(*lp));
     newString(&lp->endtag);
+    lp->content    = content;
+    lp->contentctx = contentctx;
     lp->cs = LOOK4START;
     lp->ln = 1;
 }
@@ -273,6 +273,23 @@ extern int sprlXMLEle(XMLEle *ep, int level);
 extern void indi_xmlMalloc(void *(*newmalloc)(size_t size), void *(*newrealloc)(void *ptr, size_t size),
                            void (*newfree)(void *ptr));
 
+/** \brief Receives the character data of an element while it is being parsed.
+    \param ctx the pointer given to setXMLContentHandler().
+    \param ep the element whose content this is. Its attributes and parents are complete.
+    \param data NULL when the content of ep begins, otherwise the next run of raw content characters.
+    \param len number of characters in data.
+    \return when data is NULL, non-zero to receive the content of ep instead of having it stored in ep. Ignored otherwise.
+*/
+typedef int (*XMLContentHandler)(void *ctx, XMLEle *ep, const char *data, int len);
+
+/** \brief Hand the content of chosen elements to a handler as it is parsed, instead of collecting it.
+    Content handed over is not entity decoded, and pcdataXMLEle() of its element stays empty.
+    \param lp a pointer to a lilxml parser.
+    \param handler the handler, or NULL to collect all content again.
+    \param ctx passed to the handler.
+*/
+extern void setXMLContentHandler(LilXML *lp, XMLContentHandler handler, void *ctx);
+
 /*@}*/
 
 #ifdef __cplusplus
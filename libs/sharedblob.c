@@ -0,0 +1,298 @@
+/*
+    Shared BLOB buffers for handing BLOBs to indiserver without copying.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+    indiserver gives each local driver one end of a datagram socket pair and
+    names it in the INDIBLOBFD environment variable. Each shared segment sent
+    there as SCM_RIGHTS is claimed, in order, by the next oneBLOB marked
+    attached='true' the driver writes to stdout.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // needed for memfd_create and mremap
+#endif
+
+#include "sharedblob.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#ifdef MFD_CLOEXEC
+#define HAVE_MEMFD
+#endif
+#endif
+
+#ifdef HAVE_MEMFD
+
+/* one shared buffer */
+typedef struct shared_blob
+{
+    void *ptr;                 /* where it is mapped */
+    size_t size;               /* mapped size */
+    int fd;                    /* its memfd */
+    struct shared_blob *next;
+} shared_blob;
+
+static pthread_mutex_t shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static shared_blob *shared_blobs; /* all shared buffers */
+static int shared_channel = -2;   /* INDIBLOBFD, -1 if none, -2 until known */
+
+/* return the record of ptr, or NULL if it is not a shared buffer.
+ * N.B. call with shared_mutex held.
+ */
+static shared_blob **s_find(const void *ptr)
+{
+    shared_blob **sbp;
+
+    for (sbp = &shared_blobs; *sbp; sbp = &(*sbp)->next)
+        if ((*sbp)->ptr == ptr)
+            return sbp;
+
+    return NULL;
+}
+
+/* return a new memfd of size bytes, or -1 */
+static int s_segment(size_t size)
+{
+    int fd = memfd_create("indiblob", MFD_CLOEXEC);
+
+    if (fd < 0)
+        return -1;
+    if (ftruncate(fd, size) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* return the socket to indiserver, or -1 if not run by one that accepts
+ * shared BLOBs.
+ * N.B. call with shared_mutex held.
+ */
+static int s_channel()
+{
+    if (shared_channel == -2)
+    {
+        const char *env = getenv("INDIBLOBFD");
+        shared_channel  = env ? atoi(env) : -1;
+        if (shared_channel <= 2)
+            shared_channel = -1;
+    }
+    return shared_channel;
+}
+
+void *IDSharedBlobAlloc(size_t size)
+{
+    shared_blob *sb;
+    int fd;
+
+    if (size == 0 || (fd = s_segment(size)) < 0)
+        return malloc(size);
+
+    sb = (shared_blob *)malloc(sizeof(*sb));
+    if (sb == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    sb->ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (sb->ptr == MAP_FAILED)
+    {
+        close(fd);
+        free(sb);
+        return malloc(size);
+    }
+    sb->size = size;
+    sb->fd   = fd;
+
+    pthread_mutex_lock(&shared_mutex);
+    sb->next     = shared_blobs;
+    shared_blobs = sb;
+    pthread_mutex_unlock(&shared_mutex);
+
+    return sb->ptr;
+}
+
+void *IDSharedBlobRealloc(void *ptr, size_t size)
+{
+    shared_blob **sbp;
+    shared_blob *sb;
+    void *np;
+
+    if (ptr == NULL)
+        return IDSharedBlobAlloc(size);
+
+    pthread_mutex_lock(&shared_mutex);
+    sbp = s_find(ptr);
+    if (sbp == NULL)
+    {
+        pthread_mutex_unlock(&shared_mutex);
+        return realloc(ptr, size);
+    }
+    sb = *sbp;
+
+    if (size == 0 || ftruncate(sb->fd, size) < 0)
+    {
+        pthread_mutex_unlock(&shared_mutex);
+        return NULL;
+    }
+
+    np = mremap(sb->ptr, sb->size, size, MREMAP_MAYMOVE);
+    if (np == MAP_FAILED)
+    {
+        (void)ftruncate(sb->fd, sb->size);
+        pthread_mutex_unlock(&shared_mutex);
+        return NULL;
+    }
+    sb->ptr  = np;
+    sb->size = size;
+    pthread_mutex_unlock(&shared_mutex);
+
+    return np;
+}
+
+void IDSharedBlobFree(void *ptr)
+{
+    shared_blob **sbp;
+    shared_blob *sb;
+
+    if (ptr == NULL)
+        return;
+
+    pthread_mutex_lock(&shared_mutex);
+    sbp = s_find(ptr);
+    if (sbp == NULL)
+    {
+        pthread_mutex_unlock(&shared_mutex);
+        free(ptr);
+        return;
+    }
+    sb   = *sbp;
+    *sbp = sb->next;
+    pthread_mutex_unlock(&shared_mutex);
+
+    munmap(sb->ptr, sb->size);
+    close(sb->fd);
+    free(sb);
+}
+
+int IDSharedBlobSend(const void *ptr)
+{
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    struct iovec iov;
+    shared_blob **sbp;
+    shared_blob *sb;
+    char tag = 'B';
+    int ch, fd;
+    ssize_t ns;
+
+    pthread_mutex_lock(&shared_mutex);
+    ch  = s_channel();
+    sbp = ch < 0 ? NULL : s_find(ptr);
+    if (sbp == NULL)
+    {
+        pthread_mutex_unlock(&shared_mutex);
+        return -1;
+    }
+    sb = *sbp;
+
+    /* the driver keeps using ptr, so prepare its next segment first */
+    fd = s_segment(sb->size);
+    if (fd < 0)
+    {
+        pthread_mutex_unlock(&shared_mutex);
+        return -1;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    memset(cbuf, 0, sizeof(cbuf));
+    iov.iov_base       = &tag;
+    iov.iov_len        = 1;
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    cmsg               = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level   = SOL_SOCKET;
+    cmsg->cmsg_type    = SCM_RIGHTS;
+    cmsg->cmsg_len     = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &sb->fd, sizeof(int));
+
+    do
+        ns = sendmsg(ch, &msg, MSG_NOSIGNAL);
+    while (ns < 0 && errno == EINTR);
+
+    if (ns < 0)
+    {
+        /* indiserver went away or does not want them, stop trying */
+        if (errno != ENOBUFS && errno != ENOMEM)
+            shared_channel = -1;
+        close(fd);
+        pthread_mutex_unlock(&shared_mutex);
+        return -1;
+    }
+
+    /* the sent segment now belongs to indiserver, move ptr to the new one */
+    if (mmap(sb->ptr, sb->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        /* only if out of memory, then the old segment stays shared */
+        close(fd);
+    }
+    else
+    {
+        close(sb->fd);
+        sb->fd = fd;
+    }
+    pthread_mutex_unlock(&shared_mutex);
+
+    return 0;
+}
+
+#else
+
+void *IDSharedBlobAlloc(size_t size)
+{
+    return malloc(size);
+}
+
+void *IDSharedBlobRealloc(void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void IDSharedBlobFree(void *ptr)
+{
+    free(ptr);
+}
+
+int IDSharedBlobSend(const void *ptr)
+{
+    (void)ptr;
+    return -1;
+}
+
+#endif
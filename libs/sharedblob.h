@@ -0,0 +1,78 @@
+/*
+    Shared BLOB buffers for handing BLOBs to indiserver without copying.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \defgroup sharedBlob Shared BLOB buffers: BLOB data indiserver can take without copying
+ *
+ * Buffers allocated here live in their own shared memory segment (a memfd on Linux). When such a
+ * buffer is the blob of an IBLOB sent with IDSetBLOB() to a local indiserver, only its descriptor
+ * passes through the driver's stdout and the segment itself is handed over as a file descriptor.
+ * This saves the base64 encoding and all the pipe copies of the data.
+ *
+ * Once sent, the segment belongs to its receivers and the buffer is quietly moved to a new, zeroed
+ * segment of the same size. Drivers must fill it again before sending it again.
+ *
+ * Where shared memory is not available these behave as malloc(), realloc() and free(), and BLOBs
+ * are sent base64 encoded as usual.
+ */
+/*@{*/
+
+/** \brief Allocate a shared BLOB buffer.
+    \param size bytes to allocate.
+    \return pointer to the buffer or NULL on failure.
+    \warning Sending the buffer in a BLOB with IDSetBLOB() replaces its content with zeros, see IDSharedBlobSend().
+ */
+extern void *IDSharedBlobAlloc(size_t size);
+
+/** \brief Change the size of a buffer from IDSharedBlobAlloc(), keeping its content.
+    \param ptr buffer to resize, or NULL to allocate a new one.
+    \param size new size in bytes.
+    \return pointer to the resized buffer or NULL on failure, in which case ptr is left untouched.
+ */
+extern void *IDSharedBlobRealloc(void *ptr, size_t size);
+
+/** \brief Free a buffer from IDSharedBlobAlloc().
+    \param ptr buffer to free, may be NULL.
+ */
+extern void IDSharedBlobFree(void *ptr);
+
+/** \brief Hand the segment of a shared BLOB buffer to indiserver.
+    \param ptr buffer from IDSharedBlobAlloc().
+    \return 0 if the segment was sent, else -1 if ptr is not a shared buffer or there is no indiserver
+    to send it to. The buffer is then unchanged, and IDSetBLOB() encodes it as usual.
+    \warning On success the memory at ptr is swapped: the sent segment goes to indiserver unchanged, and ptr
+    stays valid at the same address but now maps a new segment of the same size filled with zeros. Whatever
+    the driver wrote there before is gone from its point of view, so a frame that must be sent or saved again
+    has to be kept elsewhere, and saved to disk before IDSetBLOB() is called.
+    \note This is used by IDSetBLOB(), drivers do not need to call it. The environment variable INDIBLOBFD,
+    set by indiserver, names the socket the segments go to; it is read at the first call.
+ */
+extern int IDSharedBlobSend(const void *ptr);
+
+/*@}*/
+
+#ifdef __cplusplus
+}
+#endif
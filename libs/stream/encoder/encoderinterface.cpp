@@ -30,6 +30,8 @@
 #include "indiccd.h"
 #include "indidetector.h"
 
+#include <algorithm>
+
 namespace INDI
 {
 
@@ -50,6 +52,24 @@ bool EncoderInterface::setSize(uint16_t width, uint16_t height)
     return true;
 }
 
+bool EncoderInterface::setTargetSize(uint16_t maxWidth, uint16_t maxHeight)
+{
+    targetWidth  = maxWidth;
+    targetHeight = maxHeight;
+    return true;
+}
+
+bool EncoderInterface::setQuality(uint8_t quality)
+{
+    this->quality = std::max<uint8_t>(1, std::min<uint8_t>(quality, 100));
+    return true;
+}
+
+double EncoderInterface::getEncodeTime() const
+{
+    return encodeTime;
+}
+
 bool EncoderInterface::setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth)
 {
     this->pixelFormat = pixelFormat;
@@ -28,6 +28,7 @@
 #include <cstdlib>
 #include <stdint.h>
 
+#include <atomic>
 #include <vector>
 
 namespace INDI
@@ -52,6 +53,24 @@ class EncoderInterface
 
     virtual bool setSize(uint16_t width, uint16_t height);
 
+    /**
+     * @brief Set the largest size of the encoded frames, encoders that scale frames down honor it
+     * @param maxWidth, maxHeight size in pixels, 0 for no limit
+     */
+    virtual bool setTargetSize(uint16_t maxWidth, uint16_t maxHeight);
+
+    /**
+     * @brief Set the quality of lossy encoders
+     * @param quality from 1 to 100
+     */
+    virtual bool setQuality(uint8_t quality);
+
+    /**
+     * @brief Time spent in the last upload() encoding the frame
+     * @return time in seconds
+     */
+    double getEncodeTime() const;
+
     virtual bool upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool isCompressed=false) = 0;
 
     const char *getName();
@@ -62,6 +81,11 @@ class EncoderInterface
     INDI_PIXEL_FORMAT pixelFormat;            // INDI Pixel Format
     uint8_t pixelDepth = 8;                   // Bits per Pixels
     uint16_t rawWidth, rawHeight;
+    // Set from the device thread, read by upload() on the preview thread.
+    // These change the size of the class, encoders built outside the tree must be rebuilt.
+    std::atomic<uint16_t> targetWidth { 0 }, targetHeight { 0 };
+    std::atomic<uint8_t> quality { 85 };
+    std::atomic<double> encodeTime { 0 };
 };
 
 }
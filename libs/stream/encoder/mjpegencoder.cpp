@@ -22,41 +22,101 @@
 #include "mjpegencoder.h"
 #include "stream/streammanager.h"
 #include "indiccd.h"
-#include <cmath>
-#include <zlib.h>
+#include "indielapsedtimer.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
 #include <jpeglib.h>
 #include <jerror.h>
 
+namespace INDI
+{
+
+// Rows handed to libjpeg per call
+static const uint32_t MJPEG_ROWS_PER_WRITE = 16;
+
+struct MJPEGError
+{
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+// Writes to a buffer that grows as needed and is kept across frames
+struct MJPEGDestination
+{
+    jpeg_destination_mgr pub;
+    std::vector<uint8_t> *buffer;
+    size_t length;
+};
+
+struct MJPEGEncoder::Compressor
+{
+    jpeg_compress_struct cinfo;
+    MJPEGError error;
+    MJPEGDestination destination;
+
+    // Parameters of the last frame, they are kept by libjpeg between frames
+    uint32_t width = 0, height = 0, components = 0;
+    int quality = -1;
+};
+
+static void error_exit(j_common_ptr cinfo)
+{
+    auto error = reinterpret_cast<MJPEGError *>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, error->message);
+    longjmp(error->jump, 1);
+}
+
 static void init_destination(j_compress_ptr cinfo)
 {
-    INDI_UNUSED(cinfo);
-    /* No work necessary here */
+    auto destination = reinterpret_cast<MJPEGDestination *>(cinfo->dest);
+    if (destination->buffer->empty())
+        destination->buffer->resize(64 * 1024);
+    destination->pub.next_output_byte = destination->buffer->data();
+    destination->pub.free_in_buffer = destination->buffer->size();
 }
 
 static boolean empty_output_buffer(j_compress_ptr cinfo)
 {
-    INDI_UNUSED(cinfo);
-    /* No work necessary here */
+    auto destination = reinterpret_cast<MJPEGDestination *>(cinfo->dest);
+    size_t used = destination->buffer->size();
+    destination->buffer->resize(used * 2);
+    destination->pub.next_output_byte = destination->buffer->data() + used;
+    destination->pub.free_in_buffer = destination->buffer->size() - used;
     return TRUE;
 }
 
 static void term_destination(j_compress_ptr cinfo)
 {
-    INDI_UNUSED(cinfo);
-    /* no work necessary here */
+    auto destination = reinterpret_cast<MJPEGDestination *>(cinfo->dest);
+    destination->length = destination->buffer->size() - destination->pub.free_in_buffer;
 }
 
-namespace INDI
-{
-
 MJPEGEncoder::MJPEGEncoder()
+    : compressor(new Compressor)
 {
     name = "MJPEG";
+
+    jpeg_compress_struct &cinfo = compressor->cinfo;
+    cinfo.err = jpeg_std_error(&compressor->error.pub);
+    compressor->error.pub.error_exit = error_exit;
+    compressor->error.message[0] = '\0';
+    jpeg_create_compress(&cinfo);
+
+    MJPEGDestination &destination = compressor->destination;
+    destination.pub.init_destination = init_destination;
+    destination.pub.empty_output_buffer = empty_output_buffer;
+    destination.pub.term_destination = term_destination;
+    destination.buffer = &jpegBuffer;
+    destination.length = 0;
+    cinfo.dest = &destination.pub;
 }
 
 MJPEGEncoder::~MJPEGEncoder()
 {
-    delete [] jpegBuffer;
+    jpeg_destroy_compress(&compressor->cinfo);
 }
 
 const char *MJPEGEncoder::getDeviceName()
@@ -73,134 +133,83 @@ bool MJPEGEncoder::upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, boo
         return false;
     }
 
-    INDI_UNUSED(nbytes);
-    int bufsize = rawWidth * rawHeight * ((pixelFormat == INDI_RGB) ? 3 : 1);
-    if (bufsize != jpegBufferSize)
+    uint32_t components = (pixelFormat == INDI_RGB) ? 3 : 1;
+    uint32_t width = rawWidth, height = rawHeight;
+    if (nbytes < width * height * components)
     {
-        delete [] jpegBuffer;
-        jpegBuffer = new uint8_t[bufsize];
-        jpegBufferSize = bufsize;
+        LOGF_ERROR("MJPEG frame is %u bytes, expected %u.", nbytes, width * height * components);
+        return false;
     }
 
-    // Scale image DOWN by this factor
-    // 640 is now selected arbitrary to test mpeg streaming performance
-    int scale = std::max(1, static_cast<int>(std::floor(rawWidth / SCALE_WIDTH)));
-    if (pixelFormat == INDI_RGB)
-        jpeg_compress_8u_rgb(buffer, rawWidth, rawHeight, rawWidth * 3, scale, jpegBuffer, &bufsize, 85);
-    else
-        jpeg_compress_8u_gray(buffer, rawWidth, rawHeight, rawWidth, scale, jpegBuffer, &bufsize, 85);
-
-    bp->blob    = jpegBuffer;
-    bp->bloblen = bufsize;
-    bp->size    = bufsize;
-    strcpy(bp->format, ".stream_jpg");
-
-    return true;
-}
+    INDI::ElapsedTimer elapsed;
 
-/*
-FROM: https://svn.csail.mit.edu/rrg_pods/jpeg-utils/
+    // Scale down to the target size first, the JPEG encoder then works on far fewer pixels
+    const uint8_t *frame = buffer;
+    uint32_t factor = PreviewScaler::factor(width, height, targetWidth, targetHeight);
+    if (factor > 1)
+    {
+        scaledFrame.resize(static_cast<size_t>(width / factor) * (height / factor) * components);
+        scaler.scale(buffer, width, height, components, factor, scaledFrame.data());
+        frame = scaledFrame.data();
+        width /= factor;
+        height /= factor;
+    }
 
-Name:         jpeg-utils
-Maintainers:  Albert Huang <albert@csail.mit.edu>
-Summary:      Wrapper functions around libjpeg to simplify JPEG compression and
-              decompression with in-memory buffers.
-Description:
-  note: This is a simple enough library that you could just copy the .c
-  and .h files in to your own programs.
+    if (compress(frame, width, height, components, quality) == false)
+    {
+        LOGF_ERROR("JPEG compression failed: %s", compressor->error.message);
+        return false;
+    }
 
-  To use the library, link against -ljpeg-utils, or use
-  pkg-config --cflags --libs jpeg-utils
+    encodeTime = elapsed.nsecsElapsed() / 1e9;
 
-Requirements:
-  libjpeg62
+    bp->blob    = jpegBuffer.data();
+    bp->bloblen = compressor->destination.length;
+    bp->size    = compressor->destination.length;
+    strcpy(bp->format, ".stream_jpg");
 
-  For faster performance, install libjpeg-turbo, an SSE-accelerated
-  library that is ABI compatible with libjpeg62.
-*/
+    return true;
+}
 
-int MJPEGEncoder::jpeg_compress_8u_gray (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale,
-        uint8_t * dest,
-        int * destsize, int quality)
+bool MJPEGEncoder::compress(const uint8_t *src, uint32_t width, uint32_t height, uint32_t components, int quality)
 {
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    struct jpeg_destination_mgr jdest;
-    int out_size = *destsize;
-
-    cinfo.err = jpeg_std_error (&jerr);
-    jpeg_create_compress (&cinfo);
-    jdest.next_output_byte = dest;
-    jdest.free_in_buffer = out_size;
-    jdest.init_destination = init_destination;
-    jdest.empty_output_buffer = empty_output_buffer;
-    jdest.term_destination = term_destination;
-    cinfo.dest = &jdest;
-
-    cinfo.image_width = width;
-    cinfo.image_height = height;
-#if JPEG_LIB_VERSION >= 70
-    cinfo.scale_denom = scale;
-#else
-    INDI_UNUSED(scale);
-#endif
-    cinfo.input_components = 1;
-    cinfo.in_color_space = JCS_GRAYSCALE;
-    jpeg_set_defaults (&cinfo);
-    jpeg_set_quality (&cinfo, quality, TRUE);
-
-    jpeg_start_compress (&cinfo, TRUE);
-    while (cinfo.next_scanline < height)
+    jpeg_compress_struct &cinfo = compressor->cinfo;
+
+    if (setjmp(compressor->error.jump))
     {
-        JSAMPROW row = (JSAMPROW)(src + cinfo.next_scanline * stride);
-        jpeg_write_scanlines (&cinfo, &row, 1);
+        // Keeps the compressor for the next frame, with its parameters set again
+        jpeg_abort_compress(&cinfo);
+        compressor->quality = -1;
+        return false;
     }
 
-    jpeg_finish_compress (&cinfo);
-    *destsize = out_size - jdest.free_in_buffer;
-    jpeg_destroy_compress (&cinfo);
-    return 0;
-}
+    if (width != compressor->width || height != compressor->height || components != compressor->components
+            || quality != compressor->quality)
+    {
+        cinfo.image_width = width;
+        cinfo.image_height = height;
+        cinfo.input_components = components;
+        cinfo.in_color_space = (components == 3) ? JCS_RGB : JCS_GRAYSCALE;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, quality, TRUE);
+
+        compressor->width = width;
+        compressor->height = height;
+        compressor->components = components;
+        compressor->quality = quality;
+    }
 
-int MJPEGEncoder::jpeg_compress_8u_rgb (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale,
-                                        uint8_t * dest, int * destsize, int quality)
-{
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    struct jpeg_destination_mgr jdest;
-    int out_size = *destsize;
-
-    cinfo.err = jpeg_std_error (&jerr);
-    jpeg_create_compress (&cinfo);
-    jdest.next_output_byte = dest;
-    jdest.free_in_buffer = out_size;
-    jdest.init_destination = init_destination;
-    jdest.empty_output_buffer = empty_output_buffer;
-    jdest.term_destination = term_destination;
-    cinfo.dest = &jdest;
-
-    cinfo.image_width = width;
-    cinfo.image_height = height;
-#if JPEG_LIB_VERSION >= 70
-    cinfo.scale_denom = scale;
-#else
-    INDI_UNUSED(scale);
-#endif
-    cinfo.input_components = 3;
-    cinfo.in_color_space = JCS_RGB;
-    jpeg_set_defaults (&cinfo);
-    jpeg_set_quality (&cinfo, quality, TRUE);
-
-    jpeg_start_compress (&cinfo, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    JSAMPROW rows[MJPEG_ROWS_PER_WRITE];
     while (cinfo.next_scanline < height)
     {
-        JSAMPROW row = (JSAMPROW)(src + cinfo.next_scanline * stride);
-        jpeg_write_scanlines (&cinfo, &row, 1);
+        uint32_t count = std::min(MJPEG_ROWS_PER_WRITE, height - cinfo.next_scanline);
+        for (uint32_t i = 0; i < count; i++)
+            rows[i] = const_cast<JSAMPROW>(src + static_cast<size_t>(cinfo.next_scanline + i) * width * components);
+        jpeg_write_scanlines(&cinfo, rows, count);
     }
-    jpeg_finish_compress (&cinfo);
-    *destsize = out_size - jdest.free_in_buffer;
-    jpeg_destroy_compress (&cinfo);
-    return 0;
+    jpeg_finish_compress(&cinfo);
+    return true;
 }
 
 }
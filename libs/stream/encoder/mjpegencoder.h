@@ -22,6 +22,10 @@
 #pragma once
 
 #include "encoderinterface.h"
+#include "previewscaler.h"
+
+#include <memory>
+#include <vector>
 
 namespace INDI
 {
@@ -29,7 +33,8 @@ namespace INDI
 /**
  * @brief The MJPEGEncoder class encodes frames in JPEG format before transmitting them to the client.
  *
- * The quality is now hard-coded at 70 when encoding the JPEG image. Further compression is not supported.
+ * Frames are scaled down by area averaging to fit the target size, then compressed at the set quality.
+ * The compressor, the scaled frame and the JPEG buffer are kept across frames.
  */
 class MJPEGEncoder : public EncoderInterface
 {
@@ -41,15 +46,13 @@ class MJPEGEncoder : public EncoderInterface
 
     private:
         const char *getDeviceName();
-        int jpeg_compress_8u_gray (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale, uint8_t * dest,
-                                   int * destsize, int quality);
-        int jpeg_compress_8u_rgb (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale, uint8_t * dest,
-                                  int * destsize, int quality);
-        uint8_t *jpegBuffer = nullptr;
-        uint16_t jpegBufferSize = 1;
-
-        static const int SCALE_WIDTH = 640;
+        bool compress(const uint8_t *src, uint32_t width, uint32_t height, uint32_t components, int quality);
 
+        struct Compressor;
+        std::unique_ptr<Compressor> compressor;
+        PreviewScaler scaler;
+        std::vector<uint8_t> scaledFrame;
+        std::vector<uint8_t> jpegBuffer;
 };
 
 }
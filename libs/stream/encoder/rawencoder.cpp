@@ -22,6 +22,8 @@
 #include "rawencoder.h"
 #include "stream/streammanager.h"
 #include "indiccd.h"
+#include "indiblockcompress.h"
+#include "indielapsedtimer.h"
 
 #include <zlib.h>
 
@@ -48,10 +50,13 @@ bool RawEncoder::upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool
     if (isCompressed)
     {
         // Compress frame
-        compressedFrame.resize(nbytes + nbytes / 64 + 16 + 3);
-        uLongf compressedBytes = compressedFrame.size();
+        INDI::ElapsedTimer elapsed;
+        compressedFrame.resize(blockCompressBound(nbytes));
+        size_t compressedBytes = compressedFrame.size();
 
-        int ret = compress2(compressedFrame.data(), &compressedBytes, buffer, nbytes, 4);
+        INDI::CCD *ccd = dynamic_cast<INDI::CCD *>(currentDevice);
+        int level = ccd ? ccd->getCompressionLevel() : 4;
+        int ret = blockCompress(compressedFrame.data(), &compressedBytes, buffer, nbytes, level);
         if (ret != Z_OK)
         {
             // this should NEVER happen
@@ -59,6 +64,8 @@ bool RawEncoder::upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool
             return false;
         }
 
+        encodeTime = elapsed.nsecsElapsed() / 1e9;
+
         // Send it compressed
         bp->blob    = compressedFrame.data();
         bp->bloblen = compressedBytes;
@@ -68,6 +75,7 @@ bool RawEncoder::upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool
     else
     {
         // Send it uncompressed
+        encodeTime = 0;
         bp->blob    = (const_cast<uint8_t *>(buffer));
         bp->bloblen = nbytes;
         bp->size    = nbytes;
@@ -0,0 +1,108 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+    Frame Buffer Pool
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#include "framepool.h"
+
+namespace INDI
+{
+
+FramePool::FramePool(size_t limit)
+    : mState(std::make_shared<State>())
+{
+    mState->limit = limit;
+}
+
+void FramePool::State::trim()
+{
+    while (allocated > limit && !free.empty())
+    {
+        allocated -= free.back()->capacity();
+        free.pop_back();
+    }
+}
+
+FramePool::Buffer FramePool::acquire(size_t size)
+{
+    std::unique_ptr<std::vector<uint8_t>> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        auto &free = mState->free;
+
+        // Smallest free buffer big enough, subframes and downscaled frames share the pool with full frames
+        auto best = free.end();
+        for (auto it = free.begin(); it != free.end(); ++it)
+            if ((*it)->capacity() >= size && (best == free.end() || (*it)->capacity() < (*best)->capacity()))
+                best = it;
+
+        if (best != free.end())
+        {
+            buffer = std::move(*best);
+            free.erase(best);
+        }
+        else
+        {
+            // Make room from buffers too small to be used
+            while (mState->allocated + size > mState->limit && !free.empty())
+            {
+                mState->allocated -= free.back()->capacity();
+                free.pop_back();
+            }
+            if (mState->allocated + size > mState->limit)
+                return nullptr;
+            mState->allocated += size;
+        }
+    }
+
+    if (!buffer)
+        buffer.reset(new std::vector<uint8_t>(size));
+    else
+        buffer->resize(size);
+
+    std::shared_ptr<State> state = mState;
+    return Buffer(buffer.release(), [state](std::vector<uint8_t> *released)
+    {
+        std::unique_ptr<std::vector<uint8_t>> recycled(released);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->free.push_back(std::move(recycled));
+        state->trim();
+    });
+}
+
+void FramePool::setLimit(size_t limit)
+{
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    mState->limit = limit;
+    mState->trim();
+}
+
+void FramePool::clear()
+{
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    for (auto &buffer : mState->free)
+        mState->allocated -= buffer->capacity();
+    mState->free.clear();
+}
+
+size_t FramePool::allocated() const
+{
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    return mState->allocated;
+}
+
+}
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+    Frame Buffer Pool
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * \class FramePool
+ * \brief The FramePool class recycles frame buffers of a video stream.
+ *
+ * Buffers are handed out as shared handles and go back to the pool when the last handle is released, from
+ * any thread. A stream of same sized frames therefore settles on a few buffers that are reused forever,
+ * with no allocation or initialization per frame. The memory held by the pool, in use or not, never goes
+ * over the limit: acquire() fails instead and the frame should be dropped.
+ */
+class FramePool
+{
+public:
+    /// Shared handle to a frame buffer, the buffer is recycled when the last handle is released
+    typedef std::shared_ptr<std::vector<uint8_t>> Buffer;
+
+    explicit FramePool(size_t limit = SIZE_MAX);
+
+public:
+    /**
+     * @brief Get a buffer of the given size, its content is undefined
+     * @param size size of the buffer in bytes
+     * @return buffer, or nullptr if it would take the pool over its limit
+     */
+    Buffer acquire(size_t size);
+
+    /**
+     * @brief Set the most memory the pool may hold
+     * @param limit limit in bytes, free buffers over it are released
+     */
+    void setLimit(size_t limit);
+
+    /**
+     * @brief Release the free buffers, buffers in use go back to the pool as usual
+     */
+    void clear();
+
+    /**
+     * @brief Memory held by the pool
+     * @return size in bytes of all buffers, in use or free
+     */
+    size_t allocated() const;
+
+private:
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<std::vector<uint8_t>>> free;
+        size_t allocated = 0;
+        size_t limit = SIZE_MAX;
+
+        void trim();
+    };
+
+    std::shared_ptr<State> mState;
+};
+
+}
@@ -26,6 +26,9 @@
 #include <cstdint>
 #include <cstddef>
 
+/**
+ * @brief The GammaLut16 class maps 16 bit values to 8 bit through a gamma curve, with a 64K entry lookup table.
+ */
 class GammaLut16
 {
 public:
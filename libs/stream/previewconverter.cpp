@@ -0,0 +1,216 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+    Preview Converter
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#include "previewconverter.h"
+#include "gammalut16.h"
+#include "indicpufeatures.h"
+#include "indiparallel.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PREVIEW_X86
+#include <immintrin.h>
+#endif
+
+namespace INDI
+{
+
+// Below this many samples per part, handing it to another thread costs more than it saves
+static const size_t PREVIEW_SAMPLES_PER_PART = 1024 * 1024;
+// Samples taken for the auto stretch histogram, and its levels
+static const size_t PREVIEW_HISTOGRAM_SAMPLES = 65536;
+static const double PREVIEW_BLACK_LEVEL = 0.005;
+static const double PREVIEW_WHITE_LEVEL = 0.9995;
+
+PreviewConverter::Linear::Linear(uint16_t black, uint16_t white)
+    : black(black)
+    , range(std::max(white - black, 1))
+    , shift(0)
+{
+    while ((range << shift) < 32768)
+        shift++;
+    // Rounded up so the truncated result is exact when it is a whole number
+    uint32_t divisor = static_cast<uint32_t>(range) << shift;
+    scale = ((255u << 23) + divisor - 1) / divisor;
+}
+
+static inline uint8_t linearSample(const PreviewConverter::Linear &linear, uint16_t value)
+{
+    uint32_t x = value > linear.black ? value - linear.black : 0;
+    x = std::min<uint32_t>(x, linear.range) << linear.shift;
+    return std::min<uint32_t>(((x * linear.scale) >> 16) >> 7, 255);
+}
+
+#ifdef PREVIEW_X86
+
+// The kernels convert whole vectors only and return how many samples they did, linearSample() does the rest
+// min(x, range) is x - saturate(x - range), SSE2 has no unsigned 16 bit min
+
+__attribute__((target("sse2")))
+static inline __m128i linearSSE2(__m128i x, __m128i black, __m128i range, __m128i shift, __m128i scale)
+{
+    x = _mm_subs_epu16(x, black);
+    x = _mm_sub_epi16(x, _mm_subs_epu16(x, range));
+    x = _mm_sll_epi16(x, shift);
+    return _mm_srli_epi16(_mm_mulhi_epu16(x, scale), 7);
+}
+
+__attribute__((target("sse2")))
+static size_t applyLinearSSE2(const PreviewConverter::Linear &linear, const uint16_t *source, size_t count,
+                              uint8_t *destination)
+{
+    const __m128i black = _mm_set1_epi16(static_cast<short>(linear.black));
+    const __m128i range = _mm_set1_epi16(static_cast<short>(linear.range));
+    const __m128i scale = _mm_set1_epi16(static_cast<short>(linear.scale));
+    const __m128i shift = _mm_cvtsi32_si128(linear.shift);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i lo = linearSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i)), black, range, shift, scale);
+        __m128i hi = linearSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i + 8)), black, range, shift,
+                                scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_packus_epi16(lo, hi));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i linearAVX2(__m256i x, __m256i black, __m256i range, __m128i shift, __m256i scale)
+{
+    x = _mm256_min_epu16(_mm256_subs_epu16(x, black), range);
+    x = _mm256_sll_epi16(x, shift);
+    return _mm256_srli_epi16(_mm256_mulhi_epu16(x, scale), 7);
+}
+
+__attribute__((target("avx2")))
+static size_t applyLinearAVX2(const PreviewConverter::Linear &linear, const uint16_t *source, size_t count,
+                              uint8_t *destination)
+{
+    const __m256i black = _mm256_set1_epi16(static_cast<short>(linear.black));
+    const __m256i range = _mm256_set1_epi16(static_cast<short>(linear.range));
+    const __m256i scale = _mm256_set1_epi16(static_cast<short>(linear.scale));
+    const __m128i shift = _mm_cvtsi32_si128(linear.shift);
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i lo = linearAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i)), black, range, shift,
+                                scale);
+        __m256i hi = linearAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i + 16)), black, range,
+                                shift, scale);
+        // packus works within 128 bit lanes, put the quarters back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), packed);
+    }
+    return i;
+}
+
+#endif
+
+void PreviewConverter::applyLinear(const Linear &linear, const uint16_t *source, size_t count, uint8_t *destination)
+{
+    size_t i = 0;
+#ifdef PREVIEW_X86
+    i = cpuHasAVX2() ? applyLinearAVX2(linear, source, count, destination)
+        : applyLinearSSE2(linear, source, count, destination);
+#endif
+    for (; i < count; i++)
+        destination[i] = linearSample(linear, source[i]);
+}
+
+PreviewConverter::Linear PreviewConverter::autoStretch(const uint16_t *source, size_t count)
+{
+    // 4096 bins of 16 values
+    std::vector<uint32_t> histogram(4096, 0);
+    size_t step = std::max<size_t>(1, count / PREVIEW_HISTOGRAM_SAMPLES);
+    size_t samples = 0;
+    for (size_t i = 0; i < count; i += step, samples++)
+        histogram[source[i] >> 4]++;
+
+    size_t blackCount = samples * PREVIEW_BLACK_LEVEL;
+    size_t whiteCount = samples * PREVIEW_WHITE_LEVEL;
+    size_t sum = 0;
+    int black = -1, white = 4095;
+    for (int bin = 0; bin < 4096; bin++)
+    {
+        sum += histogram[bin];
+        if (black < 0 && sum > blackCount)
+            black = bin;
+        if (sum > whiteCount)
+        {
+            white = bin;
+            break;
+        }
+    }
+
+    return Linear(std::max(black, 0) << 4, (white << 4) + 15);
+}
+
+PreviewConverter::PreviewConverter()
+    : mGammaTable(65536)
+{
+    std::vector<uint16_t> values(65536);
+    std::iota(values.begin(), values.end(), 0);
+    GammaLut16().apply(values.data(), values.size(), mGammaTable.data());
+}
+
+void PreviewConverter::setMode(Mode mode)
+{
+    mMode = mode;
+}
+
+PreviewConverter::Mode PreviewConverter::getMode() const
+{
+    return mMode;
+}
+
+void PreviewConverter::convert(const uint16_t *source, size_t count, uint8_t depth, uint8_t *destination)
+{
+    Mode mode = mMode;
+    Linear linear(0, depth >= 16 ? 65535 : (1 << depth) - 1);
+    if (mode == PREVIEW_AUTO_STRETCH)
+        linear = autoStretch(source, count);
+
+    const size_t parts = parallelParts(count, PREVIEW_SAMPLES_PER_PART);
+
+    // Parts start on multiples of 32 samples to keep the vector loops whole
+    auto bound = [&](size_t i)
+    {
+        return i == parts ? count : (count * i / parts) & ~size_t(31);
+    };
+
+    parallelFor(parts, [&](size_t i)
+    {
+        size_t first = bound(i), last = bound(i + 1);
+        if (mode == PREVIEW_GAMMA)
+        {
+            const uint8_t *table = mGammaTable.data();
+            for (size_t j = first; j < last; j++)
+                destination[j] = table[source[j]];
+        }
+        else
+            applyLinear(linear, source + first, last - first, destination + first);
+    });
+}
+
+}
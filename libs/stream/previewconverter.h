@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+    Preview Converter
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The PreviewConverter class converts deep frames to 8 bit for the preview stream.
+ *
+ * It works on samples, so mono and RGB frames are handled alike. Large frames are split across CPU cores.
+ */
+class PreviewConverter
+{
+public:
+    typedef enum
+    {
+        /// sRGB like gamma curve over the whole 16 bit range
+        PREVIEW_GAMMA,
+        /// Linear over the pixel depth, like dropping the low bits
+        PREVIEW_LINEAR,
+        /// Linear between black and white levels found in a sample of each frame
+        PREVIEW_AUTO_STRETCH
+    } Mode;
+
+public:
+    PreviewConverter();
+
+public:
+    void setMode(Mode mode);
+    Mode getMode() const;
+
+    /**
+     * @brief Convert 16 bit samples to 8 bit
+     * @param source samples, count of them
+     * @param count number of samples, pixels times components
+     * @param depth significant bits of the samples, from the low bit
+     * @param destination 8 bit samples, count of them
+     */
+    void convert(const uint16_t *source, size_t count, uint8_t depth, uint8_t *destination);
+
+public:
+    /**
+     * @brief Parameters of the linear conversion, out = min(max(in - black, 0), range) * 255 / range
+     */
+    struct Linear
+    {
+        uint16_t black;
+        uint16_t range;
+        // range << shift is in [32768, 65535], out = ((in' << shift) * scale) >> 23 with in' clamped
+        uint8_t shift;
+        uint16_t scale;
+
+        Linear(uint16_t black, uint16_t white);
+    };
+
+    /**
+     * @brief Linear conversion, vectorized where the CPU allows it
+     */
+    static void applyLinear(const Linear &linear, const uint16_t *source, size_t count, uint8_t *destination);
+
+    /**
+     * @brief Black and white levels from a histogram of a sample of the frame
+     */
+    static Linear autoStretch(const uint16_t *source, size_t count);
+
+private:
+    std::atomic<Mode> mMode { PREVIEW_GAMMA };
+    /// GammaLut16 with 8 bit entries, half its size
+    std::vector<uint8_t> mGammaTable;
+};
+
+}
@@ -0,0 +1,130 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+    Preview Scaler
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#include "previewscaler.h"
+#include "indicpufeatures.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCALER_X86
+#include <immintrin.h>
+#endif
+
+namespace INDI
+{
+
+// 255 rows of 255 fit the 16 bit row sums
+static const uint32_t SCALER_MAX_FACTOR = 255;
+
+uint32_t PreviewScaler::factor(uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight)
+{
+    uint32_t factor = 1;
+    if (maxWidth > 0)
+        factor = std::max(factor, (width + maxWidth - 1) / maxWidth);
+    if (maxHeight > 0)
+        factor = std::max(factor, (height + maxHeight - 1) / maxHeight);
+    return std::max<uint32_t>(1, std::min({factor, SCALER_MAX_FACTOR, width, height}));
+}
+
+#ifdef SCALER_X86
+
+// The kernels add whole vectors only and return how many samples they did, the caller does the rest
+
+__attribute__((target("sse2")))
+static size_t addRowSSE2(uint16_t *sum, const uint8_t *row, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i *lo = reinterpret_cast<__m128i *>(sum + i);
+        __m128i *hi = reinterpret_cast<__m128i *>(sum + i + 8);
+        _mm_storeu_si128(lo, _mm_add_epi16(_mm_loadu_si128(lo), _mm_unpacklo_epi8(v, zero)));
+        _mm_storeu_si128(hi, _mm_add_epi16(_mm_loadu_si128(hi), _mm_unpackhi_epi8(v, zero)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t addRowAVX2(uint16_t *sum, const uint8_t *row, size_t count)
+{
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        __m256i *lo = reinterpret_cast<__m256i *>(sum + i);
+        __m256i *hi = reinterpret_cast<__m256i *>(sum + i + 16);
+        _mm256_storeu_si256(lo, _mm256_add_epi16(_mm256_loadu_si256(lo), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v))));
+        _mm256_storeu_si256(hi, _mm256_add_epi16(_mm256_loadu_si256(hi), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1))));
+    }
+    return i;
+}
+
+#endif
+
+static void addRow(uint16_t *sum, const uint8_t *row, size_t count)
+{
+    size_t i = 0;
+#ifdef SCALER_X86
+    i = cpuHasAVX2() ? addRowAVX2(sum, row, count) : addRowSSE2(sum, row, count);
+#endif
+    for (; i < count; i++)
+        sum[i] += row[i];
+}
+
+void PreviewScaler::scale(const uint8_t *source, uint32_t width, uint32_t height, uint32_t components,
+                          uint32_t factor, uint8_t *destination)
+{
+    const size_t stride = static_cast<size_t>(width) * components;
+    const uint32_t outWidth = width / factor, outHeight = height / factor;
+
+    if (factor == 1)
+    {
+        memcpy(destination, source, stride * height);
+        return;
+    }
+
+    const uint32_t area = factor * factor;
+    mRowSum.resize(stride);
+
+    for (uint32_t oy = 0; oy < outHeight; oy++)
+    {
+        // Sum the rows of the block with the vector kernels, this is where every input sample is read
+        std::fill(mRowSum.begin(), mRowSum.end(), 0);
+        for (uint32_t k = 0; k < factor; k++)
+            addRow(mRowSum.data(), source + (static_cast<size_t>(oy) * factor + k) * stride, stride);
+
+        // Then the columns, factor times fewer samples
+        const uint16_t *sum = mRowSum.data();
+        uint8_t *out = destination + static_cast<size_t>(oy) * outWidth * components;
+        for (uint32_t ox = 0; ox < outWidth; ox++)
+            for (uint32_t c = 0; c < components; c++)
+            {
+                uint32_t total = 0;
+                for (uint32_t k = 0; k < factor; k++)
+                    total += sum[(static_cast<size_t>(ox) * factor + k) * components + c];
+                *out++ = static_cast<uint8_t>((total + area / 2) / area);
+            }
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+/*
+    Copyright (C) 2026 INDI Library Contributors
+    Preview Scaler
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The PreviewScaler class shrinks 8 bit frames for the preview stream.
+ *
+ * Each output pixel is the mean of a factor by factor block of input pixels, components kept apart, so the
+ * preview is free of the aliasing of plain decimation. It runs on the calling thread only: the preview must
+ * not compete for cores with the recording. Its row buffer is kept across frames.
+ */
+class PreviewScaler
+{
+public:
+    /**
+     * @brief Smallest factor that fits a frame in the target size
+     * @param width, height frame size in pixels
+     * @param maxWidth, maxHeight target size in pixels, 0 for no limit
+     * @return factor in [1, 255], 1 keeps the frame as is
+     */
+    static uint32_t factor(uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight);
+
+    /**
+     * @brief Shrink a frame, pixels left over at the right and bottom edges are dropped
+     * @param source frame of width by height pixels of components samples each
+     * @param width, height frame size in pixels
+     * @param components samples per pixel, 1 for mono or 3 for RGB
+     * @param factor shrink factor in [1, 255]
+     * @param destination width / factor by height / factor pixels
+     */
+    void scale(const uint8_t *source, uint32_t width, uint32_t height, uint32_t components, uint32_t factor,
+               uint8_t *destination);
+
+private:
+    std::vector<uint16_t> mRowSum;
+};
+
+}
@@ -75,6 +75,11 @@ class RecorderInterface
     // and no need to do any further subframing operations. Otherwise, subframing must be done.
     // This is to reduce process time and save memory for a dedicated subframe buffer
     virtual void setStreamEnabled(bool enable) = 0;
+    // Number of frames the record is expected to have, 0 if unknown. Recorders may reserve disk space for them.
+    virtual void setExpectedFrames(uint64_t frames) { (void)frames; }
+    // Frames given to writeFrame() but not recorded because the disk could not keep up. writeFrame() returns true
+    // for them, they are not failures, and they do not count toward the frames of the record
+    virtual uint64_t getDroppedFrames() const { return 0; }
 
   protected:
     const char *name;
@@ -28,14 +28,25 @@
 #include "serrecorder.h"
 #include "jpegutils.h"
 
+#include <algorithm>
+#include <chrono>
 #include <ctime>
 #include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 
 #define ERRMSGSIZ 1024
 
+#define SER_HEADER_SIZE 178
+// Alignment of the batches in memory and in the file, enough for direct I/O
+#define SER_BLOCK_SIZE  4096
+#define SER_BATCH_MIN   (8 * 1024 * 1024)
+// Seconds between header updates
+#define SER_HEADER_PERIOD 2
+
 namespace INDI
 {
 
@@ -53,13 +64,13 @@ SER_Recorder::SER_Recorder()
     // always default to. LITTLE_ENDIAN appears to be ignored by them leading to garbled data.
     serh.LittleEndian = SER_BIG_ENDIAN;
     isRecordingActive = false;
-    f = nullptr;
 
     jpegBuffer = static_cast<uint8_t*>(malloc(1));
 }
 
 SER_Recorder::~SER_Recorder()
 {
+    close();
     free(jpegBuffer);
 }
 
@@ -70,49 +81,37 @@ bool SER_Recorder::is_little_endian()
     return black_magic == 0x01;
 }
 
-void SER_Recorder::write_int_le(uint32_t *i)
+void SER_Recorder::write_int_le(uint8_t *&dst, uint32_t i)
 {
-    if (is_little_endian())
-        fwrite((i), sizeof(uint32_t), 1, f);
-    else
-    {
-        unsigned char *c = (unsigned char *)i;
-        fwrite((c + 3), sizeof(char), 1, f);
-        fwrite((c + 2), sizeof(char), 1, f);
-        fwrite((c + 1), sizeof(char), 1, f);
-        fwrite((c), sizeof(char), 1, f);
-    }
+    *dst++ = i;
+    *dst++ = i >> 8;
+    *dst++ = i >> 16;
+    *dst++ = i >> 24;
 }
 
-void SER_Recorder::write_long_int_le(uint64_t *i)
+void SER_Recorder::write_long_int_le(uint8_t *&dst, uint64_t i)
 {
-    if (is_little_endian())
-    {
-        fwrite(((uint32_t *)i), sizeof(int), 1, f);
-        fwrite(((uint32_t *)(i) + 1), sizeof(int), 1, f);
-    }
-    else
-    {
-        write_int_le((uint32_t *)(i) + 1);
-        write_int_le((uint32_t *)(i));
-    }
+    write_int_le(dst, i);
+    write_int_le(dst, i >> 32);
 }
 
-void SER_Recorder::write_header(ser_header *s)
+void SER_Recorder::write_header(const ser_header *s, uint8_t *dst)
 {
-    fwrite((s->FileID), sizeof(char), 14, f);
-    write_int_le(&(s->LuID));
-    write_int_le(&(s->ColorID));
-    write_int_le(&(s->LittleEndian));
-    write_int_le(&(s->ImageWidth));
-    write_int_le(&(s->ImageHeight));
-    write_int_le(&(s->PixelDepth));
-    write_int_le(&(s->FrameCount));
-    fwrite((s->Observer), sizeof(char), 40, f);
-    fwrite((s->Instrume), sizeof(char), 40, f);
-    fwrite((s->Telescope), sizeof(char), 40, f);
-    write_long_int_le(&(s->DateTime));
-    write_long_int_le(&(s->DateTime_UTC));
+    memcpy(dst, s->FileID, 14);
+    dst += 14;
+    write_int_le(dst, s->LuID);
+    write_int_le(dst, s->ColorID);
+    write_int_le(dst, s->LittleEndian);
+    write_int_le(dst, s->ImageWidth);
+    write_int_le(dst, s->ImageHeight);
+    write_int_le(dst, s->PixelDepth);
+    write_int_le(dst, s->FrameCount);
+    memcpy(dst, s->Observer, 40);
+    memcpy(dst + 40, s->Instrume, 40);
+    memcpy(dst + 80, s->Telescope, 40);
+    dst += 120;
+    write_long_int_le(dst, s->DateTime);
+    write_long_int_le(dst, s->DateTime_UTC);
 }
 
 bool SER_Recorder::setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth)
@@ -175,16 +174,70 @@ bool SER_Recorder::open(const char *filename, char *errmsg)
     if (isRecordingActive)
         return false;
     serh.FrameCount = 0;
-    if ((f = fopen(filename, "w")) == nullptr)
+
+    directIO = false;
+#ifdef O_DIRECT
+    fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    directIO = fd >= 0;
+    // Not all file systems support it
+    if (fd < 0 && errno == EINVAL)
+#endif
+        fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
         snprintf(errmsg, ERRMSGSIZ, "recorder open error %d, %s\n", errno, strerror(errno));
         return false;
     }
+#ifdef F_NOCACHE
+    fcntl(fd, F_NOCACHE, 1);
+#endif
+
+    frame_size        = serh.ImageWidth * serh.ImageHeight * (serh.PixelDepth <= 8 ? 1 : 2) * number_of_planes;
+
+#ifdef __linux__
+    // Reserve the space of the whole record so it is written contiguously, the file keeps its size
+    if (expectedFrames > 0)
+        fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, SER_HEADER_SIZE + expectedFrames * (frame_size + sizeof(uint64_t)));
+#endif
+
+    // Batches hold a few frames, or at least one frame
+    batchSize = std::max<size_t>(SER_BATCH_MIN, frame_size);
+    batchSize = (batchSize + SER_BLOCK_SIZE - 1) / SER_BLOCK_SIZE * SER_BLOCK_SIZE;
+    freeBatches.clear();
+    fullBatches.clear();
+    for (auto &batch : batches)
+    {
+        if (posix_memalign(reinterpret_cast<void **>(&batch.data), SER_BLOCK_SIZE, batchSize) != 0)
+        {
+            snprintf(errmsg, ERRMSGSIZ, "recorder open error, out of memory\n");
+            close();
+            return false;
+        }
+        freeBatches.push_back(&batch);
+    }
+    if (posix_memalign(reinterpret_cast<void **>(&firstBlock), SER_BLOCK_SIZE, SER_BLOCK_SIZE) != 0)
+    {
+        snprintf(errmsg, ERRMSGSIZ, "recorder open error, out of memory\n");
+        close();
+        return false;
+    }
+
+    fill = freeBatches.front();
+    freeBatches.pop_front();
+    fill->used   = SER_HEADER_SIZE;
+    fill->frames = 0;
 
     serh.DateTime     = getLocalTimeStamp();
     serh.DateTime_UTC = getUTCTimeStamp();
-    write_header(&serh);
-    frame_size        = serh.ImageWidth * serh.ImageHeight * (serh.PixelDepth <= 8 ? 1 : 2) * number_of_planes;
+    write_header(&serh, fill->data);
+
+    writeOffset  = 0;
+    framesOnDisk = 0;
+    writerQuit   = false;
+    writeFailed  = false;
+    droppedFrames = 0;
+    writer = std::thread(&SER_Recorder::writerThread, this);
+
     isRecordingActive = true;
 
     frameStamps.clear();
@@ -194,66 +247,180 @@ bool SER_Recorder::open(const char *filename, char *errmsg)
 
 bool SER_Recorder::close()
 {
-    if (f)
+    bool ok = true;
+
+    if (writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writerQuit = true;
+        }
+        writerWake.notify_one();
+        writer.join();
+    }
+
+    if (fd >= 0)
     {
+        ok = !writeFailed;
+
+        // The rest is not a whole number of blocks, write it through the cache
+#ifdef O_DIRECT
+        if (directIO)
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+#endif
+        directIO = false;
+
+        if (fill != nullptr)
+        {
+            ok = writeBlock(fill->data, fill->used, writeOffset) && ok;
+            writeOffset += fill->used;
+        }
+
         // Write all timestamps
+        std::vector<uint8_t> trailer(frameStamps.size() * sizeof(uint64_t));
+        uint8_t *dst = trailer.data();
         for (auto value : frameStamps)
-            write_long_int_le(&value);
+            write_long_int_le(dst, value);
+        ok = writeBlock(trailer.data(), trailer.size(), writeOffset) && ok;
+        writeOffset += trailer.size();
 
         frameStamps.clear();
 
-        fseek(f, 0L, SEEK_SET);
-        write_header(&serh);
-        fclose(f);
-        f = nullptr;
+        uint8_t header[SER_HEADER_SIZE];
+        write_header(&serh, header);
+        ok = writeBlock(header, sizeof(header), 0) && ok;
+
+        // Give back the space reserved and not used
+        if (ftruncate(fd, writeOffset) != 0)
+            ok = false;
+        if (::close(fd) != 0)
+            ok = false;
+        fd = -1;
+    }
+
+    for (auto &batch : batches)
+    {
+        free(batch.data);
+        batch.data = nullptr;
     }
+    free(firstBlock);
+    firstBlock = nullptr;
+    fill = nullptr;
 
     isRecordingActive = false;
+    return ok;
+}
+
+bool SER_Recorder::writeBlock(const uint8_t *data, size_t size, uint64_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t n = pwrite(fd, data, size, offset);
+        if (n < 0)
+        {
+#ifdef O_DIRECT
+            // Direct I/O accepted on open but not on write, carry on through the cache
+            if (errno == EINVAL && directIO)
+            {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+                directIO = false;
+                continue;
+            }
+#endif
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
     return true;
 }
 
-bool SER_Recorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
+void SER_Recorder::updateHeader()
 {
-    if (!isRecordingActive)
-        return false;
+    // Frames counted in the header must be on disk before it
+    fdatasync(fd);
 
-#if 0
-    if (serh.ColorID == SER_MONO)
     {
-        if (isStreamingActive == false &&
-                (offsetX > 0 || offsetY > 0 || serh.ImageWidth != rawWidth || serh.ImageHeight != rawHeight))
+        std::lock_guard<std::mutex> lock(writerMutex);
+        ser_header h = serh;
+        h.FrameCount = framesOnDisk;
+        write_header(&h, firstBlock);
+    }
+
+    if (!writeBlock(firstBlock, SER_BLOCK_SIZE, 0))
+        writeFailed = true;
+}
+
+void SER_Recorder::writerThread()
+{
+    auto lastHeader = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(writerMutex);
+
+    while (true)
+    {
+        writerWake.wait(lock, [this]()
         {
-            int offset = ((rawWidth * offsetY) + offsetX);
+            return writerQuit || !fullBatches.empty();
+        });
+        if (fullBatches.empty())
+            break;
+
+        Batch *batch = fullBatches.front();
+        lock.unlock();
 
-            uint8_t *srcBuffer  = frame + offset;
-            uint8_t *destBuffer = frame;
-            int imageWidth      = serh.ImageWidth;
-            int imageHeight     = serh.ImageHeight;
+        if (!writeBlock(batch->data, batchSize, writeOffset))
+            writeFailed = true;
+        if (writeOffset == 0)
+            memcpy(firstBlock, batch->data, SER_BLOCK_SIZE);
+        writeOffset += batchSize;
 
-            for (int i = 0; i < imageHeight; i++)
-                memcpy(destBuffer + i * imageWidth, srcBuffer + rawWidth * i, imageWidth);
+        lock.lock();
+        fullBatches.pop_front();
+        freeBatches.push_back(batch);
+        framesOnDisk = batch->frames;
+
+        if (std::chrono::steady_clock::now() - lastHeader >= std::chrono::seconds(SER_HEADER_PERIOD))
+        {
+            lock.unlock();
+            updateHeader();
+            lastHeader = std::chrono::steady_clock::now();
+            lock.lock();
         }
     }
-    else
-    {
-        if (isStreamingActive == false &&
-                (offsetX > 0 || offsetY > 0 || serh.ImageWidth != rawWidth || serh.ImageHeight != rawHeight))
-        {
-            int offset = ((rawWidth * offsetY) + offsetX);
+}
 
-            uint8_t *srcBuffer  = frame + offset * 3;
-            uint8_t *destBuffer = frame;
-            int imageWidth      = serh.ImageWidth;
-            int imageHeight     = serh.ImageHeight;
+void SER_Recorder::appendFrame(const uint8_t *frame, size_t nbytes)
+{
+    while (nbytes > 0)
+    {
+        size_t n = std::min(nbytes, batchSize - fill->used);
+        memcpy(fill->data + fill->used, frame, n);
+        fill->used += n;
+        frame += n;
+        nbytes -= n;
 
-            // RGB
-            for (int i = 0; i < imageHeight; i++)
-                memcpy(destBuffer + i * imageWidth * 3, srcBuffer + rawWidth * 3 * i, imageWidth * 3);
+        if (fill->used == batchSize)
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            // Frames whose last byte is in this batch or before
+            fill->frames = serh.FrameCount + (nbytes == 0 ? 1 : 0);
+            fullBatches.push_back(fill);
+            // writeFrame() made sure there is one
+            fill = freeBatches.front();
+            freeBatches.pop_front();
+            fill->used = 0;
+            writerWake.notify_one();
         }
     }
-#endif
+}
 
-    frameStamps.push_back(getUTCTimeStamp());
+bool SER_Recorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
+{
+    if (!isRecordingActive || writeFailed)
+        return false;
 
     // Not technically pixel format, but let's use this for now.
     if (m_PixelFormat == INDI_JPG)
@@ -263,13 +430,30 @@ bool SER_Recorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
         if (decode_jpeg_rgb(const_cast<uint8_t *>(frame), nbytes, &jpegBuffer, &memsize, &naxis, &w, &h) < 0)
             return false;
 
+        std::lock_guard<std::mutex> lock(writerMutex);
         serh.ImageWidth = w;
         serh.ImageHeight = h;
         serh.ColorID = (naxis == 3) ? SER_RGB : SER_MONO;
-        fwrite(jpegBuffer, 1, memsize, f);
+        frame  = jpegBuffer;
+        nbytes = memsize;
     }
-    else
-        fwrite(frame, 1, nbytes, f);
+
+    {
+        // Drop the frame if the disk is too far behind to take it. A frame filling the last batch needs yet
+        // another one to go on with, so it must fit with room to spare
+        std::lock_guard<std::mutex> lock(writerMutex);
+        if (batchSize - fill->used + freeBatches.size() * batchSize <= nbytes)
+        {
+            // Not a failure, the record goes on without it
+            droppedFrames++;
+            return true;
+        }
+    }
+
+    frameStamps.push_back(getUTCTimeStamp());
+    appendFrame(frame, nbytes);
+
+    std::lock_guard<std::mutex> lock(writerMutex);
     serh.FrameCount += 1;
     return true;
 }
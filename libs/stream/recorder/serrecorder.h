@@ -23,8 +23,13 @@
 
 #include "recorderinterface.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <mutex>
 #include <stdio.h>
+#include <thread>
 
 typedef struct ser_header
 {
@@ -66,6 +71,12 @@ namespace INDI
 
 /**
  * @brief The SER_Recorder class implements recording of video streams in SER format.
+ *
+ * Frames are appended to large aligned batches which a writer thread writes to disk, bypassing the page cache
+ * where the system allows it, so the stream thread never waits for the disk. If the disk falls behind and all
+ * batches are waiting to be written, frames are dropped and counted. The header is rewritten every few seconds
+ * with the number of frames safely on disk, so the file stays readable if recording is interrupted. Frame
+ * timestamps are appended when the file is closed.
  */
 class SER_Recorder : public RecorderInterface
 {
@@ -80,6 +91,8 @@ class SER_Recorder : public RecorderInterface
     virtual bool close();
     virtual bool writeFrame(const uint8_t *frame, uint32_t nbytes);
     virtual void setStreamEnabled(bool enable) { isStreamingActive = enable; }
+    virtual void setExpectedFrames(uint64_t frames) { expectedFrames = frames; }
+    virtual uint64_t getDroppedFrames() const { return droppedFrames; }
 
     // Public constants
     static const uint64_t C_SEPASECONDS_PER_SECOND = 10000000;
@@ -87,17 +100,20 @@ class SER_Recorder : public RecorderInterface
   protected:
     uint64_t utcTo64BitTS();
     bool is_little_endian();
-    void write_int_le(uint32_t *i);
-    void write_long_int_le(uint64_t *i);
-    void write_header(ser_header *s);
+    void write_int_le(uint8_t *&dst, uint32_t i);
+    void write_long_int_le(uint8_t *&dst, uint64_t i);
+    void write_header(const ser_header *s, uint8_t *dst);
     ser_header serh;
     bool isRecordingActive = false, isStreamingActive = false;
-    FILE *f;
+    int fd = -1;
     uint32_t frame_size;
     uint32_t number_of_planes;
     uint16_t rawWidth = 0, rawHeight = 0;
     std::vector<uint64_t> frameStamps;
 
+    // Write to the file at the given offset, from the writer thread and on close
+    virtual bool writeBlock(const uint8_t *data, size_t size, uint64_t offset);
+
   private:
     // From pipp_timestamp.h
     // Copyright (C) 2015 Chris Garry
@@ -124,5 +140,38 @@ class SER_Recorder : public RecorderInterface
 
     uint8_t *jpegBuffer=nullptr;
     INDI_PIXEL_FORMAT m_PixelFormat;
+
+    // Asynchronous writer
+    struct Batch
+    {
+        uint8_t *data = nullptr;
+        size_t used = 0;
+        // Frames complete once this batch is on disk
+        uint32_t frames = 0;
+    };
+
+    void appendFrame(const uint8_t *frame, size_t nbytes);
+    void writerThread();
+    void updateHeader();
+
+    static const size_t BATCH_COUNT = 3;
+    size_t batchSize = 0;
+    Batch batches[BATCH_COUNT];
+    Batch *fill = nullptr;
+    std::deque<Batch *> freeBatches, fullBatches;
+    // Copy of the first aligned block of the file, holding the header
+    uint8_t *firstBlock = nullptr;
+    uint64_t writeOffset = 0;
+    uint32_t framesOnDisk = 0;
+    bool directIO = false;
+
+    std::thread writer;
+    std::mutex writerMutex;
+    std::condition_variable writerWake;
+    bool writerQuit = false;
+    std::atomic<bool> writeFailed { false };
+
+    uint64_t expectedFrames = 0;
+    std::atomic<uint64_t> droppedFrames { 0 };
 };
 }
@@ -53,7 +53,8 @@ StreamManagerPrivate::StreamManagerPrivate(DefaultDevice *defaultDevice)
 
     encoder = encoderManager.getDefaultEncoder();
 
-    encoder->init(currentDevice);
+    for (EncoderInterface * oneEncoder : encoderManager.getEncoderList())
+        oneEncoder->init(currentDevice);
 
     LOGF_DEBUG("Using default encoder (%s)", encoder->getName());
 
@@ -103,6 +104,9 @@ bool StreamManagerPrivate::initProperties()
     StreamTimeNP[0].fill("STREAM_DELAY_TIME", "Delay (s)", "%.3f", 0, 60, 0.001, 0);
     StreamTimeNP.fill(getDeviceName(), "STREAM_DELAY", "Video Stream Delay", STREAM_TAB, IP_RO, 0, IPS_IDLE);
 
+    StreamEncodeTimeNP[0].fill("STREAM_ENCODE_TIME", "Encode (s)", "%.3f", 0, 60, 0.001, 0);
+    StreamEncodeTimeNP.fill(getDeviceName(), "STREAM_ENCODE", "Preview Encode Time", STREAM_TAB, IP_RO, 0, IPS_IDLE);
+
     StreamExposureNP[STREAM_EXPOSURE].fill("STREAMING_EXPOSURE_VALUE", "Duration (s)", "%.6f", 0.000001, 60, 0.1, 0.1);
     StreamExposureNP[STREAM_DIVISOR ].fill("STREAMING_DIVISOR_VALUE",  "Divisor",      "%.f",  1,        15, 1.0, 1.0);
     StreamExposureNP.fill(getDeviceName(), "STREAMING_EXPOSURE", "Expose", STREAM_TAB, IP_RW, 60, IPS_IDLE);
@@ -126,6 +130,9 @@ bool StreamManagerPrivate::initProperties()
     RecordOptionsNP.fill(getDeviceName(), "RECORD_OPTIONS",
                        "Record Options", STREAM_TAB, IP_RW, 60, IPS_IDLE);
 
+    RecordDroppedNP[0].fill("RECORD_DROPPED_FRAMES", "Dropped frames", "%.f", 0, 999999999.0, 0, 0);
+    RecordDroppedNP.fill(getDeviceName(), "RECORD_DROPPED", "Record Dropped", STREAM_TAB, IP_RO, 60, IPS_IDLE);
+
     /* Record Switch */
     RecordStreamSP[RECORD_ON   ].fill("RECORD_ON",          "Record On",         ISS_OFF);
     RecordStreamSP[RECORD_TIME ].fill("RECORD_DURATION_ON", "Record (Duration)", ISS_OFF);
@@ -165,10 +172,25 @@ bool StreamManagerPrivate::initProperties()
     RecorderSP.resize(1);
 #endif
 
+    // Preview conversion
+    PreviewModeSP[PreviewConverter::PREVIEW_GAMMA       ].fill("PREVIEW_GAMMA",        "Gamma",        ISS_ON);
+    PreviewModeSP[PreviewConverter::PREVIEW_LINEAR      ].fill("PREVIEW_LINEAR",       "Linear",       ISS_OFF);
+    PreviewModeSP[PreviewConverter::PREVIEW_AUTO_STRETCH].fill("PREVIEW_AUTO_STRETCH", "Auto Stretch", ISS_OFF);
+    PreviewModeSP.fill(getDeviceName(), "CCD_STREAM_PREVIEW", "Preview", STREAM_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
+    // Preview encoding, a size of 0 is no limit
+    PreviewEncodingNP[PREVIEW_MAX_WIDTH ].fill("PREVIEW_MAX_WIDTH",  "Max. Width",  "%.f", 0, 16384, 16, 640);
+    PreviewEncodingNP[PREVIEW_MAX_HEIGHT].fill("PREVIEW_MAX_HEIGHT", "Max. Height", "%.f", 0, 16384, 16, 480);
+    PreviewEncodingNP[PREVIEW_QUALITY   ].fill("PREVIEW_QUALITY",    "Quality",     "%.f", 1, 100,   1,  85);
+    PreviewEncodingNP.fill(getDeviceName(), "CCD_STREAM_PREVIEW_ENCODING", "Preview Encoding", STREAM_TAB, IP_RW, 0,
+                           IPS_IDLE);
+    setPreviewEncoding();
+
     // Limits
     LimitsNP[LIMITS_BUFFER_MAX ].fill("LIMITS_BUFFER_MAX",  "Maximum Buffer Size (MB)", "%.0f", 1, 1024*64, 1, 512);
     LimitsNP[LIMITS_PREVIEW_FPS].fill("LIMITS_PREVIEW_FPS", "Maximum Preview FPS",      "%.0f", 1, 120,     1,  10);
     LimitsNP.fill(getDeviceName(), "LIMITS", "Limits", STREAM_TAB, IP_RW, 0, IPS_IDLE);
+    framePool.setLimit(LimitsNP[LIMITS_BUFFER_MAX].getValue() * 1024 * 1024);
     return true;
 }
 
@@ -192,9 +214,12 @@ void StreamManagerPrivate::ISGetProperties(const char *dev)
         currentDevice->defineProperty(RecordStreamSP);
         currentDevice->defineProperty(RecordFileTP);
         currentDevice->defineProperty(RecordOptionsNP);
+        currentDevice->defineProperty(RecordDroppedNP);
         currentDevice->defineProperty(StreamFrameNP);
         currentDevice->defineProperty(EncoderSP);
         currentDevice->defineProperty(RecorderSP);
+        currentDevice->defineProperty(PreviewModeSP);
+        currentDevice->defineProperty(PreviewEncodingNP);
         currentDevice->defineProperty(LimitsNP);
     }
 }
@@ -220,30 +245,38 @@ bool StreamManagerPrivate::updateProperties()
 
         currentDevice->defineProperty(StreamSP);
         currentDevice->defineProperty(StreamTimeNP);
+        currentDevice->defineProperty(StreamEncodeTimeNP);
         if (hasStreamingExposure)
             currentDevice->defineProperty(StreamExposureNP);
         currentDevice->defineProperty(FpsNP);
         currentDevice->defineProperty(RecordStreamSP);
         currentDevice->defineProperty(RecordFileTP);
         currentDevice->defineProperty(RecordOptionsNP);
+        currentDevice->defineProperty(RecordDroppedNP);
         currentDevice->defineProperty(StreamFrameNP);
         currentDevice->defineProperty(EncoderSP);
         currentDevice->defineProperty(RecorderSP);
+        currentDevice->defineProperty(PreviewModeSP);
+        currentDevice->defineProperty(PreviewEncodingNP);
         currentDevice->defineProperty(LimitsNP);
     }
     else
     {
         currentDevice->deleteProperty(StreamSP.getName());
         currentDevice->deleteProperty(StreamTimeNP.getName());
+        currentDevice->deleteProperty(StreamEncodeTimeNP.getName());
         if (hasStreamingExposure)
             currentDevice->deleteProperty(StreamExposureNP.getName());
         currentDevice->deleteProperty(FpsNP.getName());
         currentDevice->deleteProperty(RecordFileTP.getName());
         currentDevice->deleteProperty(RecordStreamSP.getName());
         currentDevice->deleteProperty(RecordOptionsNP.getName());
+        currentDevice->deleteProperty(RecordDroppedNP.getName());
         currentDevice->deleteProperty(StreamFrameNP.getName());
         currentDevice->deleteProperty(EncoderSP.getName());
         currentDevice->deleteProperty(RecorderSP.getName());
+        currentDevice->deleteProperty(PreviewModeSP.getName());
+        currentDevice->deleteProperty(PreviewEncodingNP.getName());
         currentDevice->deleteProperty(LimitsNP.getName());
     }
 
@@ -256,19 +289,14 @@ bool StreamManager::updateProperties()
     return d->updateProperties();
 }
 
-/*
- * The camera driver is expected to send the FULL FRAME of the Camera after BINNING without any subframing at all
- * Subframing for streaming/recording is done in the stream manager.
- * Therefore nbytes is expected to be SubW/BinX * SubH/BinY * Bytes_Per_Pixels * Number_Color_Components
- * Binned frame must be sent from the camera driver for this to work consistentaly for all drivers.*/
-void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
+bool StreamManagerPrivate::countFrame()
 {
     // close the data stream on the same thread as the data stream
     // manually triggered to stop recording.
     if (isRecordingAboutToClose)
     {
         stopRecording();
-        return;
+        return false;
     }
 
     // Discard every N frame.
@@ -280,7 +308,7 @@ void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
         (frameCountDivider % static_cast<int>(StreamExposureNP[STREAM_DIVISOR].value)) == 0
     )
     {
-        return;
+        return false;
     }
 
     if (FPSAverage.newFrame())
@@ -295,32 +323,74 @@ void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
             std::thread([&](){ FpsNP.apply(); fastFPSUpdate.unlock(); }).detach();
     }
 
+    return true;
+}
+
+/*
+ * The camera driver is expected to send the FULL FRAME of the Camera after BINNING without any subframing at all
+ * Subframing for streaming/recording is done in the stream manager.
+ * Therefore nbytes is expected to be SubW/BinX * SubH/BinY * Bytes_Per_Pixels * Number_Color_Components
+ * Binned frame must be sent from the camera driver for this to work consistentaly for all drivers.*/
+void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
+{
+    if (countFrame() == false)
+        return;
+
+    FramePool::Buffer frame;
     if (isStreaming || (isRecording && !isRecordingAboutToClose))
     {
-        size_t allocatedSize = nbytes * framesIncoming.size() / 1024 / 1024; // allocated size in MB
-        if (allocatedSize > LimitsNP[LIMITS_BUFFER_MAX].getValue())
+        frame = framePool.acquire(nbytes);
+        if (!frame)
         {
             LOG_WARN("Frame buffer is full, skipping frame...");
+            if (isRecording)
+                bufferDroppedFrames++;
             return;
         }
 
-        std::vector<uint8_t> copyBuffer(buffer, buffer + nbytes); // copy the frame
+        memcpy(frame->data(), buffer, nbytes); // copy the frame
+    }
+
+    queueFrame(std::move(frame));
+}
+
+void StreamManagerPrivate::newFrame(FramePool::Buffer &&frame)
+{
+    if (countFrame() == false)
+        return;
+
+    queueFrame(std::move(frame));
+}
 
-        framesIncoming.push(TimeFrame{FPSFast.deltaTime(), std::move(copyBuffer)}); // push it into the queue
+void StreamManagerPrivate::queueFrame(FramePool::Buffer &&frame)
+{
+    if (frame && (isStreaming || (isRecording && !isRecordingAboutToClose)))
+    {
+        framesIncoming.push(TimeFrame{FPSFast.deltaTime(), std::move(frame)}); // push it into the queue
     }
 
     if (isRecording && !isRecordingAboutToClose)
     {
         FPSRecorder.newFrame(); // count frames and total time
 
+        // Frames the recorder dropped are not in the record and do not count
+        auto recordedFrames = [this]()
+        {
+            return FPSRecorder.totalFrames() - recorder->getDroppedFrames();
+        };
+        bool frameLimit = RecordStreamSP[RECORD_FRAME].getState() == ISS_ON;
+        bool timeUp     = RecordStreamSP[RECORD_TIME ].getState() == ISS_ON &&
+                          FPSRecorder.totalTime() >= (RecordOptionsNP[0].value * 1000.0);
+
         // captured all frames, stream should be close
-        if (
-            (RecordStreamSP[RECORD_FRAME].getState() == ISS_ON && FPSRecorder.totalFrames() >= (RecordOptionsNP[1].value)) ||
-            (RecordStreamSP[RECORD_TIME ].getState() == ISS_ON && FPSRecorder.totalTime()   >= (RecordOptionsNP[0].value * 1000.0))
-        )
+        if ((frameLimit && recordedFrames() >= RecordOptionsNP[1].value) || timeUp)
         {
             LOG_INFO("Waiting for all buffered frames to be recorded");
             framesIncoming.waitForEmpty();
+
+            // Some of the buffered frames were dropped, record more to make up for them
+            if (!timeUp && recordedFrames() < RecordOptionsNP[1].value)
+                return;
             // duplicated message
 #if 0
             LOGF_INFO(
@@ -345,6 +415,25 @@ void StreamManager::newFrame(const uint8_t * buffer, uint32_t nbytes)
     d->newFrame(buffer, nbytes);
 }
 
+FramePool::Buffer StreamManager::acquireFrame(uint32_t nbytes)
+{
+    D_PTR(StreamManager);
+    FramePool::Buffer frame = d->framePool.acquire(nbytes);
+    if (!frame)
+    {
+        LOG_WARN("Frame buffer is full, skipping frame...");
+        if (d->isRecording)
+            d->bufferDroppedFrames++;
+    }
+    return frame;
+}
+
+void StreamManager::newFrame(FramePool::Buffer &&frame)
+{
+    D_PTR(StreamManager);
+    d->newFrame(std::move(frame));
+}
+
 
 StreamManagerPrivate::FrameInfo StreamManagerPrivate::updateSourceFrameInfo()
 {
@@ -397,23 +486,35 @@ void StreamManagerPrivate::subframe(
 
     srcBuffer += srcOffset;
 
-    // Copy line-by-line
+    // Copy line-by-line, each line moves to the same place or earlier so dstBuffer may be srcBuffer
     for (size_t i = 0; i < dstFrameInfo.h; ++i)
     {
-        memcpy(dstBuffer, srcBuffer, dstStride);
+        memmove(dstBuffer, srcBuffer, dstStride);
         dstBuffer += dstStride;
         srcBuffer += srcStride;
     }
 }
 
+void StreamManagerPrivate::updateDroppedFrames(bool force)
+{
+    double dropped = recorder->getDroppedFrames() + bufferDroppedFrames;
+    auto now = std::chrono::steady_clock::now();
+
+    if (dropped == RecordDroppedNP[0].getValue() ||
+            (!force && now - droppedUpdateTime < std::chrono::seconds(1)))
+        return;
+
+    droppedUpdateTime = now;
+    RecordDroppedNP[0].setValue(dropped);
+    RecordDroppedNP.setState(IPS_BUSY);
+    RecordDroppedNP.apply();
+}
+
 void StreamManagerPrivate::asyncStreamThread()
 {
     TimeFrame sourceTimeFrame;
     sourceTimeFrame.time = 0;
 
-    std::vector<uint8_t> subframeBuffer;  // Subframe buffer for recording/streaming
-    std::vector<uint8_t> downscaleBuffer; // Downscale buffer for streaming
-
     INDI::SingleThreadPool previewThreadPool;
     INDI::ElapsedTimer previewElapsed;
 
@@ -424,7 +525,8 @@ void StreamManagerPrivate::asyncStreamThread()
 
         FrameInfo srcFrameInfo = updateSourceFrameInfo();
 
-        std::vector<uint8_t> *sourceBuffer = &sourceTimeFrame.frame;
+        // Frames are shared with the preview thread, and go back to the pool once both are done with them
+        FramePool::Buffer sourceBuffer = std::move(sourceTimeFrame.frame);
 
         if (sourceBuffer->size() != srcFrameInfo.totalSize())
         {
@@ -433,16 +535,35 @@ void StreamManagerPrivate::asyncStreamThread()
         }
 
         // Check if we need to subframe
+        const uint8_t *recordBuffer = nullptr;
         if (
             PixelFormat != INDI_JPG &&
             dstFrameInfo.pixels() != 0 &&
             dstFrameInfo != srcFrameInfo
         )
         {
-            subframeBuffer.resize(dstFrameInfo.totalSize());
-            subframe(sourceBuffer->data(), srcFrameInfo, subframeBuffer.data(), dstFrameInfo);
+            FramePool::Buffer subframeBuffer;
 
-            sourceBuffer = &subframeBuffer;
+            if (sourceBuffer.use_count() == 1)
+            {
+                // Nobody else holds the frame, crop it where it is
+                subframe(sourceBuffer->data(), srcFrameInfo, sourceBuffer->data(), dstFrameInfo);
+                sourceBuffer->resize(dstFrameInfo.totalSize());
+            }
+            else if ((subframeBuffer = framePool.acquire(dstFrameInfo.totalSize())))
+            {
+                subframe(sourceBuffer->data(), srcFrameInfo, subframeBuffer->data(), dstFrameInfo);
+                sourceBuffer = std::move(subframeBuffer);
+            }
+            else
+            {
+                // The pool is full: the recording still gets the frame, the preview does without it
+                recordScratch.resize(dstFrameInfo.totalSize());
+                subframe(sourceBuffer->data(), srcFrameInfo, recordScratch.data(), dstFrameInfo);
+                recordBuffer = recordScratch.data();
+                if (isStreaming)
+                    LOG_WARN("Frame buffer is full, skipping preview...");
+            }
         }
 
         // For recording, save immediately.
@@ -450,43 +571,56 @@ void StreamManagerPrivate::asyncStreamThread()
             std::lock_guard<std::mutex> lock(recordMutex);
             if (
                 isRecording && !isRecordingAboutToClose &&
-                recordStream(sourceBuffer->data(), sourceBuffer->size(), sourceTimeFrame.time) == false
+                (recordBuffer != nullptr ?
+                 recordStream(recordBuffer, recordScratch.size(), sourceTimeFrame.time) :
+                 recordStream(sourceBuffer->data(), sourceBuffer->size(), sourceTimeFrame.time)) == false
             )
             {
                 LOG_ERROR("Recording failed.");
                 isRecordingAboutToClose = true;
             }
+            if (isRecording)
+                updateDroppedFrames();
         }
 
         // For streaming, downscale to 8bit if higher than 8bit to reduce bandwidth
         // You can reduce the number of frames by setting a frame limit.
-        if (isStreaming && FPSPreview.newFrame())
+        if (isStreaming && recordBuffer == nullptr && FPSPreview.newFrame())
         {
             // Downscale to 8bit always for streaming to reduce bandwidth
             if (PixelFormat != INDI_JPG && PixelDepth > 8)
             {
-                // Allocale new buffer if size changes
-                downscaleBuffer.resize(dstFrameInfo.pixels());
+                // Every component of every pixel
+                size_t samples = sourceBuffer->size() / sizeof(uint16_t);
+                FramePool::Buffer downscaleBuffer = framePool.acquire(samples);
+                if (!downscaleBuffer)
+                {
+                    // Already recorded, only the preview goes without this frame
+                    LOG_WARN("Frame buffer is full, skipping preview...");
+                    continue;
+                }
 
-                // Apply gamma
-                gammaLut16.apply(
+                previewConverter.convert(
                     reinterpret_cast<const uint16_t*>(sourceBuffer->data()),
-                    downscaleBuffer.size(),
-                    downscaleBuffer.data()
+                    samples,
+                    PixelDepth,
+                    downscaleBuffer->data()
                 );
 
-                sourceBuffer = &downscaleBuffer;
+                sourceBuffer = std::move(downscaleBuffer);
             }
 
             //uploadStream(sourceBuffer->data(), sourceBuffer->size());
-            previewThreadPool.tryStart(std::bind([this, &previewElapsed](const std::atomic_bool &isAboutToQuit, std::vector<uint8_t> frame){
+            previewThreadPool.tryStart([this, &previewElapsed, sourceBuffer](const std::atomic_bool &isAboutToQuit){
                 INDI_UNUSED(isAboutToQuit);
                 previewElapsed.start();
-                uploadStream(frame.data(), frame.size());
+                uploadStream(sourceBuffer->data(), sourceBuffer->size());
                 StreamTimeNP[0].setValue(previewElapsed.nsecsElapsed() / 1000000000.0);
                 StreamTimeNP.apply();
+                StreamEncodeTimeNP[0].setValue(PixelFormat == INDI_JPG ? 0 : encoder->getEncodeTime());
+                StreamEncodeTimeNP.apply();
 
-            }, std::placeholders::_1, std::move(*sourceBuffer)));
+            });
         }
     }
 }
@@ -529,6 +663,16 @@ void StreamManagerPrivate::setSize(uint16_t width, uint16_t height)
         oneRecorder->setSize(rawWidth, rawHeight);
 }
 
+void StreamManagerPrivate::setPreviewEncoding()
+{
+    for (EncoderInterface * oneEncoder : encoderManager.getEncoderList())
+    {
+        oneEncoder->setTargetSize(PreviewEncodingNP[PREVIEW_MAX_WIDTH].getValue(),
+                                  PreviewEncodingNP[PREVIEW_MAX_HEIGHT].getValue());
+        oneEncoder->setQuality(PreviewEncodingNP[PREVIEW_QUALITY].getValue());
+    }
+}
+
 bool StreamManager::close()
 {
     D_PTR(StreamManager);
@@ -656,6 +800,14 @@ bool StreamManagerPrivate::startRecording()
                   strerror(errno));
         return false;
     }
+    // Let the recorder reserve disk space for the whole record
+    if (RecordStreamSP[RECORD_FRAME].getState() == ISS_ON)
+        recorder->setExpectedFrames(RecordOptionsNP[1].getValue());
+    else if (RecordStreamSP[RECORD_TIME].getState() == ISS_ON)
+        recorder->setExpectedFrames(RecordOptionsNP[0].getValue() * FpsNP[FPS_AVERAGE].getValue());
+    else
+        recorder->setExpectedFrames(0);
+
     if (!recorder->open(filename.c_str(), errmsg))
     {
         RecordStreamSP.setState(IPS_ALERT);
@@ -684,6 +836,10 @@ bool StreamManagerPrivate::startRecording()
 #endif
     FPSRecorder.reset();
     frameCountDivider = 0;
+    bufferDroppedFrames = 0;
+    RecordDroppedNP[0].setValue(0);
+    RecordDroppedNP.setState(IPS_IDLE);
+    RecordDroppedNP.apply();
 
     if (isStreaming == false)
     {
@@ -740,8 +896,17 @@ bool StreamManagerPrivate::stopRecording(bool force)
     {
         std::lock_guard<std::mutex> lock(recordMutex);
         recorder->close();
+        updateDroppedFrames(true);
     }
 
+    RecordDroppedNP.setState(RecordDroppedNP[0].getValue() > 0 ? IPS_ALERT : IPS_OK);
+    RecordDroppedNP.apply();
+    if (RecordDroppedNP[0].getValue() > 0)
+        LOGF_WARN("%.f frames were dropped from the record.", RecordDroppedNP[0].getValue());
+
+    if (!isStreaming)
+        framePool.clear();
+
     if (force)
         return false;
 
@@ -835,6 +1000,16 @@ bool StreamManagerPrivate::ISNewSwitch(const char * dev, const char * name, ISSt
         return true;
     }
 
+    // Preview conversion
+    if (PreviewModeSP.isNameMatch(name))
+    {
+        PreviewModeSP.update(states, names, n);
+        previewConverter.setMode(static_cast<PreviewConverter::Mode>(PreviewModeSP.findOnSwitchIndex()));
+        PreviewModeSP.setState(IPS_OK);
+        PreviewModeSP.apply();
+        return true;
+    }
+
     // Encoder Selection
     if (EncoderSP.isNameMatch(name))
     {
@@ -944,6 +1119,7 @@ bool StreamManagerPrivate::ISNewNumber(const char * dev, const char * name, doub
     {
         LimitsNP.update(values, names, n);
 
+        framePool.setLimit(LimitsNP[LIMITS_BUFFER_MAX].getValue() * 1024 * 1024);
         FPSPreview.setTimeWindow(1000.0 / LimitsNP[LIMITS_PREVIEW_FPS].getValue());
         FPSPreview.reset();
 
@@ -952,6 +1128,16 @@ bool StreamManagerPrivate::ISNewNumber(const char * dev, const char * name, doub
         return true;
     }
 
+    /* Preview Encoding */
+    if (PreviewEncodingNP.isNameMatch(name))
+    {
+        PreviewEncodingNP.update(values, names, n);
+        setPreviewEncoding();
+        PreviewEncodingNP.setState(IPS_OK);
+        PreviewEncodingNP.apply();
+        return true;
+    }
+
     /* Record Options */
     if (RecordOptionsNP.isNameMatch(name))
     {
@@ -1104,6 +1290,8 @@ bool StreamManagerPrivate::setStream(bool enable)
             StreamSP.reset();
             StreamSP[1].setState(ISS_ON);
             isStreaming = false;
+            if (!isRecording)
+                framePool.clear();
             Format.clear();
             FpsNP[FPS_INSTANT].setValue(0);
             FpsNP[FPS_AVERAGE].setValue(0);
@@ -1130,6 +1318,8 @@ bool StreamManager::saveConfigItems(FILE * fp)
     d->RecordOptionsNP.save(fp);
     d->RecorderSP.save(fp);
     d->LimitsNP.save(fp);
+    d->PreviewModeSP.save(fp);
+    d->PreviewEncodingNP.save(fp);
     return true;
 }
 
@@ -26,6 +26,7 @@
 #include "indidevapi.h"
 #include "indibasetypes.h"
 #include "indimacros.h"
+#include "framepool.h"
 #include <memory>
 
 /**
@@ -46,6 +47,9 @@
 
    It is highly recommended to implement the streaming functionality in a dedicated thread.
 
+   Frames passed to newFrame() as a pointer are copied once into a recycled buffer. Drivers streaming at high frame rates
+   can avoid that copy by reading the frame into a buffer from acquireFrame() and passing it to newFrame() instead.
+
    \section Encoders
 
    Encoders are responsible for encoding the frame and transmitting it to the client. The CCD1 BLOB format is set to the desired format.
@@ -117,6 +121,20 @@ public:
      */
     void newFrame(const uint8_t *buffer, uint32_t nbytes);
 
+    /**
+     * @brief acquireFrame Get a buffer from the stream frame pool, for drivers to read a frame into directly and pass it
+     * to newFrame() without any copy. The pool is limited by the Maximum Buffer Size limit.
+     * @param nbytes size of the frame in bytes, as expected by newFrame()
+     * @return buffer, or nullptr if the frame buffer is full and the frame should be skipped.
+     */
+    FramePool::Buffer acquireFrame(uint32_t nbytes);
+
+    /**
+     * @brief newFrame CCD drivers call this function with a frame read into a buffer from acquireFrame(). The
+     * stream manager keeps the buffer until the frame is recorded and previewed, then it goes back to the pool.
+     */
+    void newFrame(FramePool::Buffer &&frame);
+
     bool close();
 
 public:
@@ -27,10 +27,12 @@
 #include "recorder/recordermanager.h"
 #include "encoder/encodermanager.h"
 #include "fpsmeter.h"
+#include "framepool.h"
 #include "uniquequeue.h"
-#include "gammalut16.h"
+#include "previewconverter.h"
 
 #include <atomic>
+#include <chrono>
 #include <string>
 #include <map>
 #include <thread>
@@ -102,6 +104,18 @@ public:
     bool ISNewNumber(const char * dev, const char * name, double values[], char * names[], int n);
 
     void newFrame(const uint8_t * buffer, uint32_t nbytes);
+    void newFrame(FramePool::Buffer &&frame);
+
+    /**
+     * @brief countFrame Count a new frame in the FPS statistics
+     * @return False if the frame is to be discarded
+     */
+    bool countFrame();
+
+    /**
+     * @brief queueFrame Queue a counted frame for recording and preview, and end the recording when complete
+     */
+    void queueFrame(FramePool::Buffer &&frame);
 
     bool updateProperties();
     bool setStream(bool enable);
@@ -109,6 +123,7 @@ public:
     const char *getDeviceName() const;
 
     void setSize(uint16_t width, uint16_t height);
+    void setPreviewEncoding();
     bool setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth);
 
     /**
@@ -161,6 +176,7 @@ public:
     INDI::PropertySwitch StreamSP {2};
 
     INDI::PropertyNumber StreamTimeNP {1};
+    INDI::PropertyNumber StreamEncodeTimeNP {1};
 
     /* Record switch */
     INDI::PropertySwitch RecordStreamSP {4};
@@ -189,6 +205,9 @@ public:
     /* Record Options */
     INDI::PropertyNumber RecordOptionsNP {2};
 
+    /* Frames not recorded because the disk or the frame buffer could not keep up */
+    INDI::PropertyNumber RecordDroppedNP {1};
+
     // Stream Frame
     INDI::PropertyNumber StreamFrameNP {4};
 
@@ -203,6 +222,13 @@ public:
     INDI::PropertySwitch RecorderSP {2};
     enum { RECORDER_RAW, RECORDER_OGV };
 
+    // Conversion of deep frames to 8 bit for the preview
+    INDI::PropertySwitch PreviewModeSP {3};
+
+    // Size and quality of the preview of encoders that scale it down and compress it
+    INDI::PropertyNumber PreviewEncodingNP {3};
+    enum { PREVIEW_MAX_WIDTH, PREVIEW_MAX_HEIGHT, PREVIEW_QUALITY };
+
     // Limits. Maximum queue size for incoming frames. FPS Limit for preview
     INDI::PropertyNumber LimitsNP {2};
     enum { LIMITS_BUFFER_MAX, LIMITS_PREVIEW_FPS };
@@ -228,6 +254,15 @@ public:
     FPSMeter FPSPreview;
     FPSMeter FPSRecorder;
 
+    // Frames skipped for a full frame buffer while recording
+    std::atomic<uint64_t> bufferDroppedFrames { 0 };
+    std::chrono::steady_clock::time_point droppedUpdateTime;
+
+    /**
+     * @brief updateDroppedFrames Publish the number of dropped frames, at most once a second unless forced
+     */
+    void updateDroppedFrames(bool force = false);
+
     uint32_t frameCountDivider = 0;
 
     INDI_PIXEL_FORMAT PixelFormat = INDI_MONO;
@@ -238,17 +273,19 @@ public:
     // Processing for streaming
     typedef struct {
         double time;
-        std::vector<uint8_t> frame;
+        FramePool::Buffer frame;
     } TimeFrame;
 
     std::thread              framesThread;   // async incoming frames processing
     std::atomic<bool>        framesThreadTerminate {false};
     UniqueQueue<TimeFrame>   framesIncoming;
+    FramePool                framePool;      // incoming, subframed and downscaled frames, limited by LIMITS_BUFFER_MAX
+    std::vector<uint8_t>     recordScratch;  // subframe to record when the pool is full, framesThread only
 
     std::mutex               fastFPSUpdate;
     std::mutex               recordMutex;
 
-    GammaLut16               gammaLut16;
+    PreviewConverter         previewConverter;
 };
 
 }
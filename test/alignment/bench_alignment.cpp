@@ -0,0 +1,122 @@
+/*******************************************************************************
+ Copyright(c) 2026 INDI Library Contributors. All rights reserved.
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+// Celestial to telescope transforms per second of the built in math plugin
+// against the size of the alignment database.
+//
+// Usage: bench_alignment [transforms per run]
+
+#include <alignment/BuiltInMathPlugin.h>
+#include <alignment/InMemoryDatabase.h>
+#include <indilogger.h>
+#include <libastro.h>
+#include <libnova/julian_day.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace INDI::AlignmentSubsystem;
+
+static const double Latitude  = 34.70;
+static const double Longitude = 279.46;
+
+// A mount with a small polar misalignment, so every sync point gets a slightly different correction
+static TelescopeDirectionVector MountDirection(BuiltInMathPlugin &Plugin, INDI::IHorizontalCoordinates AltAz)
+{
+    TelescopeDirectionVector Direction = Plugin.TelescopeDirectionVectorFromAltitudeAzimuth(AltAz);
+    Direction.RotateAroundY(0.3);
+    return Direction;
+}
+
+// Random visible sky position at JulianDate
+static void VisiblePosition(std::mt19937 &Random, double JulianDate, double &RA, double &Dec)
+{
+    std::uniform_real_distribution<double> RADistribution(0, 24), DecDistribution(-30, 89);
+    INDI::IGeographicCoordinates Position { Longitude, Latitude, 0 };
+    INDI::IHorizontalCoordinates AltAz;
+    do
+    {
+        INDI::IEquatorialCoordinates RaDec { RADistribution(Random), DecDistribution(Random) };
+        INDI::EquatorialToHorizontal(&RaDec, &Position, JulianDate, &AltAz);
+        RA  = RaDec.rightascension;
+        Dec = RaDec.declination;
+    }
+    while (AltAz.altitude < 15);
+}
+
+static double Run(size_t SyncPoints, size_t Transforms, bool Tracking)
+{
+    std::mt19937 Random(SyncPoints);
+    InMemoryDatabase Database;
+    BuiltInMathPlugin Plugin;
+    double JulianDate = ln_get_julian_from_sys();
+
+    Database.SetDatabaseReferencePosition(Latitude, Longitude);
+    INDI::IGeographicCoordinates Position;
+    Database.GetDatabaseReferencePosition(Position);
+
+    for (size_t i = 0; i < SyncPoints; i++)
+    {
+        AlignmentDatabaseEntry Entry;
+        INDI::IHorizontalCoordinates AltAz;
+        VisiblePosition(Random, JulianDate, Entry.RightAscension, Entry.Declination);
+        INDI::IEquatorialCoordinates RaDec { Entry.RightAscension, Entry.Declination };
+        INDI::EquatorialToHorizontal(&RaDec, &Position, JulianDate, &AltAz);
+        Entry.ObservationJulianDate = JulianDate;
+        Entry.TelescopeDirection    = MountDirection(Plugin, AltAz);
+        Database.GetAlignmentDatabase().push_back(Entry);
+    }
+
+    Plugin.SetApproximateMountAlignment(ZENITH);
+    Plugin.Initialise(&Database);
+
+    // Either follow one target, as ReadScopeStatus does, or jump around the sky
+    std::vector<std::pair<double, double>> Targets(Tracking ? 1 : 1024);
+    for (auto &Target : Targets)
+        VisiblePosition(Random, JulianDate, Target.first, Target.second);
+
+    TelescopeDirectionVector Direction;
+    auto Start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < Transforms; i++)
+    {
+        const auto &Target = Targets[i % Targets.size()];
+        // When tracking, advance the clock 10 ms per transform like a fast status poll
+        double Offset = Tracking ? i / 86400.0 / 100 : 0;
+        Plugin.TransformCelestialToTelescope(Target.first, Target.second, Offset, Direction);
+    }
+    std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+
+    return Transforms / Elapsed.count();
+}
+
+int main(int argc, char **argv)
+{
+    size_t Transforms = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+    INDI::Logger::getInstance().configure("", INDI::Logger::file_off,
+                                          INDI::Logger::DBG_ERROR, INDI::Logger::DBG_ERROR);
+
+    printf("%12s %16s %16s\n", "sync points", "tracking /s", "random /s");
+    for (size_t SyncPoints : { 1, 3, 4, 8, 16, 32, 64, 128, 256, 512 })
+        printf("%12zu %16.0f %16.0f\n", SyncPoints, Run(SyncPoints, Transforms, true),
+               Run(SyncPoints, Transforms, false));
+
+    return 0;
+}
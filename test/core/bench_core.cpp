@@ -0,0 +1,198 @@
+/*******************************************************************************
+ Copyright(c) 2026 INDI Library Contributors. All rights reserved.
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+// Throughput of the core frame and protocol paths: base64, binning, preview conversion and scaling, and the
+// event loop timers. The unit tests check the results, this only prints how fast they come.
+//
+// Usage: bench_core [base64|binning|preview|scaler|timers]...
+
+#include "base64.h"
+#include "eventloop.h"
+#include "indibinning.h"
+#include "previewconverter.h"
+#include "previewscaler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+static double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchBase64()
+{
+    const size_t len   = 16 * 1024 * 1024;
+    const int    loops = 8;
+
+    std::mt19937 random(1);
+    std::vector<unsigned char> raw(len);
+    for (auto &byte : raw)
+        byte = random() & 0xff;
+    std::vector<unsigned char> enc(4 * len / 3 + 4);
+    std::vector<char> dec(len);
+
+    auto start = std::chrono::steady_clock::now();
+    int enclen = 0;
+    for (int i = 0; i < loops; i++)
+        enclen = to64frombits_s(enc.data(), raw.data(), len, enc.size());
+    double encode = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    int declen = 0;
+    for (int i = 0; i < loops; i++)
+        declen = from64tobits_fast(dec.data(), reinterpret_cast<char *>(enc.data()), enclen);
+    double decode = seconds(start);
+
+    if (declen != static_cast<int>(len) || memcmp(raw.data(), dec.data(), len) != 0)
+        printf("base64 round trip failed\n");
+
+    double mb = double(len) * loops / (1024 * 1024);
+    printf("base64 encode %.0f MB/s, decode %.0f MB/s\n", mb / encode, mb / decode);
+}
+
+static void benchBinning()
+{
+    const uint32_t width = 6000, height = 4000;
+    const int loops = 4;
+
+    std::mt19937 random(1);
+    std::vector<uint16_t> frame(static_cast<size_t>(width) * height), binned(frame.size());
+    for (auto &pixel : frame)
+        pixel = random() & 0xffff;
+
+    for (uint32_t bin : {2, 3, 4})
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < loops; i++)
+            INDI::binFrame(frame.data(), binned.data(), width, height, 16, bin, bin, INDI::BINNING_SUM);
+        printf("16 bit %ux%u binning %.0f MPixel/s\n", bin, bin, double(width) * height * loops / 1e6 / seconds(start));
+    }
+}
+
+static void benchPreview()
+{
+    const int loops = 4;
+
+    std::mt19937 random(1);
+    std::vector<uint16_t> samples(6000 * 4000);
+    for (auto &sample : samples)
+        sample = random() % 4096;
+    std::vector<uint8_t> converted(samples.size());
+
+    INDI::PreviewConverter converter;
+    for (auto mode : {INDI::PreviewConverter::PREVIEW_GAMMA, INDI::PreviewConverter::PREVIEW_LINEAR, INDI::PreviewConverter::PREVIEW_AUTO_STRETCH})
+    {
+        converter.setMode(mode);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < loops; i++)
+            converter.convert(samples.data(), samples.size(), 12, converted.data());
+        printf("preview mode %d: %.0f MSamples/s\n", mode, double(samples.size()) * loops / 1e6 / seconds(start));
+    }
+}
+
+static void benchScaler()
+{
+    const uint32_t width = 6000, height = 4000;
+    const int loops = 4;
+
+    std::mt19937 random(1);
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height), scaled(frame.size());
+    for (auto &sample : frame)
+        sample = random() & 0xff;
+
+    INDI::PreviewScaler scaler;
+    uint32_t factor = INDI::PreviewScaler::factor(width, height, 640, 480);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; i++)
+        scaler.scale(frame.data(), width, height, 1, factor, scaled.data());
+    printf("8 bit %ux%u to 640x480 preview %.0f MPixel/s\n", width, height,
+           double(width) * height * loops / 1e6 / seconds(start));
+}
+
+static void noTimer(void *)
+{
+}
+
+static void benchTimers()
+{
+    const int count = 100000;
+    std::mt19937 random(count);
+    std::uniform_int_distribution<int> delay(1000, 100999);
+    std::vector<int> ids(count);
+
+    // Many pending timers, as with drivers that host many devices
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+        ids[i] = addTimer(delay(random), noTimer, nullptr);
+    std::shuffle(ids.begin(), ids.end(), random);
+    for (int id : ids)
+        rmTimer(id);
+    printf("%d timers added then removed, %.0f kops/s\n", count, 2.0 * count / 1e3 / seconds(start));
+
+    // Churn, timers rearmed while many others are pending
+    std::vector<int> pending(count / 10);
+    for (auto &id : pending)
+        id = addTimer(delay(random), noTimer, nullptr);
+    std::uniform_int_distribution<size_t> which(0, pending.size() - 1);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        int &id = pending[which(random)];
+        rmTimer(id);
+        id = addTimer(delay(random), noTimer, nullptr);
+    }
+    double elapsed = seconds(start);
+    for (int id : pending)
+        rmTimer(id);
+
+    printf("%d timers rearmed among %zu, %.0f kops/s\n", count, pending.size(), 2.0 * count / 1e3 / elapsed);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct
+    {
+        const char *name;
+        void (*run)();
+    } benches[] =
+    {
+        { "base64", benchBase64 },
+        { "binning", benchBinning },
+        { "preview", benchPreview },
+        { "scaler", benchScaler },
+        { "timers", benchTimers },
+    };
+
+    for (const auto &bench : benches)
+    {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++)
+            selected = selected || !strcmp(argv[i], bench.name);
+        if (selected)
+            bench.run();
+    }
+
+    return 0;
+}
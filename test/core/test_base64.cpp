@@ -21,8 +21,12 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "base64.h"
 
@@ -78,3 +82,129 @@ TEST(CORE_BASE64, Test_from64tobits_fast)
     ASSERT_EQ(out_len, res_len);
     ASSERT_STREQ(out_msg, res_msg);
 }
+
+// plain RFC 4648 encoder to check the fast paths against
+static std::string reference64(const unsigned char *in, size_t len)
+{
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t n = in[i] << 16;
+        if (i + 1 < len)
+            n |= in[i + 1] << 8;
+        if (i + 2 < len)
+            n |= in[i + 2];
+
+        out += digits[(n >> 18) & 0x3f];
+        out += digits[(n >> 12) & 0x3f];
+        out += i + 1 < len ? digits[(n >> 6) & 0x3f] : '=';
+        out += i + 2 < len ? digits[n & 0x3f] : '=';
+    }
+    return out;
+}
+
+static std::vector<unsigned char> randomBytes(size_t len)
+{
+    std::vector<unsigned char> v(len);
+    for (size_t i = 0; i < len; i++)
+        v[i] = rand() & 0xff;
+    return v;
+}
+
+TEST(CORE_BASE64, Test_roundtrip)
+{
+    srand(1);
+
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < 1100; i++)
+        sizes.push_back(i);
+    sizes.push_back(65536);
+    sizes.push_back(1000003);
+
+    for (size_t len : sizes)
+    {
+        // odd offsets so that neither buffer is aligned
+        std::vector<unsigned char> raw = randomBytes(len + 1);
+        std::vector<unsigned char> enc(4 * len / 3 + 8);
+        std::vector<char> dec(len + 8);
+
+        int enclen = to64frombits_s(enc.data() + 1, raw.data() + 1, len, enc.size() - 1);
+        std::string ref = reference64(raw.data() + 1, len);
+        ASSERT_EQ(ref.size(), (size_t)enclen) << "len " << len;
+        ASSERT_EQ(ref, std::string(reinterpret_cast<char *>(enc.data() + 1), enclen)) << "len " << len;
+
+        int declen = from64tobits_fast(dec.data() + 1, reinterpret_cast<char *>(enc.data() + 1), enclen);
+        ASSERT_EQ(len, (size_t)declen) << "len " << len;
+        ASSERT_EQ(0, memcmp(raw.data() + 1, dec.data() + 1, len)) << "len " << len;
+
+        declen = from64tobits(dec.data(), reinterpret_cast<char *>(enc.data() + 1));
+        ASSERT_EQ(len, (size_t)declen) << "len " << len;
+        ASSERT_EQ(0, memcmp(raw.data() + 1, dec.data(), len)) << "len " << len;
+    }
+}
+
+TEST(CORE_BASE64, Test_from64tobits_lines)
+{
+    srand(2);
+
+    for (size_t len : {1, 53, 54, 55, 100, 1000, 100000})
+    {
+        std::vector<unsigned char> raw = randomBytes(len);
+        std::string ref = reference64(raw.data(), len);
+
+        // wrapped the way IUUserIOBLOBContextOne sends it, minus the last line break
+        std::string wrapped;
+        for (size_t i = 0; i < ref.size(); i += 72)
+        {
+            if (i > 0)
+                wrapped += '\n';
+            wrapped += ref.substr(i, 72);
+        }
+
+        std::vector<char> dec(wrapped.size());
+
+        // by the number of base64 digits, as from enclen
+        int declen = from64tobits_fast(dec.data(), wrapped.c_str(), ref.size());
+        ASSERT_EQ(len, (size_t)declen) << "len " << len;
+        ASSERT_EQ(0, memcmp(raw.data(), dec.data(), len)) << "len " << len;
+
+        // by the length of the whole text, as from pcdatalenXMLEle
+        memset(dec.data(), 0, dec.size());
+        declen = from64tobits_fast(dec.data(), wrapped.c_str(), wrapped.size());
+        ASSERT_EQ(len, (size_t)declen) << "len " << len;
+        ASSERT_EQ(0, memcmp(raw.data(), dec.data(), len)) << "len " << len;
+    }
+}
+
+// A floor well below any build, even an unoptimized one, to catch a fast path gone missing; bench_core has the
+// real numbers
+TEST(CORE_BASE64, Test_throughput)
+{
+    const size_t len = 4 * 1024 * 1024;
+
+    srand(3);
+    std::vector<unsigned char> raw = randomBytes(len);
+    std::vector<unsigned char> enc(4 * len / 3 + 4);
+    std::vector<char> dec(len);
+
+    double encode = 0, decode = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int enclen = to64frombits_s(enc.data(), raw.data(), len, enc.size());
+        auto middle = std::chrono::steady_clock::now();
+        int declen = from64tobits_fast(dec.data(), reinterpret_cast<char *>(enc.data()), enclen);
+        auto end = std::chrono::steady_clock::now();
+        ASSERT_EQ(len, (size_t)declen);
+
+        // MB/s of the best run
+        encode = std::max(encode, len / 1e6 / std::chrono::duration<double>(middle - start).count());
+        decode = std::max(decode, len / 1e6 / std::chrono::duration<double>(end - middle).count());
+    }
+    ASSERT_EQ(0, memcmp(raw.data(), dec.data(), len));
+
+    EXPECT_GT(encode, 50) << "MB/s";
+    EXPECT_GT(decode, 50) << "MB/s";
+}
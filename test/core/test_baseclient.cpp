@@ -0,0 +1,447 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include "base64.h"
+#include "baseclient.h"
+#include "basedevice.h"
+
+// One client connection on a local port, the test plays the INDI server
+class FakeServer
+{
+    public:
+        FakeServer()
+        {
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family      = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t len        = sizeof(addr);
+            bind(listener, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+            listen(listener, 1);
+            getsockname(listener, reinterpret_cast<struct sockaddr *>(&addr), &len);
+            port = ntohs(addr.sin_port);
+        }
+
+        ~FakeServer()
+        {
+            hangUp();
+            close(listener);
+        }
+
+        void accept()
+        {
+            connection = ::accept(listener, nullptr, nullptr);
+            // Each send() arrives on its own, so the client parses the text in the same pieces
+            int one = 1;
+            setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        void send(const std::string &xml)
+        {
+            ASSERT_EQ(write(connection, xml.data(), xml.size()), static_cast<ssize_t>(xml.size()));
+        }
+
+        // Send and give the client time to read it before anything else arrives
+        void sendAlone(const std::string &xml)
+        {
+            send(xml);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        // Send in pieces of chunk bytes, which split the base64 groups
+        void sendSplit(const std::string &xml, size_t chunk)
+        {
+            for (size_t i = 0; i < xml.size(); i += chunk)
+            {
+                send(xml.substr(i, chunk));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        void hangUp()
+        {
+            if (connection >= 0)
+                close(connection);
+            connection = -1;
+        }
+
+        int listener {-1};
+        int connection {-1};
+        unsigned short port {0};
+};
+
+static const char *DEFINITIONS =
+    "<defNumberVector device='Dev' name='NUM' state='Idle' perm='rw' timeout='0'>"
+    "<defNumber name='V' format='%g' min='0' max='10' step='1'>0</defNumber></defNumberVector>"
+    "<defBLOBVector device='Dev' name='BLOB' state='Idle' perm='ro' timeout='0'>"
+    "<defBLOB name='B'/></defBLOBVector>";
+
+// 'INDI' in base64
+static const char *SET_BLOB =
+    "<setBLOBVector device='Dev' name='BLOB' state='Ok'>"
+    "<oneBLOB name='B' size='4' format='.bin'>SU5ESQ==</oneBLOB></setBLOBVector>";
+
+class Client : public INDI::BaseClient
+{
+    public:
+        void newDevice(INDI::BaseDevice *) override {}
+        void removeDevice(INDI::BaseDevice *) override {}
+        void newProperty(INDI::Property *) override {}
+        void removeProperty(INDI::Property *) override {}
+        void newSwitch(ISwitchVectorProperty *) override {}
+        void newNumber(INumberVectorProperty *) override {}
+        void newText(ITextVectorProperty *) override {}
+        void newLight(ILightVectorProperty *) override {}
+        void newMessage(INDI::BaseDevice *, int) override {}
+        void serverConnected() override {}
+        void serverDisconnected(int) override {}
+
+        template <typename Predicate>
+        bool waitFor(Predicate predicate)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            return changed.wait_for(lock, std::chrono::seconds(5), predicate);
+        }
+
+        std::mutex mutex;
+        std::condition_variable changed;
+};
+
+// Stays in newBLOB() until released, then sends a number back
+class BlockingClient : public Client
+{
+    public:
+        void newBLOB(IBLOB *) override
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            inBLOB = true;
+            changed.notify_all();
+            changed.wait(lock, [this] { return release; });
+            lock.unlock();
+
+            // Talk back to a server that is gone
+            sendNewNumber("Dev", "NUM", "V", 1);
+
+            lock.lock();
+            blobDone = true;
+            changed.notify_all();
+        }
+
+        bool inBLOB {false};
+        bool release {false};
+        bool blobDone {false};
+};
+
+// Decodes BLOB.B into one buffer it hands out every time, and keeps a copy of each BLOB it is given
+class RecordingClient : public Client
+{
+    public:
+        RecordingClient()
+        {
+            setBLOBAllocator("Dev", "BLOB", [this](IBLOB *, size_t size)
+            {
+                buffer.resize(size);
+                return static_cast<void *>(buffer.data());
+            });
+        }
+
+        void newBLOB(IBLOB *bp) override
+        {
+            std::string data(static_cast<const char *>(bp->blob), bp->size);
+            bool inBuffer = bp->blob == buffer.data();
+
+            // Give a frame that would tear this one time to arrive
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+            std::lock_guard<std::mutex> lock(mutex);
+            intact = intact && data == std::string(static_cast<const char *>(bp->blob), bp->size);
+            blobs.push_back(data);
+            streamed.push_back(inBuffer);
+            changed.notify_all();
+        }
+
+        std::vector<char> buffer;
+        int delayMs {0};
+        std::vector<std::string> blobs;
+        std::vector<bool> streamed;
+        bool intact {true};
+};
+
+static std::string base64(const std::string &data)
+{
+    std::vector<unsigned char> text(4 * ((data.size() + 2) / 3) + 1);
+    int len = to64frombits_s(text.data(), reinterpret_cast<const unsigned char *>(data.data()), data.size(), text.size());
+    return std::string(reinterpret_cast<const char *>(text.data()), len);
+}
+
+static std::string zlibCompress(const std::string &data)
+{
+    uLongf len = compressBound(data.size());
+    std::string out(len, '\0');
+    compress(reinterpret_cast<Bytef *>(&out[0]), &len, reinterpret_cast<const Bytef *>(data.data()), data.size());
+    out.resize(len);
+    return out;
+}
+
+static std::string setBLOB(const std::string &text, size_t size, const char *format)
+{
+    return "<setBLOBVector device='Dev' name='BLOB' state='Ok'><oneBLOB name='B' size='" + std::to_string(size) +
+           "' format='" + format + "'>" + text + "</oneBLOB></setBLOBVector>";
+}
+
+// As drivers send it, with the length of the text announced
+static std::string setBLOBWithLength(const std::string &text, size_t size, const char *format)
+{
+    return "<setBLOBVector device='Dev' name='BLOB' state='Ok'><oneBLOB name='B' size='" + std::to_string(size) +
+           "' enclen='" + std::to_string(4 * ((size + 2) / 3)) + "' format='" + format + "'>" + text +
+           "</oneBLOB></setBLOBVector>";
+}
+
+// Frame of len bytes that differs with seed
+static std::string frame(size_t len, int seed)
+{
+    std::string data(len, '\0');
+    for (size_t i = 0; i < len; i++)
+        data[i] = static_cast<char>(i * 7 + seed * 13 + (i >> 8));
+    return data;
+}
+
+class BaseClientTest : public ::testing::Test
+{
+    protected:
+        void connect(Client &client, int workers = 0)
+        {
+            signal(SIGPIPE, SIG_IGN);
+            client.setServer("127.0.0.1", server.port);
+            client.setBLOBDecodeWorkers(workers);
+            ASSERT_TRUE(client.connectServer());
+            server.accept();
+            server.send(DEFINITIONS);
+
+            // BLOBs are only streamed to the allocator once their property is known
+            for (int i = 0; i < 500 && !defined(client); i++)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            ASSERT_TRUE(defined(client));
+        }
+
+        static bool defined(Client &client)
+        {
+            INDI::BaseDevice *device = client.getDevice("Dev");
+            return device != nullptr && device->getBLOB("BLOB") != nullptr;
+        }
+
+        FakeServer server;
+};
+
+TEST_F(BaseClientTest, Test_disconnect_during_newBLOB)
+{
+    BlockingClient client;
+    connect(client, 1);
+    server.send(SET_BLOB);
+
+    ASSERT_TRUE(client.waitFor([&] { return client.inBLOB; }));
+
+    // The reading thread tears the connection down while the worker is still in newBLOB()
+    server.hangUp();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        std::lock_guard<std::mutex> lock(client.mutex);
+        client.release = true;
+    }
+    client.changed.notify_all();
+
+    bool done = client.waitFor([&] { return client.blobDone; });
+    for (int i = 0; i < 500 && client.isServerConnected(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (!done || client.isServerConnected())
+    {
+        ADD_FAILURE() << "Client deadlocked tearing down the connection";
+        // Destroying the client would hang as well
+        std::_Exit(EXIT_FAILURE);
+    }
+}
+
+TEST_F(BaseClientTest, Test_stream_split_groups)
+{
+    RecordingClient client;
+    connect(client);
+
+    // 1 to 7 byte pieces cut the groups everywhere, line breaks as indiserver sends them
+    std::string data = frame(300, 1);
+    std::string text = base64(data);
+    for (size_t i = 72; i < text.size(); i += 73)
+        text.insert(i, "\n");
+    for (size_t chunk = 1; chunk <= 7; chunk++)
+        server.sendSplit(setBLOB(text, data.size(), ".bin"), chunk);
+
+    ASSERT_TRUE(client.waitFor([&] { return client.blobs.size() == 7; }));
+    for (size_t i = 0; i < client.blobs.size(); i++)
+    {
+        EXPECT_EQ(client.blobs[i], data) << "chunk " << i + 1;
+        EXPECT_TRUE(client.streamed[i]);
+    }
+}
+
+TEST_F(BaseClientTest, Test_stream_compressed)
+{
+    RecordingClient client;
+    connect(client);
+
+    std::string data = frame(100000, 2);
+    std::string text = base64(zlibCompress(data));
+    server.send(setBLOB(text, data.size(), ".bin.z"));
+    server.sendSplit(setBLOB(text, data.size(), ".bin.z"), 1000);
+
+    ASSERT_TRUE(client.waitFor([&] { return client.blobs.size() == 2; }));
+    EXPECT_EQ(client.blobs[0], data);
+    EXPECT_EQ(client.blobs[1], data);
+    EXPECT_TRUE(client.streamed[0]);
+}
+
+TEST_F(BaseClientTest, Test_stream_overrun)
+{
+    RecordingClient client;
+    connect(client);
+
+    // More data than announced is refused, plain or compressed, and the next BLOB is fine
+    std::string data = frame(3000, 3);
+    server.sendAlone(setBLOB(base64(data), 1000, ".bin"));
+    server.sendAlone(setBLOB(base64(zlibCompress(data)), 1000, ".bin.z"));
+    server.sendAlone(setBLOB(base64(data), data.size(), ".bin"));
+
+    ASSERT_TRUE(client.waitFor([&] { return client.blobs.size() == 1; }));
+    EXPECT_EQ(client.blobs[0], data);
+    EXPECT_TRUE(client.streamed[0]);
+}
+
+TEST_F(BaseClientTest, Test_stream_enclen)
+{
+    RecordingClient client;
+    connect(client);
+
+    // The announced length must not make the parser keep the text to itself
+    std::string data = frame(20000, 5);
+    std::string text = base64(data);
+    for (size_t i = 72; i < text.size(); i += 73)
+        text.insert(i, "\n");
+    server.sendAlone(setBLOBWithLength(text, data.size(), ".bin"));
+    server.sendSplit(setBLOBWithLength(text, data.size(), ".bin"), 1000);
+
+    ASSERT_TRUE(client.waitFor([&] { return client.blobs.size() == 2; }));
+    EXPECT_EQ(client.blobs[0], data);
+    EXPECT_EQ(client.blobs[1], data);
+    EXPECT_TRUE(client.streamed[0]);
+    EXPECT_TRUE(client.streamed[1]);
+}
+
+TEST_F(BaseClientTest, Test_stream_short)
+{
+    RecordingClient client;
+    connect(client);
+
+    // Less data than announced is refused too, and the next BLOB is fine
+    std::string data = frame(3000, 6);
+    server.sendAlone(setBLOB(base64(data), data.size() + 1000, ".bin"));
+    server.sendSplit(setBLOBWithLength(base64(data), data.size() + 1000, ".bin"), 500);
+    server.sendAlone(setBLOB(base64(data).substr(0, 2001), data.size(), ".bin"));
+    server.sendAlone(setBLOB(base64(data), data.size(), ".bin"));
+
+    ASSERT_TRUE(client.waitFor([&] { return !client.blobs.empty(); }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(client.blobs.size(), 1u);
+    EXPECT_EQ(client.blobs[0], data);
+    EXPECT_TRUE(client.streamed[0]);
+}
+
+TEST_F(BaseClientTest, Test_stream_malformed)
+{
+    RecordingClient client;
+    connect(client);
+
+    std::string data = frame(5000, 4);
+    std::string compressed = zlibCompress(data);
+
+    // Not a zlib stream, a stream cut short, and text that is not base64
+    server.sendAlone(setBLOB(base64(data), data.size(), ".bin.z"));
+    server.sendAlone(setBLOB(base64(compressed.substr(0, compressed.size() / 2)), data.size(), ".bin.z"));
+    server.sendAlone(setBLOB(std::string(4000, '!') + "@@@", data.size(), ".bin"));
+    server.sendAlone(setBLOB(base64(data), data.size(), ".bin"));
+
+    // The garbage text may be delivered as whatever it decodes to, but none of it reaches past the buffer
+    ASSERT_TRUE(client.waitFor([&] { return !client.blobs.empty() && client.blobs.back() == data; }));
+    EXPECT_LE(client.blobs.size(), 2u);
+    EXPECT_TRUE(client.streamed.back());
+}
+
+TEST_F(BaseClientTest, Test_stream_same_chunk)
+{
+    RecordingClient client;
+    connect(client);
+
+    // Vectors are dispatched after the whole chunk is parsed: only the first may use the shared buffer
+    std::vector<std::string> frames;
+    std::string xml;
+    for (int i = 0; i < 3; i++)
+    {
+        frames.push_back(frame(2000, 20 + i));
+        xml += setBLOB(base64(frames.back()), frames.back().size(), ".bin");
+    }
+    server.send(xml);
+
+    ASSERT_TRUE(client.waitFor([&] { return client.blobs.size() == frames.size(); }));
+    EXPECT_EQ(client.blobs, frames);
+}
+
+TEST_F(BaseClientTest, Test_stream_reuse_with_workers)
+{
+    RecordingClient client;
+    client.delayMs = 50;
+    connect(client, 2);
+
+    // Every frame goes to the same buffer, each must stay intact while its newBLOB() runs
+    std::vector<std::string> frames;
+    for (int i = 0; i < 4; i++)
+    {
+        frames.push_back(frame(20000, 10 + i));
+        server.sendAlone(setBLOB(base64(frames.back()), frames.back().size(), ".bin"));
+    }
+
+    ASSERT_TRUE(client.waitFor([&] { return client.blobs.size() == frames.size(); }));
+    EXPECT_TRUE(client.intact);
+    EXPECT_EQ(client.blobs, frames);
+    EXPECT_EQ(client.streamed, std::vector<bool>(frames.size(), true));
+}
@@ -0,0 +1,148 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "basedevice.h"
+#include "defaultdevice.h"
+#include "indidevapi.h"
+
+struct NumberVector
+{
+    NumberVector(const char *name)
+    {
+        IUFillNumber(&number, "V", "V", "%g", 0, 10, 1, 0);
+        IUFillNumberVector(&vector, &number, 1, "Dev", name, name, "", IP_RW, 0, IPS_IDLE);
+    }
+
+    INumber number;
+    INumberVectorProperty vector;
+};
+
+TEST(CORE_BASEDEVICE, Test_index_add_remove)
+{
+    INDI::BaseDevice device;
+    NumberVector a("A"), b("B"), again("A");
+    char errmsg[MAXRBUF];
+
+    device.registerProperty(&a.vector);
+    device.registerProperty(&b.vector);
+    EXPECT_EQ(device.getProperty("A").getProperty(), &a.vector);
+    EXPECT_EQ(device.getProperty("B", INDI_NUMBER).getProperty(), &b.vector);
+    EXPECT_FALSE(device.getProperty("B", INDI_SWITCH).isValid());
+    EXPECT_FALSE(device.getProperty("C").isValid());
+
+    EXPECT_EQ(device.removeProperty("A", errmsg), 0);
+    EXPECT_FALSE(device.getProperty("A").isValid());
+    EXPECT_EQ(device.getProperty("B").getProperty(), &b.vector);
+    EXPECT_NE(device.removeProperty("A", errmsg), 0);
+
+    device.registerProperty(&again.vector);
+    EXPECT_EQ(device.getProperty("A").getProperty(), &again.vector);
+    EXPECT_EQ(device.getProperties().size(), 2u);
+}
+
+TEST(CORE_BASEDEVICE, Test_index_same_name)
+{
+    INDI::BaseDevice device;
+    NumberVector number("X");
+    ISwitch one;
+    ISwitchVectorProperty switches;
+    IUFillSwitch(&one, "S", "S", ISS_OFF);
+    IUFillSwitchVector(&switches, &one, 1, "Dev", "X", "X", "", IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
+    device.registerProperty(&number.vector);
+    device.registerProperty(&switches);
+    EXPECT_EQ(device.getProperty("X").getProperty(), &number.vector);
+    EXPECT_EQ(device.getProperty("X", INDI_SWITCH).getProperty(), &switches);
+}
+
+TEST(CORE_BASEDEVICE, Test_index_behind_back)
+{
+    INDI::BaseDevice device;
+    NumberVector a("A"), b("B");
+    char errmsg[MAXRBUF];
+
+    // The list is shared, so it can grow without the device knowing
+    device.registerProperty(&a.vector);
+    device.getProperties().push_back(INDI::Property(&b.vector));
+    EXPECT_EQ(device.getProperty("B").getProperty(), &b.vector);
+
+    EXPECT_EQ(device.removeProperty("B", errmsg), 0);
+    EXPECT_FALSE(device.getProperty("B").isValid());
+    EXPECT_EQ(device.getProperty("A").getProperty(), &a.vector);
+}
+
+class DispatchDevice : public INDI::DefaultDevice
+{
+    public:
+        DispatchDevice()
+        {
+            setDeviceName("Dev");
+        }
+
+        const char *getDefaultName() override
+        {
+            return "Dev";
+        }
+
+        bool ISNewNumber(const char *, const char *name, double[], char *[], int) override
+        {
+            received.push_back(name);
+            return true;
+        }
+
+        std::vector<std::string> received;
+};
+
+TEST(CORE_BASEDEVICE, Test_dispatch_update)
+{
+    DispatchDevice device;
+    NumberVector handled("HANDLED"), plain("PLAIN");
+    device.defineProperty(&handled.vector);
+    device.defineProperty(&plain.vector);
+
+    int updates = 0;
+    device.getProperty("HANDLED").onUpdate([&updates]
+    {
+        updates++;
+    });
+
+    double values[] = { 5 };
+    char name[] = "V";
+    char *names[] = { name };
+
+    // Straight to the callback, with the values already in the property
+    ::ISNewNumber("Dev", "HANDLED", values, names, 1);
+    EXPECT_EQ(updates, 1);
+    EXPECT_EQ(handled.number.value, 5);
+    EXPECT_TRUE(device.received.empty());
+
+    // Out of range, the update fails and the callback is not called
+    values[0] = 50;
+    ::ISNewNumber("Dev", "HANDLED", values, names, 1);
+    EXPECT_EQ(updates, 1);
+    EXPECT_EQ(handled.number.value, 5);
+
+    // Everything else still goes to ISNewNumber()
+    ::ISNewNumber("Dev", "PLAIN", values, names, 1);
+    ::ISNewNumber("Dev", "MISSING", values, names, 1);
+    EXPECT_EQ(updates, 1);
+    EXPECT_EQ(device.received, std::vector<std::string>({ "PLAIN", "MISSING" }));
+}
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "indibinning.h"
+
+template <typename Pixel>
+static std::vector<Pixel> makeFrame(uint32_t width, uint32_t height, uint32_t maxValue)
+{
+    std::vector<Pixel> frame(static_cast<size_t>(width) * height);
+    srand(width * height);
+    for (auto &pixel : frame)
+        pixel = static_cast<Pixel>(rand() % (maxValue + 1));
+    return frame;
+}
+
+// Straightforward binning, one output pixel at a time
+template <typename Pixel>
+static std::vector<Pixel> referenceBin(const std::vector<Pixel> &src, uint32_t width, uint32_t height, uint32_t binX,
+                                       uint32_t binY, INDI::BinningMode mode, bool bayer)
+{
+    uint32_t outWidth = width / binX, outHeight = height / binY;
+    uint32_t step = bayer ? 2 : 1;
+    std::vector<Pixel> dst(static_cast<size_t>(outWidth) * outHeight);
+
+    for (uint32_t oy = 0; oy < outHeight; oy++)
+        for (uint32_t ox = 0; ox < outWidth; ox++)
+        {
+            uint32_t y0 = bayer ? (oy / 2) * 2 * binY + oy % 2 : oy * binY;
+            uint32_t x0 = bayer ? (ox / 2) * 2 * binX + ox % 2 : ox * binX;
+            double sum = 0;
+            uint32_t n = 0;
+            for (uint32_t k = 0, y = y0; k < binY && y < height; k++, y += step)
+                for (uint32_t l = 0, x = x0; l < binX && x < width; l++, x += step, n++)
+                    sum += src[static_cast<size_t>(y) * width + x];
+
+            double value;
+            if (mode == INDI::BINNING_MEAN)
+                value = std::numeric_limits<Pixel>::is_integer ? static_cast<uint64_t>(sum + n / 2) / n : sum / n;
+            else
+                value = std::min<double>(sum, std::numeric_limits<Pixel>::max());
+            dst[static_cast<size_t>(oy) * outWidth + ox] = static_cast<Pixel>(value);
+        }
+    return dst;
+}
+
+template <typename Pixel>
+static void checkBinning(int bitpix, uint32_t maxValue)
+{
+    const uint32_t sizes[][2] = { {64, 48}, {97, 61}, {1001, 33}, {5, 3} };
+    const uint32_t bins[][2]  = { {1, 1}, {2, 2}, {3, 3}, {4, 4}, {2, 1}, {1, 3}, {3, 2}, {5, 4} };
+
+    for (auto &size : sizes)
+    {
+        auto frame = makeFrame<Pixel>(size[0], size[1], maxValue);
+        for (auto &bin : bins)
+            for (auto mode : {INDI::BINNING_SUM, INDI::BINNING_MEAN})
+                for (bool bayer : {false, true})
+                {
+                    if (bin[0] > size[0] || bin[1] > size[1])
+                        continue;
+
+                    auto expected = referenceBin(frame, size[0], size[1], bin[0], bin[1], mode, bayer);
+                    std::vector<Pixel> binned(expected.size());
+                    ASSERT_TRUE(INDI::binFrame(frame.data(), binned.data(), size[0], size[1], bitpix, bin[0], bin[1], mode,
+                                               bayer));
+                    for (size_t i = 0; i < expected.size(); i++)
+                        ASSERT_FLOAT_EQ(expected[i], binned[i]) << "bitpix " << bitpix << " size " << size[0] << "x" << size[1]
+                                << " bin " << bin[0] << "x" << bin[1] << " mode " << mode << " bayer " << bayer
+                                << " pixel " << i;
+                }
+    }
+}
+
+TEST(CORE_BINNING, Test_8bit)
+{
+    checkBinning<uint8_t>(8, UINT8_MAX);
+}
+
+TEST(CORE_BINNING, Test_16bit)
+{
+    checkBinning<uint16_t>(16, UINT16_MAX);
+}
+
+TEST(CORE_BINNING, Test_32bit)
+{
+    checkBinning<uint32_t>(32, 1000000);
+}
+
+TEST(CORE_BINNING, Test_float)
+{
+    checkBinning<float>(-32, 1000);
+}
+
+TEST(CORE_BINNING, Test_saturation)
+{
+    std::vector<uint16_t> frame(16 * 16, 40000);
+    std::vector<uint16_t> binned(4 * 4);
+
+    ASSERT_TRUE(INDI::binFrame(frame.data(), binned.data(), 16, 16, 16, 4, 4, INDI::BINNING_SUM));
+    for (auto pixel : binned)
+        ASSERT_EQ(pixel, UINT16_MAX);
+
+    ASSERT_TRUE(INDI::binFrame(frame.data(), binned.data(), 16, 16, 16, 4, 4, INDI::BINNING_MEAN));
+    for (auto pixel : binned)
+        ASSERT_EQ(pixel, 40000);
+}
+
+// Each binned pixel of a Bayer frame only has pixels of its own color
+TEST(CORE_BINNING, Test_bayer_pattern)
+{
+    const uint8_t colors[2][2] = { {10, 20}, {30, 40} };
+    std::vector<uint8_t> frame(24 * 18);
+    for (uint32_t y = 0; y < 18; y++)
+        for (uint32_t x = 0; x < 24; x++)
+            frame[y * 24 + x] = colors[y % 2][x % 2];
+
+    std::vector<uint8_t> binned(8 * 6);
+    ASSERT_TRUE(INDI::binFrame(frame.data(), binned.data(), 24, 18, 8, 3, 3, INDI::BINNING_MEAN, true));
+    for (uint32_t y = 0; y < 6; y++)
+        for (uint32_t x = 0; x < 8; x++)
+            ASSERT_EQ(binned[y * 8 + x], colors[y % 2][x % 2]);
+}
+
+// Each 2x2 cell of a Bayer frame becomes one RGB pixel, whatever the order of its colors
+TEST(CORE_BINNING, Test_super_pixel)
+{
+    const uint32_t width = 2000, height = 1002;
+    for (const char *pattern : {"RGGB", "BGGR", "GRBG", "GBRG"})
+    {
+        std::vector<uint16_t> frame(width * height);
+        for (uint32_t y = 0; y < height; y++)
+            for (uint32_t x = 0; x < width; x++)
+            {
+                // Red and blue by cell, the greens differ within a cell
+                char color = pattern[(y % 2) * 2 + x % 2];
+                uint16_t cell = ((y / 2) * (width / 2) + x / 2) % 60000;
+                frame[y * width + x] = color == 'R' ? cell : color == 'B' ? cell + 7 : cell + 2 + (y % 2) * 3;
+            }
+
+        std::vector<uint16_t> rgb(3 * (width / 2) * (height / 2));
+        ASSERT_TRUE(INDI::superPixelFrame(frame.data(), rgb.data(), width, height, 16, pattern));
+
+        const size_t plane = (width / 2) * (height / 2);
+        for (size_t i = 0; i < plane; i++)
+        {
+            uint16_t cell = i % 60000;
+            ASSERT_EQ(rgb[i], cell) << pattern << " pixel " << i;
+            ASSERT_EQ(rgb[plane + i], static_cast<uint16_t>(cell + 4)) << pattern << " pixel " << i;
+            ASSERT_EQ(rgb[2 * plane + i], static_cast<uint16_t>(cell + 7)) << pattern << " pixel " << i;
+        }
+    }
+
+    float pixels[4] = { 1, 2, 3, 4 }, out[3];
+    ASSERT_TRUE(INDI::superPixelFrame(pixels, out, 2, 2, -32, "RGGB"));
+    EXPECT_FLOAT_EQ(out[0], 1);
+    EXPECT_FLOAT_EQ(out[1], 2.5);
+    EXPECT_FLOAT_EQ(out[2], 4);
+}
+
+TEST(CORE_BINNING, Test_invalid)
+{
+    uint16_t pixel = 0;
+    EXPECT_FALSE(INDI::binFrame(&pixel, &pixel, 1, 1, 16, 0, 1, INDI::BINNING_SUM));
+    EXPECT_FALSE(INDI::binFrame(&pixel, &pixel, 1, 1, 64, 1, 1, INDI::BINNING_SUM));
+    EXPECT_FALSE(INDI::superPixelFrame(&pixel, &pixel, 2, 2, 16, "RGGG"));
+    EXPECT_FALSE(INDI::superPixelFrame(&pixel, &pixel, 2, 2, 16, "RGB"));
+    EXPECT_FALSE(INDI::superPixelFrame(&pixel, &pixel, 2, 2, 64, "RGGB"));
+}
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "indiblockcompress.h"
+
+// Something between noise and a flat field, like a real frame
+static std::vector<uint8_t> makeFrame(size_t len)
+{
+    std::vector<uint8_t> frame(len);
+    srand(len);
+    for (size_t i = 0; i < len; i++)
+        frame[i] = (i / 7 + (rand() & 3)) & 0xff;
+    return frame;
+}
+
+static std::vector<uint8_t> compress(const std::vector<uint8_t> &frame, int level)
+{
+    std::vector<uint8_t> out(INDI::blockCompressBound(frame.size()));
+    size_t len = out.size();
+    EXPECT_EQ(INDI::blockCompress(out.data(), &len, frame.data(), frame.size(), level), Z_OK);
+    out.resize(len);
+    return out;
+}
+
+TEST(CORE_BLOCKCOMPRESS, Test_roundtrip)
+{
+    for (size_t len : {0, 1, 100, 512 * 1024 - 1, 512 * 1024, 512 * 1024 + 1, 3 * 512 * 1024 + 5})
+    {
+        auto frame = makeFrame(len);
+        for (int level : {1, 4, 9})
+        {
+            auto packed = compress(frame, level);
+
+            std::vector<uint8_t> unpacked(len + 16);
+            size_t unpackedLen = unpacked.size();
+            ASSERT_EQ(INDI::blockUncompress(unpacked.data(), &unpackedLen, packed.data(), packed.size()), Z_OK);
+            ASSERT_EQ(unpackedLen, len);
+            ASSERT_EQ(memcmp(unpacked.data(), frame.data(), len), 0) << "len " << len << " level " << level;
+        }
+    }
+}
+
+// Clients using plain zlib must still read compressed BLOBs
+TEST(CORE_BLOCKCOMPRESS, Test_zlib_compatible)
+{
+    auto frame  = makeFrame(2 * 1024 * 1024 + 3);
+    auto packed = compress(frame, 4);
+
+    std::vector<uint8_t> unpacked(frame.size());
+    uLongf unpackedLen = unpacked.size();
+    ASSERT_EQ(uncompress(unpacked.data(), &unpackedLen, packed.data(), packed.size()), Z_OK);
+    ASSERT_EQ(unpackedLen, frame.size());
+    ASSERT_EQ(memcmp(unpacked.data(), frame.data(), frame.size()), 0);
+
+    // and the other way around, from older drivers
+    std::vector<uint8_t> plain(compressBound(frame.size()));
+    uLongf plainLen = plain.size();
+    ASSERT_EQ(compress2(plain.data(), &plainLen, frame.data(), frame.size(), 9), Z_OK);
+
+    size_t len = unpacked.size();
+    memset(unpacked.data(), 0, len);
+    ASSERT_EQ(INDI::blockUncompress(unpacked.data(), &len, plain.data(), plainLen), Z_OK);
+    ASSERT_EQ(len, frame.size());
+    ASSERT_EQ(memcmp(unpacked.data(), frame.data(), frame.size()), 0);
+}
+
+TEST(CORE_BLOCKCOMPRESS, Test_errors)
+{
+    auto frame  = makeFrame(1024 * 1024 + 7);
+    auto packed = compress(frame, 4);
+
+    // too small an output buffer
+    std::vector<uint8_t> unpacked(frame.size());
+    size_t len = frame.size() - 1;
+    EXPECT_NE(INDI::blockUncompress(unpacked.data(), &len, packed.data(), packed.size()), Z_OK);
+
+    // damaged data
+    packed[packed.size() / 2] ^= 0x55;
+    len = unpacked.size();
+    EXPECT_NE(INDI::blockUncompress(unpacked.data(), &len, packed.data(), packed.size()), Z_OK);
+}
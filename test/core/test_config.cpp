@@ -0,0 +1,302 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "defaultdevice.h"
+#include "indidriver.h"
+
+static std::string numberVector(const char *dev, const char *name, double value)
+{
+    char xml[256];
+    snprintf(xml, sizeof(xml),
+             "<newNumberVector device='%s' name='%s'>\n<oneNumber name='V'>%g</oneNumber>\n</newNumberVector>\n",
+             dev, name, value);
+    return xml;
+}
+
+static std::string config(double value)
+{
+    return "<INDIDriver>\n" +
+           numberVector("Dev", "NUM", value) +
+           numberVector("Other", "NUM", 2) +
+           "<newSwitchVector device='Dev' name='SW'>\n"
+           "<oneSwitch name='A'>Off</oneSwitch>\n<oneSwitch name='B'>On</oneSwitch>\n</newSwitchVector>\n"
+           "<newTextVector device='Dev' name='TXT'>\n<oneText name='T'>hello</oneText>\n</newTextVector>\n"
+           "</INDIDriver>\n";
+}
+
+// Dev, which looks its own config up and saves it again from ISNewNumber()
+class ConfigDevice : public INDI::DefaultDevice
+{
+    public:
+        ConfigDevice()
+        {
+            setDeviceName("Dev");
+            // Only defined properties are dispatched
+            IUFillNumber(&number, "V", "V", "%g", 0, 10, 1, 0);
+            IUFillNumberVector(&numberVector, &number, 1, "Dev", "NUM", "NUM", "", IP_RW, 0, IPS_IDLE);
+            IDDefNumber(&numberVector, nullptr);
+        }
+
+        const char *getDefaultName() override
+        {
+            return "Dev";
+        }
+
+        bool ISNewNumber(const char *, const char *name, double values[], char *names[], int n) override
+        {
+            for (int i = 0; i < n; i++)
+                received.push_back(std::string(name) + "." + names[i] + "=" + std::to_string(values[i]));
+
+            double value = 0;
+            lookedUp = IUGetConfigNumber("Dev", "NUM", "V", &value) == 0 ? value : -1;
+
+            if (!saveFrom.empty())
+            {
+                char errmsg[MAXRBUF];
+                FILE *fp = IUBeginConfigSave(nullptr, "Dev", errmsg);
+                fputs(saveFrom.c_str(), fp);
+                saved = IUEndConfigSave(fp, nullptr, "Dev", errmsg);
+            }
+            return true;
+        }
+
+        INumber number;
+        INumberVectorProperty numberVector;
+        std::vector<std::string> received;
+        double lookedUp {0};
+        std::string saveFrom;
+        int saved {1};
+};
+
+class ConfigTest : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            char dir[] = "/tmp/indi_config_XXXXXX";
+            ASSERT_NE(mkdtemp(dir), nullptr);
+            home = dir;
+            path = home + "/Dev_config.xml";
+            setenv("HOME", home.c_str(), 1);
+            setenv("INDICONFIG", path.c_str(), 1);
+        }
+
+        void TearDown() override
+        {
+            remove(path.c_str());
+            remove((path + ".tmp").c_str());
+            rmdir((home + "/.indi").c_str());
+            rmdir(home.c_str());
+        }
+
+        // Write the file behind the back of the cache, with the given modification time
+        void write(const std::string &xml, time_t sec, long nsec)
+        {
+            FILE *fp = fopen(path.c_str(), "r+");
+            if (fp == nullptr)
+                fp = fopen(path.c_str(), "w");
+            ASSERT_NE(fp, nullptr);
+            fputs(xml.c_str(), fp);
+            fclose(fp);
+
+            struct timespec times[2] = { { sec, nsec }, { sec, nsec } };
+            ASSERT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+        }
+
+        std::string read(const std::string &name)
+        {
+            std::string text;
+            FILE *fp = fopen(name.c_str(), "r");
+            if (fp == nullptr)
+                return text;
+            char buffer[256];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+                text.append(buffer, n);
+            fclose(fp);
+            return text;
+        }
+
+        static double number(const char *dev, const char *property)
+        {
+            double value = -1;
+            return IUGetConfigNumber(dev, property, "V", &value) == 0 ? value : -1;
+        }
+
+        std::string home;
+        std::string path;
+};
+
+TEST_F(ConfigTest, Test_find)
+{
+    write(config(1), 1000000000, 0);
+
+    EXPECT_EQ(number("Dev", "NUM"), 1);
+    EXPECT_EQ(number("Other", "NUM"), 2);
+    EXPECT_EQ(number("Dev", "MISSING"), -1);
+    EXPECT_EQ(number("Missing", "NUM"), -1);
+
+    ISState state = ISS_OFF;
+    EXPECT_EQ(IUGetConfigSwitch("Dev", "SW", "B", &state), 0);
+    EXPECT_EQ(state, ISS_ON);
+    EXPECT_EQ(IUGetConfigSwitch("Dev", "SW", "C", &state), -1);
+
+    int index = -1;
+    EXPECT_EQ(IUGetConfigOnSwitchIndex("Dev", "SW", &index), 0);
+    EXPECT_EQ(index, 1);
+
+    char text[16] = "";
+    EXPECT_EQ(IUGetConfigText("Dev", "TXT", "T", text, sizeof(text)), 0);
+    EXPECT_STREQ(text, "hello");
+}
+
+TEST_F(ConfigTest, Test_find_after_change)
+{
+    // Same inode, size and second: only the nanoseconds tell the files apart
+    write(config(1), 1000000000, 100);
+    EXPECT_EQ(number("Dev", "NUM"), 1);
+
+    write(config(3), 1000000000, 200);
+    EXPECT_EQ(number("Dev", "NUM"), 3);
+
+    remove(path.c_str());
+    EXPECT_EQ(number("Dev", "NUM"), -1);
+}
+
+TEST_F(ConfigTest, Test_read_dispatches_copy)
+{
+    write(config(1), 1000000000, 0);
+
+    // The device replaces the file, and with it the cached tree, while the property is dispatched
+    ConfigDevice device;
+    device.saveFrom = config(5);
+    char errmsg[MAXRBUF];
+    ASSERT_EQ(IUReadConfig(nullptr, "Dev", "NUM", 1, errmsg), 0);
+
+    ASSERT_EQ(device.received.size(), 1u);
+    EXPECT_EQ(device.received[0], "NUM.V=" + std::to_string(1.0));
+    EXPECT_EQ(device.lookedUp, 1);
+    EXPECT_EQ(device.saved, 0);
+    EXPECT_EQ(number("Dev", "NUM"), 5);
+}
+
+TEST_F(ConfigTest, Test_save)
+{
+    write(config(1), 1000000000, 0);
+    EXPECT_EQ(number("Dev", "NUM"), 1);
+
+    char errmsg[MAXRBUF];
+    FILE *fp = IUBeginConfigSave(nullptr, "Dev", errmsg);
+    ASSERT_NE(fp, nullptr) << errmsg;
+    fputs(config(7).c_str(), fp);
+    fflush(fp);
+
+    // Nothing replaces the configuration until the save is complete
+    EXPECT_EQ(read(path), config(1));
+    EXPECT_EQ(read(path + ".tmp"), config(7));
+    EXPECT_EQ(number("Dev", "NUM"), 1);
+
+    struct stat before;
+    ASSERT_EQ(stat((path + ".tmp").c_str(), &before), 0);
+    ASSERT_EQ(IUEndConfigSave(fp, nullptr, "Dev", errmsg), 0) << errmsg;
+
+    // Renamed over the old file, not copied
+    struct stat after;
+    ASSERT_EQ(stat(path.c_str(), &after), 0);
+    EXPECT_EQ(after.st_ino, before.st_ino);
+    EXPECT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+    EXPECT_EQ(read(path), config(7));
+    EXPECT_EQ(number("Dev", "NUM"), 7);
+}
+
+TEST_F(ConfigTest, Test_save_keeps_mode)
+{
+    write(config(1), 1000000000, 0);
+    ASSERT_EQ(chmod(path.c_str(), S_IRUSR | S_IWUSR), 0);
+
+    char errmsg[MAXRBUF];
+    FILE *fp = IUBeginConfigSave(nullptr, "Dev", errmsg);
+    ASSERT_NE(fp, nullptr) << errmsg;
+    fputs(config(7).c_str(), fp);
+    ASSERT_EQ(IUEndConfigSave(fp, nullptr, "Dev", errmsg), 0) << errmsg;
+
+    struct stat st;
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 07777, static_cast<mode_t>(S_IRUSR | S_IWUSR));
+    EXPECT_EQ(number("Dev", "NUM"), 7);
+}
+
+TEST_F(ConfigTest, Test_save_symlink)
+{
+    // The configuration lives somewhere else, the usual path links to it
+    std::string real = home + "/real_config.xml";
+    FILE *fp = fopen(real.c_str(), "w");
+    ASSERT_NE(fp, nullptr);
+    fputs(config(1).c_str(), fp);
+    fclose(fp);
+    ASSERT_EQ(symlink(real.c_str(), path.c_str()), 0);
+    EXPECT_EQ(number("Dev", "NUM"), 1);
+
+    char errmsg[MAXRBUF];
+    fp = IUBeginConfigSave(nullptr, "Dev", errmsg);
+    ASSERT_NE(fp, nullptr) << errmsg;
+    fputs(config(7).c_str(), fp);
+    fflush(fp);
+    EXPECT_EQ(read(real + ".tmp"), config(7));
+    ASSERT_EQ(IUEndConfigSave(fp, nullptr, "Dev", errmsg), 0) << errmsg;
+
+    struct stat st;
+    ASSERT_EQ(lstat(path.c_str(), &st), 0);
+    EXPECT_TRUE(S_ISLNK(st.st_mode));
+    EXPECT_EQ(read(real), config(7));
+    EXPECT_NE(access((real + ".tmp").c_str(), F_OK), 0);
+    EXPECT_EQ(number("Dev", "NUM"), 7);
+
+    remove(real.c_str());
+}
+
+TEST_F(ConfigTest, Test_save_failed)
+{
+    write(config(1), 1000000000, 0);
+
+    char errmsg[MAXRBUF];
+    FILE *fp = IUBeginConfigSave(nullptr, "Dev", errmsg);
+    ASSERT_NE(fp, nullptr) << errmsg;
+    fputs(config(7).c_str(), fp);
+
+    // A configuration file that cannot be replaced
+    remove(path.c_str());
+    ASSERT_EQ(mkdir(path.c_str(), S_IRWXU), 0);
+    mkdir((path + "/keep").c_str(), S_IRWXU);
+
+    EXPECT_EQ(IUEndConfigSave(fp, nullptr, "Dev", errmsg), -1);
+    EXPECT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+
+    rmdir((path + "/keep").c_str());
+    rmdir(path.c_str());
+}
@@ -0,0 +1,186 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+#include <vector>
+
+#include "eventloop.h"
+
+static std::vector<int> fired;
+
+static void recordTimer(void *ud)
+{
+    fired.push_back(static_cast<int>(reinterpret_cast<intptr_t>(ud)));
+}
+
+static void setFlag(void *ud)
+{
+    *static_cast<int *>(ud) = 1;
+}
+
+// Run the loop for ms, timers added so far with a shorter delay fire
+static void runFor(int ms)
+{
+    int done = 0;
+    addTimer(ms, setFlag, &done);
+    deferLoop(0, &done);
+}
+
+TEST(CORE_EVENTLOOP, Test_order)
+{
+    const int delays[] = { 30, 10, 20, 10, 0, 30, 5, 20 };
+    fired.clear();
+    for (size_t i = 0; i < sizeof(delays) / sizeof(delays[0]); i++)
+        addTimer(delays[i], recordTimer, reinterpret_cast<void *>(i));
+    runFor(60);
+
+    // By delay, same delays in the order they were added
+    std::vector<int> expected = { 4, 6, 1, 3, 2, 7, 0, 5 };
+    EXPECT_EQ(fired, expected);
+}
+
+TEST(CORE_EVENTLOOP, Test_remove)
+{
+    const int count = 1000;
+    std::vector<int> ids;
+    fired.clear();
+    for (int i = 0; i < count; i++)
+        ids.push_back(addTimer(i % 20, recordTimer, reinterpret_cast<void *>(static_cast<intptr_t>(i))));
+
+    // Remove the odd ones, the even ones must all fire and nothing else
+    for (int i = 1; i < count; i += 2)
+    {
+        rmTimer(ids[i]);
+        EXPECT_EQ(remainingTimer(ids[i]), -1);
+    }
+    rmTimer(ids[1]);
+
+    // One not due yet reports its time left
+    int pending = addTimer(1000, recordTimer, nullptr);
+    EXPECT_GT(remainingTimer(pending), 0);
+    rmTimer(pending);
+    EXPECT_EQ(remainingTimer(pending), -1);
+
+    runFor(40);
+    ASSERT_EQ(fired.size(), size_t(count / 2));
+    for (int id : fired)
+        EXPECT_EQ(id % 2, 0);
+    EXPECT_EQ(remainingTimer(ids[0]), -1);
+}
+
+static int periodicId;
+static int periodicCount;
+
+static void periodicTimer(void *)
+{
+    if (++periodicCount == 5)
+        rmTimer(periodicId);
+    // Timers added from a timer get the entry of the removed one
+    addTimer(1000, recordTimer, nullptr);
+}
+
+TEST(CORE_EVENTLOOP, Test_periodic)
+{
+    fired.clear();
+    periodicCount = 0;
+    periodicId = addPeriodicTimer(2, periodicTimer, nullptr);
+    runFor(30);
+    EXPECT_EQ(periodicCount, 5);
+    EXPECT_EQ(remainingTimer(periodicId), -1);
+}
+
+static void readByte(int fd, void *ud)
+{
+    char c;
+    if (read(fd, &c, 1) == 1)
+        ++*static_cast<int *>(ud);
+}
+
+TEST(CORE_EVENTLOOP, Test_callback)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    int received = 0;
+    int cid = addCallback(fds[0], readByte, &received);
+    ASSERT_EQ(write(fds[1], "ab", 2), 2);
+    runFor(10);
+    EXPECT_EQ(received, 2);
+
+    // No longer called once removed
+    rmCallback(cid);
+    ASSERT_EQ(write(fds[1], "c", 1), 1);
+    runFor(10);
+    EXPECT_EQ(received, 2);
+
+    // Regular files are always ready
+    FILE *file = tmpfile();
+    ASSERT_NE(file, nullptr);
+    fputs("xyz", file);
+    fflush(file);
+    rewind(file);
+    int fromFile = 0;
+    cid = addCallback(fileno(file), readByte, &fromFile);
+    runFor(10);
+    rmCallback(cid);
+    EXPECT_EQ(fromFile, 3);
+
+    fclose(file);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(CORE_EVENTLOOP, Test_callback_closed_first)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    // Closed before its callback is removed, while a dup keeps the pipe open and readable
+    int received = 0;
+    int cid = addCallback(fds[0], readByte, &received);
+    int copy = dup(fds[0]);
+    close(fds[0]);
+    rmCallback(cid);
+    ASSERT_EQ(write(fds[1], "a", 1), 1);
+
+    // The loop waits instead of spinning on it
+    struct timespec start, end;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    runFor(100);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+    double cpu = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    EXPECT_LT(cpu, 50);
+    EXPECT_EQ(received, 0);
+
+    // And still calls the others
+    int fds2[2];
+    ASSERT_EQ(pipe(fds2), 0);
+    cid = addCallback(fds2[0], readByte, &received);
+    ASSERT_EQ(write(fds2[1], "b", 1), 1);
+    runFor(10);
+    rmCallback(cid);
+    EXPECT_EQ(received, 1);
+
+    close(copy);
+    close(fds[1]);
+    close(fds2[0]);
+    close(fds2[1]);
+}
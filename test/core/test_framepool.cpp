@@ -0,0 +1,154 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+#include "framepool.h"
+
+using INDI::FramePool;
+
+TEST(CORE_FRAMEPOOL, Test_acquire)
+{
+    FramePool pool;
+
+    auto a = pool.acquire(100);
+    auto b = pool.acquire(200);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(a->size(), 100u);
+    EXPECT_EQ(b->size(), 200u);
+    EXPECT_NE(a->data(), b->data());
+    EXPECT_EQ(pool.allocated(), 300u);
+
+    // Zero sized frames are still buffers
+    auto empty = pool.acquire(0);
+    ASSERT_NE(empty, nullptr);
+    EXPECT_EQ(empty->size(), 0u);
+}
+
+TEST(CORE_FRAMEPOOL, Test_recycle)
+{
+    FramePool pool;
+
+    auto frame = pool.acquire(1000);
+    ASSERT_NE(frame, nullptr);
+    const uint8_t *data = frame->data();
+    frame.reset();
+    EXPECT_EQ(pool.allocated(), 1000u);
+
+    // Same buffer, no new memory
+    frame = pool.acquire(1000);
+    ASSERT_NE(frame, nullptr);
+    EXPECT_EQ(frame->data(), data);
+    EXPECT_EQ(pool.allocated(), 1000u);
+
+    // A smaller frame fits in it too
+    frame.reset();
+    frame = pool.acquire(10);
+    EXPECT_EQ(frame->data(), data);
+    EXPECT_EQ(frame->size(), 10u);
+    EXPECT_EQ(pool.allocated(), 1000u);
+}
+
+TEST(CORE_FRAMEPOOL, Test_recycle_smallest)
+{
+    FramePool pool;
+
+    auto big = pool.acquire(200);
+    auto small = pool.acquire(100);
+    const uint8_t *bigData = big->data();
+    const uint8_t *smallData = small->data();
+    big.reset();
+    small.reset();
+
+    // The smallest buffer that fits, the big one stays for full frames
+    auto frame = pool.acquire(50);
+    EXPECT_EQ(frame->data(), smallData);
+    auto other = pool.acquire(150);
+    EXPECT_EQ(other->data(), bigData);
+    EXPECT_EQ(pool.allocated(), 300u);
+}
+
+TEST(CORE_FRAMEPOOL, Test_limit)
+{
+    FramePool pool(1000);
+
+    auto a = pool.acquire(600);
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(pool.acquire(600), nullptr);
+    EXPECT_EQ(pool.acquire(2000), nullptr);
+
+    auto b = pool.acquire(400);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(pool.allocated(), 1000u);
+
+    // Free buffers too small for the frame make room for it
+    a.reset();
+    b.reset();
+    auto c = pool.acquire(800);
+    ASSERT_NE(c, nullptr);
+    EXPECT_LE(pool.allocated(), 1000u);
+}
+
+TEST(CORE_FRAMEPOOL, Test_set_limit)
+{
+    FramePool pool;
+
+    auto used = pool.acquire(500);
+    pool.acquire(300).reset();
+    EXPECT_EQ(pool.allocated(), 800u);
+
+    // Free buffers go at once, buffers in use when they come back
+    pool.setLimit(400);
+    EXPECT_EQ(pool.allocated(), 500u);
+    used.reset();
+    EXPECT_EQ(pool.allocated(), 0u);
+
+    EXPECT_EQ(pool.acquire(500), nullptr);
+    EXPECT_NE(pool.acquire(400), nullptr);
+}
+
+TEST(CORE_FRAMEPOOL, Test_clear)
+{
+    FramePool pool;
+
+    auto used = pool.acquire(500);
+    pool.acquire(300).reset();
+
+    pool.clear();
+    EXPECT_EQ(pool.allocated(), 500u);
+    used.reset();
+    EXPECT_EQ(pool.allocated(), 500u);
+}
+
+TEST(CORE_FRAMEPOOL, Test_release_elsewhere)
+{
+    auto pool = std::unique_ptr<FramePool>(new FramePool(1000));
+
+    auto frame = pool->acquire(1000);
+    ASSERT_NE(frame, nullptr);
+    std::thread([&frame] { frame.reset(); }).join();
+    frame = pool->acquire(1000);
+    ASSERT_NE(frame, nullptr);
+
+    // A buffer may outlive its pool
+    pool.reset();
+    (*frame)[0] = 1;
+    frame.reset();
+}
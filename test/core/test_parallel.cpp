@@ -0,0 +1,68 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "indiparallel.h"
+
+TEST(Parallel, Test_each_index_once)
+{
+    for (size_t count : {0, 1, 2, 3, 100, 10000})
+    {
+        std::vector<std::atomic<int>> runs(count);
+        INDI::parallelFor(count, [&](size_t i)
+        {
+            runs[i]++;
+        });
+        for (size_t i = 0; i < count; i++)
+            ASSERT_EQ(runs[i], 1) << "count " << count << " index " << i;
+    }
+}
+
+TEST(Parallel, Test_nested)
+{
+    std::atomic<size_t> total {0};
+    INDI::parallelFor(16, [&](size_t)
+    {
+        INDI::parallelFor(16, [&](size_t j)
+        {
+            total += j;
+        });
+    });
+    EXPECT_EQ(total, 16 * (15 * 16 / 2));
+}
+
+TEST(Parallel, Test_concurrent_callers)
+{
+    std::atomic<size_t> total {0};
+    std::vector<std::thread> callers;
+    for (int c = 0; c < 4; c++)
+        callers.emplace_back([&]()
+        {
+            for (int k = 0; k < 100; k++)
+                INDI::parallelFor(10, [&](size_t i)
+                {
+                    total += i;
+                });
+        });
+    for (auto &caller : callers)
+        caller.join();
+    EXPECT_EQ(total, 4 * 100 * 45);
+}
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "previewconverter.h"
+
+using INDI::PreviewConverter;
+
+static std::vector<uint16_t> makeSamples(size_t count, uint16_t first, uint16_t last)
+{
+    std::vector<uint16_t> samples(count);
+    srand(count);
+    for (auto &sample : samples)
+        sample = first + rand() % (last - first + 1);
+    return samples;
+}
+
+TEST(CORE_PREVIEW, Test_linear)
+{
+    for (int trial = 0; trial < 100; trial++)
+    {
+        uint16_t black = rand() % 65536, white = rand() % 65536;
+        if (trial % 4 == 0)
+        {
+            black = 0;
+            white = (1 << (8 + trial % 9)) - 1;
+        }
+        PreviewConverter::Linear linear(black, white);
+
+        // Odd sizes for the scalar tail after the vector loops
+        auto samples = makeSamples(1000 + trial, 0, 65535);
+        std::vector<uint8_t> converted(samples.size());
+        PreviewConverter::applyLinear(linear, samples.data(), samples.size(), converted.data());
+
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            double x = std::min<double>(samples[i] > black ? samples[i] - black : 0, linear.range);
+            ASSERT_NEAR(converted[i], x * 255 / linear.range, 1.0) << "black " << black << " white " << white
+                    << " value " << samples[i];
+        }
+    }
+}
+
+TEST(CORE_PREVIEW, Test_linear_depth)
+{
+    // 12 bit samples use the whole 8 bit range
+    std::vector<uint16_t> samples = { 0, 16, 2048, 4095 };
+    std::vector<uint8_t> converted(samples.size());
+
+    PreviewConverter converter;
+    converter.setMode(PreviewConverter::PREVIEW_LINEAR);
+    converter.convert(samples.data(), samples.size(), 12, converted.data());
+
+    EXPECT_EQ(converted[0], 0);
+    EXPECT_EQ(converted[1], 0);
+    EXPECT_EQ(converted[2], 127);
+    EXPECT_EQ(converted[3], 255);
+}
+
+TEST(CORE_PREVIEW, Test_gamma)
+{
+    std::vector<uint16_t> samples(65536);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = i;
+    std::vector<uint8_t> converted(samples.size());
+
+    PreviewConverter converter;
+    converter.convert(samples.data(), samples.size(), 16, converted.data());
+
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        double I = i / 65535.0;
+        double p = I <= 0.00304 ? 12.92 * I : 1.055 * powf(I, 1.0 / 2.4) - 0.055;
+        ASSERT_EQ(converted[i], round(255.0 * p)) << "value " << i;
+    }
+}
+
+TEST(CORE_PREVIEW, Test_auto_stretch)
+{
+    // Background between 1000 and 1200, a few stars at 40000
+    auto samples = makeSamples(1 << 20, 1000, 1200);
+    for (size_t i = 0; i < samples.size(); i += 100000)
+        samples[i] = 40000;
+
+    auto linear = PreviewConverter::autoStretch(samples.data(), samples.size());
+    EXPECT_GE(linear.black, 992);
+    EXPECT_LE(linear.black, 1008);
+    EXPECT_GE(linear.black + linear.range, 1200);
+    EXPECT_LE(linear.black + linear.range, 1216);
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "previewscaler.h"
+
+using INDI::PreviewScaler;
+
+static std::vector<uint8_t> makeFrame(uint32_t width, uint32_t height, uint32_t components)
+{
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * components);
+    srand(frame.size());
+    for (auto &sample : frame)
+        sample = rand() % 256;
+    return frame;
+}
+
+TEST(CORE_PREVIEW_SCALER, Test_factor)
+{
+    EXPECT_EQ(PreviewScaler::factor(640, 480, 640, 480), 1u);
+    EXPECT_EQ(PreviewScaler::factor(1920, 1080, 640, 480), 3u);
+    EXPECT_EQ(PreviewScaler::factor(6000, 4000, 640, 480), 10u);
+    EXPECT_EQ(PreviewScaler::factor(6000, 4000, 640, 0), 10u);
+    EXPECT_EQ(PreviewScaler::factor(6000, 4000, 0, 0), 1u);
+    EXPECT_EQ(PreviewScaler::factor(100000, 100000, 10, 10), 255u);
+    EXPECT_EQ(PreviewScaler::factor(3, 3000, 1, 1), 3u);
+}
+
+TEST(CORE_PREVIEW_SCALER, Test_scale)
+{
+    const uint32_t sizes[][2] = { {64, 48}, {97, 61}, {1001, 33}, {5, 3} };
+    PreviewScaler scaler;
+
+    for (auto &size : sizes)
+        for (uint32_t components : {1, 3})
+        {
+            auto frame = makeFrame(size[0], size[1], components);
+            for (uint32_t factor : {1, 2, 3, 5, 16})
+            {
+                if (factor > size[0] || factor > size[1])
+                    continue;
+
+                uint32_t outWidth = size[0] / factor, outHeight = size[1] / factor;
+                std::vector<uint8_t> scaled(static_cast<size_t>(outWidth) * outHeight * components);
+                scaler.scale(frame.data(), size[0], size[1], components, factor, scaled.data());
+
+                for (uint32_t oy = 0; oy < outHeight; oy++)
+                    for (uint32_t ox = 0; ox < outWidth; ox++)
+                        for (uint32_t c = 0; c < components; c++)
+                        {
+                            uint32_t sum = 0;
+                            for (uint32_t y = oy * factor; y < (oy + 1) * factor; y++)
+                                for (uint32_t x = ox * factor; x < (ox + 1) * factor; x++)
+                                    sum += frame[(static_cast<size_t>(y) * size[0] + x) * components + c];
+                            uint32_t area = factor * factor;
+                            ASSERT_EQ(scaled[(static_cast<size_t>(oy) * outWidth + ox) * components + c], (sum + area / 2) / area)
+                                    << "size " << size[0] << "x" << size[1] << " components " << components << " factor " << factor;
+                        }
+            }
+        }
+}
+
+// The row sums must not overflow at the largest factor
+TEST(CORE_PREVIEW_SCALER, Test_saturation)
+{
+    std::vector<uint8_t> frame(255 * 255 * 3, 255);
+    std::vector<uint8_t> scaled(3);
+    PreviewScaler scaler;
+    scaler.scale(frame.data(), 255, 255, 3, 255, scaled.data());
+    for (auto sample : scaled)
+        ASSERT_EQ(sample, 255);
+}
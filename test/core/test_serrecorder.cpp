@@ -0,0 +1,292 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "recorder/serrecorder.h"
+
+static const size_t HEADER_SIZE = 178;
+
+// The disk, as slow as the test wants it
+class GatedRecorder : public INDI::SER_Recorder
+{
+    public:
+        void hold()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            passes = 0;
+        }
+
+        // One more write, while held
+        void allow()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                passes++;
+            }
+            changed.notify_all();
+        }
+
+        void release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                passes = SIZE_MAX;
+            }
+            changed.notify_all();
+        }
+
+        // Until the writer is stuck with the next batch, the ones before written and free again
+        void waitForWriter()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]() { return waiting > 0 && passes == 0; });
+        }
+
+    protected:
+        bool writeBlock(const uint8_t *data, size_t size, uint64_t offset) override
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                waiting++;
+                changed.notify_all();
+                changed.wait(lock, [this]() { return passes > 0; });
+                passes--;
+                waiting--;
+            }
+            return SER_Recorder::writeBlock(data, size, offset);
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t passes {SIZE_MAX};
+        int waiting {0};
+};
+
+class SerRecorderTest : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            char name[] = "/tmp/indi_ser_XXXXXX";
+            int fd = mkstemp(name);
+            ASSERT_GE(fd, 0);
+            close(fd);
+            path = name;
+        }
+
+        void TearDown() override
+        {
+            unlink(path.c_str());
+        }
+
+        bool open(INDI::SER_Recorder &recorder, uint16_t width, uint16_t height, uint8_t depth = 8)
+        {
+            char errmsg[1024];
+            recorder.setPixelFormat(INDI_MONO, depth);
+            recorder.setSize(width, height);
+            return recorder.open(path.c_str(), errmsg);
+        }
+
+        static std::vector<uint8_t> frame(uint32_t index, size_t size)
+        {
+            std::vector<uint8_t> data(size);
+            for (size_t i = 0; i < size; i++)
+                data[i] = index * 31 + i * 13;
+            return data;
+        }
+
+        std::vector<uint8_t> read()
+        {
+            std::vector<uint8_t> data;
+            FILE *fp = fopen(path.c_str(), "r");
+            uint8_t buffer[65536];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+                data.insert(data.end(), buffer, buffer + n);
+            fclose(fp);
+            return data;
+        }
+
+        static uint32_t word(const std::vector<uint8_t> &data, size_t offset)
+        {
+            return data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 | uint32_t(data[offset + 3]) << 24;
+        }
+
+        static uint32_t frameCount(const std::vector<uint8_t> &data)
+        {
+            return word(data, 38);
+        }
+
+        // Frames in the file are the given ones, in that order, followed by their timestamps
+        static void expectFrames(const std::vector<uint8_t> &data, const std::vector<uint32_t> &frames, size_t size)
+        {
+            ASSERT_EQ(data.size(), HEADER_SIZE + frames.size() * (size + sizeof(uint64_t)));
+            EXPECT_EQ(frameCount(data), frames.size());
+
+            for (size_t i = 0; i < frames.size(); i++)
+            {
+                std::vector<uint8_t> expected = frame(frames[i], size);
+                EXPECT_TRUE(std::equal(expected.begin(), expected.end(), data.begin() + HEADER_SIZE + i * size))
+                        << "frame " << i;
+            }
+
+            const size_t trailer = HEADER_SIZE + frames.size() * size;
+            uint64_t last = 0;
+            for (size_t i = 0; i < frames.size(); i++)
+            {
+                uint64_t stamp = word(data, trailer + 8 * i) | uint64_t(word(data, trailer + 8 * i + 4)) << 32;
+                EXPECT_GE(stamp, last);
+                last = stamp;
+            }
+        }
+
+        std::string path;
+};
+
+TEST_F(SerRecorderTest, Test_write_order)
+{
+    // Frames straddle the batches
+    const uint16_t width = 1000, height = 999;
+    const size_t size = width * height;
+
+    INDI::SER_Recorder recorder;
+    ASSERT_TRUE(open(recorder, width, height));
+
+    std::vector<uint32_t> frames;
+    for (uint32_t i = 0; i < 30; i++)
+    {
+        ASSERT_TRUE(recorder.writeFrame(frame(i, size).data(), size));
+        frames.push_back(i);
+    }
+    ASSERT_TRUE(recorder.close());
+    EXPECT_EQ(recorder.getDroppedFrames(), 0u);
+
+    std::vector<uint8_t> data = read();
+    expectFrames(data, frames, size);
+    EXPECT_EQ(word(data, 26), width);
+    EXPECT_EQ(word(data, 30), height);
+}
+
+TEST_F(SerRecorderTest, Test_header_frame_count)
+{
+    const uint16_t width = 1024, height = 1024;
+    const size_t size = width * height;
+
+    INDI::SER_Recorder recorder;
+    ASSERT_TRUE(open(recorder, width, height));
+
+    // The header is rewritten with the frames on disk as batches are written, every few seconds
+    uint32_t written = 0;
+    for (; written < 10; written++)
+        ASSERT_TRUE(recorder.writeFrame(frame(written, size).data(), size));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    for (; written < 20; written++)
+        ASSERT_TRUE(recorder.writeFrame(frame(written, size).data(), size));
+
+    uint32_t count = 0;
+    for (int i = 0; i < 100 && count == 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        count = frameCount(read());
+    }
+    EXPECT_GT(count, 0u);
+    EXPECT_LT(count, written);
+
+    // The frames it counts are there already
+    std::vector<uint8_t> data = read();
+    ASSERT_GE(data.size(), HEADER_SIZE + count * size);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::vector<uint8_t> expected = frame(i, size);
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), data.begin() + HEADER_SIZE + i * size));
+    }
+
+    ASSERT_TRUE(recorder.close());
+    EXPECT_EQ(frameCount(read()), written);
+}
+
+TEST_F(SerRecorderTest, Test_dropped_frames)
+{
+    const uint16_t width = 1024, height = 1024;
+    const size_t size = width * height;
+
+    GatedRecorder recorder;
+    ASSERT_TRUE(open(recorder, width, height));
+
+    // Three batches of 8 frames, the disk takes none of them: what does not fit is dropped, and that is no
+    // failure
+    recorder.hold();
+    std::vector<uint32_t> frames;
+    for (uint32_t i = 0; i < 30; i++)
+    {
+        ASSERT_TRUE(recorder.writeFrame(frame(i, size).data(), size));
+        if (i < 23)
+            frames.push_back(i);
+    }
+    EXPECT_EQ(recorder.getDroppedFrames(), 7u);
+
+    recorder.release();
+    ASSERT_TRUE(recorder.close());
+    EXPECT_EQ(recorder.getDroppedFrames(), 7u);
+
+    // Neither in the file nor in its frame count
+    expectFrames(read(), frames, size);
+}
+
+TEST_F(SerRecorderTest, Test_last_batch_exactly_filled)
+{
+    // With the header, seven of these fill six batches exactly
+    const uint16_t width = 185, height = 19433;
+    const size_t size = 2 * width * height;
+
+    GatedRecorder recorder;
+    ASSERT_TRUE(open(recorder, width, height, 16));
+
+    // The disk stays one batch behind
+    recorder.hold();
+    for (uint32_t i = 0; i < 3; i++)
+        ASSERT_TRUE(recorder.writeFrame(frame(i, size).data(), size));
+    for (uint32_t i = 3; i < 6; i++)
+    {
+        recorder.waitForWriter();
+        recorder.allow();
+        recorder.waitForWriter();
+        ASSERT_TRUE(recorder.writeFrame(frame(i, size).data(), size));
+    }
+
+    // It would end with the last free batch, and no other to go on with
+    ASSERT_TRUE(recorder.writeFrame(frame(6, size).data(), size));
+    EXPECT_EQ(recorder.getDroppedFrames(), 1u);
+
+    recorder.release();
+    ASSERT_TRUE(recorder.close());
+    expectFrames(read(), {0, 1, 2, 3, 4, 5}, size);
+}
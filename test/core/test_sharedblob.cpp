@@ -0,0 +1,117 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sharedblob.h"
+
+#ifdef __linux__
+
+// Receive one segment sent by IDSharedBlobSend(), return its fd or -1
+static int receiveSegment(int socket)
+{
+    char tag = 0;
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { &tag, 1 };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    if (recvmsg(socket, &msg, MSG_DONTWAIT) != 1)
+        return -1;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        return -1;
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+TEST(CORE_SHAREDBLOB, Test_send)
+{
+    int sockets[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets), 0);
+    // Read at the first send, as indiserver would have set it
+    setenv("INDIBLOBFD", std::to_string(sockets[0]).c_str(), 1);
+
+    const size_t size = 3 * 4096 + 123;
+    uint8_t *blob = static_cast<uint8_t *>(IDSharedBlobAlloc(size));
+    ASSERT_NE(blob, nullptr);
+    for (size_t i = 0; i < size; i++)
+        blob[i] = static_cast<uint8_t>(i * 7 + 3);
+
+    ASSERT_EQ(IDSharedBlobSend(blob), 0);
+
+    int fd = receiveSegment(sockets[1]);
+    ASSERT_GE(fd, 0);
+    struct stat st;
+    ASSERT_EQ(fstat(fd, &st), 0);
+    ASSERT_EQ(static_cast<size_t>(st.st_size), size);
+
+    const uint8_t *received = static_cast<const uint8_t *>(mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0));
+    ASSERT_NE(received, MAP_FAILED);
+    for (size_t i = 0; i < size; i++)
+        ASSERT_EQ(received[i], static_cast<uint8_t>(i * 7 + 3)) << "byte " << i;
+
+    // The driver's buffer is now a new zeroed segment, writing it leaves the sent one alone
+    for (size_t i = 0; i < size; i++)
+        ASSERT_EQ(blob[i], 0) << "byte " << i;
+    memset(blob, 0xff, size);
+    EXPECT_EQ(received[0], 3);
+    EXPECT_EQ(received[size - 1], static_cast<uint8_t>((size - 1) * 7 + 3));
+
+    // Buffers that are not shared are not sent
+    void *plain = malloc(size);
+    EXPECT_EQ(IDSharedBlobSend(plain), -1);
+    free(plain);
+    EXPECT_EQ(receiveSegment(sockets[1]), -1);
+
+    munmap(const_cast<uint8_t *>(received), size);
+    close(fd);
+    IDSharedBlobFree(blob);
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+TEST(CORE_SHAREDBLOB, Test_realloc)
+{
+    uint8_t *blob = static_cast<uint8_t *>(IDSharedBlobAlloc(2880));
+    ASSERT_NE(blob, nullptr);
+    for (size_t i = 0; i < 2880; i++)
+        blob[i] = static_cast<uint8_t>(i);
+
+    blob = static_cast<uint8_t *>(IDSharedBlobRealloc(blob, 10 * 2880));
+    ASSERT_NE(blob, nullptr);
+    for (size_t i = 0; i < 2880; i++)
+        ASSERT_EQ(blob[i], static_cast<uint8_t>(i));
+    memset(blob + 2880, 1, 9 * 2880);
+
+    IDSharedBlobFree(blob);
+    IDSharedBlobFree(nullptr);
+}
+
+#endif
@@ -0,0 +1,215 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "indicom.h"
+
+// The driver reads the port end of a pty, the test plays the device on the other end
+class TtyTest : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            device = posix_openpt(O_RDWR | O_NOCTTY);
+            ASSERT_GE(device, 0);
+            ASSERT_EQ(grantpt(device), 0);
+            ASSERT_EQ(unlockpt(device), 0);
+
+            port = open(ptsname(device), O_RDWR | O_NOCTTY);
+            ASSERT_GE(port, 0);
+
+            struct termios tty_setting;
+            ASSERT_EQ(tcgetattr(port, &tty_setting), 0);
+            cfmakeraw(&tty_setting);
+            ASSERT_EQ(tcsetattr(port, TCSANOW, &tty_setting), 0);
+        }
+
+        void TearDown() override
+        {
+            tty_disconnect(port);
+            close(device);
+        }
+
+        void send(const std::string &reply)
+        {
+            ASSERT_EQ(write(device, reply.data(), reply.size()), static_cast<ssize_t>(reply.size()));
+            // Until all of it is there to be read
+            for (int i = 0; i < 100 && pending() < static_cast<int>(reply.size()); i++)
+                usleep(1000);
+        }
+
+        int pending()
+        {
+            int count = 0;
+            ioctl(port, FIONREAD, &count);
+            return count;
+        }
+
+        std::string readSection(char stop = '#')
+        {
+            char buf[64] = {0};
+            int nbytes_read = 0;
+            EXPECT_EQ(tty_read_section(port, buf, stop, 1, &nbytes_read), TTY_OK);
+            return std::string(buf, nbytes_read);
+        }
+
+        // What a driver reading the port itself gets
+        static std::string readRaw(int fd)
+        {
+            struct timeval tv = {0, 100000};
+            fd_set readout;
+            FD_ZERO(&readout);
+            FD_SET(fd, &readout);
+            if (select(fd + 1, &readout, nullptr, nullptr, &tv) <= 0)
+                return std::string();
+
+            char buf[64];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            return n > 0 ? std::string(buf, n) : std::string();
+        }
+
+        int device {-1};
+        int port {-1};
+};
+
+TEST_F(TtyTest, Test_section_leaves_rest)
+{
+    send("ab#cd#");
+
+    EXPECT_EQ(readSection(), "ab#");
+    EXPECT_EQ(readRaw(port), "cd#");
+}
+
+TEST_F(TtyTest, Test_nread_overflow)
+{
+    send("abcdef#");
+
+    char buf[3];
+    int nbytes_read = 0;
+    EXPECT_EQ(tty_nread_section(port, buf, sizeof(buf), '#', 1, &nbytes_read), TTY_OVERFLOW);
+    EXPECT_EQ(std::string(buf, nbytes_read), "abc");
+    EXPECT_EQ(readRaw(port), "def#");
+}
+
+TEST_F(TtyTest, Test_clear_trailing_lf)
+{
+    send("\nab#");
+
+    tty_clr_trailing_read_lf(1);
+    EXPECT_EQ(readSection(), "ab#");
+    tty_clr_trailing_read_lf(0);
+}
+
+TEST_F(TtyTest, Test_readahead)
+{
+    tty_set_readahead(port, 1);
+    send("ab#cd#ef");
+
+    // The next reply is already read, and the rest goes to a plain read
+    EXPECT_EQ(readSection(), "ab#");
+    EXPECT_EQ(pending(), 0);
+    EXPECT_EQ(readSection(), "cd#");
+
+    char buf[4] = {0};
+    int nbytes_read = 0;
+    EXPECT_EQ(tty_read(port, buf, 2, 1, &nbytes_read), TTY_OK);
+    EXPECT_EQ(std::string(buf, nbytes_read), "ef");
+}
+
+TEST_F(TtyTest, Test_readahead_flush)
+{
+    tty_set_readahead(port, 1);
+    send("ab#stale#");
+    EXPECT_EQ(readSection(), "ab#");
+
+    tty_tcflush(port, TCIFLUSH);
+    send("cd#");
+    EXPECT_EQ(readSection(), "cd#");
+}
+
+TEST_F(TtyTest, Test_readahead_reset)
+{
+    tty_set_readahead(port, 1);
+    send("ab#stale#");
+    EXPECT_EQ(readSection(), "ab#");
+
+    // Turning it off drops what was read ahead, and reads no further from then on
+    tty_set_readahead(port, 0);
+    send("cd#ef#");
+    EXPECT_EQ(readSection(), "cd#");
+    EXPECT_EQ(readRaw(port), "ef#");
+}
+
+TEST_F(TtyTest, Test_readahead_disconnect)
+{
+    tty_set_readahead(port, 1);
+    send("ab#stale#");
+    EXPECT_EQ(readSection(), "ab#");
+    tty_disconnect(port);
+
+    // Whatever gets the fd number next starts afresh
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    int fd = fds[0] == port ? fds[0] : dup2(fds[0], port);
+    ASSERT_EQ(fd, port);
+    ASSERT_EQ(write(fds[1], "cd#ef#", 6), 6);
+
+    EXPECT_EQ(readSection(), "cd#");
+    EXPECT_EQ(readRaw(port), "ef#");
+
+    if (fds[0] != port)
+        close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(TtySocketTest, Test_section_leaves_rest)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_EQ(write(fds[1], "ab#cd", 5), 5);
+
+    char buf[64] = {0};
+    int nbytes_read = 0;
+    EXPECT_EQ(tty_read_section(fds[0], buf, '#', 1, &nbytes_read), TTY_OK);
+    EXPECT_EQ(std::string(buf, nbytes_read), "ab#");
+
+    // A reply split across packets
+    ASSERT_EQ(write(fds[1], "#", 1), 1);
+    EXPECT_EQ(tty_read_section(fds[0], buf, '#', 1, &nbytes_read), TTY_OK);
+    EXPECT_EQ(std::string(buf, nbytes_read), "cd#");
+
+    ASSERT_EQ(write(fds[1], "ef#gh", 5), 5);
+    EXPECT_EQ(tty_read_section(fds[0], buf, '#', 1, &nbytes_read), TTY_OK);
+    EXPECT_EQ(std::string(buf, nbytes_read), "ef#");
+    char rest[4] = {0};
+    EXPECT_EQ(read(fds[0], rest, sizeof(rest)), 2);
+    EXPECT_STREQ(rest, "gh");
+
+    close(fds[0]);
+    close(fds[1]);
+}
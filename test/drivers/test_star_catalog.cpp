@@ -0,0 +1,234 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "star_catalog.h"
+
+static StarCatalog::Star star(double ra, double dec, double mag)
+{
+    StarCatalog::Star s;
+    s.ra  = ra;
+    s.dec = dec;
+    s.mag = mag;
+    return s;
+}
+
+static double distance(double ra1, double dec1, double ra2, double dec2)
+{
+    const double r = M_PI / 180.0;
+    double c = sin(dec1 * r) * sin(dec2 * r) + cos(dec1 * r) * cos(dec2 * r) * cos((ra1 - ra2) * r);
+    return acos(std::min(1.0, std::max(-1.0, c))) / r;
+}
+
+class StarCatalogTest : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            char name[] = "/tmp/indi_star_catalog_XXXXXX";
+            int fd = mkstemp(name);
+            ASSERT_GE(fd, 0);
+            close(fd);
+            path = name;
+
+            // Random stars all over the sky, and a few on the edges of bands and tiles
+            std::mt19937 random(1);
+            std::uniform_real_distribution<double> ra(0, 360), z(-1, 1), mag(0, 12);
+            for (int i = 0; i < 5000; i++)
+                stars.push_back(star(ra(random), asin(z(random)) * 180.0 / M_PI, mag(random)));
+            stars.push_back(star(0, 0, 1));
+            stars.push_back(star(359.99, 0.5, 2));
+            stars.push_back(star(45, 90, 3));
+            stars.push_back(star(200, -90, 4));
+            stars.push_back(star(10, -0.001, 5));
+
+            std::vector<StarCatalog::Star> written = stars;
+            std::string error;
+            ASSERT_TRUE(StarCatalog::write(path, written, error)) << error;
+        }
+
+        void TearDown() override
+        {
+            unlink(path.c_str());
+        }
+
+        // Stars of the cone, found the slow way and rounded as the catalog stores them
+        std::vector<double> expected(double ra, double dec, double radius, double magLimit, size_t maxStars)
+        {
+            std::vector<double> mags;
+            for (const auto &one : stars)
+            {
+                if (static_cast<float>(one.mag) <= magLimit &&
+                        distance(static_cast<float>(one.ra), static_cast<float>(one.dec), ra, dec) <= radius)
+                    mags.push_back(static_cast<float>(one.mag));
+            }
+            std::sort(mags.begin(), mags.end());
+            if (mags.size() > maxStars)
+                mags.resize(maxStars);
+            return mags;
+        }
+
+        std::vector<uint32_t> readFile()
+        {
+            std::vector<uint32_t> words;
+            FILE *fp = fopen(path.c_str(), "r");
+            uint32_t word;
+            while (fread(&word, sizeof(word), 1, fp) == 1)
+                words.push_back(word);
+            fclose(fp);
+            return words;
+        }
+
+        void writeFile(const std::vector<uint32_t> &words)
+        {
+            FILE *fp = fopen(path.c_str(), "w");
+            fwrite(words.data(), sizeof(uint32_t), words.size(), fp);
+            fclose(fp);
+        }
+
+        std::string path;
+        std::vector<StarCatalog::Star> stars;
+};
+
+TEST_F(StarCatalogTest, Test_query)
+{
+    StarCatalog catalog;
+    std::string error;
+    ASSERT_TRUE(catalog.open(path, error)) << error;
+
+    // Around the sky, across the RA wrap and over both poles
+    const double cones[][2] = { {0, 0}, {359.9, 0.4}, {120, 45}, {300, -60}, {45, 89.5}, {200, -89.9}, {10, 0} };
+    std::vector<StarCatalog::Star> found;
+    for (const auto &cone : cones)
+    {
+        for (double radius : { 0.5, 3.0, 12.0 })
+        {
+            catalog.query(cone[0], cone[1], radius, 10, 100000, found);
+
+            std::vector<double> mags;
+            for (const auto &one : found)
+            {
+                EXPECT_LE(distance(one.ra, one.dec, cone[0], cone[1]), radius + 1e-9);
+                mags.push_back(one.mag);
+            }
+            EXPECT_TRUE(std::is_sorted(mags.begin(), mags.end()));
+            EXPECT_EQ(mags, expected(cone[0], cone[1], radius, 10, 100000))
+                    << "cone " << cone[0] << " " << cone[1] << " radius " << radius;
+        }
+    }
+
+    // The brightest ones only
+    EXPECT_EQ(catalog.query(120, 45, 12, 10, 5, found), 5u);
+    std::vector<double> mags;
+    for (const auto &one : found)
+        mags.push_back(one.mag);
+    EXPECT_EQ(mags, expected(120, 45, 12, 10, 5));
+
+    // Unit vectors match the positions
+    catalog.query(0, 0, 0.01, 20, 10, found);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_NEAR(found[0].x, 1, 1e-9);
+    EXPECT_NEAR(found[0].y, 0, 1e-9);
+    EXPECT_NEAR(found[0].z, 0, 1e-9);
+}
+
+TEST_F(StarCatalogTest, Test_reopen)
+{
+    StarCatalog catalog;
+    std::string error;
+    std::vector<StarCatalog::Star> first, second;
+
+    ASSERT_TRUE(catalog.open(path, error)) << error;
+    catalog.query(120, 45, 5, 12, 1000, first);
+    ASSERT_FALSE(first.empty());
+
+    ASSERT_TRUE(catalog.open(path, error)) << error;
+    catalog.query(120, 45, 5, 12, 1000, second);
+    ASSERT_EQ(first.size(), second.size());
+    for (size_t i = 0; i < first.size(); i++)
+        EXPECT_EQ(first[i].mag, second[i].mag);
+
+    catalog.close();
+    EXPECT_FALSE(catalog.isOpen());
+    EXPECT_EQ(catalog.query(120, 45, 5, 12, 1000, second), 0u);
+
+    EXPECT_FALSE(catalog.open(path + ".missing", error));
+    EXPECT_FALSE(catalog.isOpen());
+}
+
+TEST_F(StarCatalogTest, Test_corrupted)
+{
+    const std::vector<uint32_t> good = readFile();
+    const uint32_t bands = good[1], tiles = good[2];
+    const size_t bandStart = 4, tileStart = bandStart + bands + 1;
+
+    auto opens = [&](const std::vector<uint32_t> &words)
+    {
+        writeFile(words);
+        StarCatalog catalog;
+        std::string error;
+        return catalog.open(path, error);
+    };
+
+    ASSERT_TRUE(opens(good));
+
+    std::vector<uint32_t> words = good;
+    words[0] = 0;
+    EXPECT_FALSE(opens(words)) << "magic";
+
+    words = good;
+    words.pop_back();
+    EXPECT_FALSE(opens(words)) << "truncated";
+
+    words = good;
+    std::swap(words[bandStart + 10], words[bandStart + 11]);
+    EXPECT_FALSE(opens(words)) << "bands out of order";
+
+    words = good;
+    words[bandStart + 20] = words[bandStart + 21];
+    EXPECT_FALSE(opens(words)) << "band without tiles";
+
+    words = good;
+    words[bandStart] = 1;
+    EXPECT_FALSE(opens(words)) << "first band";
+
+    words = good;
+    words[bandStart + 30] = tiles + 5;
+    EXPECT_FALSE(opens(words)) << "band past the tiles";
+
+    words = good;
+    words[tileStart + 100] = words[tileStart + tiles] + 1000;
+    EXPECT_FALSE(opens(words)) << "tile past the stars";
+
+    words = good;
+    words[tileStart] = 1;
+    EXPECT_FALSE(opens(words)) << "first tile";
+
+    // Tiles may be empty, they still open
+    words = good;
+    words[tileStart + 1] = 0;
+    EXPECT_TRUE(opens(words));
+}